@@ -0,0 +1,84 @@
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "array.h"
+
+
+typedef enum {
+    REPEAT_MEMCPY_PER_ITEM,
+    REPEAT_ARRAY,
+    REPEAT_ARRAY_AND_WRITE,
+} RepeatMethod;
+
+
+// Times [item] * length in a heap of its own, the way OP_MULTIPLY_HEAP_VALUE
+// did it with a memcpy per item, or with repeatArray.
+static void benchmarkRepeat(const char* case_name, int32_t item, size_t length, RepeatMethod method) {
+    Heap heap;
+    Stack stack;
+    Stack stack_references_positions;
+    initHeap(&heap);
+    initStack(&stack);
+    initStack(&stack_references_positions);
+
+    Object* source = allocateObjectFromValue(
+        &heap,
+        &stack,
+        &stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        sizeof(int32_t),
+        (const uint8_t*)&item
+    );
+
+    double start = benchmarkTime();
+    Object* result;
+    if (method == REPEAT_MEMCPY_PER_ITEM) {
+        dontCollectObjectOnNextGC(&heap, source);
+        result = allocateEmptyObject(
+            &heap,
+            &stack,
+            &stack_references_positions,
+            REFERENCE_RULE_PLAIN,
+            NULL,
+            length * sizeof(int32_t)
+        );
+        for (size_t i = 0; i < length; ++i) {
+            memcpy(result->value + i * sizeof(int32_t), source->value, sizeof(int32_t));
+        }
+    } else {
+        result = repeatArray(&heap, &stack, &stack_references_positions, source, length);
+    }
+
+    // Lazily zeroed pages are only taken when they're written.
+    if (method == REPEAT_ARRAY_AND_WRITE) {
+        for (size_t i = 0; i < length; ++i) {
+            ((int32_t*)result->value)[i] = (int32_t)i;
+        }
+    }
+    reportBenchmark(case_name, length, benchmarkTime() - start);
+    benchmark_sink += (uint64_t)((int32_t*)result->value)[length - 1];
+
+    freeHeap(&heap);
+    freeStack(&stack);
+    freeStack(&stack_references_positions);
+}
+
+
+BENCHMARK(RepeatArray) {
+    for (size_t length = 1000 * 1000, power = 6; power <= 8; length *= 10, ++power) {
+        char case_name[64];
+        snprintf(case_name, sizeof(case_name), "[0] * 10^%zu, memcpy per item", power);
+        benchmarkRepeat(case_name, 0, length, REPEAT_MEMCPY_PER_ITEM);
+        snprintf(case_name, sizeof(case_name), "[0] * 10^%zu", power);
+        benchmarkRepeat(case_name, 0, length, REPEAT_ARRAY);
+        snprintf(case_name, sizeof(case_name), "[0] * 10^%zu, then written", power);
+        benchmarkRepeat(case_name, 0, length, REPEAT_ARRAY_AND_WRITE);
+        snprintf(case_name, sizeof(case_name), "[7] * 10^%zu, memcpy per item", power);
+        benchmarkRepeat(case_name, 7, length, REPEAT_MEMCPY_PER_ITEM);
+        snprintf(case_name, sizeof(case_name), "[7] * 10^%zu", power);
+        benchmarkRepeat(case_name, 7, length, REPEAT_ARRAY);
+    }
+}
@@ -0,0 +1,99 @@
+#include "benchmark.h"
+
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define MAX_BENCHMARKS 64
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+typedef struct {
+    const char* name;
+    BenchmarkFunction function;
+} Benchmark;
+
+
+// ┌─────────┐
+// │ Globals │
+// └─────────┘
+
+volatile uint64_t benchmark_sink = 0;
+
+static Benchmark benchmarks[MAX_BENCHMARKS];
+static size_t benchmarks_count = 0;
+static const char* running_benchmark = NULL;
+
+
+// ┌──────┐
+// │ Main │
+// └──────┘
+
+int main(int argc, const char* argv[]) {
+    const char* filter = argc > 1 ? argv[1] : NULL;
+
+    for (size_t i = 0; i < benchmarks_count; ++i) {
+        if (filter && !strstr(benchmarks[i].name, filter)) {
+            continue;
+        }
+        running_benchmark = benchmarks[i].name;
+        benchmarks[i].function();
+    }
+
+    return 0;
+}
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+void registerBenchmark(const char* name, BenchmarkFunction function) {
+    assert(name);
+    assert(function);
+    assert(benchmarks_count < MAX_BENCHMARKS);
+
+    benchmarks[benchmarks_count].name = name;
+    benchmarks[benchmarks_count].function = function;
+    ++benchmarks_count;
+}
+
+double benchmarkTime(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+void reportBenchmark(const char* case_name, size_t operations, double seconds) {
+    assert(case_name);
+    assert(operations > 0);
+
+    printf(
+        "%-32s %-32s %10.2f ns/op\n",
+        running_benchmark,
+        case_name,
+        seconds * 1e9 / (double)operations
+    );
+}
+
+void reportBenchmarkThroughput(const char* case_name, size_t bytes, double seconds) {
+    assert(case_name);
+    assert(bytes > 0);
+
+    printf(
+        "%-32s %-32s %10.2f GB/s\n",
+        running_benchmark,
+        case_name,
+        (double)bytes / seconds * 1e-9
+    );
+}
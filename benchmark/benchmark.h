@@ -0,0 +1,85 @@
+#ifndef lala_benchmark_h
+#define lala_benchmark_h
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu_features.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Registers a benchmark, which is run by LalaBenchmark if its name
+// contains the first command line argument, or always if there's none.
+#define BENCHMARK(name)                                                       \
+    static void name(void);                                                   \
+    static void __attribute__((constructor)) registerBenchmark_##name(void) { \
+        registerBenchmark(#name, name);                                       \
+    }                                                                         \
+    static void name(void)
+
+// Times the statement repeated for the given number of passes, and gives
+// the seconds to the report function of the benchmark.
+#define BENCHMARK_CASE(case_name, passes, report, statement) \
+    {                                                        \
+        double start = benchmarkTime();                      \
+        for (size_t pass = 0; pass < (passes); ++pass) {     \
+            statement;                                       \
+        }                                                    \
+        report(case_name, benchmarkTime() - start);          \
+    }
+
+// Runs a case with each of the kernel levels the CPU supports, then
+// restores the selected level. The getter and the setter are those of the
+// kernel module, like stringKernelsLevel and setStringKernelsLevel.
+#define BENCHMARK_KERNEL_LEVELS(get_level, set_level, passes, report, statement)          \
+    {                                                                                     \
+        CpuLevel best_level = get_level();                                                \
+        for (int level = CPU_LEVEL_SCALAR; level <= CPU_LEVEL_AVX2; ++level) {            \
+            if (set_level((CpuLevel)level)) {                                             \
+                BENCHMARK_CASE(cpuLevelName((CpuLevel)level), passes, report, statement); \
+            }                                                                             \
+        }                                                                                 \
+        set_level(best_level);                                                            \
+    }
+
+// The naive versions of kernels are kept from being vectorized by the
+// compiler, so that they show what a plain loop costs.
+#define BENCHMARK_NAIVE __attribute__((optimize("no-tree-vectorize")))
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+typedef void (*BenchmarkFunction)(void);
+
+
+// ┌─────────┐
+// │ Globals │
+// └─────────┘
+
+// Results are added here, so that the compiler doesn't drop the work.
+extern volatile uint64_t benchmark_sink;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+void registerBenchmark(const char* name, BenchmarkFunction function);
+
+// Monotonic time in seconds.
+double benchmarkTime(void);
+
+// Prints the time per operation of a case of the running benchmark.
+void reportBenchmark(const char* case_name, size_t operations, double seconds);
+
+// Prints the throughput of a case that processes the given number of bytes.
+void reportBenchmarkThroughput(const char* case_name, size_t bytes, double seconds);
+
+
+#endif
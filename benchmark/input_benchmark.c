@@ -0,0 +1,89 @@
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "input.h"
+
+
+#define VALUES_COUNT (10 * 1000 * 1000)
+
+
+// Writes the values to a temporary file, which the benchmarks read from the start.
+static FILE* createValuesFile(const char* format, double (*value)(size_t)) {
+    FILE* file = tmpfile();
+    srand(1);
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        fprintf(file, format, value(i), i % 16 == 15 ? '\n' : ' ');
+    }
+    fflush(file);
+    return file;
+}
+
+static double intValue(size_t i) {
+    // Mostly small numbers, as in the usual inputs of tasks.
+    return i % 4 == 0 ? (double)(rand() - RAND_MAX / 2) : (double)(rand() % 10000 - 5000);
+}
+
+static double floatValue(size_t i) {
+    return (double)(rand() % 2000000 - 1000000) / (double)(1 << (i % 16));
+}
+
+
+BENCHMARK(ReadInts) {
+    FILE* file = createValuesFile("%.0f%c", intValue);
+
+    rewind(file);
+    double start = benchmarkTime();
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        int value;
+        if (fscanf(file, "%d", &value) == 1) {
+            benchmark_sink += (uint64_t)value;
+        }
+    }
+    reportBenchmark("scanf", VALUES_COUNT, benchmarkTime() - start);
+
+    rewind(file);
+    Input input;
+    initInput(&input, fileno(file));
+    start = benchmarkTime();
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        int32_t value;
+        if (readInt(&input, &value)) {
+            benchmark_sink += (uint64_t)value;
+        }
+    }
+    reportBenchmark("readInt", VALUES_COUNT, benchmarkTime() - start);
+
+    freeInput(&input);
+    fclose(file);
+}
+
+BENCHMARK(ReadFloats) {
+    FILE* file = createValuesFile("%.17g%c", floatValue);
+
+    rewind(file);
+    double start = benchmarkTime();
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        double value;
+        if (fscanf(file, "%lf", &value) == 1) {
+            benchmark_sink += (uint64_t)(int64_t)value;
+        }
+    }
+    reportBenchmark("scanf", VALUES_COUNT, benchmarkTime() - start);
+
+    rewind(file);
+    Input input;
+    initInput(&input, fileno(file));
+    start = benchmarkTime();
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        double value;
+        if (readFloat(&input, &value)) {
+            benchmark_sink += (uint64_t)(int64_t)value;
+        }
+    }
+    reportBenchmark("readFloat", VALUES_COUNT, benchmarkTime() - start);
+
+    freeInput(&input);
+    fclose(file);
+}
@@ -0,0 +1,59 @@
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "number_format.h"
+
+
+#define VALUES_COUNT (1024 * 1024)
+
+
+static int32_t ints[VALUES_COUNT];
+static double floats[VALUES_COUNT];
+
+static void fillValues(void) {
+    srand(1);
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        // Mostly small numbers, as in loop counters and indices.
+        ints[i] = i % 4 == 0 ? (int32_t)((uint32_t)rand() << 1) : rand() % 10000 - 5000;
+        floats[i] = (double)(rand() % 2000000 - 1000000) / (double)(1 << (i % 16));
+    }
+}
+
+
+BENCHMARK(FormatInt) {
+    fillValues();
+    char buffer[INT_STRING_MAX_LENGTH + 1];
+
+    double start = benchmarkTime();
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        benchmark_sink += (uint64_t)snprintf(buffer, sizeof(buffer), "%d", ints[i]);
+    }
+    reportBenchmark("snprintf", VALUES_COUNT, benchmarkTime() - start);
+
+    start = benchmarkTime();
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        size_t length = intStringLength(ints[i]);
+        formatInt(ints[i], (uint8_t*)buffer, length);
+        benchmark_sink += length;
+    }
+    reportBenchmark("formatInt", VALUES_COUNT, benchmarkTime() - start);
+}
+
+BENCHMARK(FormatFloat) {
+    fillValues();
+    char buffer[FLOAT_STRING_MAX_LENGTH + 1];
+
+    double start = benchmarkTime();
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        benchmark_sink += (uint64_t)snprintf(buffer, sizeof(buffer), "%g", floats[i]);
+    }
+    reportBenchmark("snprintf", VALUES_COUNT, benchmarkTime() - start);
+
+    start = benchmarkTime();
+    for (size_t i = 0; i < VALUES_COUNT; ++i) {
+        benchmark_sink += formatFloat(floats[i], (uint8_t*)buffer);
+    }
+    reportBenchmark("formatFloat", VALUES_COUNT, benchmarkTime() - start);
+}
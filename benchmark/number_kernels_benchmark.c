@@ -0,0 +1,108 @@
+#include "benchmark.h"
+
+#include <stdlib.h>
+
+#include "number_kernels.h"
+
+
+// The arrays fit in L2 cache, so that the kernels are measured rather than
+// the memory bandwidth.
+#define ITEMS_COUNT (16 * 1024)
+#define PASSES      4096
+
+
+static double floats[3][ITEMS_COUNT];
+static int32_t ints[3][ITEMS_COUNT];
+static uint8_t bits[ITEMS_COUNT / 8];
+
+static void fillNumbers(void) {
+    srand(1);
+    for (size_t array = 0; array < 3; ++array) {
+        for (size_t i = 0; i < ITEMS_COUNT; ++i) {
+            ints[array][i] = rand() % 1000 + 1;
+            floats[array][i] = (double)ints[array][i] / 64;
+        }
+    }
+}
+
+// Reads the results too, so that the compiler doesn't drop the work.
+static void reportItems(const char* case_name, double seconds) {
+    reportBenchmark(case_name, ITEMS_COUNT * PASSES, seconds);
+    benchmark_sink += (uint64_t)ints[0][0] + bits[0];
+}
+
+#define ITEMS_CASE(case_name, call) \
+    BENCHMARK_CASE(case_name, PASSES, reportItems, call)
+
+#define ITEMS_KERNEL_LEVELS(call) \
+    BENCHMARK_KERNEL_LEVELS(numberKernelsLevel, setNumberKernelsLevel, PASSES, reportItems, call)
+
+
+BENCHMARK_NAIVE
+static void naiveAddFloats(double* destination, const double* source, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        destination[i] += source[i];
+    }
+}
+
+// One accumulator makes every addition wait for the previous one.
+BENCHMARK_NAIVE
+static double naiveSumFloats(const double* items, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += items[i];
+    }
+    return sum;
+}
+
+BENCHMARK_NAIVE
+static void naiveMultiplyAddInts(int32_t* destination, const int32_t* left, const int32_t* right, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        destination[i] = (int32_t)((uint32_t)destination[i] + (uint32_t)left[i] * (uint32_t)right[i]);
+    }
+}
+
+
+BENCHMARK(AddFloatItems) {
+    fillNumbers();
+
+    ITEMS_CASE("naive", naiveAddFloats(floats[0], floats[1], ITEMS_COUNT));
+    ITEMS_KERNEL_LEVELS(combineFloats(floats[0], floats[1], ITEMS_COUNT, ITEMS_ADD));
+}
+
+BENCHMARK(MultiplyAddItems) {
+    fillNumbers();
+
+    ITEMS_CASE("naive ints", naiveMultiplyAddInts(ints[0], ints[1], ints[2], ITEMS_COUNT));
+    ITEMS_KERNEL_LEVELS(multiplyAddInts(ints[0], ints[1], ints[2], ITEMS_COUNT));
+    ITEMS_KERNEL_LEVELS(multiplyAddFloats(floats[0], floats[1], floats[2], ITEMS_COUNT));
+}
+
+BENCHMARK(DivideIntItems) {
+    fillNumbers();
+
+    ITEMS_KERNEL_LEVELS(divideInts(ints[0], ints[1], ITEMS_COUNT));
+}
+
+BENCHMARK(LessAndSelectItems) {
+    fillNumbers();
+
+    ITEMS_KERNEL_LEVELS(lessFloats(bits, floats[0], floats[1], ITEMS_COUNT));
+    ITEMS_KERNEL_LEVELS(selectInts(ints[0], bits, ints[1], ITEMS_COUNT));
+}
+
+BENCHMARK(SumFloatItems) {
+    fillNumbers();
+
+    ITEMS_CASE("naive", floats[0][0] += naiveSumFloats(floats[1], ITEMS_COUNT) * 0x1p-60);
+    ITEMS_KERNEL_LEVELS(floats[0][0] += sumFloats(floats[1], ITEMS_COUNT) * 0x1p-60);
+    ITEMS_KERNEL_LEVELS(floats[0][0] += dotFloats(floats[1], floats[2], ITEMS_COUNT) * 0x1p-60);
+}
+
+BENCHMARK(ReduceIntItems) {
+    fillNumbers();
+
+    ITEMS_KERNEL_LEVELS(ints[0][0] += sumInts(ints[1], ITEMS_COUNT));
+    ITEMS_KERNEL_LEVELS(ints[0][0] += maxInts(ints[1], ITEMS_COUNT));
+    ITEMS_KERNEL_LEVELS(ints[0][0] += (int32_t)findInt(ints[1], ITEMS_COUNT, 0));
+}
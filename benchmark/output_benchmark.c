@@ -0,0 +1,49 @@
+#include "benchmark.h"
+
+#include <stdio.h>
+
+#include "output.h"
+
+
+#define LINES_COUNT (1000 * 1000)
+
+
+// Prints numbers to /dev/null with fprintf, the way the print opcodes did,
+// and with an output, both in the given buffering mode.
+static void benchmarkPrints(
+    const char* printf_case,
+    const char* output_case,
+    int stdio_mode,
+    OutputBuffering buffering
+) {
+    FILE* file = fopen("/dev/null", "w");
+    setvbuf(file, NULL, stdio_mode, BUFSIZ);
+
+    double start = benchmarkTime();
+    for (size_t i = 0; i < LINES_COUNT; ++i) {
+        benchmark_sink += (uint64_t)fprintf(file, "%d\n", (int)(i * 7919));
+    }
+    fflush(file);
+    reportBenchmark(printf_case, LINES_COUNT, benchmarkTime() - start);
+
+    Output output;
+    initOutput(&output, fileno(file));
+    setOutputBuffering(&output, buffering);
+
+    start = benchmarkTime();
+    for (size_t i = 0; i < LINES_COUNT; ++i) {
+        writeInt(&output, (int32_t)(i * 7919));
+        endOutputLine(&output);
+    }
+    flushOutput(&output);
+    reportBenchmark(output_case, LINES_COUNT, benchmarkTime() - start);
+
+    freeOutput(&output);
+    fclose(file);
+}
+
+
+BENCHMARK(PrintLines) {
+    benchmarkPrints("printf, line buffered", "Output, line buffered", _IOLBF, OUTPUT_BUFFERING_LINE);
+    benchmarkPrints("printf, fully buffered", "Output, fully buffered", _IOFBF, OUTPUT_BUFFERING_FULL);
+}
@@ -0,0 +1,112 @@
+// memmem is a GNU extension.
+#define _GNU_SOURCE
+
+#include "benchmark.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "string_kernels.h"
+
+
+// The text fits in L2 cache, so that the kernels are measured rather than
+// the memory bandwidth.
+#define TEXT_SIZE (256 * 1024)
+#define PASSES    1024
+
+
+static uint8_t text[TEXT_SIZE];
+static uint8_t text_copy[TEXT_SIZE];
+
+// Words of lowercase letters in lines of about 60 bytes.
+static void fillText(void) {
+    srand(1);
+    for (size_t i = 0; i < TEXT_SIZE; ++i) {
+        int r = rand() % 64;
+        text[i] = (uint8_t)(r == 0 ? '\n' : r < 10 ? ' ' : 'a' + r % 26);
+    }
+    memcpy(text_copy, text, TEXT_SIZE);
+    text_copy[TEXT_SIZE - 1] ^= 1;
+}
+
+static void reportText(const char* case_name, double seconds) {
+    reportBenchmarkThroughput(case_name, TEXT_SIZE * PASSES, seconds);
+}
+
+#define TEXT_CASE(case_name, expression) \
+    BENCHMARK_CASE(case_name, PASSES, reportText, benchmark_sink += (uint64_t)(expression))
+
+#define TEXT_KERNEL_LEVELS(expression)                                 \
+    BENCHMARK_KERNEL_LEVELS(                                           \
+        stringKernelsLevel, setStringKernelsLevel, PASSES, reportText, \
+        benchmark_sink += (uint64_t)(expression)                       \
+    )
+
+
+BENCHMARK_NAIVE
+static int naiveCompare(const uint8_t* left, const uint8_t* right, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        if (left[i] != right[i]) {
+            return left[i] < right[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+BENCHMARK_NAIVE
+static size_t naiveFind(const uint8_t* haystack, size_t size, const uint8_t* needle, size_t needle_size) {
+    for (size_t i = 0; i + needle_size <= size; ++i) {
+        size_t j = 0;
+        while (j < needle_size && haystack[i + j] == needle[j]) {
+            ++j;
+        }
+        if (j == needle_size) {
+            return i;
+        }
+    }
+    return STRING_NOT_FOUND;
+}
+
+BENCHMARK_NAIVE
+static size_t naiveCountByte(const uint8_t* haystack, size_t size, uint8_t byte) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i) {
+        count += haystack[i] == byte;
+    }
+    return count;
+}
+
+
+BENCHMARK(CompareStrings) {
+    fillText();
+
+    TEXT_CASE("naive", naiveCompare(text, text_copy, TEXT_SIZE));
+    TEXT_CASE("strncmp", strncmp((const char*)text, (const char*)text_copy, TEXT_SIZE));
+    TEXT_CASE("memcmp", memcmp(text, text_copy, TEXT_SIZE));
+    TEXT_KERNEL_LEVELS(compareBytes(text, text_copy, TEXT_SIZE));
+}
+
+BENCHMARK(FindSubstring) {
+    fillText();
+    const uint8_t* needle = (const uint8_t*)"lala lang";
+    size_t needle_size = strlen((const char*)needle);
+
+    TEXT_CASE("naive", naiveFind(text, TEXT_SIZE, needle, needle_size));
+    TEXT_CASE("memmem", memmem(text, TEXT_SIZE, needle, needle_size) != NULL);
+    TEXT_KERNEL_LEVELS(findSubstring(text, TEXT_SIZE, needle, needle_size));
+}
+
+BENCHMARK(FindByte) {
+    fillText();
+
+    TEXT_CASE("naive", naiveFind(text, TEXT_SIZE, (const uint8_t*)"#", 1));
+    TEXT_CASE("memchr", memchr(text, '#', TEXT_SIZE) != NULL);
+    TEXT_KERNEL_LEVELS(findByte(text, TEXT_SIZE, '#'));
+}
+
+BENCHMARK(CountLines) {
+    fillText();
+
+    TEXT_CASE("naive", naiveCountByte(text, TEXT_SIZE, '\n'));
+    TEXT_KERNEL_LEVELS(countSubstring(text, TEXT_SIZE, (const uint8_t*)"\n", 1));
+}
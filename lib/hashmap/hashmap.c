@@ -35,14 +35,6 @@
 // │ Static function declarations │
 // └──────────────────────────────┘
 
-static bool storeInHashMapKnownHash(
-    HashMap* map,
-    const char* string,
-    size_t length,
-    uint32_t hash,
-    size_t value
-);
-
 static HashMapEntry* findEntry(
     const HashMap* map,
     const char* string,
@@ -166,6 +158,30 @@ bool getFromHashMap(
     return true;
 }
 
+bool getFromHashMapKnownHash(
+    const HashMap* map,
+    const char* key,
+    size_t key_length,
+    uint32_t hash,
+    size_t* value
+) {
+    ASSERT_HASH_MAP(map);
+    assert(hash == calculateHash(key, key_length));
+
+    if (map->count == 0)
+        return false;
+
+    HashMapEntry* entry = findEntry(map, key, key_length, hash);
+    if (entry->key == NULL) {
+        return false;
+    }
+
+    *value = entry->value;
+
+    ASSERT_HASH_MAP(map);
+    return true;
+}
+
 bool removeFromHashMap(HashMap* map, const char* key, size_t key_length) {
     ASSERT_HASH_MAP(map);
 
@@ -199,12 +215,46 @@ bool hashMapContains(const HashMap* map, const char* key, size_t key_length) {
     return entry->key != NULL;
 }
 
+void updateHashMapEntries(HashMap* map, HashMapEntryUpdate update, void* context) {
+    ASSERT_HASH_MAP(map);
+    assert(update);
 
-// ┌─────────────────────────────────┐
-// │ Static function implementations │
-// └─────────────────────────────────┘
+    size_t live_count = 0;
+    bool removed = false;
+    for (size_t i = 0; i < map->capacity; ++i) {
+        HashMapEntry* entry = &map->entries[i];
+        if (entry->key == NULL) {
+            continue;
+        }
+
+        if (update(entry, context)) {
+            assert(entry->key != NULL);
+            ++live_count;
+        } else {
+            entry->key = NULL;
+            entry->key_length = 1;
+            entry->hash = 0;
+            entry->value = 0;
+            removed = true;
+        }
+    }
 
-static bool storeInHashMapKnownHash(
+    // Rebuild the map without the tombstones.
+    if (removed) {
+        size_t new_capacity = map->capacity;
+        while (
+            new_capacity > INITIAL_HASH_MAP_SIZE &&
+            live_count < new_capacity / HASH_MAP_MIN_LOAD_DIVISOR
+        ) {
+            new_capacity /= 2;
+        }
+        resizeHashMap(map, new_capacity);
+    }
+
+    ASSERT_HASH_MAP(map);
+}
+
+bool storeInHashMapKnownHash(
     HashMap* map,
     const char* key,
     size_t key_length,
@@ -212,6 +262,7 @@ static bool storeInHashMapKnownHash(
     size_t value
 ) {
     ASSERT_HASH_MAP(map);
+    assert(hash == calculateHash(key, key_length));
 
     HashMapEntry* entry = findEntry(map, key, key_length, hash);
 
@@ -231,6 +282,11 @@ static bool storeInHashMapKnownHash(
     return is_new_key;
 }
 
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
 static HashMapEntry* findEntry(
     const HashMap* map,
     const char* key,
@@ -35,6 +35,11 @@ typedef struct {
     size_t count;
 } HashMap;
 
+// Is called for each entry by updateHashMapEntries. Returns false
+// if the entry is to be removed. May change the key pointer and the value,
+// but not the key itself.
+typedef bool (*HashMapEntryUpdate)(HashMapEntry* entry, void* context);
+
 
 // ┌───────────────────────┐
 // │ Function declarations │
@@ -70,6 +75,28 @@ bool hashMapContains(
     size_t key_length
 );
 
+// The same as the above, for callers that keep the hashes of their keys.
+bool storeInHashMapKnownHash(
+    HashMap* map,
+    const char* key,
+    size_t key_length,
+    uint32_t hash,
+    size_t value
+);
+bool getFromHashMapKnownHash(
+    const HashMap* map,
+    const char* key,
+    size_t key_length,
+    uint32_t hash,
+    size_t* value
+);
+
+/* Lets the map be used as a weak one, which doesn't own its keys and values.
+ * When their owner moves or frees them, for example during garbage
+ * collection, it updates or removes the entries with this function.
+ * */
+void updateHashMapEntries(HashMap* map, HashMapEntryUpdate update, void* context);
+
 
 #endif
 
@@ -0,0 +1,321 @@
+#include "array.h"
+
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define IS_ARRAY_REFERENCE_RULE(reference_rule)      \
+    (                                                \
+        (reference_rule) == REFERENCE_RULE_PLAIN ||  \
+        (reference_rule) == REFERENCE_RULE_REF_ARRAY \
+    )
+
+#define VALIDATE_ARRAY(array)                                            \
+    (                                                                    \
+        array &&                                                         \
+        array->value &&                                                  \
+        (                                                                \
+            IS_ARRAY_REFERENCE_RULE(array->reference_rule) ||            \
+            (                                                            \
+                array->reference_rule == REFERENCE_RULE_VIEW          && \
+                IS_ARRAY_REFERENCE_RULE(array->base->reference_rule)  && \
+                array->value + array->size <=                            \
+                    array->base->value + array->base->size               \
+            )                                                            \
+        )                                                                \
+    )
+
+#define ASSERT_ARRAY(array)                             \
+    if (!VALIDATE_ARRAY(array)) {                       \
+        fprintf(stderr,                                 \
+            "%s:%d, in %s:\nArray assertion failed.\n", \
+            __FILENAME__,                               \
+            __LINE__,                                   \
+            __FUNCTION_NAME__                           \
+        );                                              \
+        fdumpObject(stderr, array, 0);                  \
+        exit(1);                                        \
+    }
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+// The reference rule of the object with the items.
+static ReferenceRule arrayItemsReferenceRule(const Object* array);
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+size_t arrayCapacity(const Object* array) {
+    ASSERT_ARRAY(array);
+
+    if (array->reference_rule != REFERENCE_RULE_VIEW) {
+        return array->size;
+    }
+    return array->base->size - (size_t)(array->value - array->base->value);
+}
+
+bool reserveArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t capacity
+) {
+    assert(heap);
+    ASSERT_ARRAY(array);
+
+    size_t old_capacity = arrayCapacity(array);
+    if (old_capacity >= capacity) {
+        return true;
+    }
+
+    size_t new_capacity = capacity;
+    if (old_capacity <= SIZE_MAX / 2 && new_capacity < old_capacity * 2) {
+        new_capacity = old_capacity * 2;
+    }
+    if (new_capacity < ARRAY_MIN_CAPACITY) {
+        new_capacity = ARRAY_MIN_CAPACITY;
+    }
+
+    // Grow the buffer in place, or at least to the capacity asked for.
+    if (array->reference_rule == REFERENCE_RULE_VIEW) {
+        Object* buffer = array->base;
+        size_t offset = (size_t)(array->value - buffer->value);
+        size_t old_size = buffer->size;
+        if (
+            growObjectInPlace(heap, buffer, offset + new_capacity) ||
+            growObjectInPlace(heap, buffer, offset + capacity)
+        ) {
+            if (buffer->reference_rule == REFERENCE_RULE_REF_ARRAY) {
+                memset(buffer->value + old_size, 0, buffer->size - old_size);
+            }
+            ASSERT_ARRAY(array);
+            return true;
+        }
+    }
+
+    ReferenceRule reference_rule = arrayItemsReferenceRule(array);
+
+    // A pinned view keeps its buffer alive, and its value
+    // is updated if the buffer is moved.
+    dontCollectObjectOnNextGC(heap, array);
+    Object* buffer = allocateEmptyObject(
+        heap,
+        stack,
+        stack_references_positions,
+        reference_rule,
+        NULL,
+        new_capacity
+    );
+    if (!buffer) {
+        return false;
+    }
+    memcpy(buffer->value, array->value, array->size);
+    if (reference_rule == REFERENCE_RULE_REF_ARRAY) {
+        memset(buffer->value + array->size, 0, new_capacity - array->size);
+    }
+
+    // The old value of an array that wasn't a view
+    // is freed by the next gc.
+    array->reference_rule = REFERENCE_RULE_VIEW;
+    array->base = buffer;
+    array->value = buffer->value;
+
+    ASSERT_ARRAY(array);
+    return true;
+}
+
+void makeArrayOfReferences(Object* array) {
+    ASSERT_ARRAY(array);
+
+    Object* items = array->reference_rule == REFERENCE_RULE_VIEW ? array->base : array;
+    if (items->reference_rule == REFERENCE_RULE_PLAIN) {
+        assert(array->size == 0);
+        items->reference_rule = REFERENCE_RULE_REF_ARRAY;
+        memset(items->value, 0, items->size);
+    }
+
+    ASSERT_ARRAY(array);
+}
+
+void truncateArray(Object* array, size_t size) {
+    ASSERT_ARRAY(array);
+    assert(size <= array->size);
+
+    // The whole buffer is traced, so the dropped references are cleared
+    // to let them be collected.
+    if (
+        array->reference_rule == REFERENCE_RULE_VIEW &&
+        array->base->reference_rule == REFERENCE_RULE_REF_ARRAY
+    ) {
+        memset(array->value + size, 0, array->size - size);
+    }
+    array->size = size;
+
+    ASSERT_ARRAY(array);
+}
+
+void fillArray(Object* array, size_t start, size_t end, const void* item, size_t item_size) {
+    ASSERT_ARRAY(array);
+    assert(item);
+    assert(start <= end && end <= array->size);
+    assert(item_size > 0 && (end - start) % item_size == 0);
+
+    if (start == end) {
+        return;
+    }
+    if (item_size == 1) {
+        memset(array->value + start, *(const uint8_t*)item, end - start);
+        return;
+    }
+
+    // Double the filled part up to a chunk that stays in L1 cache,
+    // then copy that chunk, so that the rest is written without reading
+    // the memory that was just written.
+    uint8_t* destination = array->value + start;
+    size_t size = end - start;
+    size_t chunk_size = ARRAY_FILL_CHUNK_SIZE / item_size * item_size;
+    memcpy(destination, item, item_size);
+    size_t filled = item_size;
+    while (filled < size) {
+        size_t chunk = filled < chunk_size ? filled : chunk_size;
+        if (chunk > size - filled) {
+            chunk = size - filled;
+        }
+        memcpy(destination + filled, destination, chunk);
+        filled += chunk;
+    }
+}
+
+Object* sliceArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t start,
+    size_t end
+) {
+    assert(heap);
+    ASSERT_ARRAY(array);
+    assert(start <= end && end <= array->size);
+
+    dontCollectObjectOnNextGC(heap, array);
+    Object* slice = allocateEmptyObject(
+        heap,
+        stack,
+        stack_references_positions,
+        arrayItemsReferenceRule(array),
+        NULL,
+        end - start
+    );
+    if (!slice) {
+        return NULL;
+    }
+    memcpy(slice->value, array->value + start, end - start);
+
+    ASSERT_ARRAY(slice);
+    return slice;
+}
+
+Object* concatenateArrays(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    Object* right
+) {
+    assert(heap);
+    ASSERT_ARRAY(left);
+    ASSERT_ARRAY(right);
+
+    if (left->size > SIZE_MAX / 4 - right->size) {
+        return NULL;
+    }
+
+    // An empty array literal [] is plain whatever its items are.
+    ReferenceRule reference_rule = arrayItemsReferenceRule(left);
+    if (arrayItemsReferenceRule(right) == REFERENCE_RULE_REF_ARRAY) {
+        reference_rule = REFERENCE_RULE_REF_ARRAY;
+    }
+
+    dontCollectObjectOnNextGC(heap, left);
+    dontCollectObjectOnNextGC(heap, right);
+    Object* result = allocateEmptyObject(
+        heap,
+        stack,
+        stack_references_positions,
+        reference_rule,
+        NULL,
+        left->size + right->size
+    );
+    if (!result) {
+        return NULL;
+    }
+    memcpy(result->value, left->value, left->size);
+    memcpy(result->value + left->size, right->value, right->size);
+
+    ASSERT_ARRAY(result);
+    return result;
+}
+
+Object* repeatArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t times
+) {
+    assert(heap);
+    ASSERT_ARRAY(array);
+    assert(times == 0 || array->size <= SIZE_MAX / times);
+
+    bool is_zero = true;
+    for (size_t i = 0; i < array->size && is_zero; ++i) {
+        is_zero = array->value[i] == 0;
+    }
+
+    dontCollectObjectOnNextGC(heap, array);
+    Object* result = (is_zero ? allocateZeroedObject : allocateEmptyObject)(
+        heap,
+        stack,
+        stack_references_positions,
+        arrayItemsReferenceRule(array),
+        NULL,
+        array->size * times
+    );
+    if (!result) {
+        return NULL;
+    }
+    if (!is_zero) {
+        fillArray(result, 0, result->size, array->value, array->size);
+    }
+
+    ASSERT_ARRAY(result);
+    return result;
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static ReferenceRule arrayItemsReferenceRule(const Object* array) {
+    return (
+        array->reference_rule == REFERENCE_RULE_VIEW
+            ? array->base->reference_rule
+            : array->reference_rule
+    );
+}
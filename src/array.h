@@ -0,0 +1,99 @@
+#ifndef lala_array_h
+#define lala_array_h
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "heap.h"
+#include "stack.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Size of the first buffer of an array that grows, in bytes.
+#define ARRAY_MIN_CAPACITY 64
+
+// Size of the pattern that's copied to fill arrays with wide items.
+#define ARRAY_FILL_CHUNK_SIZE 4096
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+/* Arrays are plain or ref array objects with the items as their values.
+ * An array that grows becomes a view of a buffer with spare capacity,
+ * so that the array object itself isn't moved and the references to it
+ * stay valid. The spare capacity of a buffer of references is zeroed.
+ * Sizes and capacities are in bytes.
+ * */
+size_t arrayCapacity(const Object* array);
+
+/* Makes sure the array may grow to capacity bytes without allocating.
+ * The capacity at least doubles, so that growing an item at a time takes
+ * amortized constant time. The buffer is grown in place if the heap allows
+ * it, otherwise the items are copied to a new one. The array isn't moved
+ * by the allocation, but other objects may be.
+ * Returns false if the allocation fails.
+ * */
+bool reserveArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t capacity
+);
+
+// The item type of an empty array literal [] isn't known, so it's
+// a plain array until a reference is pushed onto it.
+void makeArrayOfReferences(Object* array);
+
+// Drops the items past size bytes, the capacity is kept.
+void truncateArray(Object* array, size_t size);
+
+/* Sets the bytes [start, end) of the array to copies of an item.
+ * The item is written once and then copied in chunks, so that filling
+ * runs at memcpy speed.
+ * */
+void fillArray(Object* array, size_t start, size_t end, const void* item, size_t item_size);
+
+/* Return a new array with the bytes [start, end) of the array,
+ * or with the items of left followed by the items of right.
+ * The result is an array of references if the items are references.
+ * The operands are pinned, so they aren't moved by the allocation.
+ * Return NULL if the allocation fails.
+ * */
+Object* sliceArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t start,
+    size_t end
+);
+Object* concatenateArrays(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    Object* right
+);
+
+/* Returns a new array with the items of the array repeated times times,
+ * as [x] * n does. Zero items aren't written but allocated zeroed,
+ * and other items are filled in like fillArray does.
+ * Returns NULL if the allocation fails.
+ * */
+Object* repeatArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t times
+);
+
+
+#endif
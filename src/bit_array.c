@@ -0,0 +1,341 @@
+#include "bit_array.h"
+
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "array.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Bits are moved in chunks that fit in a word
+// together with the up to 7 bits before them in their first byte.
+#define BITS_CHUNK_LENGTH 56
+
+#define VALIDATE_BIT_ARRAY(array)                          \
+    (                                                      \
+        (array) &&                                         \
+        (array)->unused_bits < 8 &&                        \
+        ((array)->size > 0 || (array)->unused_bits == 0)   \
+    )
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+// Up to 8 bytes as a little-endian number, the missing ones are zero.
+static uint64_t loadWord(const uint8_t* bytes, size_t size);
+static void storeWord(uint8_t* bytes, size_t size, uint64_t word);
+
+// Up to BITS_CHUNK_LENGTH items from the index on.
+static uint64_t readBits(const Object* array, size_t index, size_t length);
+static void writeBits(Object* array, size_t index, size_t length, uint64_t bits);
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+size_t bitArrayLength(const Object* array) {
+    assert(VALIDATE_BIT_ARRAY(array));
+    return 8 * array->size - array->unused_bits;
+}
+
+void setBitArrayLength(Object* array, size_t length) {
+    assert(VALIDATE_BIT_ARRAY(array));
+
+    size_t size = BIT_ARRAY_SIZE(length);
+    assert(size <= arrayCapacity(array));
+
+    // The spare capacity of a buffer isn't zeroed.
+    if (size > array->size) {
+        memset(array->value + array->size, 0, size - array->size);
+    }
+    array->size = size;
+    array->unused_bits = (uint8_t)(8 * size - length);
+    if (length % 8 != 0) {
+        array->value[size - 1] &= (uint8_t)((1u << (length % 8)) - 1);
+    }
+}
+
+Object* allocateBitArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    size_t length
+) {
+    assert(heap);
+
+    Object* array = allocateZeroedObject(
+        heap,
+        stack,
+        stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        BIT_ARRAY_SIZE(length)
+    );
+    if (!array) {
+        return NULL;
+    }
+    array->unused_bits = (uint8_t)(8 * array->size - length);
+    return array;
+}
+
+Object* packBits(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    const uint8_t* bools,
+    size_t length
+) {
+    assert(heap);
+    assert(bools || length == 0);
+
+    Object* array = allocateBitArray(heap, stack, stack_references_positions, length);
+    if (!array) {
+        return NULL;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        array->value[i / 8] |= (uint8_t)((bools[i] != 0) << (i % 8));
+    }
+    return array;
+}
+
+void fillBits(Object* array, size_t start, size_t end, bool value) {
+    assert(start <= end && end <= bitArrayLength(array));
+
+    if (start == end) {
+        return;
+    }
+
+    uint8_t byte = value ? 0xFF : 0;
+    size_t first = start / 8;
+    size_t last = (end - 1) / 8;
+    uint8_t first_mask = (uint8_t)(0xFF << (start % 8));
+    uint8_t last_mask = (uint8_t)(0xFF >> (7 - (end - 1) % 8));
+    if (first == last) {
+        first_mask &= last_mask;
+    }
+
+    array->value[first] = (uint8_t)((array->value[first] & ~first_mask) | (byte & first_mask));
+    if (first == last) {
+        return;
+    }
+    memset(array->value + first + 1, byte, last - first - 1);
+    array->value[last] = (uint8_t)((array->value[last] & ~last_mask) | (byte & last_mask));
+}
+
+void copyBits(Object* destination, size_t at, const Object* source, size_t start, size_t end) {
+    assert(start <= end && end <= bitArrayLength(source));
+    assert(at + (end - start) <= bitArrayLength(destination));
+
+    size_t length = end - start;
+    // The items are copied from the end if they move to the right
+    // in the same array, so that they're read before they're overwritten.
+    bool backwards = destination->value == source->value && at > start;
+
+    // Whole bytes of byte-aligned ranges are moved as they are.
+    if (at % 8 == 0 && start % 8 == 0) {
+        size_t moved = length / 8 * 8;
+        size_t rest = length - moved;
+        if (backwards && rest > 0) {
+            writeBits(destination, at + moved, rest, readBits(source, start + moved, rest));
+        }
+        memmove(destination->value + at / 8, source->value + start / 8, moved / 8);
+        if (!backwards && rest > 0) {
+            writeBits(destination, at + moved, rest, readBits(source, start + moved, rest));
+        }
+        return;
+    }
+
+    if (backwards) {
+        for (size_t copied = 0; copied < length;) {
+            size_t chunk = length - copied < BITS_CHUNK_LENGTH ? length - copied : BITS_CHUNK_LENGTH;
+            copied += chunk;
+            writeBits(destination, at + length - copied, chunk, readBits(source, start + length - copied, chunk));
+        }
+        return;
+    }
+    for (size_t copied = 0; copied < length;) {
+        size_t chunk = length - copied < BITS_CHUNK_LENGTH ? length - copied : BITS_CHUNK_LENGTH;
+        writeBits(destination, at + copied, chunk, readBits(source, start + copied, chunk));
+        copied += chunk;
+    }
+}
+
+Object* sliceBits(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t start,
+    size_t end
+) {
+    assert(heap);
+    assert(start <= end && end <= bitArrayLength(array));
+
+    dontCollectObjectOnNextGC(heap, array);
+    Object* slice = allocateBitArray(heap, stack, stack_references_positions, end - start);
+    if (!slice) {
+        return NULL;
+    }
+    copyBits(slice, 0, array, start, end);
+    return slice;
+}
+
+Object* concatenateBits(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    Object* right
+) {
+    assert(heap);
+
+    size_t left_length = bitArrayLength(left);
+    size_t right_length = bitArrayLength(right);
+    if (left_length > SIZE_MAX / 4 - right_length) {
+        return NULL;
+    }
+
+    dontCollectObjectOnNextGC(heap, left);
+    dontCollectObjectOnNextGC(heap, right);
+    Object* result = allocateBitArray(heap, stack, stack_references_positions, left_length + right_length);
+    if (!result) {
+        return NULL;
+    }
+    copyBits(result, 0, left, 0, left_length);
+    copyBits(result, left_length, right, 0, right_length);
+    return result;
+}
+
+Object* repeatBits(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t times
+) {
+    assert(heap);
+
+    size_t length = bitArrayLength(array);
+    assert(times == 0 || length <= SIZE_MAX / 8 / times);
+    size_t trues_count = countBits(array);
+
+    // The result is allocated zeroed, so falses aren't written.
+    dontCollectObjectOnNextGC(heap, array);
+    Object* result = allocateBitArray(heap, stack, stack_references_positions, length * times);
+    if (!result || trues_count == 0) {
+        return result;
+    }
+    if (trues_count == length) {
+        fillBits(result, 0, length * times, true);
+        return result;
+    }
+
+    // The items written so far are copied after themselves.
+    copyBits(result, 0, array, 0, length);
+    for (size_t filled = length; filled < length * times;) {
+        size_t chunk = filled < length * times - filled ? filled : length * times - filled;
+        copyBits(result, filled, result, 0, chunk);
+        filled += chunk;
+    }
+    return result;
+}
+
+size_t countBits(const Object* array) {
+    assert(VALIDATE_BIT_ARRAY(array));
+
+    size_t count = 0;
+    for (size_t i = 0; i < array->size; i += sizeof(uint64_t)) {
+        size_t size = array->size - i < sizeof(uint64_t) ? array->size - i : sizeof(uint64_t);
+        count += (size_t)__builtin_popcountll(loadWord(array->value + i, size));
+    }
+    return count;
+}
+
+size_t findBit(const Object* array, size_t start) {
+    size_t length = bitArrayLength(array);
+
+    // The unused bits are zero, so a bit found is an item.
+    for (size_t index = start; index < length;) {
+        size_t byte = index / 8;
+        size_t size = array->size - byte < sizeof(uint64_t) ? array->size - byte : sizeof(uint64_t);
+        uint64_t word = loadWord(array->value + byte, size) >> (index % 8);
+        if (word != 0) {
+            return index + (size_t)__builtin_ctzll(word);
+        }
+        index = 8 * (byte + size);
+    }
+    return length;
+}
+
+void combineBits(Object* destination, const Object* source, BitwiseOperation operation) {
+    assert(bitArrayLength(destination) == bitArrayLength(source));
+
+    for (size_t i = 0; i < destination->size; i += sizeof(uint64_t)) {
+        size_t size = destination->size - i < sizeof(uint64_t) ? destination->size - i : sizeof(uint64_t);
+        uint64_t left = loadWord(destination->value + i, size);
+        uint64_t right = loadWord(source->value + i, size);
+        switch (operation) {
+            case BITWISE_AND: left &= right; break;
+            case BITWISE_OR:  left |= right; break;
+            case BITWISE_XOR: left ^= right; break;
+        }
+        storeWord(destination->value + i, size, left);
+    }
+}
+
+void sortBits(Object* array) {
+    size_t length = bitArrayLength(array);
+    size_t trues_count = countBits(array);
+    fillBits(array, 0, length - trues_count, false);
+    fillBits(array, length - trues_count, length, true);
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static uint64_t loadWord(const uint8_t* bytes, size_t size) {
+    assert(size <= sizeof(uint64_t));
+
+    uint64_t word = 0;
+    memcpy(&word, bytes, size);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+static void storeWord(uint8_t* bytes, size_t size, uint64_t word) {
+    assert(size <= sizeof(uint64_t));
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    memcpy(bytes, &word, size);
+}
+
+static uint64_t readBits(const Object* array, size_t index, size_t length) {
+    assert(length <= BITS_CHUNK_LENGTH);
+
+    uint64_t word = loadWord(array->value + index / 8, BIT_ARRAY_SIZE(index % 8 + length));
+    return (word >> (index % 8)) & ((UINT64_C(1) << length) - 1);
+}
+
+static void writeBits(Object* array, size_t index, size_t length, uint64_t bits) {
+    assert(length <= BITS_CHUNK_LENGTH);
+
+    size_t size = BIT_ARRAY_SIZE(index % 8 + length);
+    uint64_t mask = ((UINT64_C(1) << length) - 1) << (index % 8);
+    uint64_t word = loadWord(array->value + index / 8, size);
+    word = (word & ~mask) | (bits << (index % 8));
+    storeWord(array->value + index / 8, size, word);
+}
@@ -0,0 +1,115 @@
+#ifndef lala_bit_array_h
+#define lala_bit_array_h
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "heap.h"
+#include "stack.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Number of bytes of a bit array of the length.
+#define BIT_ARRAY_SIZE(length) (((length) + 7) / 8)
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+typedef enum {
+    BITWISE_AND,
+    BITWISE_OR,
+    BITWISE_XOR,
+} BitwiseOperation;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+/* Arrays of bools are bit arrays: the item i is the bit i % 8 of the byte
+ * i / 8. They are arrays as array.h describes, with sizes in bytes,
+ * and the unused_bits field of the array object tells how many bits
+ * of the last byte aren't items. Those bits are always zero, so that
+ * whole bytes and words are counted and combined as they are.
+ * Lengths and indices are in items.
+ * */
+size_t bitArrayLength(const Object* array);
+
+// The capacity must be enough for the length. New bits are zero.
+void setBitArrayLength(Object* array, size_t length);
+
+/* Returns a new bit array of the length with all the items false.
+ * Returns NULL if the allocation fails.
+ * */
+Object* allocateBitArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    size_t length
+);
+
+/* Returns a new bit array with the bools, a byte each.
+ * Returns NULL if the allocation fails.
+ * */
+Object* packBits(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    const uint8_t* bools,
+    size_t length
+);
+
+// Sets the items [start, end) to the value.
+void fillBits(Object* array, size_t start, size_t end, bool value);
+
+// Copies the items [start, end) of the source to the destination
+// from the index at on. The ranges may overlap.
+void copyBits(Object* destination, size_t at, const Object* source, size_t start, size_t end);
+
+/* Bit array versions of sliceArray, concatenateArrays and repeatArray.
+ * Return NULL if the allocation fails.
+ * */
+Object* sliceBits(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t start,
+    size_t end
+);
+Object* concatenateBits(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    Object* right
+);
+Object* repeatBits(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    size_t times
+);
+
+// Number of true items.
+size_t countBits(const Object* array);
+
+// Index of the first true item from start on, or the length if there's none.
+size_t findBit(const Object* array, size_t start);
+
+// Combines the items of the destination with the items of the source,
+// a word at a time. The arrays must be of the same length.
+void combineBits(Object* destination, const Object* source, BitwiseOperation operation);
+
+// Puts the false items before the true ones.
+void sortBits(Object* array);
+
+
+#endif
@@ -0,0 +1,135 @@
+#include "builtin.h"
+
+
+#include <assert.h>
+#include <string.h>
+
+
+// ┌───────────┐
+// │ Constants │
+// └───────────┘
+
+static const Builtin BUILTINS[] = {
+    BUILTIN_ADD_ITEMS,
+    BUILTIN_AND_ITEMS,
+    BUILTIN_ARGMAX,
+    BUILTIN_ARGMIN,
+    BUILTIN_COLUMNS,
+    BUILTIN_COMPARE,
+    BUILTIN_CONCAT,
+    BUILTIN_COPY,
+    BUILTIN_COPY_ITEMS,
+    BUILTIN_COUNT,
+    BUILTIN_COUNT_TRUE,
+    BUILTIN_DELETE,
+    BUILTIN_DIVIDE_ITEMS,
+    BUILTIN_DOT,
+    BUILTIN_FILL,
+    BUILTIN_FIND,
+    BUILTIN_FIND_BYTE,
+    BUILTIN_FIND_TRUE,
+    BUILTIN_LENGTH,
+    BUILTIN_LESS_ITEMS,
+    BUILTIN_MATRIX,
+    BUILTIN_MAX,
+    BUILTIN_MIN,
+    BUILTIN_MULTIPLY_ADD_ITEMS,
+    BUILTIN_MULTIPLY_ITEMS,
+    BUILTIN_OR_ITEMS,
+    BUILTIN_POP,
+    BUILTIN_PUSH,
+    BUILTIN_RESERVE,
+    BUILTIN_ROWS,
+    BUILTIN_SATURATING_SUM,
+    BUILTIN_SCALE_ITEMS,
+    BUILTIN_SELECT_ITEMS,
+    BUILTIN_SLICE,
+    BUILTIN_SORT,
+    BUILTIN_SPLIT,
+    BUILTIN_SUBSTRING,
+    BUILTIN_SUBTRACT_ITEMS,
+    BUILTIN_SUM,
+    BUILTIN_TO_ARRAY,
+    BUILTIN_TO_FLOAT,
+    BUILTIN_TO_FLOAT32,
+    BUILTIN_TO_INT,
+    BUILTIN_TO_INT16,
+    BUILTIN_TO_INT8,
+    BUILTIN_TO_MATRIX,
+    BUILTIN_TRUNCATE,
+    BUILTIN_XOR_ITEMS,
+};
+#define BUILTINS_COUNT (sizeof(BUILTINS) / sizeof(BUILTINS[0]))
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+const char* builtinName(Builtin builtin) {
+    switch (builtin) {
+        case BUILTIN_ADD_ITEMS:          return "add-items";
+        case BUILTIN_AND_ITEMS:          return "and-items";
+        case BUILTIN_ARGMAX:             return "argmax";
+        case BUILTIN_ARGMIN:             return "argmin";
+        case BUILTIN_COLUMNS:            return "columns";
+        case BUILTIN_COMPARE:            return "compare";
+        case BUILTIN_CONCAT:             return "concat";
+        case BUILTIN_COPY:               return "copy";
+        case BUILTIN_COPY_ITEMS:         return "copy-items";
+        case BUILTIN_COUNT:              return "count";
+        case BUILTIN_COUNT_TRUE:         return "count-true";
+        case BUILTIN_DELETE:             return "delete";
+        case BUILTIN_DIVIDE_ITEMS:       return "divide-items";
+        case BUILTIN_DOT:                return "dot";
+        case BUILTIN_FILL:               return "fill";
+        case BUILTIN_FIND:               return "find";
+        case BUILTIN_FIND_BYTE:          return "find-byte";
+        case BUILTIN_FIND_TRUE:          return "find-true";
+        case BUILTIN_LENGTH:             return "length";
+        case BUILTIN_LESS_ITEMS:         return "less-items";
+        case BUILTIN_MATRIX:             return "matrix";
+        case BUILTIN_MAX:                return "max";
+        case BUILTIN_MIN:                return "min";
+        case BUILTIN_MULTIPLY_ADD_ITEMS: return "multiply-add-items";
+        case BUILTIN_MULTIPLY_ITEMS:     return "multiply-items";
+        case BUILTIN_OR_ITEMS:           return "or-items";
+        case BUILTIN_POP:                return "pop";
+        case BUILTIN_PUSH:               return "push";
+        case BUILTIN_RESERVE:            return "reserve";
+        case BUILTIN_ROWS:               return "rows";
+        case BUILTIN_SATURATING_SUM:     return "saturating-sum";
+        case BUILTIN_SCALE_ITEMS:        return "scale-items";
+        case BUILTIN_SELECT_ITEMS:       return "select-items";
+        case BUILTIN_SLICE:              return "slice";
+        case BUILTIN_SORT:               return "sort";
+        case BUILTIN_SPLIT:              return "split";
+        case BUILTIN_SUBSTRING:          return "substring";
+        case BUILTIN_SUBTRACT_ITEMS:     return "subtract-items";
+        case BUILTIN_SUM:                return "sum";
+        case BUILTIN_TO_ARRAY:           return "to-array";
+        case BUILTIN_TO_FLOAT:           return "to-float";
+        case BUILTIN_TO_FLOAT32:         return "to-float32";
+        case BUILTIN_TO_INT:             return "to-int";
+        case BUILTIN_TO_INT16:           return "to-int16";
+        case BUILTIN_TO_INT8:            return "to-int8";
+        case BUILTIN_TO_MATRIX:          return "to-matrix";
+        case BUILTIN_TRUNCATE:           return "truncate";
+        case BUILTIN_XOR_ITEMS:          return "xor-items";
+        default:                         return "INVALID BUILTIN";
+    }
+}
+
+bool findBuiltin(const char* name, size_t length, Builtin* builtin) {
+    assert(name);
+    assert(builtin);
+
+    for (size_t i = 0; i < BUILTINS_COUNT; ++i) {
+        const char* builtin_name = builtinName(BUILTINS[i]);
+        if (strlen(builtin_name) == length && strncmp(builtin_name, name, length) == 0) {
+            *builtin = BUILTINS[i];
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,78 @@
+#ifndef lala_builtin_h
+#define lala_builtin_h
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+// Functions provided by the language. They are called like functions,
+// but are compiled into op codes of their own. A variable with the same
+// name hides a builtin.
+typedef enum {
+    BUILTIN_ADD_ITEMS,
+    BUILTIN_AND_ITEMS,
+    BUILTIN_ARGMAX,
+    BUILTIN_ARGMIN,
+    BUILTIN_COLUMNS,
+    BUILTIN_COMPARE,
+    BUILTIN_CONCAT,
+    BUILTIN_COPY,
+    BUILTIN_COPY_ITEMS,
+    BUILTIN_COUNT,
+    BUILTIN_COUNT_TRUE,
+    BUILTIN_DELETE,
+    BUILTIN_DIVIDE_ITEMS,
+    BUILTIN_DOT,
+    BUILTIN_FILL,
+    BUILTIN_FIND,
+    BUILTIN_FIND_BYTE,
+    BUILTIN_FIND_TRUE,
+    BUILTIN_LENGTH,
+    BUILTIN_LESS_ITEMS,
+    BUILTIN_MATRIX,
+    BUILTIN_MAX,
+    BUILTIN_MIN,
+    BUILTIN_MULTIPLY_ADD_ITEMS,
+    BUILTIN_MULTIPLY_ITEMS,
+    BUILTIN_OR_ITEMS,
+    BUILTIN_POP,
+    BUILTIN_PUSH,
+    BUILTIN_RESERVE,
+    BUILTIN_ROWS,
+    BUILTIN_SATURATING_SUM,
+    BUILTIN_SCALE_ITEMS,
+    BUILTIN_SELECT_ITEMS,
+    BUILTIN_SLICE,
+    BUILTIN_SORT,
+    BUILTIN_SPLIT,
+    BUILTIN_SUBSTRING,
+    BUILTIN_SUBTRACT_ITEMS,
+    BUILTIN_SUM,
+    BUILTIN_TO_ARRAY,
+    BUILTIN_TO_FLOAT,
+    BUILTIN_TO_FLOAT32,
+    BUILTIN_TO_INT,
+    BUILTIN_TO_INT16,
+    BUILTIN_TO_INT8,
+    BUILTIN_TO_MATRIX,
+    BUILTIN_TRUNCATE,
+    BUILTIN_XOR_ITEMS,
+} Builtin;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+const char* builtinName(Builtin builtin);
+
+// Returns false if there's no builtin with the name.
+bool findBuiltin(const char* name, size_t length, Builtin* builtin);
+
+
+#endif
@@ -2,6 +2,7 @@
 
 
 #include <assert.h>
+#include <string.h>
 
 
 // ┌──────────────────┐
@@ -30,9 +31,17 @@ static size_t getConstantValuesSize(const Constants* constants) {
 
 uint8_t addConstant(Constants* constants, uint8_t length, const uint8_t* value) {
     assert(constants);
-    assert(constants->count < MAX_CONSTANTS);
     assert(value);
 
+    // Equal constants share an index, so that they are the same object in VM.
+    for (uint8_t i = 0; i < constants->count; ++i) {
+        const Constant* constant = &constants->constants[i];
+        if (constant->length == length && memcmp(constant->value, value, length) == 0) {
+            return i;
+        }
+    }
+
+    assert(constants->count < MAX_CONSTANTS);
     constants->constants[constants->count].length = length;
     constants->constants[constants->count].value = value;
     constants->count += 1;
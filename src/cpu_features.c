@@ -0,0 +1,47 @@
+#include "cpu_features.h"
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+bool cpuSupportsLevel(CpuLevel level) {
+    switch (level) {
+        case CPU_LEVEL_SCALAR:
+            return true;
+#ifdef CPU_FEATURES_X86
+        case CPU_LEVEL_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case CPU_LEVEL_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+bool cpuSupportsFma(void) {
+#ifdef CPU_FEATURES_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+const char* cpuLevelName(CpuLevel level) {
+    switch (level) {
+        case CPU_LEVEL_SCALAR: return "scalar";
+        case CPU_LEVEL_SSE2:   return "sse2";
+        case CPU_LEVEL_AVX2:   return "avx2";
+        default:               return "INVALID CPU LEVEL";
+    }
+}
+
+void selectBestCpuLevel(bool (*set_level)(CpuLevel level)) {
+    if (!set_level(CPU_LEVEL_AVX2) && !set_level(CPU_LEVEL_SSE2)) {
+        set_level(CPU_LEVEL_SCALAR);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef lala_cpu_features_h
+#define lala_cpu_features_h
+
+
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Attributes of the functions that use the instruction sets.
+#define TARGET_SSE2     __attribute__((target("sse2")))
+#define TARGET_AVX2     __attribute__((target("avx2")))
+#define TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+
+// The kernels of a module, selected on the first call.
+#define SELECTED_KERNELS(kernels, select_best_kernels) ((kernels) ? (kernels) : (select_best_kernels)())
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+// Instruction sets the kernels are implemented with.
+typedef enum {
+    CPU_LEVEL_SCALAR,
+    CPU_LEVEL_SSE2,
+    CPU_LEVEL_AVX2,
+} CpuLevel;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+/* Kernel modules, like string_kernels.h, have a version of every kernel
+ * for every level. The best level the CPU supports is selected with CPUID
+ * on the first call of a kernel. Setting a level is meant for tests and
+ * benchmarks, and fails if the CPU doesn't support it.
+ * */
+bool cpuSupportsLevel(CpuLevel level);
+bool cpuSupportsFma(void);
+const char* cpuLevelName(CpuLevel level);
+
+// Tries the levels from the best one down, until set_level accepts one.
+void selectBestCpuLevel(bool (*set_level)(CpuLevel level));
+
+
+#endif
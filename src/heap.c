@@ -2,10 +2,15 @@
 
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "debug.h"
+#include "map.h"
+#include "string_kernels.h"
 
 
 // ┌────────┐
@@ -18,14 +23,21 @@
         (                                                         \
             object->reference_rule == REFERENCE_RULE_PLAIN     || \
             object->reference_rule == REFERENCE_RULE_REF_ARRAY || \
-            object->reference_rule == REFERENCE_RULE_CUSTOM       \
+            object->reference_rule == REFERENCE_RULE_CUSTOM    || \
+            object->reference_rule == REFERENCE_RULE_VIEW      || \
+            object->reference_rule == REFERENCE_RULE_MAP_TABLE    \
         ) &&                                                      \
         (                                                         \
             object->reference_rule != REFERENCE_RULE_CUSTOM ||    \
             object->custom_reference_rule                         \
         ) &&                                                      \
+        (                                                         \
+            object->reference_rule != REFERENCE_RULE_VIEW ||      \
+            object->base                                          \
+        ) &&                                                      \
         (                                                         \
             object->reference_rule == REFERENCE_RULE_CUSTOM ||    \
+            object->reference_rule == REFERENCE_RULE_VIEW   ||    \
             !object->custom_reference_rule                        \
         ) &&                                                      \
         object->value                                             \
@@ -44,26 +56,118 @@
     }
 
 
+
+#define SEGMENT_OF(object) \
+    ((Segment*)((uintptr_t)(object) & ~(uintptr_t)(HEAP_SEGMENT_SIZE - 1)))
+
+#define BYTES_TO_GRANULES(bytes) \
+    (((bytes) + HEAP_GRANULE_SIZE - 1) / HEAP_GRANULE_SIZE)
+
+// The first granule of a segment that's not occupied by its header.
+#define SEGMENT_FIRST_GRANULE BYTES_TO_GRANULES(sizeof(Segment))
+#define SEGMENT_PAYLOAD_SIZE \
+    ((HEAP_SEGMENT_GRANULES - SEGMENT_FIRST_GRANULE) * HEAP_GRANULE_SIZE)
+
+#define GRANULE_ADDRESS(segment, granule) \
+    ((uint8_t*)(segment) + (granule) * HEAP_GRANULE_SIZE)
+
+#define ADDRESS_GRANULE(segment, address) \
+    ((size_t)((const uint8_t*)(address) - (const uint8_t*)(segment)) / HEAP_GRANULE_SIZE)
+
+#define LOW_BITS(bit) (((uint64_t)1 << ((bit) % 64)) - 1)
+
+#define TEST_BIT(bitmap, bit) ((bitmap)[(bit) / 64] & ((uint64_t)1 << ((bit) % 64)))
+#define SET_BIT(bitmap, bit)  ((bitmap)[(bit) / 64] |= ((uint64_t)1 << ((bit) % 64)))
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+struct FreeChunk {
+    FreeChunk* next;
+    size_t granules;
+};
+
+
 // ┌───────────────────────┐
 // │ Constants definitions │
 // └───────────────────────┘
 
-Object OBJECT_STRING_TRUE  = { REFERENCE_RULE_PLAIN, NULL, 4, (uint8_t*)"true",  NULL, true };
-Object OBJECT_STRING_FALSE = { REFERENCE_RULE_PLAIN, NULL, 5, (uint8_t*)"false", NULL, true };
+Object OBJECT_STRING_TRUE  = { REFERENCE_RULE_PLAIN, true, false, false, 0, 0, { NULL }, 4, (uint8_t*)"true"  };
+Object OBJECT_STRING_FALSE = { REFERENCE_RULE_PLAIN, true, false, false, 0, 0, { NULL }, 5, (uint8_t*)"false" };
+Object OBJECT_STRING_EMPTY = { REFERENCE_RULE_PLAIN, true, false, false, 0, 0, { NULL }, 0, (uint8_t*)""      };
 
 
 // ┌──────────────────────────────┐
 // │ Static function declarations │
 // └──────────────────────────────┘
 
+static void fdumpSegment(FILE* out, Segment* segment, int padding);
+
 static void collectGarbage(
     Heap* heap,
-    const Stack* stack,
+    Stack* stack,
+    const Stack* stack_references_positions
+);
+
+static void markObject(Heap* heap, Object* object);
+// Releases the unmarked large objects and clears the marks of the others.
+static void sweepLargeObjects(Heap* heap);
+static bool isObjectMarked(const Object* object);
+static bool keepMarkedString(HashMapEntry* entry, void* heap);
+static bool forwardInternedString(HashMapEntry* entry, void* heap);
+
+static bool shouldCompact(const Heap* heap);
+// Slides the reachable objects of the regular segments towards the head
+// of the segment list and updates the references to them. Leaves the
+// mark bits of the moved objects set for sweeping.
+// Returns false if there's no memory to compact the heap.
+static bool compactHeap(
+    Heap* heap,
+    Stack* stack,
     const Stack* stack_references_positions
 );
+static Object* forwardObject(const Heap* heap, Object* object);
+static void forwardObjectReferences(const Heap* heap, Object* object);
+static bool isObjectPinned(const Heap* heap, const Object* object);
+
+// Sweeps the segment at the sweep cursor and advances the cursor.
+static void sweepSegment(Heap* heap);
+static void finishSweep(Heap* heap);
+
+static size_t objectGranules(const Object* object);
+
+// Appends right_size bytes to left, copying them from right
+// if it's not NULL. See appendToString.
+static Object* appendToStringFrom(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    Object* right,
+    size_t right_size
+);
+
+// Allocates an object of the given size in granules, header included,
+// and marks it allocated. The header is left to the caller.
+static Object* allocateObject(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    size_t granules
+);
+
+static uint8_t* allocateSmall(Heap* heap, size_t granules);
+static uint8_t* allocateLarge(Heap* heap, size_t granules);
+static Segment* allocateSegment(Heap* heap);
+static void releaseSegment(Heap* heap, Segment* segment);
+static Segment* mapLargeObject(Heap* heap, size_t size);
+static void unmapLargeObject(Heap* heap, Segment* segment);
+static size_t pageSize(void);
 
-static void markObject(Object* object);
-static void deallocateObject(Heap* heap, Object* object);
+static void addFreeChunk(Heap* heap, uint8_t* start, size_t granules);
+static uint8_t* takeFreeChunk(Heap* heap, size_t granules);
 
 
 // ┌──────────────────────────┐
@@ -75,28 +179,90 @@ const char* referenceRuleName(ReferenceRule reference_rule) {
         case REFERENCE_RULE_PLAIN:     return "plain";
         case REFERENCE_RULE_REF_ARRAY: return "ref array";
         case REFERENCE_RULE_CUSTOM:    return "custom";
+        case REFERENCE_RULE_VIEW:      return "view";
+        case REFERENCE_RULE_MAP_TABLE: return "map table";
         default:                       return "INVALID REFERENCE RULE";
     }
 }
 
+void initHeapConfig(HeapConfig* config) {
+    assert(config);
+
+    config->initial_threshold    = GC_INITIAL_THRESHOLD;
+    config->growth_factor        = GC_THRESHOLD_HEAP_GROWTH_FACTOR;
+    config->min_size             = HEAP_MIN_SIZE;
+    config->max_size             = HEAP_MAX_SIZE;
+    config->limit                = HEAP_LIMIT;
+    config->compaction_threshold = GC_COMPACTION_THRESHOLD;
+    config->intern_max_size      = HEAP_INTERN_MAX_SIZE;
+}
+
 void initHeap(Heap* heap) {
     assert(heap);
 
-    heap->first   = NULL;
-    heap->size    = 0;
-    heap->next_gc = GC_INITIAL_THRESHOLD;
+    initHeapConfig(&heap->config);
+
+    heap->segments      = NULL;
+    heap->spare_segment = NULL;
+
+    heap->large_objects            = NULL;
+    heap->large_object_cache_count = 0;
+
+    heap->size          = 0;
+    heap->next_gc       = heap->config.initial_threshold;
+
+    heap->marked_segments_size = 0;
+
+    heap->bump     = NULL;
+    heap->bump_end = NULL;
+
+    heap->sweeping       = false;
+    heap->sweep_previous = NULL;
+    heap->sweep_cursor   = NULL;
+
+    for (size_t i = 0; i < HEAP_FREE_LIST_CLASSES; ++i) {
+        heap->free_lists[i] = NULL;
+    }
+
+    heap->pinned_count = 0;
+
+    heap->strings.entries  = NULL;
+    heap->strings.capacity = 0;
+    heap->strings.count    = 0;
 }
 
 void freeHeap(Heap* heap) {
     assert(heap);
 
-    while (heap->first != NULL) {
-        Object* next = heap->first->next;
-        deallocateObject(heap, heap->first);
-        heap->first = next;
+    while (heap->segments != NULL) {
+        Segment* next = heap->segments->next;
+        free(heap->segments);
+        heap->segments = next;
+    }
+    free(heap->spare_segment);
+
+    while (heap->large_objects != NULL) {
+        Segment* next = heap->large_objects->next;
+        munmap(heap->large_objects, heap->large_objects->size);
+        heap->large_objects = next;
+    }
+    for (uint8_t i = 0; i < heap->large_object_cache_count; ++i) {
+        munmap(heap->large_object_cache[i], heap->large_object_cache[i]->size);
+    }
+
+    if (heap->strings.entries != NULL) {
+        freeHashMap(&heap->strings);
     }
-    heap->size    = 0;
-    heap->next_gc = GC_INITIAL_THRESHOLD;
+
+    initHeap(heap);
+}
+
+void setHeapConfig(Heap* heap, const HeapConfig* config) {
+    assert(heap);
+    assert(config);
+
+    heap->config = *config;
+    heap->next_gc = config->initial_threshold;
 }
 
 void dumpHeap(const Heap* heap) {
@@ -122,12 +288,28 @@ void fdumpHeap(FILE* out, const Heap* heap, int padding) {
 
         printf("  size = %ld\n", heap->size);
         printf("  next_gc = %ld\n", heap->next_gc);
-        printf("  objects = [\n");
-        for (Object* i = heap->first; i != NULL; i = i->next) {
+        printf("  limit = %ld\n", heap->config.limit);
+        printf("  sweeping = %s\n", heap->sweeping ? "true" : "false");
+        printf("  sweep_cursor = ");
+        if (heap->sweep_cursor) {
+            fprintf(out, "*(%p)\n", (void*)heap->sweep_cursor);
+        } else {
+            fprintf(out, "*(NULL)\n");
+        }
+        printf("  pinned_count = %u\n", heap->pinned_count);
+        printf("  segments = [\n");
+        for (Segment* segment = heap->segments; segment != NULL; segment = segment->next) {
             printf("    ");
-            fdumpObject(out, i, padding + 2);
+            fdumpSegment(out, segment, padding + 2);
         }
         printf("  ]\n");
+        printf("  large_objects = [\n");
+        for (Segment* segment = heap->large_objects; segment != NULL; segment = segment->next) {
+            printf("    ");
+            fdumpSegment(out, segment, padding + 2);
+        }
+        printf("  ]\n");
+        printf("  large_object_cache_count = %u\n", heap->large_object_cache_count);
         printf("}\n");
     }
 
@@ -158,7 +340,16 @@ void fdumpObject(FILE* out, const Object* object, int padding) {
         );
 
         printf("  reference_rule = %s\n", referenceRuleName(object->reference_rule));
-        printf("  custom_reference_rule = ");
+        printf("  immortal = %s\n", object->immortal ? "true" : "false");
+        printf("  string_buffer = %s\n", object->string_buffer ? "true" : "false");
+        printf("  interned = %s\n", object->interned ? "true" : "false");
+        printf("  unused_bits = %u\n", object->unused_bits);
+        printf("  hash = %u\n", object->hash);
+        printf(
+            object->reference_rule == REFERENCE_RULE_VIEW
+                ? "  base = "
+                : "  custom_reference_rule = "
+        );
         if (object->custom_reference_rule) {
             fprintf(out, "*(%p)\n", (void*)object->custom_reference_rule);
             // fdumpObject(out, object->custom_reference_rule, padding + 1);
@@ -181,13 +372,6 @@ void fdumpObject(FILE* out, const Object* object, int padding) {
         } else {
             fprintf(out, "*(NULL)\n");
         }
-        printf("  next = ");
-        if (object->next) {
-            fprintf(out, "*(%p)\n", (void*)object->next);
-        } else {
-            fprintf(out, "*(NULL)\n");
-        }
-        printf("  marked = %s\n", object->marked ? "true" : "false");
         printf("}\n");
     }
 
@@ -196,7 +380,7 @@ void fdumpObject(FILE* out, const Object* object, int padding) {
 
 Object* allocateEmptyObject(
     Heap* heap,
-    const Stack* stack,
+    Stack* stack,
     const Stack* stack_references_positions,
     ReferenceRule reference_rule,
     Object* custom_reference_rule,
@@ -206,26 +390,30 @@ Object* allocateEmptyObject(
     assert(stack);
     assert(stack_references_positions);
 
-    if (heap->size >= heap->next_gc) {
-        collectGarbage(heap, stack, stack_references_positions);
+    if (size > SIZE_MAX - sizeof(Object) - HEAP_SEGMENT_SIZE) {
+        heap->pinned_count = 0;
+        return NULL;
     }
 
-    Object* object = calloc(sizeof(Object), 1);
-    // TODO: check that object has been allocated
-    
-#ifdef DEBUG_HEAP
-    printf("allocate %p\n", (void*)object);
-#endif
+    Object* object = allocateObject(
+        heap,
+        stack,
+        stack_references_positions,
+        BYTES_TO_GRANULES(sizeof(Object) + size)
+    );
+    if (!object) {
+        return NULL;
+    }
 
     object->reference_rule = reference_rule;
+    object->immortal = false;
+    object->string_buffer = false;
+    object->interned = false;
+    object->unused_bits = 0;
+    object->hash = 0;
     object->custom_reference_rule = custom_reference_rule;
     object->size = size;
-    object->value = malloc(size);
-    object->next = heap->first;
-    object->marked = false;
-
-    heap->first = object;
-    heap->size += sizeof(Object) + size;
+    object->value = (uint8_t*)(object + 1);
 
     ASSERT_OBJECT(object);
     return object;
@@ -233,7 +421,7 @@ Object* allocateEmptyObject(
 
 Object* allocateObjectFromValue(
     Heap* heap,
-    const Stack* stack,
+    Stack* stack,
     const Stack* stack_references_positions,
     ReferenceRule reference_rule,
     Object* custom_reference_rule,
@@ -253,18 +441,277 @@ Object* allocateObjectFromValue(
         custom_reference_rule,
         size
     );
+    if (!object) {
+        return NULL;
+    }
     memcpy(object->value, value_source, size);
 
     ASSERT_OBJECT(object);
     return object;
 }
 
-void dontCollectObjectOnNextGC(Object* object) {
+Object* allocateZeroedObject(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    ReferenceRule reference_rule,
+    Object* custom_reference_rule,
+    size_t size
+) {
+    assert(heap);
+    assert(stack);
+    assert(stack_references_positions);
+
+    Object* object = allocateEmptyObject(
+        heap,
+        stack,
+        stack_references_positions,
+        reference_rule,
+        custom_reference_rule,
+        size
+    );
+    if (!object) {
+        return NULL;
+    }
+
+    // Fresh mappings are zeroed already, and the pages of a cached one
+    // are dropped, so that they're zero-filled again when touched.
+    uint8_t* pages = (uint8_t*)(
+        ((uintptr_t)object->value + pageSize() - 1) & ~(uintptr_t)(pageSize() - 1)
+    );
+    uint8_t* end = object->value + size;
+    if (SEGMENT_OF(object)->large && pages < end) {
+        memset(object->value, 0, (size_t)(pages - object->value));
+        size_t pages_size = (size_t)(end - pages) / pageSize() * pageSize();
+        if (pages_size != 0 && madvise(pages, pages_size, MADV_DONTNEED) != 0) {
+            memset(pages, 0, pages_size);
+        }
+        memset(pages + pages_size, 0, (size_t)(end - pages) - pages_size);
+    } else {
+        memset(object->value, 0, size);
+    }
+
+    ASSERT_OBJECT(object);
+    return object;
+}
+
+void dontCollectObjectOnNextGC(Heap* heap, Object* object) {
+    assert(heap);
+    ASSERT_OBJECT(object);
+    assert(heap->pinned_count < HEAP_MAX_PINNED_OBJECTS);
+
+    heap->pinned[heap->pinned_count++] = object;
+
+    ASSERT_OBJECT(object);
+}
+
+bool growObjectInPlace(Heap* heap, Object* object, size_t size) {
+    assert(heap);
+    ASSERT_OBJECT(object);
+    assert(size >= object->size);
+
+    if (
+        object->immortal ||
+        object->reference_rule == REFERENCE_RULE_VIEW ||
+        size > SIZE_MAX - sizeof(Object) - HEAP_SEGMENT_SIZE
+    ) {
+        return false;
+    }
+
+    size_t granules = objectGranules(object);
+    size_t new_granules = BYTES_TO_GRANULES(sizeof(Object) + size);
+    size_t added_size = (new_granules - granules) * HEAP_GRANULE_SIZE;
+    if (heap->config.limit != 0 && heap->size + added_size > heap->config.limit) {
+        return false;
+    }
+
+    Segment* segment = SEGMENT_OF(object);
+    uint8_t* end = (uint8_t*)object + granules * HEAP_GRANULE_SIZE;
+    uint8_t* new_end = (uint8_t*)object + new_granules * HEAP_GRANULE_SIZE;
+    if (segment->large) {
+        if (new_end > (uint8_t*)segment + segment->size) {
+            return false;
+        }
+    } else {
+        // Free chunks found by sweeping may be followed by anything,
+        // only the bump space is known to be free. An object that
+        // would be large stays where it is.
+        if (
+            end != heap->bump ||
+            new_end > heap->bump_end ||
+            new_granules * HEAP_GRANULE_SIZE > HEAP_LARGE_OBJECT_SIZE
+        ) {
+            return false;
+        }
+        heap->bump = new_end;
+    }
+
+    object->size = size;
+    heap->size += added_size;
+
     ASSERT_OBJECT(object);
+    return true;
+}
+
+Object* allocateView(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* base,
+    size_t offset,
+    size_t size
+) {
+    assert(heap);
+    assert(stack);
+    assert(stack_references_positions);
+    ASSERT_OBJECT(base);
+
+    if (base->reference_rule == REFERENCE_RULE_VIEW) {
+        offset += (size_t)(base->value - base->base->value);
+        base = base->base;
+    }
+    assert(base->reference_rule != REFERENCE_RULE_VIEW);
+    assert(offset + size <= base->size);
+
+    dontCollectObjectOnNextGC(heap, base);
+    Object* object = allocateObject(
+        heap,
+        stack,
+        stack_references_positions,
+        BYTES_TO_GRANULES(sizeof(Object))
+    );
+    if (!object) {
+        return NULL;
+    }
 
-    object->marked = true;
+    object->reference_rule = REFERENCE_RULE_VIEW;
+    object->immortal = false;
+    object->string_buffer = false;
+    object->interned = false;
+    object->unused_bits = 0;
+    object->hash = 0;
+    object->base = base;
+    object->size = size;
+    object->value = base->value + offset;
 
     ASSERT_OBJECT(object);
+    return object;
+}
+
+Object* appendToString(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    size_t size
+) {
+    return appendToStringFrom(heap, stack, stack_references_positions, left, NULL, size);
+}
+
+Object* concatenateStrings(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    Object* right
+) {
+    ASSERT_OBJECT(right);
+    return appendToStringFrom(heap, stack, stack_references_positions, left, right, right->size);
+}
+
+uint32_t stringHash(Object* string) {
+    ASSERT_OBJECT(string);
+
+    if (string->hash == 0) {
+        string->hash = calculateHash((const char*)string->value, string->size);
+    }
+    return string->hash;
+}
+
+bool stringsEqual(Object* left, Object* right) {
+    ASSERT_OBJECT(left);
+    ASSERT_OBJECT(right);
+
+    if (left == right) {
+        return true;
+    }
+    if (
+        left->size != right->size ||
+        (left->interned && right->interned) ||
+        (left->hash != 0 && right->hash != 0 && left->hash != right->hash)
+    ) {
+        return false;
+    }
+    return compareBytes(left->value, right->value, left->size) == 0;
+}
+
+int compareStrings(const Object* left, const Object* right) {
+    ASSERT_OBJECT(left);
+    ASSERT_OBJECT(right);
+
+    if (left == right) {
+        return 0;
+    }
+    size_t size = left->size < right->size ? left->size : right->size;
+    int result = compareBytes(left->value, right->value, size);
+    if (result != 0) {
+        return result;
+    }
+    return (left->size > right->size) - (left->size < right->size);
+}
+
+Object* internString(Heap* heap, Object* string) {
+    assert(heap);
+    ASSERT_OBJECT(string);
+
+    if (string->interned) {
+        return string;
+    }
+
+    if (heap->strings.entries == NULL) {
+        initHashMap(&heap->strings);
+    }
+
+    size_t interned;
+    uint32_t hash = stringHash(string);
+    if (getFromHashMapKnownHash(
+        &heap->strings,
+        (const char*)string->value,
+        string->size,
+        hash,
+        &interned
+    )) {
+        return (Object*)interned;
+    }
+
+    if (string->reference_rule != REFERENCE_RULE_PLAIN || string->string_buffer) {
+        return string;
+    }
+
+    storeInHashMapKnownHash(
+        &heap->strings,
+        (const char*)string->value,
+        string->size,
+        hash,
+        (size_t)string
+    );
+    string->interned = true;
+
+    return string;
+}
+
+Object* findInternedString(Heap* heap, const uint8_t* value, size_t size) {
+    assert(heap);
+    assert(value);
+
+    size_t interned;
+    if (
+        heap->strings.entries == NULL ||
+        !getFromHashMap(&heap->strings, (const char*)value, size, &interned)
+    ) {
+        return NULL;
+    }
+    return (Object*)interned;
 }
 
 
@@ -272,9 +719,41 @@ void dontCollectObjectOnNextGC(Object* object) {
 // │ Static function implementations │
 // └─────────────────────────────────┘
 
+static void fdumpSegment(FILE* out, Segment* segment, int padding) {
+    assert(out);
+    assert(segment);
+
+#define printf(...)                                \
+    {                                              \
+        if (padding > 0) {                         \
+            fprintf(out, "%*s", padding * 2, " "); \
+        }                                          \
+        fprintf(out, __VA_ARGS__);                 \
+    }
+
+    fprintf(out, "Segment *(%p) {\n", (const void*)segment);
+    printf("  size = %ld\n", segment->size);
+    printf("  large = %s\n", segment->large ? "true" : "false");
+    printf("  objects = [\n");
+    size_t granules = segment->large ? SEGMENT_FIRST_GRANULE + 1 : HEAP_SEGMENT_GRANULES;
+    for (size_t granule = 0; granule < granules; ++granule) {
+        if (TEST_BIT(segment->object_bits, granule)) {
+            printf("    ");
+            fdumpObject(out, (Object*)GRANULE_ADDRESS(segment, granule), padding + 2);
+            printf("    marked = %s\n",
+                TEST_BIT(segment->mark_bits, granule) ? "true" : "false"
+            );
+        }
+    }
+    printf("  ]\n");
+    printf("}\n");
+
+#undef printf
+}
+
 static void collectGarbage(
     Heap* heap,
-    const Stack* stack,
+    Stack* stack,
     const Stack* stack_references_positions
 ) {
     assert(heap);
@@ -286,85 +765,148 @@ static void collectGarbage(
     printf("heap size before start: %ld\n", heap->size);
 #endif
 
-    // Mark.
+    // Finish the previous sweep, so that no object is left marked.
+    finishSweep(heap);
+
+    // Mark. Marking counts the size of the reachable objects.
+    heap->size = 0;
+    heap->marked_segments_size = 0;
     for (
         size_t* reference_position = (size_t*)stack_references_positions->stack;
         (uint8_t*)reference_position < stack_references_positions->stack_top;
         ++reference_position
     ) {
-        markObject((Object*)getAddressFromStack(stack, *reference_position));
+        markObject(heap, (Object*)getAddressFromStack(stack, *reference_position));
+    }
+    for (uint8_t i = 0; i < heap->pinned_count; ++i) {
+        markObject(heap, heap->pinned[i]);
+    }
+
+    // The intern table doesn't keep the strings alive.
+    if (heap->strings.entries != NULL) {
+        updateHashMapEntries(&heap->strings, keepMarkedString, heap);
     }
 
 #ifdef DEBUG_HEAP
     printf("mark done\n");
+    printf("heap size after mark: %ld\n\n", heap->size);
 #endif
 
-    // Sweep.
-    Object* last_reachable_object;
-    for (Object* object = heap->first; object != NULL;) {
-        Object* next = object->next;
-
-        // Unmark an object for the future garbage collections.
-        if (object->marked) {
-            object->marked = false;
-            last_reachable_object = object;
-        }
+    // Sweeping finds the free space anew, including the space
+    // that's free now.
+    for (size_t i = 0; i < HEAP_FREE_LIST_CLASSES; ++i) {
+        heap->free_lists[i] = NULL;
+    }
+    heap->bump     = NULL;
+    heap->bump_end = NULL;
 
-        // Delete the unreachable object.
-        else {
-            if (object == heap->first) {
-                heap->first = object->next;
-            } else {
-                assert(last_reachable_object);
-                last_reachable_object->next = object->next;
-            }
-            deallocateObject(heap, object);
-        }
+    bool compact = (
+        shouldCompact(heap) &&
+        compactHeap(heap, stack, stack_references_positions)
+    );
 
-        object = next;
+    // There are few large objects, and the sooner the dead ones are
+    // unmapped, the sooner their memory can be used by anything else.
+    sweepLargeObjects(heap);
+
+    // Sweep lazily: the following allocations sweep the heap segment
+    // by segment when they run out of free space. After compaction
+    // the free space is in a few segments at the end of the list
+    // only, so it's found right away.
+    heap->sweeping       = heap->segments != NULL;
+    heap->sweep_previous = NULL;
+    heap->sweep_cursor   = heap->segments;
+    if (compact) {
+        finishSweep(heap);
     }
 
-#ifdef DEBUG_HEAP
-    printf("sweep done\n");
-    printf("heap size after end: %ld\n\n", heap->size);
-#endif
-
-    // Calculate next gc threshold.
-    heap->next_gc = heap->size * GC_THRESHOLD_HEAP_GROWTH_FACTOR;
+    // Calculate next gc threshold. Converting a double that doesn't fit
+    // into size_t is undefined, so it's clamped first.
+    double next_gc = (double)heap->size * heap->config.growth_factor;
+    heap->next_gc = next_gc < (double)SIZE_MAX ? (size_t)next_gc : SIZE_MAX;
+    if (heap->next_gc < heap->config.min_size) {
+        heap->next_gc = heap->config.min_size;
+    }
+    if (heap->config.max_size != 0 && heap->next_gc > heap->config.max_size) {
+        heap->next_gc = heap->config.max_size;
+    }
 }
 
-static void markObject(Object* object) {
+static void markObject(Heap* heap, Object* object) {
+    assert(heap);
     ASSERT_OBJECT(object);
 
-    if (object->marked) {
+    if (object->immortal) {
+        return;
+    }
+
+    Segment* segment = SEGMENT_OF(object);
+    size_t granule = ADDRESS_GRANULE(segment, object);
+    assert(TEST_BIT(segment->object_bits, granule));
+    if (TEST_BIT(segment->mark_bits, granule)) {
         return;
     }
 
-    object->marked = true;
+    SET_BIT(segment->mark_bits, granule);
+    heap->size += objectGranules(object) * HEAP_GRANULE_SIZE;
+    if (!segment->large) {
+        heap->marked_segments_size += objectGranules(object) * HEAP_GRANULE_SIZE;
+    }
+
     switch (object->reference_rule) {
         case REFERENCE_RULE_PLAIN:
             break;
         
         case REFERENCE_RULE_REF_ARRAY:
             for (
-                Object* array_item_object = (Object*)object->value;
-                (uint8_t*)array_item_object < object->value + object->size;
-                ++array_item_object
+                size_t* array_item = (size_t*)object->value;
+                (uint8_t*)array_item < object->value + object->size;
+                ++array_item
             ) {
-                markObject(array_item_object);
+                if (*array_item != 0) {
+                    markObject(heap, (Object*)*array_item);
+                }
             }
             break;
 
         case REFERENCE_RULE_CUSTOM: {
             Object* custom_rule = object->custom_reference_rule;
-            markObject(custom_rule);
+            markObject(heap, custom_rule);
             for (
                 size_t* reference_offset = (size_t*)custom_rule->value;
                 (uint8_t*)reference_offset < custom_rule->value + custom_rule->size;
                 ++reference_offset
             ) {
                 assert(*reference_offset + sizeof(size_t) <= object->size);
-                markObject((Object*)*(size_t*)(object->value + *reference_offset));
+                markObject(heap, (Object*)*(size_t*)(object->value + *reference_offset));
+            }
+            break;
+        }
+
+        case REFERENCE_RULE_VIEW:
+            markObject(heap, object->base);
+            break;
+
+        case REFERENCE_RULE_MAP_TABLE: {
+            MapTable* table = (MapTable*)object->value;
+            bool mark_keys = isMapItemReference(table->key_kind);
+            bool mark_values = isMapItemReference(table->value_kind);
+            if (!mark_keys && !mark_values) {
+                break;
+            }
+
+            const uint8_t* controls = mapTableControls(table);
+            const MapSlot* slots = mapTableSlots(table);
+            for (size_t i = 0; i < table->capacity; ++i) {
+                if (!IS_MAP_CONTROL_FULL(controls[i])) {
+                    continue;
+                }
+                if (mark_keys) {
+                    markObject(heap, (Object*)slots[i].key);
+                }
+                if (mark_values) {
+                    markObject(heap, (Object*)slots[i].value);
+                }
             }
             break;
         }
@@ -374,16 +916,765 @@ static void markObject(Object* object) {
     }
 }
 
-static void deallocateObject(Heap* heap, Object* object) {
+static void sweepLargeObjects(Heap* heap) {
     assert(heap);
+
+    Segment** previous_next = &heap->large_objects;
+    while (*previous_next != NULL) {
+        Segment* segment = *previous_next;
+        if (TEST_BIT(segment->mark_bits, SEGMENT_FIRST_GRANULE)) {
+            segment->mark_bits[SEGMENT_FIRST_GRANULE / 64] = 0;
+            previous_next = &segment->next;
+        } else {
+            *previous_next = segment->next;
+            unmapLargeObject(heap, segment);
+        }
+    }
+}
+
+static bool isObjectMarked(const Object* object) {
     ASSERT_OBJECT(object);
 
-#ifdef DEBUG_HEAP
-    printf("deallocate %p\n", (void*)object);
-#endif
+    if (object->immortal) {
+        return true;
+    }
 
-    heap->size -= sizeof(Object) + object->size;
-    free(object->value);
-    free(object);
+    Segment* segment = SEGMENT_OF(object);
+    return TEST_BIT(segment->mark_bits, ADDRESS_GRANULE(segment, object));
 }
 
+static bool keepMarkedString(HashMapEntry* entry, void* heap) {
+    assert(entry);
+    assert(heap);
+
+    return isObjectMarked((const Object*)entry->value);
+}
+
+static bool forwardInternedString(HashMapEntry* entry, void* heap) {
+    assert(entry);
+    assert(heap);
+
+    // The objects haven't moved yet, so only the new address is known.
+    // Interned strings keep their values inline, so the value moves
+    // with the object.
+    Object* string = (Object*)entry->value;
+    if (!string->immortal) {
+        string = forwardObject(heap, string);
+        entry->key = (const char*)(string + 1);
+        entry->value = (size_t)string;
+    }
+    return true;
+}
+
+static bool shouldCompact(const Heap* heap) {
+    assert(heap);
+
+    if (heap->config.compaction_threshold == 0) {
+        return false;
+    }
+
+    size_t segments_size = 0;
+    for (const Segment* segment = heap->segments; segment != NULL; segment = segment->next) {
+        segments_size += SEGMENT_PAYLOAD_SIZE;
+    }
+    size_t free_size = segments_size - heap->marked_segments_size;
+
+    return (
+        free_size * 100 > segments_size * heap->config.compaction_threshold &&
+        free_size >= GC_COMPACTION_MIN_FREED_SIZE
+    );
+}
+
+static bool compactHeap(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions
+) {
+    assert(heap);
+    assert(stack);
+    assert(stack_references_positions);
+
+#ifdef DEBUG_HEAP
+    printf("compact\n");
+#endif
+
+    // Rank the mark bits.
+    for (Segment* segment = heap->segments; segment != NULL; segment = segment->next) {
+        size_t rank = 0;
+        for (size_t i = 0; i < HEAP_SEGMENT_BITMAP_WORDS; ++i) {
+            segment->mark_ranks[i] = (uint16_t)rank;
+            rank += (size_t)__builtin_popcountll(segment->mark_bits[i]);
+        }
+        // An extra entry, so that malloc doesn't return NULL for empty segments.
+        segment->forwarding = malloc((rank + 1) * sizeof(Object*));
+        if (!segment->forwarding) {
+            for (Segment* i = heap->segments; i != segment; i = i->next) {
+                free(i->forwarding);
+                i->forwarding = NULL;
+            }
+            return false;
+        }
+    }
+
+    // Compute the new addresses. The objects keep their order, so an object
+    // never moves to a later segment or to a later granule of its segment.
+    // Pinned objects stay where they are, and others are placed around them.
+    Segment* destination_segment = heap->segments;
+    size_t destination_granule = SEGMENT_FIRST_GRANULE;
+    for (Segment* segment = heap->segments; segment != NULL; segment = segment->next) {
+        size_t rank = 0;
+        for (size_t i = 0; i < HEAP_SEGMENT_BITMAP_WORDS; ++i) {
+            for (uint64_t bits = segment->mark_bits[i]; bits != 0; bits &= bits - 1) {
+                Object* object = (Object*)GRANULE_ADDRESS(segment, i * 64 + (size_t)__builtin_ctzll(bits));
+                if (isObjectPinned(heap, object)) {
+                    segment->forwarding[rank++] = object;
+                    continue;
+                }
+
+                size_t granules = objectGranules(object);
+                for (;;) {
+                    if (destination_granule + granules > HEAP_SEGMENT_GRANULES) {
+                        destination_segment = destination_segment->next;
+                        destination_granule = SEGMENT_FIRST_GRANULE;
+                        continue;
+                    }
+
+                    bool overlaps_pinned = false;
+                    for (uint8_t j = 0; j < heap->pinned_count; ++j) {
+                        const Object* pinned = heap->pinned[j];
+                        if (pinned->immortal || SEGMENT_OF(pinned) != destination_segment) {
+                            continue;
+                        }
+                        size_t pinned_granule = ADDRESS_GRANULE(destination_segment, pinned);
+                        size_t pinned_end = pinned_granule + objectGranules(pinned);
+                        if (
+                            pinned_granule < destination_granule + granules &&
+                            destination_granule < pinned_end
+                        ) {
+                            destination_granule = pinned_end;
+                            overlaps_pinned = true;
+                        }
+                    }
+                    if (!overlaps_pinned) {
+                        break;
+                    }
+                }
+
+                segment->forwarding[rank++] = (Object*)GRANULE_ADDRESS(destination_segment, destination_granule);
+                destination_granule += granules;
+            }
+        }
+    }
+
+    // Update the references while the objects are still in place.
+    for (
+        size_t* reference_position = (size_t*)stack_references_positions->stack;
+        (uint8_t*)reference_position < stack_references_positions->stack_top;
+        ++reference_position
+    ) {
+        Object* object = (Object*)getAddressFromStack(stack, *reference_position);
+        setAddressOnStack(stack, *reference_position, (size_t)forwardObject(heap, object));
+    }
+    for (Segment* segment = heap->segments; segment != NULL; segment = segment->next) {
+        for (size_t i = 0; i < HEAP_SEGMENT_BITMAP_WORDS; ++i) {
+            for (uint64_t bits = segment->mark_bits[i]; bits != 0; bits &= bits - 1) {
+                Object* object = (Object*)GRANULE_ADDRESS(segment, i * 64 + (size_t)__builtin_ctzll(bits));
+                forwardObjectReferences(heap, object);
+            }
+        }
+    }
+    for (Segment* segment = heap->large_objects; segment != NULL; segment = segment->next) {
+        if (TEST_BIT(segment->mark_bits, SEGMENT_FIRST_GRANULE)) {
+            forwardObjectReferences(heap, (Object*)GRANULE_ADDRESS(segment, SEGMENT_FIRST_GRANULE));
+        }
+    }
+    if (heap->strings.entries != NULL) {
+        updateHashMapEntries(&heap->strings, forwardInternedString, heap);
+    }
+
+    // Move. A bitmap word is cleared before the objects it marks are moved,
+    // and the bits of the new addresses are set, which are never later.
+    for (Segment* segment = heap->segments; segment != NULL; segment = segment->next) {
+        size_t rank = 0;
+        for (size_t i = 0; i < HEAP_SEGMENT_BITMAP_WORDS; ++i) {
+            uint64_t mark_bits = segment->mark_bits[i];
+            segment->mark_bits[i]   = 0;
+            segment->object_bits[i] = 0;
+
+            for (uint64_t bits = mark_bits; bits != 0; bits &= bits - 1) {
+                Object* object = (Object*)GRANULE_ADDRESS(segment, i * 64 + (size_t)__builtin_ctzll(bits));
+                Object* destination = segment->forwarding[rank++];
+                if (destination != object) {
+                    memmove(destination, object, objectGranules(object) * HEAP_GRANULE_SIZE);
+                    if (destination->reference_rule != REFERENCE_RULE_VIEW) {
+                        destination->value = (uint8_t*)(destination + 1);
+                    }
+                }
+
+                Segment* destination_segment = SEGMENT_OF(destination);
+                size_t destination_granule = ADDRESS_GRANULE(destination_segment, destination);
+                SET_BIT(destination_segment->object_bits, destination_granule);
+                SET_BIT(destination_segment->mark_bits,   destination_granule);
+            }
+        }
+
+        free(segment->forwarding);
+        segment->forwarding = NULL;
+    }
+
+    return true;
+}
+
+static Object* forwardObject(const Heap* heap, Object* object) {
+    assert(heap);
+    ASSERT_OBJECT(object);
+
+    if (object->immortal) {
+        return object;
+    }
+
+    Segment* segment = SEGMENT_OF(object);
+    if (segment->large) {
+        return object;
+    }
+
+    size_t granule = ADDRESS_GRANULE(segment, object);
+    assert(TEST_BIT(segment->mark_bits, granule));
+    size_t rank = segment->mark_ranks[granule / 64] + (size_t)__builtin_popcountll(
+        segment->mark_bits[granule / 64] & LOW_BITS(granule)
+    );
+    return segment->forwarding[rank];
+}
+
+static void forwardObjectReferences(const Heap* heap, Object* object) {
+    assert(heap);
+    ASSERT_OBJECT(object);
+
+    switch (object->reference_rule) {
+        case REFERENCE_RULE_PLAIN:
+            break;
+        
+        case REFERENCE_RULE_REF_ARRAY:
+            for (
+                size_t* array_item = (size_t*)object->value;
+                (uint8_t*)array_item < object->value + object->size;
+                ++array_item
+            ) {
+                if (*array_item != 0) {
+                    *array_item = (size_t)forwardObject(heap, (Object*)*array_item);
+                }
+            }
+            break;
+
+        case REFERENCE_RULE_CUSTOM: {
+            // The custom reference rule object hasn't moved yet.
+            Object* custom_rule = object->custom_reference_rule;
+            for (
+                size_t* reference_offset = (size_t*)custom_rule->value;
+                (uint8_t*)reference_offset < custom_rule->value + custom_rule->size;
+                ++reference_offset
+            ) {
+                size_t* reference = (size_t*)(object->value + *reference_offset);
+                *reference = (size_t)forwardObject(heap, (Object*)*reference);
+            }
+            object->custom_reference_rule = forwardObject(heap, custom_rule);
+            break;
+        }
+
+        case REFERENCE_RULE_VIEW: {
+            // Moved objects have their values right after the header.
+            Object* base = forwardObject(heap, object->base);
+            if (base != object->base) {
+                object->value = (uint8_t*)(base + 1) + (object->value - object->base->value);
+                object->base = base;
+            }
+            break;
+        }
+
+        case REFERENCE_RULE_MAP_TABLE: {
+            MapTable* table = (MapTable*)object->value;
+            bool forward_keys = isMapItemReference(table->key_kind);
+            bool forward_values = isMapItemReference(table->value_kind);
+            if (!forward_keys && !forward_values) {
+                break;
+            }
+
+            const uint8_t* controls = mapTableControls(table);
+            MapSlot* slots = mapTableSlots(table);
+            for (size_t i = 0; i < table->capacity; ++i) {
+                if (!IS_MAP_CONTROL_FULL(controls[i])) {
+                    continue;
+                }
+                if (forward_keys) {
+                    slots[i].key = (size_t)forwardObject(heap, (Object*)slots[i].key);
+                }
+                if (forward_values) {
+                    slots[i].value = (size_t)forwardObject(heap, (Object*)slots[i].value);
+                }
+            }
+            break;
+        }
+        
+        default:
+            assert(false);
+    }
+}
+
+static bool isObjectPinned(const Heap* heap, const Object* object) {
+    assert(heap);
+
+    for (uint8_t i = 0; i < heap->pinned_count; ++i) {
+        if (heap->pinned[i] == object) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sweepSegment(Heap* heap) {
+    assert(heap);
+    assert(heap->sweeping);
+
+    Segment* segment = heap->sweep_cursor;
+    heap->sweep_cursor = segment->next;
+
+    // Only the reachable objects stay allocated. The bitmaps are processed
+    // a word at a time without touching the objects themselves.
+    size_t live_objects = 0;
+    for (size_t i = 0; i < HEAP_SEGMENT_BITMAP_WORDS; ++i) {
+        segment->object_bits[i] &= segment->mark_bits[i];
+        segment->mark_bits[i] = 0;
+        live_objects += (size_t)__builtin_popcountll(segment->object_bits[i]);
+    }
+
+    if (live_objects == 0) {
+        if (heap->sweep_previous == NULL) {
+            assert(segment == heap->segments);
+            heap->segments = segment->next;
+        } else {
+            heap->sweep_previous->next = segment->next;
+        }
+        releaseSegment(heap, segment);
+    } else {
+        heap->sweep_previous = segment;
+
+        // The space between the live objects is free.
+        size_t free_start = SEGMENT_FIRST_GRANULE;
+        for (size_t i = 0; i < HEAP_SEGMENT_BITMAP_WORDS; ++i) {
+            for (uint64_t bits = segment->object_bits[i]; bits != 0; bits &= bits - 1) {
+                size_t granule = i * 64 + (size_t)__builtin_ctzll(bits);
+                if (granule > free_start) {
+                    addFreeChunk(heap, GRANULE_ADDRESS(segment, free_start), granule - free_start);
+                }
+                free_start = granule + objectGranules((Object*)GRANULE_ADDRESS(segment, granule));
+            }
+        }
+        if (free_start < HEAP_SEGMENT_GRANULES) {
+            addFreeChunk(heap, GRANULE_ADDRESS(segment, free_start), HEAP_SEGMENT_GRANULES - free_start);
+        }
+    }
+
+    if (heap->sweep_cursor == NULL) {
+        heap->sweeping       = false;
+        heap->sweep_previous = NULL;
+
+#ifdef DEBUG_HEAP
+        printf("sweep done\n");
+#endif
+    }
+}
+
+static void finishSweep(Heap* heap) {
+    assert(heap);
+
+    while (heap->sweeping) {
+        sweepSegment(heap);
+    }
+}
+
+static Object* appendToStringFrom(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    Object* right,
+    size_t right_size
+) {
+    assert(heap);
+    assert(stack);
+    assert(stack_references_positions);
+    ASSERT_OBJECT(left);
+
+    if (left->size > SIZE_MAX / 4 || right_size > SIZE_MAX / 4) {
+        return NULL;
+    }
+    size_t size = left->size + right_size;
+
+    if (size < HEAP_STRING_BUFFER_MIN_SIZE) {
+        dontCollectObjectOnNextGC(heap, left);
+        if (right) {
+            dontCollectObjectOnNextGC(heap, right);
+        }
+        Object* object = allocateEmptyObject(
+            heap,
+            stack,
+            stack_references_positions,
+            REFERENCE_RULE_PLAIN,
+            NULL,
+            size
+        );
+        if (!object) {
+            return NULL;
+        }
+        memcpy(object->value, left->value, left->size);
+        if (right) {
+            memcpy(object->value + left->size, right->value, right_size);
+        }
+        return object;
+    }
+
+    // Append in place. The bytes after the end of left are only
+    // free if nothing was appended to left yet.
+    if (left->reference_rule == REFERENCE_RULE_VIEW && left->base->string_buffer) {
+        Object* buffer = left->base;
+        size_t* used = (size_t*)buffer->value;
+        size_t left_end = (size_t)(left->value - buffer->value) + left->size;
+        if (
+            left_end == sizeof(size_t) + *used &&
+            right_size <= buffer->size - left_end
+        ) {
+            if (right) {
+                memcpy(buffer->value + left_end, right->value, right_size);
+            }
+            *used += right_size;
+            return allocateView(
+                heap,
+                stack,
+                stack_references_positions,
+                buffer,
+                left_end - left->size,
+                size
+            );
+        }
+    }
+
+    // The right value is copied before allocating the view,
+    // because it's only protected during one allocation.
+    dontCollectObjectOnNextGC(heap, left);
+    if (right) {
+        dontCollectObjectOnNextGC(heap, right);
+    }
+    Object* buffer = allocateEmptyObject(
+        heap,
+        stack,
+        stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        sizeof(size_t) + size * 2
+    );
+    if (!buffer) {
+        return NULL;
+    }
+    buffer->string_buffer = true;
+    *(size_t*)buffer->value = size;
+    memcpy(buffer->value + sizeof(size_t), left->value, left->size);
+    if (right) {
+        memcpy(buffer->value + sizeof(size_t) + left->size, right->value, right_size);
+    }
+
+    return allocateView(
+        heap,
+        stack,
+        stack_references_positions,
+        buffer,
+        sizeof(size_t),
+        size
+    );
+}
+
+static size_t objectGranules(const Object* object) {
+    ASSERT_OBJECT(object);
+
+    // The value of a view isn't a part of it.
+    if (object->reference_rule == REFERENCE_RULE_VIEW) {
+        return BYTES_TO_GRANULES(sizeof(Object));
+    }
+    return BYTES_TO_GRANULES(sizeof(Object) + object->size);
+}
+
+static Object* allocateObject(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    size_t granules
+) {
+    assert(heap);
+    assert(stack);
+    assert(stack_references_positions);
+
+    bool exceeds_limit = (
+        heap->config.limit != 0 &&
+        heap->size + granules * HEAP_GRANULE_SIZE > heap->config.limit
+    );
+    if (heap->size >= heap->next_gc || exceeds_limit) {
+        collectGarbage(heap, stack, stack_references_positions);
+    }
+    if (
+        heap->config.limit != 0 &&
+        heap->size + granules * HEAP_GRANULE_SIZE > heap->config.limit
+    ) {
+        heap->pinned_count = 0;
+        return NULL;
+    }
+
+    Object* object = (Object*)(
+        granules * HEAP_GRANULE_SIZE > HEAP_LARGE_OBJECT_SIZE
+            ? allocateLarge(heap, granules)
+            : allocateSmall(heap, granules)
+    );
+    heap->pinned_count = 0;
+    if (!object) {
+        return NULL;
+    }
+
+    Segment* segment = SEGMENT_OF(object);
+    SET_BIT(segment->object_bits, ADDRESS_GRANULE(segment, object));
+
+#ifdef DEBUG_HEAP
+    printf("allocate %p\n", (void*)object);
+#endif
+
+    heap->size += granules * HEAP_GRANULE_SIZE;
+
+    return object;
+}
+
+static uint8_t* allocateSmall(Heap* heap, size_t granules) {
+    assert(heap);
+
+    size_t size = granules * HEAP_GRANULE_SIZE;
+    for (;;) {
+        uint8_t* start = takeFreeChunk(heap, granules);
+        if (start) {
+            return start;
+        }
+
+        if (heap->bump && heap->bump + size <= heap->bump_end) {
+            start = heap->bump;
+            heap->bump += size;
+            return start;
+        }
+
+        if (!heap->sweeping) {
+            break;
+        }
+        sweepSegment(heap);
+    }
+
+    // Keep what's left of the previous segment and start a new one.
+    if (heap->bump) {
+        addFreeChunk(heap, heap->bump, (size_t)(heap->bump_end - heap->bump) / HEAP_GRANULE_SIZE);
+        heap->bump     = NULL;
+        heap->bump_end = NULL;
+    }
+    Segment* segment = allocateSegment(heap);
+    if (!segment) {
+        return NULL;
+    }
+    heap->bump     = GRANULE_ADDRESS(segment, SEGMENT_FIRST_GRANULE) + size;
+    heap->bump_end = (uint8_t*)segment + HEAP_SEGMENT_SIZE;
+    return GRANULE_ADDRESS(segment, SEGMENT_FIRST_GRANULE);
+}
+
+static uint8_t* allocateLarge(Heap* heap, size_t granules) {
+    assert(heap);
+
+    size_t size = (SEGMENT_FIRST_GRANULE + granules) * HEAP_GRANULE_SIZE;
+    size = (size + pageSize() - 1) / pageSize() * pageSize();
+
+    Segment* segment = mapLargeObject(heap, size);
+    if (!segment) {
+        return NULL;
+    }
+
+#ifdef DEBUG_HEAP
+    printf("allocate large object segment %p\n", (void*)segment);
+#endif
+
+    segment->next = heap->large_objects;
+    heap->large_objects = segment;
+
+    return GRANULE_ADDRESS(segment, SEGMENT_FIRST_GRANULE);
+}
+
+static Segment* allocateSegment(Heap* heap) {
+    assert(heap);
+
+    Segment* segment;
+    if (heap->spare_segment) {
+        segment = heap->spare_segment;
+        heap->spare_segment = NULL;
+    } else {
+        segment = aligned_alloc(HEAP_SEGMENT_SIZE, HEAP_SEGMENT_SIZE);
+        if (!segment) {
+            return NULL;
+        }
+    }
+
+#ifdef DEBUG_HEAP
+    printf("allocate segment %p\n", (void*)segment);
+#endif
+
+    segment->size = HEAP_SEGMENT_SIZE;
+    segment->large = false;
+    segment->forwarding = NULL;
+    memset(segment->object_bits, 0, sizeof(segment->object_bits));
+    memset(segment->mark_bits,   0, sizeof(segment->mark_bits));
+
+    // If the sweep cursor was the first segment, the new segment
+    // now precedes it.
+    if (heap->sweeping && heap->sweep_previous == NULL) {
+        heap->sweep_previous = segment;
+    }
+    segment->next = heap->segments;
+    heap->segments = segment;
+
+    return segment;
+}
+
+static void releaseSegment(Heap* heap, Segment* segment) {
+    assert(heap);
+    assert(segment);
+
+#ifdef DEBUG_HEAP
+    printf("release segment %p\n", (void*)segment);
+#endif
+
+    if (!heap->spare_segment) {
+        heap->spare_segment = segment;
+    } else {
+        free(segment);
+    }
+}
+
+static Segment* mapLargeObject(Heap* heap, size_t size) {
+    assert(heap);
+    assert(size % pageSize() == 0);
+
+    // Reuse a cached mapping if it isn't much bigger than needed.
+    for (uint8_t i = 0; i < heap->large_object_cache_count; ++i) {
+        Segment* segment = heap->large_object_cache[i];
+        if (segment->size >= size && segment->size / 2 <= size) {
+            heap->large_object_cache[i] = heap->large_object_cache[--heap->large_object_cache_count];
+            return segment;
+        }
+    }
+
+    // Segment alignment is needed to find the header from the object
+    // address. Map more than needed and unmap the unaligned ends.
+    if (size > SIZE_MAX - HEAP_SEGMENT_SIZE) {
+        return NULL;
+    }
+    size_t mapping_size = size + HEAP_SEGMENT_SIZE;
+    uint8_t* mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+    uint8_t* start = (uint8_t*)(
+        ((uintptr_t)mapping + HEAP_SEGMENT_SIZE - 1) & ~(uintptr_t)(HEAP_SEGMENT_SIZE - 1)
+    );
+    if (start > mapping) {
+        munmap(mapping, (size_t)(start - mapping));
+    }
+    if (start + size < mapping + mapping_size) {
+        munmap(start + size, (size_t)(mapping + mapping_size - (start + size)));
+    }
+
+    // Fresh pages are zeroed, so the bitmaps are clear already
+    // and only the touched pages of the header take memory.
+    Segment* segment = (Segment*)start;
+    segment->size = size;
+    segment->large = true;
+    segment->forwarding = NULL;
+    return segment;
+}
+
+static void unmapLargeObject(Heap* heap, Segment* segment) {
+    assert(heap);
+    assert(segment);
+    assert(segment->large);
+
+#ifdef DEBUG_HEAP
+    printf("release large object segment %p\n", (void*)segment);
+#endif
+
+    // MADV_DONTNEED releases the pages of a private anonymous mapping,
+    // and they read as zeros afterwards. Only the header fields need
+    // to survive, and they are written again below.
+    size_t size = segment->size;
+    if (
+        heap->large_object_cache_count < HEAP_LARGE_OBJECT_CACHE_SIZE &&
+        madvise(segment, size, MADV_DONTNEED) == 0
+    ) {
+        segment->size = size;
+        segment->large = true;
+        segment->forwarding = NULL;
+        heap->large_object_cache[heap->large_object_cache_count++] = segment;
+    } else {
+        munmap(segment, size);
+    }
+}
+
+static size_t pageSize(void) {
+    static size_t page_size = 0;
+    if (page_size == 0) {
+        page_size = (size_t)sysconf(_SC_PAGESIZE);
+    }
+    return page_size;
+}
+
+static void addFreeChunk(Heap* heap, uint8_t* start, size_t granules) {
+    assert(heap);
+    assert(start);
+
+    // Too small to hold an object header.
+    if (granules * HEAP_GRANULE_SIZE < sizeof(Object)) {
+        return;
+    }
+
+    size_t free_list = granules < HEAP_FREE_LIST_CLASSES ? granules : HEAP_FREE_LIST_CLASSES - 1;
+    FreeChunk* chunk = (FreeChunk*)start;
+    chunk->next     = heap->free_lists[free_list];
+    chunk->granules = granules;
+    heap->free_lists[free_list] = chunk;
+}
+
+static uint8_t* takeFreeChunk(Heap* heap, size_t granules) {
+    assert(heap);
+
+    // Any chunk from the lists of sizes from granules on fits, except for
+    // the last list, which holds chunks of different sizes.
+    FreeChunk** previous_next = NULL;
+    for (size_t i = granules; i < HEAP_FREE_LIST_CLASSES - 1 && !previous_next; ++i) {
+        if (heap->free_lists[i]) {
+            previous_next = &heap->free_lists[i];
+        }
+    }
+    if (!previous_next) {
+        previous_next = &heap->free_lists[HEAP_FREE_LIST_CLASSES - 1];
+        while (*previous_next && (*previous_next)->granules < granules) {
+            previous_next = &(*previous_next)->next;
+        }
+    }
+
+    FreeChunk* chunk = *previous_next;
+    if (!chunk) {
+        return NULL;
+    }
+    *previous_next = chunk->next;
+
+    if (chunk->granules > granules) {
+        addFreeChunk(heap, (uint8_t*)chunk + granules * HEAP_GRANULE_SIZE, chunk->granules - granules);
+    }
+    return (uint8_t*)chunk;
+}
@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "hashmap.h"
 #include "stack.h"
 
 
@@ -16,13 +17,63 @@
 // #define DEBUG_HEAP
 // #define STRESS_GC
 
+// Defaults of the HeapConfig fields.
 #ifdef STRESS_GC
     #define GC_INITIAL_THRESHOLD            0
     #define GC_THRESHOLD_HEAP_GROWTH_FACTOR 0
+    #define GC_COMPACTION_MIN_FREED_SIZE    1
 #else
     #define GC_INITIAL_THRESHOLD            (1024 * 1024)
     #define GC_THRESHOLD_HEAP_GROWTH_FACTOR 2
+    #define GC_COMPACTION_MIN_FREED_SIZE    HEAP_SEGMENT_SIZE
 #endif
+// Larger factors are rejected by the options, a gc threshold that far
+// above the heap size wouldn't be reached anyway.
+#define GC_MAX_GROWTH_FACTOR 1000
+#define HEAP_MIN_SIZE 0
+#define HEAP_MAX_SIZE 0
+#define HEAP_LIMIT    0
+
+// Percentage of free space in the segments after marking above which
+// gc compacts the heap instead of sweeping it. 0 disables compaction.
+// Compaction also requires at least GC_COMPACTION_MIN_FREED_SIZE bytes
+// to be free, so that it pays off.
+#define GC_COMPACTION_THRESHOLD 50
+
+// Objects are allocated in segments of HEAP_SEGMENT_SIZE bytes aligned
+// to their size, so that the segment of an object is found by masking its
+// address. Segment memory is divided into granules, and mark bits are kept
+// in a bitmap at the start of the segment, a bit per granule.
+#define HEAP_SEGMENT_SIZE         (256 * 1024)
+#define HEAP_GRANULE_SIZE         16
+#define HEAP_SEGMENT_GRANULES     (HEAP_SEGMENT_SIZE / HEAP_GRANULE_SIZE)
+#define HEAP_SEGMENT_BITMAP_WORDS (HEAP_SEGMENT_GRANULES / 64)
+
+// Objects bigger than this are allocated in the large object space,
+// each in a memory mapping of its own. The mapping starts with a segment
+// header, so that large objects are marked the same way. They are never
+// moved, and their memory is returned to the system when they die.
+#define HEAP_LARGE_OBJECT_SIZE (HEAP_SEGMENT_SIZE / 4)
+
+// Number of mappings of dead large objects kept for reuse. Their pages
+// are released with madvise, only the address space is kept.
+#define HEAP_LARGE_OBJECT_CACHE_SIZE 4
+
+// Free chunks of up to HEAP_FREE_LIST_CLASSES - 2 granules are kept in
+// a list per size. Bigger ones share the last list.
+#define HEAP_FREE_LIST_CLASSES 32
+
+#define HEAP_MAX_PINNED_OBJECTS 4
+
+// Concatenation results shorter than this are copied into objects of
+// their own. Longer ones are built in buffers with spare capacity,
+// so that appending to the last string built in a buffer doesn't copy it.
+#define HEAP_STRING_BUFFER_MIN_SIZE 64
+
+// Strings created at run time of up to this size are interned,
+// so that equal ones are usually the same object. 0 disables interning
+// of such strings, constants are interned anyway.
+#define HEAP_INTERN_MAX_SIZE 32
 
 
 // ┌───────┐
@@ -31,8 +82,16 @@
 
 typedef enum {
     REFERENCE_RULE_PLAIN,
+    // Null items are skipped, they are the spare capacity
+    // of growable arrays, see array.h.
     REFERENCE_RULE_REF_ARRAY,
     REFERENCE_RULE_CUSTOM,
+    // The value points into the value of the base object,
+    // and the object references whatever the base does.
+    REFERENCE_RULE_VIEW,
+    // The value is a MapTable, see map.h. The keys and values
+    // of its full slots are traced if they are references.
+    REFERENCE_RULE_MAP_TABLE,
 } ReferenceRule;
 
 struct Object;
@@ -40,17 +99,116 @@ typedef struct Object Object;
 
 struct Object {
     ReferenceRule reference_rule;
-    Object* custom_reference_rule;
+    // Immortal objects aren't allocated on the heap and are never
+    // collected. They may only reference other immortal objects.
+    bool immortal;
+    // The value starts with the number of bytes of the buffer in use,
+    // followed by the strings built in it. See concatenateStrings.
+    bool string_buffer;
+    // Interned strings are the only ones with their values in the intern
+    // table, so two different interned strings are never equal.
+    bool interned;
+    // Arrays of bools are packed a bit per item, and the last unused_bits
+    // bits of their last byte are zero and aren't items. See bit_array.h.
+    uint8_t unused_bits;
+    // Hash of the value of a string, 0 until it's calculated.
+    // See stringHash.
+    uint32_t hash;
+    union {
+        Object* custom_reference_rule;
+        // Is never a view itself.
+        Object* base;
+    };
     size_t size;
     uint8_t* value;
-    Object* next;
-    bool marked;
 };
 
+struct Segment;
+typedef struct Segment Segment;
+
+struct Segment {
+    Segment* next;
+    // HEAP_SEGMENT_SIZE for regular segments, size of the mapping
+    // for large objects.
+    size_t size;
+    bool large;
+    // Bits of the granules the allocated objects start at.
+    uint64_t object_bits[HEAP_SEGMENT_BITMAP_WORDS];
+    // Bits of the granules the reachable objects start at.
+    // Are set by marking and cleared by sweeping.
+    uint64_t mark_bits[HEAP_SEGMENT_BITMAP_WORDS];
+
+    // Used during compaction. New addresses of the reachable objects
+    // in the order of their mark bits, and the number of mark bits
+    // preceding each word of the bitmap.
+    Object** forwarding;
+    uint16_t mark_ranks[HEAP_SEGMENT_BITMAP_WORDS];
+};
+
+struct FreeChunk;
+typedef struct FreeChunk FreeChunk;
+
+// Sizes are in bytes of objects on the heap.
 typedef struct {
-    Object* first;
+    // Heap size at which the first gc happens.
+    size_t initial_threshold;
+    // After a gc, the next one happens when the heap grows to the size
+    // of the reachable objects multiplied by growth_factor.
+    double growth_factor;
+    // Bounds of the next gc threshold. 0 max_size means no bound.
+    size_t min_size;
+    size_t max_size;
+    // Allocations that would make the heap bigger than limit even
+    // after a gc fail. 0 means no limit.
+    size_t limit;
+    // See GC_COMPACTION_THRESHOLD.
+    uint8_t compaction_threshold;
+    // See HEAP_INTERN_MAX_SIZE.
+    size_t intern_max_size;
+} HeapConfig;
+
+typedef struct {
+    HeapConfig config;
+
+    Segment* segments;
+    // An empty segment kept to avoid reallocating one.
+    Segment* spare_segment;
+
+    // Segments holding a single large object each.
+    Segment* large_objects;
+    Segment* large_object_cache[HEAP_LARGE_OBJECT_CACHE_SIZE];
+    uint8_t  large_object_cache_count;
+    // Size of the objects that survived the last gc plus the size 
+    // of the objects allocated after it.
     size_t size;
     size_t next_gc;
+
+    // Size of the reachable objects in the regular segments,
+    // counted by marking.
+    size_t marked_segments_size;
+
+    // Free space at the end of the segment allocated last.
+    uint8_t* bump;
+    uint8_t* bump_end;
+
+    // Lazy sweep state. Segments from sweep_cursor to the end of the list
+    // haven't been swept since the last mark. sweep_previous is the segment
+    // preceding sweep_cursor in the list, or NULL if sweep_cursor is first.
+    bool     sweeping;
+    Segment* sweep_previous;
+    Segment* sweep_cursor;
+
+    // Free space found by sweeping, by size in granules.
+    FreeChunk* free_lists[HEAP_FREE_LIST_CLASSES];
+
+    // Objects protected from collection until the end of the next allocation.
+    Object* pinned[HEAP_MAX_PINNED_OBJECTS];
+    uint8_t pinned_count;
+
+    // Weak table of the interned strings, from their values to the objects.
+    // Entries of the strings that die are removed by gc. Is created
+    // on the first use, entries is NULL until then.
+    HashMap strings;
 } Heap;
 
 
@@ -60,6 +218,7 @@ typedef struct {
 
 extern Object OBJECT_STRING_TRUE;
 extern Object OBJECT_STRING_FALSE;
+extern Object OBJECT_STRING_EMPTY;
 
 
 // ┌───────────────────────┐
@@ -68,17 +227,22 @@ extern Object OBJECT_STRING_FALSE;
 
 const char* referenceRuleName(ReferenceRule reference_rule);
 
+void initHeapConfig(HeapConfig* config);
+
 void initHeap(Heap* heap);
 void freeHeap(Heap* heap);
+void setHeapConfig(Heap* heap, const HeapConfig* config);
 void dumpHeap(const Heap* heap);
 void fdumpHeap(FILE* out, const Heap* heap, int padding);
 
 void dumpObject(const Object* object);
 void fdumpObject(FILE* out, const Object* object, int padding);
 
+// Allocation functions return NULL if the heap limit is exceeded
+// or memory can't be allocated.
 Object* allocateEmptyObject(
     Heap* heap,
-    const Stack* stack,
+    Stack* stack,
     const Stack* stack_references_positions,
     ReferenceRule reference_rule,
     Object* custom_reference_rule,
@@ -87,7 +251,7 @@ Object* allocateEmptyObject(
 
 Object* allocateObjectFromValue(
     Heap* heap,
-    const Stack* stack,
+    Stack* stack,
     const Stack* stack_references_positions,
     ReferenceRule reference_rule,
     Object* custom_reference_rule,
@@ -95,12 +259,88 @@ Object* allocateObjectFromValue(
     const uint8_t* value_source
 );
 
+/* Allocates an object with a zeroed value, like calloc. The value of
+ * a large object is mapped to the zero page, so its memory is taken
+ * page by page when it's written rather than right away.
+ * */
+Object* allocateZeroedObject(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    ReferenceRule reference_rule,
+    Object* custom_reference_rule,
+    size_t size
+);
+
 /* Prevents an object from being collected on the next gc.
  * Is useful when an object that's already popped from stack
  * (this isn't marked as root) isn't used yet. Look at 
- * OP_CONCATENATE in VM for example.
+ * OP_MULTIPLY_HEAP_VALUE in VM for example.
+ *
+ * The object stays protected until the next allocation returns.
+ * It isn't moved by compaction either.
+ * */
+void dontCollectObjectOnNextGC(Heap* heap, Object* object);
+
+/* Makes the value of an object size bytes long without moving it, like
+ * realloc does when there's free space right after the block. Is only
+ * possible for the object allocated last in a segment, and for a large
+ * object whose mapping has enough spare pages. Returns false otherwise.
+ * The added bytes aren't initialized.
+ * */
+bool growObjectInPlace(Heap* heap, Object* object, size_t size);
+
+// Allocates a view of size bytes of the value of base starting at offset.
+Object* allocateView(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* base,
+    size_t offset,
+    size_t size
+);
+
+/* Returns a string with the value of left followed by size bytes,
+ * which the caller writes at value + left->size before the next allocation.
+ *
+ * Long strings are views of string buffers. If left is the last string
+ * appended to its buffer and there's enough space after it, the bytes
+ * are appended in place, and only the view is allocated. Otherwise a buffer
+ * twice as big as needed is allocated, so that repeated concatenation
+ * takes amortized linear time.
+ * */
+Object* appendToString(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    size_t size
+);
+
+// Returns a string with the value of left followed by the value of right.
+Object* concatenateStrings(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* left,
+    Object* right
+);
+
+// Calculates the hash of the value of a string once and caches it.
+uint32_t stringHash(Object* string);
+bool stringsEqual(Object* left, Object* right);
+
+// Compares the values of strings byte by byte, a prefix is less
+// than the whole string. Returns -1, 0 or 1.
+int compareStrings(const Object* left, const Object* right);
+
+/* Returns the interned string equal to string. If there's none, string
+ * becomes the interned one, unless it's a view or a string buffer,
+ * which are returned as they are. Immortal strings must outlive the heap.
  * */
-void dontCollectObjectOnNextGC(Object* object);
+Object* internString(Heap* heap, Object* string);
+// Returns the interned string with the given value, or NULL.
+Object* findInternedString(Heap* heap, const uint8_t* value, size_t size);
 
 
 #endif
@@ -0,0 +1,466 @@
+#include "input.h"
+
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "string_kernels.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define VALIDATE_INPUT(input)                \
+    (                                        \
+        input                             && \
+        input->buffer                     && \
+        input->start <= input->end        && \
+        input->end   <= input->capacity      \
+    )
+
+#define ASSERT_INPUT(input)                             \
+    if (!VALIDATE_INPUT(input)) {                       \
+        fprintf(stderr,                                 \
+            "%s:%d, in %s:\ninput assertion failed.\n", \
+            __FILENAME__,                               \
+            __LINE__,                                   \
+            __FUNCTION_NAME__                           \
+        );                                              \
+        fdumpInput(stderr, input, 0);                   \
+        exit(1);                                        \
+    }
+
+// Decimal floats with at most this many digits, which fit in a
+// uint64_t mantissa, are parsed without strtod.
+#define FAST_FLOAT_MAX_DIGITS 19
+
+// Mantissas up to 2^53 and powers of ten up to 10^22 are exact doubles,
+// so one multiplication or division rounds the result correctly.
+#define FAST_FLOAT_MAX_MANTISSA (UINT64_C(1) << 53)
+#define FAST_FLOAT_MAX_EXPONENT 22
+
+#define IS_DIGIT(byte) ((byte) >= '0' && (byte) <= '9')
+
+// Same as isspace in the C locale, without the table lookup.
+#define IS_SPACE(byte) ((byte) == ' ' || ((byte) >= '\t' && (byte) <= '\r'))
+
+
+// ┌───────────┐
+// │ Constants │
+// └───────────┘
+
+static const double POWERS_OF_TEN[FAST_FLOAT_MAX_EXPONENT + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+// Makes room for at least size bytes after end.
+static void reserveInput(Input* input, size_t size);
+
+// Reads the next block. Returns false at the end of input.
+static bool fillInput(Input* input);
+
+static void skipWhitespace(Input* input);
+
+// Length of the non-whitespace bytes at start, which are
+// read completely into the buffer.
+static size_t bufferToken(Input* input);
+
+// Byte at the offset from start, which is read into the buffer if needed,
+// or -1 if the input ends before it.
+static inline int peekInput(Input* input, size_t offset);
+
+// Parses a float with strtod. It's used for the tokens the fast path
+// doesn't handle: long mantissas, big exponents, infinities and hex floats.
+static bool readFloatToken(Input* input, double* value);
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+void initInput(Input* input, int file_descriptor) {
+    assert(input);
+
+    input->file_descriptor = file_descriptor;
+    input->buffer = malloc(INPUT_BLOCK_SIZE);
+    input->capacity = INPUT_BLOCK_SIZE;
+    input->start = 0;
+    input->end = 0;
+    input->at_end = false;
+    input->tied_output = NULL;
+
+    ASSERT_INPUT(input);
+}
+
+void freeInput(Input* input) {
+    ASSERT_INPUT(input);
+
+    free(input->buffer);
+    input->buffer = NULL;
+    input->capacity = 0;
+    input->start = 0;
+    input->end = 0;
+}
+
+void dumpInput(const Input* input) {
+    fdumpInput(stdout, input, 0);
+}
+
+void fdumpInput(FILE* out, const Input* input, int padding) {
+    assert(out);
+
+#define printf(...)                                \
+    {                                              \
+        if (padding > 0) {                         \
+            fprintf(out, "%*s", padding * 2, " "); \
+        }                                          \
+        fprintf(out, __VA_ARGS__);                 \
+    }
+
+    if (!input) {
+        fprintf(out, "Input *(NULL)\n");
+    } else {
+        fprintf(out, "Input *(%p) %s {\n",
+            (const void*)input,
+            VALIDATE_INPUT(input) ? "VALID" : "INVALID"
+        );
+        printf("  file_descriptor = %d\n", input->file_descriptor);
+        printf("  buffer = *(%p)\n", (const void*)input->buffer);
+        printf("  capacity = %zu\n", input->capacity);
+        printf("  start = %zu\n", input->start);
+        printf("  end = %zu\n", input->end);
+        printf("  at_end = %s\n", input->at_end ? "true" : "false");
+        printf("  tied_output = *(%p)\n", (const void*)input->tied_output);
+        printf("}\n");
+    }
+
+#undef printf
+}
+
+bool readLine(Input* input, const uint8_t** line, size_t* length) {
+    ASSERT_INPUT(input);
+    assert(line);
+    assert(length);
+
+    // Bytes after start that are known not to contain a line break.
+    // It's an offset from start, because filling may move the bytes.
+    size_t searched = 0;
+    for (;;) {
+        size_t available = input->end - input->start;
+        if (available > searched) {
+            size_t found = findByte(input->buffer + input->start + searched, available - searched, '\n');
+            if (found != STRING_NOT_FOUND) {
+                *line = input->buffer + input->start;
+                *length = searched + found;
+                input->start += *length + 1;
+                return true;
+            }
+        }
+        searched = available;
+
+        if (!fillInput(input)) {
+            break;
+        }
+    }
+
+    // The last line may not end with a line break.
+    if (input->start == input->end) {
+        return false;
+    }
+    *line = input->buffer + input->start;
+    *length = input->end - input->start;
+    input->start = input->end;
+
+    ASSERT_INPUT(input);
+    return true;
+}
+
+void readAll(Input* input) {
+    ASSERT_INPUT(input);
+
+    while (fillInput(input)) {}
+
+    ASSERT_INPUT(input);
+}
+
+bool readBool(Input* input, bool* value) {
+    ASSERT_INPUT(input);
+    assert(value);
+
+    skipWhitespace(input);
+    size_t length = bufferToken(input);
+    const uint8_t* token = input->buffer + input->start;
+
+    if (length >= 4 && memcmp(token, "true", 4) == 0) {
+        input->start += 4;
+        *value = true;
+        return true;
+    }
+    if (length >= 5 && memcmp(token, "false", 5) == 0) {
+        input->start += 5;
+        *value = false;
+        return true;
+    }
+    return false;
+}
+
+bool readInt(Input* input, int32_t* value) {
+    ASSERT_INPUT(input);
+    assert(value);
+
+    skipWhitespace(input);
+
+    size_t length = 0;
+    int byte = peekInput(input, 0);
+    bool negative = byte == '-';
+    if (byte == '-' || byte == '+') {
+        length = 1;
+    }
+
+    // Wraps around on overflow, like strtol's result converted to int32_t.
+    size_t digits_start = length;
+    uint32_t magnitude = 0;
+    while (IS_DIGIT(byte = peekInput(input, length))) {
+        magnitude = magnitude * 10 + (uint32_t)(byte - '0');
+        ++length;
+    }
+    if (length == digits_start) {
+        return false;
+    }
+
+    input->start += length;
+    *value = (int32_t)(negative ? 0u - magnitude : magnitude);
+    return true;
+}
+
+bool readFloat(Input* input, double* value) {
+    ASSERT_INPUT(input);
+    assert(value);
+
+    skipWhitespace(input);
+
+    // The syntax is strtod's decimal one:
+    // [sign] digits [. digits] [(e|E) [sign] digits].
+    size_t length = 0;
+    int byte = peekInput(input, 0);
+    bool negative = byte == '-';
+    if (byte == '-' || byte == '+') {
+        length = 1;
+    }
+    size_t mantissa_start = length;
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    while (IS_DIGIT(byte = peekInput(input, length))) {
+        if (digits < FAST_FLOAT_MAX_DIGITS) {
+            mantissa = mantissa * 10 + (uint64_t)(byte - '0');
+        }
+        ++digits;
+        ++length;
+    }
+    if (byte == '.') {
+        ++length;
+        while (IS_DIGIT(byte = peekInput(input, length))) {
+            if (digits < FAST_FLOAT_MAX_DIGITS) {
+                mantissa = mantissa * 10 + (uint64_t)(byte - '0');
+            }
+            ++digits;
+            --exponent;
+            ++length;
+        }
+    }
+
+    if (digits == 0) {
+        // Not a decimal number, but may be "inf" or "nan".
+        int first = peekInput(input, mantissa_start);
+        if (first == '.' || first == -1 || IS_SPACE(first)) {
+            return false;
+        }
+        return readFloatToken(input, value);
+    }
+    // A hex float, like 0x1p3.
+    if ((byte == 'x' || byte == 'X') && length == mantissa_start + 1 && mantissa == 0) {
+        return readFloatToken(input, value);
+    }
+
+    if (byte == 'e' || byte == 'E') {
+        size_t exponent_length = 1;
+        int sign = peekInput(input, length + 1);
+        if (sign == '-' || sign == '+') {
+            exponent_length = 2;
+        }
+        if (IS_DIGIT(peekInput(input, length + exponent_length))) {
+            int written_exponent = 0;
+            while (IS_DIGIT(byte = peekInput(input, length + exponent_length))) {
+                // Bigger exponents take the strtod path anyway.
+                if (written_exponent < 10000) {
+                    written_exponent = written_exponent * 10 + (byte - '0');
+                }
+                ++exponent_length;
+            }
+            exponent += sign == '-' ? -written_exponent : written_exponent;
+            length += exponent_length;
+        }
+    }
+
+    if (
+        digits > FAST_FLOAT_MAX_DIGITS            ||
+        mantissa > FAST_FLOAT_MAX_MANTISSA        ||
+        exponent < -FAST_FLOAT_MAX_EXPONENT       ||
+        exponent > FAST_FLOAT_MAX_EXPONENT
+    ) {
+        return readFloatToken(input, value);
+    }
+
+    double parsed = (double)mantissa;
+    if (exponent < 0) {
+        parsed /= POWERS_OF_TEN[-exponent];
+    } else {
+        parsed *= POWERS_OF_TEN[exponent];
+    }
+
+    input->start += length;
+    *value = negative ? -parsed : parsed;
+    return true;
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static void reserveInput(Input* input, size_t size) {
+    ASSERT_INPUT(input);
+
+    if (input->capacity - input->end >= size) {
+        return;
+    }
+
+    // Move the unread bytes to the beginning.
+    memmove(input->buffer, input->buffer + input->start, input->end - input->start);
+    input->end -= input->start;
+    input->start = 0;
+
+    if (input->capacity - input->end < size) {
+        size_t new_capacity = input->capacity * 2;
+        if (new_capacity < input->end + size) {
+            new_capacity = input->end + size;
+        }
+        input->buffer = realloc(input->buffer, new_capacity);
+        input->capacity = new_capacity;
+    }
+
+    ASSERT_INPUT(input);
+}
+
+static bool fillInput(Input* input) {
+    ASSERT_INPUT(input);
+
+    if (input->at_end) {
+        return false;
+    }
+
+    reserveInput(input, INPUT_BLOCK_SIZE);
+
+    if (input->tied_output) {
+        flushOutput(input->tied_output);
+    }
+
+    ssize_t count;
+    do {
+        count = read(
+            input->file_descriptor,
+            input->buffer + input->end,
+            input->capacity - input->end
+        );
+    } while (count < 0 && errno == EINTR);
+
+    if (count <= 0) {
+        input->at_end = true;
+        return false;
+    }
+    input->end += (size_t)count;
+
+    ASSERT_INPUT(input);
+    return true;
+}
+
+static void skipWhitespace(Input* input) {
+    ASSERT_INPUT(input);
+
+    do {
+        while (input->start < input->end && IS_SPACE(input->buffer[input->start])) {
+            ++input->start;
+        }
+    } while (input->start == input->end && fillInput(input));
+}
+
+static size_t bufferToken(Input* input) {
+    ASSERT_INPUT(input);
+
+    size_t length = 0;
+    do {
+        while (input->start + length < input->end && !IS_SPACE(input->buffer[input->start + length])) {
+            ++length;
+        }
+    } while (input->start + length == input->end && fillInput(input));
+
+    return length;
+}
+
+static inline int peekInput(Input* input, size_t offset) {
+    while (input->start + offset >= input->end) {
+        if (!fillInput(input)) {
+            return -1;
+        }
+    }
+    return input->buffer[input->start + offset];
+}
+
+static bool readFloatToken(Input* input, double* value) {
+    ASSERT_INPUT(input);
+    assert(value);
+
+    size_t length = bufferToken(input);
+
+    // strtod needs a null terminated string, so the byte after the token
+    // is replaced for the call. The token may be of any length.
+    reserveInput(input, 1);
+    char* token = (char*)input->buffer + input->start;
+    char after_token = token[length];
+    token[length] = '\0';
+
+    char* token_end;
+    double parsed = strtod(token, &token_end);
+    token[length] = after_token;
+    if (token_end == token) {
+        return false;
+    }
+
+    input->start += (size_t)(token_end - token);
+    *value = parsed;
+    return true;
+}
+
+
+#undef IS_SPACE
+#undef IS_DIGIT
+#undef FAST_FLOAT_MAX_EXPONENT
+#undef FAST_FLOAT_MAX_MANTISSA
+#undef FAST_FLOAT_MAX_DIGITS
+
+#undef ASSERT_INPUT
+#undef VALIDATE_INPUT
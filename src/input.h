@@ -0,0 +1,71 @@
+#ifndef lala_input_h
+#define lala_input_h
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "output.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Input is read with read(2) in blocks of at least this size.
+#define INPUT_BLOCK_SIZE (64 * 1024)
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+/* Buffered reader of a file descriptor.
+ *
+ * The unread bytes are buffer[start, end). Values are parsed and strings
+ * are copied right from the buffer. The buffer grows if a line or a token
+ * doesn't fit in it.
+ * */
+typedef struct {
+    int file_descriptor;
+    uint8_t* buffer;
+    size_t capacity;
+    size_t start;
+    size_t end;
+    // Set when read(2) returns 0 or fails.
+    bool at_end;
+    // Flushed before reading, so that a prompt is visible while
+    // the program waits for input. NULL after initInput.
+    Output* tied_output;
+} Input;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+void initInput(Input* input, int file_descriptor);
+void freeInput(Input* input);
+void dumpInput(const Input* input);
+void fdumpInput(FILE* out, const Input* input, int padding);
+
+/* Reads the rest of the current line without the line break.
+ * Returns false if there's no input left. Otherwise the line is
+ * *line[0, *length), which is valid until the next call on the input.
+ * */
+bool readLine(Input* input, const uint8_t** line, size_t* length);
+
+// Reads all the remaining input into the buffer, so that
+// the unread bytes are buffer[start, end).
+void readAll(Input* input);
+
+// These skip whitespace before the value, like scanf.
+// They return false if there's no valid value.
+bool readBool (Input* input, bool* value);
+bool readInt  (Input* input, int32_t* value);
+bool readFloat(Input* input, double* value);
+
+
+#endif
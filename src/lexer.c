@@ -511,10 +511,14 @@ static TokenType identifierTokenType(const Lexer* lexer) {
                                              'r', "break",     TOKEN_BREAK);
         case 'e': TRY_MATCH_TWO_KEYWORDS( 1, 'l', "else",      TOKEN_ELSE,
                                              'n', "enum",      TOKEN_ENUM);
-        case 'f': TRY_MATCH_FOUR_KEYWORDS(1, 'a', "false",     TOKEN_FALSE,
-                                             'l', "float",     TOKEN_FLOAT,
-                                             'o', "for",       TOKEN_FOR,
-                                             'u', "function",  TOKEN_FUNCTION);
+        case 'f':
+            if (length == 7) {
+                return tryMatchKeyword(lexer, "float32", TOKEN_FLOAT32);
+            }
+            TRY_MATCH_FOUR_KEYWORDS(1, 'a', "false",     TOKEN_FALSE,
+                                       'l', "float",     TOKEN_FLOAT,
+                                       'o', "for",       TOKEN_FOR,
+                                       'u', "function",  TOKEN_FUNCTION);
         case 'p': TRY_MATCH_TWO_KEYWORDS( 2, 'e', "predicate", TOKEN_PREDICATE,
                                              'i', "print",     TOKEN_PRINT);
         case 'r': TRY_MATCH_TWO_KEYWORDS( 2, 'a', "read",      TOKEN_READ,
@@ -532,6 +536,10 @@ static TokenType identifierTokenType(const Lexer* lexer) {
                 }
             } else if (length == 3) {
                 return tryMatchKeyword(lexer, "int", TOKEN_INT);
+            } else if (length == 4) {
+                return tryMatchKeyword(lexer, "int8", TOKEN_INT8);
+            } else if (length == 5) {
+                return tryMatchKeyword(lexer, "int16", TOKEN_INT16);
             } else {
                 return tryMatchKeyword(lexer, "include", TOKEN_INCLUDE);
             }
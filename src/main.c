@@ -3,7 +3,12 @@
 
 
 #include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
 
+#include "map.h"
 #include "path.h"
 
 
@@ -20,6 +25,8 @@ typedef struct {
     LalaMode mode;
     const char* input_filename;
     const char* output_filename;
+    HeapConfig heap_config;
+    OutputBuffering output_buffering;
 } LalaArguments;
 
 typedef struct {
@@ -33,10 +40,30 @@ typedef struct {
 
 #define LALABY_HEADER_SIZE (3 * sizeof(uint8_t) + 4 * sizeof(size_t))
 
+// Options of the execute mode. Each option can also be set
+// with an environment variable, for example LALA_HEAP_LIMIT.
+// Options take precedence over environment variables.
+static const char* EXECUTE_OPTIONS[] = {
+    "gc-initial-threshold",
+    "gc-growth-factor",
+    "gc-compaction-threshold",
+    "heap-min",
+    "heap-max",
+    "heap-limit",
+    "string-intern-max-size",
+    "output-buffering",
+};
+#define EXECUTE_OPTIONS_COUNT (sizeof(EXECUTE_OPTIONS) / sizeof(EXECUTE_OPTIONS[0]))
+
 
 static LalaMode parseMode(const char* modeStr);
 static LalaArguments parseArguments(int argc, const char* argv[]);
 
+static bool readExecuteOptionsFromEnvironment(LalaArguments* arguments);
+static bool parseExecuteOption(LalaArguments* arguments, const char* option);
+static bool setExecuteOption(LalaArguments* arguments, const char* name, const char* value);
+static bool parseSize(const char* str, size_t* size);
+
 static void fillLalabyHeader(LalabyHeader* header, const Parser* parser);
 static void   serializeLalabyHeader(FILE* file, const LalabyHeader* header);
 static void deserializeLalabyHeader(
@@ -136,19 +163,37 @@ static LalaArguments parseArguments(int argc, const char* argv[]) {
                 arguments.mode = LALA_INVALID;
             }
             break;
-        case LALA_EXECUTE:
-            if (argc == 3) {
-                arguments.input_filename = argv[2];
-            } else {
+        case LALA_EXECUTE: {
+            initHeapConfig(&arguments.heap_config);
+            arguments.output_buffering = OUTPUT_BUFFERING_AUTO;
+            if (!readExecuteOptionsFromEnvironment(&arguments)) {
+                arguments.mode = LALA_INVALID;
+                break;
+            }
+
+            int files_count = 0;
+            for (int i = 2; i < argc; ++i) {
+                if (strncmp(argv[i], "--", 2) == 0) {
+                    if (!parseExecuteOption(&arguments, argv[i])) {
+                        arguments.mode = LALA_INVALID;
+                    }
+                } else {
+                    arguments.input_filename = argv[i];
+                    ++files_count;
+                }
+            }
+
+            if (arguments.mode != LALA_INVALID && files_count != 1) {
                 fprintf(stderr,
                     "Expected 1 argument in execute mode: "
                     "input file name. Got %d arguments.\n"
-                    "%s %s <input file name>\n",
-                    argc - 2, argv[0], argv[1]
+                    "%s %s [<options>] <input file name>\n",
+                    files_count, argv[0], argv[1]
                 );
                 arguments.mode = LALA_INVALID;
             }
             break;
+        }
         case LALA_INTERPRET:
             if (argc == 3) {
                 arguments.input_filename = argv[2];
@@ -180,6 +225,149 @@ static LalaArguments parseArguments(int argc, const char* argv[]) {
     return arguments;
 }
 
+static bool readExecuteOptionsFromEnvironment(LalaArguments* arguments) {
+    assert(arguments);
+
+    for (size_t i = 0; i < EXECUTE_OPTIONS_COUNT; ++i) {
+        // gc-initial-threshold -> LALA_GC_INITIAL_THRESHOLD
+        char variable[64] = "LALA_";
+        size_t length = strlen(variable);
+        for (const char* c = EXECUTE_OPTIONS[i]; *c != '\0'; ++c, ++length) {
+            variable[length] = *c == '-' ? '_' : (char)toupper(*c);
+        }
+        variable[length] = '\0';
+
+        const char* value = getenv(variable);
+        if (value != NULL && !setExecuteOption(arguments, EXECUTE_OPTIONS[i], value)) {
+            fprintf(stderr, "Invalid value '%s' of environment variable %s.\n", value, variable);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool parseExecuteOption(LalaArguments* arguments, const char* option) {
+    assert(arguments);
+    assert(option);
+
+    // --<name>=<value>
+    const char* name = option + 2;
+    const char* value = strchr(name, '=');
+    if (value == NULL) {
+        fprintf(stderr, "Expected a value of option '%s': %s=<value>.\n", option, option);
+        return false;
+    }
+    size_t name_length = (size_t)(value - name);
+    ++value;
+
+    for (size_t i = 0; i < EXECUTE_OPTIONS_COUNT; ++i) {
+        if (
+            strlen(EXECUTE_OPTIONS[i]) == name_length &&
+            strncmp(EXECUTE_OPTIONS[i], name, name_length) == 0
+        ) {
+            if (!setExecuteOption(arguments, EXECUTE_OPTIONS[i], value)) {
+                fprintf(stderr, "Invalid value '%s' of option --%s.\n", value, EXECUTE_OPTIONS[i]);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    fprintf(stderr, "Unknown option '%.*s'.\n", (int)(name_length + 2), option);
+    return false;
+}
+
+static bool setExecuteOption(LalaArguments* arguments, const char* name, const char* value) {
+    assert(arguments);
+    assert(name);
+    assert(value);
+
+    HeapConfig* config = &arguments->heap_config;
+
+    if (strcmp(name, "gc-initial-threshold") == 0) {
+        return parseSize(value, &config->initial_threshold);
+    }
+    if (strcmp(name, "heap-min") == 0) {
+        return parseSize(value, &config->min_size);
+    }
+    if (strcmp(name, "heap-max") == 0) {
+        return parseSize(value, &config->max_size);
+    }
+    if (strcmp(name, "heap-limit") == 0) {
+        return parseSize(value, &config->limit);
+    }
+    if (strcmp(name, "string-intern-max-size") == 0) {
+        return parseSize(value, &config->intern_max_size);
+    }
+
+    if (strcmp(name, "gc-growth-factor") == 0) {
+        char* end;
+        double factor = strtod(value, &end);
+        if (end == value || *end != '\0' || !isfinite(factor) || factor < 0.0 || factor > GC_MAX_GROWTH_FACTOR) {
+            return false;
+        }
+        config->growth_factor = factor;
+        return true;
+    }
+
+    if (strcmp(name, "gc-compaction-threshold") == 0) {
+        char* end;
+        errno = 0;
+        unsigned long percentage = strtoul(value, &end, 10);
+        if (!isdigit(*value) || *end != '\0' || errno != 0 || percentage > 100) {
+            return false;
+        }
+        config->compaction_threshold = (uint8_t)percentage;
+        return true;
+    }
+
+    if (strcmp(name, "output-buffering") == 0) {
+        OutputBuffering modes[] = {
+            OUTPUT_BUFFERING_AUTO,
+            OUTPUT_BUFFERING_FULL,
+            OUTPUT_BUFFERING_LINE,
+        };
+        for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+            if (strcmp(value, outputBufferingName(modes[i])) == 0) {
+                arguments->output_buffering = modes[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    assert(false);
+    return false;
+}
+
+// Parses a size in bytes with an optional K, M or G suffix.
+static bool parseSize(const char* str, size_t* size) {
+    assert(str);
+    assert(size);
+
+    char* end;
+    errno = 0;
+    unsigned long long value = strtoull(str, &end, 10);
+    if (!isdigit(*str) || errno != 0) {
+        return false;
+    }
+
+    unsigned long long multiplier = 1;
+    switch (*end) {
+        case 'K': case 'k': multiplier = 1024ULL;               ++end; break;
+        case 'M': case 'm': multiplier = 1024ULL * 1024;        ++end; break;
+        case 'G': case 'g': multiplier = 1024ULL * 1024 * 1024; ++end; break;
+        default: break;
+    }
+    if (*end != '\0' || value > SIZE_MAX / multiplier) {
+        return false;
+    }
+
+    *size = (size_t)(value * multiplier);
+    return true;
+}
+
 static void fillLalabyHeader(LalabyHeader* header, const Parser* parser) {
     assert(header);
     assert(parser);
@@ -252,9 +440,21 @@ static void help(LalaArguments arguments) {
     printf("Available commands:\n");
     printf("  help - Print this message\n");
     printf("  compile <lala file> <lalaby output file> - Compile lala source file into lalaby bytecode file.\n");
-    printf("  execute <lalaby file> - Execute the given lalaby bytecode file.\n");
+    printf("  execute [<options>] <lalaby file> - Execute the given lalaby bytecode file.\n");
     printf("  interpret <lala file> - Compile the given lala source file and execute it right away.\n");
     printf("  disassemble <lalaby file> - Disassemble the given lalaby bytecode file.\n");
+
+    printf("\nExecute options:\n");
+    printf("  --gc-initial-threshold=<size> - Heap size at which the first garbage collection happens.\n");
+    printf("  --gc-growth-factor=<factor> - The next collection happens when the heap grows to the reachable size times factor, at most 1000.\n");
+    printf("  --gc-compaction-threshold=<percent> - Compact the heap if more than percent of it is free. 0 disables compaction.\n");
+    printf("  --heap-min=<size> - Don't collect garbage until the heap grows to size.\n");
+    printf("  --heap-max=<size> - Always collect garbage when the heap grows to size.\n");
+    printf("  --heap-limit=<size> - Fail with an out of memory error when the heap can't fit into size.\n");
+    printf("  --string-intern-max-size=<size> - Intern strings of up to size bytes created at run time. 0 disables it.\n");
+    printf("  --output-buffering=<auto|full|line> - Write the output when the buffer is full, or after every line. auto is line for a terminal.\n");
+    printf("Sizes are in bytes and may have a K, M or G suffix. Each option can also be set with an\n");
+    printf("environment variable, for example LALA_HEAP_LIMIT=64M.\n");
 }
 
 static void compile(LalaArguments arguments) {
@@ -333,6 +533,8 @@ static void execute(LalaArguments arguments) {
 
     VM vm;
     initVM(&vm, program, header.program_length, &constants);
+    setHeapConfig(&vm.heap, &arguments.heap_config);
+    setOutputBuffering(&vm.output, arguments.output_buffering);
 
     interpret(&vm);
 
@@ -393,6 +595,12 @@ static void disassemble(LalaArguments arguments) {
         switch (*ip++) {
             case OP_PUSH_BYTE:
             case OP_LOAD_CONSTANT:
+            case OP_ARRAY_LENGTH:
+            case OP_ARRAY_RESERVE:
+            case OP_ARRAY_TRUNCATE:
+            case OP_ARRAY_COPY:
+            case OP_ARRAY_SLICE:
+            case OP_ARRAY_TO_MATRIX:
                 printf(" %u", *(uint8_t*)ip);
                 ip += sizeof(uint8_t);
                 break;
@@ -414,8 +622,44 @@ static void disassemble(LalaArguments arguments) {
                 ip += sizeof(uint8_t);
                 break;
 
+            case OP_ARRAY_SORT_BY:
+                printf(" %u", *(uint8_t*)ip);
+                ip += sizeof(uint8_t);
+                printf(" %s", *ip++ ? "references" : "values");
+                break;
+
+            case OP_DEFINE_MAP:
+                printf(" %lu", *(size_t*)ip);
+                ip += sizeof(size_t);
+                printf(" %s", mapItemKindName((MapItemKind)*ip++));
+                printf(" %s", mapItemKindName((MapItemKind)*ip++));
+                break;
+
+            case OP_MAP_GET:
+            case OP_MAP_SET:
+            case OP_MAP_CONTAINS:
+            case OP_MAP_DELETE:
+                printf(" %s", mapItemKindName((MapItemKind)*ip++));
+                printf(" %s", mapItemKindName((MapItemKind)*ip++));
+                break;
+
+            case OP_CONCATENATE_N: {
+                uint8_t count = *ip++;
+                printf(" %u", count);
+                for (uint8_t i = 0; i < count; ++i) {
+                    switch (*ip++) {
+                        case CONCATENATE_OPERAND_STRING: printf(" string"); break;
+                        case CONCATENATE_OPERAND_INT:    printf(" int");    break;
+                        case CONCATENATE_OPERAND_FLOAT:  printf(" float");  break;
+                        default:                         printf(" ?");      break;
+                    }
+                }
+                break;
+            }
+
             case OP_PUSH_ADDRESS:
             case OP_POP_BYTES:
+            case OP_DEFINE_BITS_ON_HEAP:
 
             case OP_GET_BYTE_FROM_HEAP:
             case OP_GET_INT_FROM_HEAP:
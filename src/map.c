@@ -0,0 +1,470 @@
+#include "map.h"
+
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "debug.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define VALIDATE_MAP(map)                                           \
+    (                                                               \
+        map                                                      && \
+        map->reference_rule == REFERENCE_RULE_REF_ARRAY          && \
+        map->size == sizeof(size_t)                              && \
+        MAP_TABLE_OBJECT(map)                                    && \
+        MAP_TABLE_OBJECT(map)->reference_rule ==                    \
+            REFERENCE_RULE_MAP_TABLE                             && \
+        MAP_TABLE(map)->capacity >= MAP_MIN_CAPACITY             && \
+        (MAP_TABLE(map)->capacity & (MAP_TABLE(map)->capacity - 1)) \
+            == 0                                                 && \
+        MAP_TABLE(map)->count + MAP_TABLE(map)->growth_left <=      \
+            maxMapCount(MAP_TABLE(map)->capacity)                   \
+    )
+
+#define ASSERT_MAP(map)                               \
+    if (!VALIDATE_MAP(map)) {                         \
+        fprintf(stderr,                               \
+            "%s:%d, in %s:\nMap assertion failed.\n", \
+            __FILENAME__,                             \
+            __LINE__,                                 \
+            __FUNCTION_NAME__                         \
+        );                                            \
+        fdumpObject(stderr, map, 0);                  \
+        exit(1);                                      \
+    }
+
+#define MAP_TABLE_OBJECT(map) (*(Object**)(map)->value)
+#define MAP_TABLE(map)        ((MapTable*)MAP_TABLE_OBJECT(map)->value)
+
+// Returned by findSlot if there's no slot with the key.
+#define SLOT_NOT_FOUND SIZE_MAX
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+static size_t maxMapCount(size_t capacity);
+static size_t mapCapacityFor(size_t count);
+static size_t mapTableSize(size_t capacity);
+
+// Allocates a table without items. Returns NULL if the allocation fails.
+static Object* allocateMapTable(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    MapItemKind key_kind,
+    MapItemKind value_kind,
+    size_t capacity
+);
+
+// Keys are hashed with the multiplicative hash, which spreads them
+// to the high bits, and the high bits are folded into the low ones.
+// Hashes of string keys are cached in the strings.
+static uint64_t hashKey(MapItemKind key_kind, size_t key);
+static bool keysEqual(MapItemKind key_kind, size_t left, size_t right);
+
+// Bits of the slots of a group with the given control byte,
+// and with empty or deleted control bytes.
+static uint32_t matchControl(const uint8_t* group, uint8_t control);
+static uint32_t matchFree(const uint8_t* group);
+
+// Returns the index of the slot with the key, or SLOT_NOT_FOUND.
+// Sets *free_slot to the first slot without an item on the probe path
+// if free_slot isn't NULL.
+static size_t findSlot(MapTable* table, size_t key, uint64_t hash, size_t* free_slot);
+static void setControl(MapTable* table, size_t slot, uint8_t control);
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+const char* mapItemKindName(MapItemKind kind) {
+    switch (kind) {
+        case MAP_ITEM_UNKNOWN:   return "unknown";
+        case MAP_ITEM_BOOL:      return "bool";
+        case MAP_ITEM_INT:       return "int";
+        case MAP_ITEM_FLOAT:     return "float";
+        case MAP_ITEM_STRING:    return "string";
+        case MAP_ITEM_REFERENCE: return "reference";
+        default:                 return "INVALID";
+    }
+}
+
+size_t mapItemSize(MapItemKind kind) {
+    switch (kind) {
+        case MAP_ITEM_BOOL:      return sizeof(uint8_t);
+        case MAP_ITEM_INT:       return sizeof(int32_t);
+        case MAP_ITEM_FLOAT:     return sizeof(double);
+        case MAP_ITEM_STRING:
+        case MAP_ITEM_REFERENCE: return sizeof(size_t);
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+bool isMapItemReference(MapItemKind kind) {
+    return kind == MAP_ITEM_STRING || kind == MAP_ITEM_REFERENCE;
+}
+
+uint8_t* mapTableControls(MapTable* table) {
+    assert(table);
+    return (uint8_t*)(table + 1);
+}
+
+MapSlot* mapTableSlots(MapTable* table) {
+    assert(table);
+    return (MapSlot*)(mapTableControls(table) + table->capacity);
+}
+
+Object* allocateMap(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    MapItemKind key_kind,
+    MapItemKind value_kind,
+    size_t count
+) {
+    assert(heap);
+
+    Object* table = allocateMapTable(
+        heap,
+        stack,
+        stack_references_positions,
+        key_kind,
+        value_kind,
+        mapCapacityFor(count)
+    );
+    if (!table) {
+        return NULL;
+    }
+
+    dontCollectObjectOnNextGC(heap, table);
+    Object* map = allocateEmptyObject(
+        heap,
+        stack,
+        stack_references_positions,
+        REFERENCE_RULE_REF_ARRAY,
+        NULL,
+        sizeof(size_t)
+    );
+    if (!map) {
+        return NULL;
+    }
+    MAP_TABLE_OBJECT(map) = table;
+
+    ASSERT_MAP(map);
+    return map;
+}
+
+bool reserveMap(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* map,
+    size_t count
+) {
+    assert(heap);
+    ASSERT_MAP(map);
+
+    MapTable* old_table = MAP_TABLE(map);
+    if (old_table->growth_left >= count) {
+        return true;
+    }
+
+    // The new table is sized for the items only, so a table full
+    // of deleted slots is rebuilt without growing.
+    dontCollectObjectOnNextGC(heap, map);
+    dontCollectObjectOnNextGC(heap, MAP_TABLE_OBJECT(map));
+    Object* table_object = allocateMapTable(
+        heap,
+        stack,
+        stack_references_positions,
+        old_table->key_kind,
+        old_table->value_kind,
+        mapCapacityFor(old_table->count + count)
+    );
+    if (!table_object) {
+        return false;
+    }
+
+    // The keys are unique, so each is put into the first empty slot
+    // on its probe path.
+    MapTable* table = (MapTable*)table_object->value;
+    const uint8_t* old_controls = mapTableControls(old_table);
+    const MapSlot* old_slots = mapTableSlots(old_table);
+    MapSlot* slots = mapTableSlots(table);
+    size_t groups_mask = table->capacity / MAP_GROUP_SIZE - 1;
+
+    for (size_t i = 0; i < old_table->capacity; ++i) {
+        if (!IS_MAP_CONTROL_FULL(old_controls[i])) {
+            continue;
+        }
+
+        uint64_t hash = hashKey(table->key_kind, old_slots[i].key);
+        size_t group = (size_t)(hash >> 7) & groups_mask;
+        uint32_t empty = matchControl(mapTableControls(table) + group * MAP_GROUP_SIZE, MAP_CONTROL_EMPTY);
+        for (size_t step = 1; empty == 0; ++step) {
+            group = (group + step) & groups_mask;
+            empty = matchControl(mapTableControls(table) + group * MAP_GROUP_SIZE, MAP_CONTROL_EMPTY);
+        }
+
+        size_t slot = group * MAP_GROUP_SIZE + (size_t)__builtin_ctz(empty);
+        setControl(table, slot, (uint8_t)(hash & 0x7F));
+        slots[slot] = old_slots[i];
+    }
+    table->count = old_table->count;
+    table->growth_left -= old_table->count;
+
+    MAP_TABLE_OBJECT(map) = table_object;
+
+    ASSERT_MAP(map);
+    return true;
+}
+
+size_t mapCount(const Object* map) {
+    ASSERT_MAP(map);
+    return MAP_TABLE(map)->count;
+}
+
+MapSlot* findInMap(Object* map, size_t key) {
+    ASSERT_MAP(map);
+
+    MapTable* table = MAP_TABLE(map);
+    if (table->count == 0) {
+        return NULL;
+    }
+
+    size_t slot = findSlot(table, key, hashKey(table->key_kind, key), NULL);
+    return slot == SLOT_NOT_FOUND ? NULL : &mapTableSlots(table)[slot];
+}
+
+MapSlot* insertIntoMap(
+    Object* map,
+    MapItemKind key_kind,
+    MapItemKind value_kind,
+    size_t key
+) {
+    ASSERT_MAP(map);
+    assert(key_kind != MAP_ITEM_UNKNOWN);
+
+    MapTable* table = MAP_TABLE(map);
+    if (table->key_kind == MAP_ITEM_UNKNOWN) {
+        assert(table->count == 0);
+        table->key_kind = key_kind;
+        table->value_kind = value_kind;
+    }
+    assert(table->key_kind == key_kind);
+    assert(table->value_kind == value_kind);
+
+    uint64_t hash = hashKey(key_kind, key);
+    size_t free_slot;
+    size_t slot = findSlot(table, key, hash, &free_slot);
+    if (slot != SLOT_NOT_FOUND) {
+        return &mapTableSlots(table)[slot];
+    }
+
+    uint8_t* controls = mapTableControls(table);
+    if (controls[free_slot] == MAP_CONTROL_EMPTY) {
+        if (table->growth_left == 0) {
+            return NULL;
+        }
+        table->growth_left -= 1;
+    }
+    setControl(table, free_slot, (uint8_t)(hash & 0x7F));
+    table->count += 1;
+
+    MapSlot* result = &mapTableSlots(table)[free_slot];
+    result->key = key;
+    result->value = 0;
+    return result;
+}
+
+bool deleteFromMap(Object* map, size_t key) {
+    ASSERT_MAP(map);
+
+    MapTable* table = MAP_TABLE(map);
+    if (table->count == 0) {
+        return false;
+    }
+
+    size_t slot = findSlot(table, key, hashKey(table->key_kind, key), NULL);
+    if (slot == SLOT_NOT_FOUND) {
+        return false;
+    }
+
+    // Probing stops at a group with an empty slot, so if the group
+    // already has one, no probe path goes past it, and the slot may
+    // become empty too. Otherwise it's marked as deleted, so that
+    // the probing of the keys that went past the group goes on.
+    const uint8_t* group = mapTableControls(table) + slot / MAP_GROUP_SIZE * MAP_GROUP_SIZE;
+    if (matchControl(group, MAP_CONTROL_EMPTY) != 0) {
+        setControl(table, slot, MAP_CONTROL_EMPTY);
+        table->growth_left += 1;
+    } else {
+        setControl(table, slot, MAP_CONTROL_DELETED);
+    }
+    table->count -= 1;
+
+    ASSERT_MAP(map);
+    return true;
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static size_t maxMapCount(size_t capacity) {
+    return capacity / MAP_MAX_LOAD_DENOMINATOR * MAP_MAX_LOAD_NUMERATOR;
+}
+
+static size_t mapCapacityFor(size_t count) {
+    size_t capacity = MAP_MIN_CAPACITY;
+    while (maxMapCount(capacity) < count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+static size_t mapTableSize(size_t capacity) {
+    return sizeof(MapTable) + capacity * (sizeof(uint8_t) + sizeof(MapSlot));
+}
+
+static Object* allocateMapTable(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    MapItemKind key_kind,
+    MapItemKind value_kind,
+    size_t capacity
+) {
+    assert(heap);
+    assert(capacity >= MAP_MIN_CAPACITY);
+    assert((capacity & (capacity - 1)) == 0);
+
+    Object* object = allocateEmptyObject(
+        heap,
+        stack,
+        stack_references_positions,
+        REFERENCE_RULE_MAP_TABLE,
+        NULL,
+        mapTableSize(capacity)
+    );
+    if (!object) {
+        return NULL;
+    }
+
+    MapTable* table = (MapTable*)object->value;
+    table->capacity = capacity;
+    table->count = 0;
+    table->growth_left = maxMapCount(capacity);
+    table->key_kind = key_kind;
+    table->value_kind = value_kind;
+    memset(mapTableControls(table), MAP_CONTROL_EMPTY, capacity);
+
+    return object;
+}
+
+static uint64_t hashKey(MapItemKind key_kind, size_t key) {
+    uint64_t hash = key_kind == MAP_ITEM_STRING ? stringHash((Object*)key) : (uint64_t)key;
+    hash *= UINT64_C(0x9E3779B97F4A7C15);
+    return hash ^ (hash >> 32);
+}
+
+static bool keysEqual(MapItemKind key_kind, size_t left, size_t right) {
+    if (key_kind == MAP_ITEM_STRING) {
+        return stringsEqual((Object*)left, (Object*)right);
+    }
+    return left == right;
+}
+
+static uint32_t matchControl(const uint8_t* group, uint8_t control) {
+#ifdef __SSE2__
+    __m128i controls = _mm_loadu_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8((char)control)));
+#else
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < MAP_GROUP_SIZE; ++i) {
+        bits |= (uint32_t)(group[i] == control) << i;
+    }
+    return bits;
+#endif
+}
+
+static uint32_t matchFree(const uint8_t* group) {
+#ifdef __SSE2__
+    // Only the control bytes without items have the high bit set.
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < MAP_GROUP_SIZE; ++i) {
+        bits |= (uint32_t)!IS_MAP_CONTROL_FULL(group[i]) << i;
+    }
+    return bits;
+#endif
+}
+
+// Groups are probed triangularly: 1, 2, 3... groups after the previous
+// one. With a power of two number of groups, every group is visited,
+// and at least one of them has an empty slot.
+static size_t findSlot(MapTable* table, size_t key, uint64_t hash, size_t* free_slot) {
+    assert(table);
+
+    const uint8_t* controls = mapTableControls(table);
+    const MapSlot* slots = mapTableSlots(table);
+    uint8_t control = (uint8_t)(hash & 0x7F);
+    size_t groups_mask = table->capacity / MAP_GROUP_SIZE - 1;
+    size_t group = (size_t)(hash >> 7) & groups_mask;
+
+    if (free_slot) {
+        *free_slot = SLOT_NOT_FOUND;
+    }
+
+    for (size_t step = 1; ; ++step) {
+        const uint8_t* group_controls = controls + group * MAP_GROUP_SIZE;
+
+        for (uint32_t bits = matchControl(group_controls, control); bits != 0; bits &= bits - 1) {
+            size_t slot = group * MAP_GROUP_SIZE + (size_t)__builtin_ctz(bits);
+            if (keysEqual(table->key_kind, slots[slot].key, key)) {
+                return slot;
+            }
+        }
+
+        if (free_slot && *free_slot == SLOT_NOT_FOUND) {
+            uint32_t free_bits = matchFree(group_controls);
+            if (free_bits != 0) {
+                *free_slot = group * MAP_GROUP_SIZE + (size_t)__builtin_ctz(free_bits);
+            }
+        }
+
+        if (matchControl(group_controls, MAP_CONTROL_EMPTY) != 0) {
+            return SLOT_NOT_FOUND;
+        }
+        group = (group + step) & groups_mask;
+    }
+}
+
+static void setControl(MapTable* table, size_t slot, uint8_t control) {
+    assert(slot < table->capacity);
+    mapTableControls(table)[slot] = control;
+}
+
+
+#undef SLOT_NOT_FOUND
+#undef MAP_TABLE
+#undef MAP_TABLE_OBJECT
+#undef ASSERT_MAP
+#undef VALIDATE_MAP
@@ -0,0 +1,133 @@
+#ifndef lala_map_h
+#define lala_map_h
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "heap.h"
+#include "stack.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Slots are probed in groups, comparing the control bytes
+// of a whole group at once.
+#define MAP_GROUP_SIZE   16
+#define MAP_MIN_CAPACITY MAP_GROUP_SIZE
+
+// A table grows when more than 7/8 of its slots would be taken.
+#define MAP_MAX_LOAD_NUMERATOR   7
+#define MAP_MAX_LOAD_DENOMINATOR 8
+
+// Control bytes of the slots without items. A full slot has the low
+// 7 bits of the hash of its key as its control byte.
+#define MAP_CONTROL_EMPTY   0x80
+#define MAP_CONTROL_DELETED 0xFE
+#define IS_MAP_CONTROL_FULL(control) (((control) & 0x80) == 0)
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+// Kinds of keys and values, they tell how items are compared, hashed
+// and traced. Keys may only be bools, ints and strings.
+typedef enum {
+    // Kinds of an empty map literal, which doesn't know its type.
+    // The map takes the kinds of the first item inserted.
+    MAP_ITEM_UNKNOWN,
+    MAP_ITEM_BOOL,
+    MAP_ITEM_INT,
+    MAP_ITEM_FLOAT,
+    // Strings are compared by value.
+    MAP_ITEM_STRING,
+    // Arrays, maps and objects are compared by address.
+    MAP_ITEM_REFERENCE,
+} MapItemKind;
+
+// Items are widened to size_t: bools and ints are zero extended,
+// floats keep their bits, references are addresses.
+typedef struct {
+    size_t key;
+    size_t value;
+} MapSlot;
+
+/* Value of a REFERENCE_RULE_MAP_TABLE object.
+ *
+ * The table is followed by capacity control bytes and capacity slots.
+ * The capacity is a power of two, at least MAP_MIN_CAPACITY.
+ * A map is a ref array with the address of its table as the only item,
+ * so that a table is replaced with a bigger one when it's full.
+ * */
+typedef struct {
+    size_t capacity;
+    size_t count;
+    // Number of empty slots that may be taken before the table grows.
+    // Deleted slots are reused, but aren't counted here.
+    size_t growth_left;
+    MapItemKind key_kind;
+    MapItemKind value_kind;
+} MapTable;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+const char* mapItemKindName(MapItemKind kind);
+// Size of an item on the stack.
+size_t mapItemSize(MapItemKind kind);
+bool isMapItemReference(MapItemKind kind);
+
+uint8_t* mapTableControls(MapTable* table);
+MapSlot* mapTableSlots(MapTable* table);
+
+// Allocates an empty map with room for count items.
+// Returns NULL if the allocation fails.
+Object* allocateMap(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    MapItemKind key_kind,
+    MapItemKind value_kind,
+    size_t count
+);
+
+/* Makes sure count more items may be inserted without growing the table.
+ * The map isn't moved by the allocation, but other objects may be.
+ * Returns false if the allocation fails.
+ * */
+bool reserveMap(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* map,
+    size_t count
+);
+
+size_t mapCount(const Object* map);
+
+// Returns the slot of the key, or NULL if it isn't in the map.
+MapSlot* findInMap(Object* map, size_t key);
+
+/* Returns the slot of the key, adding the key if it isn't in the map.
+ * The value of an added slot is set to 0 and has to be set before
+ * the next allocation. Returns NULL if the table has to grow first,
+ * see reserveMap.
+ * */
+MapSlot* insertIntoMap(
+    Object* map,
+    MapItemKind key_kind,
+    MapItemKind value_kind,
+    size_t key
+);
+
+// Returns false if the key isn't in the map.
+bool deleteFromMap(Object* map, size_t key);
+
+
+#endif
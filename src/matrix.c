@@ -0,0 +1,110 @@
+#include "matrix.h"
+
+
+#include <assert.h>
+#include <string.h>
+
+#include "array.h"
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+Object* allocateMatrix(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    uint32_t rows,
+    uint32_t columns,
+    const void* item,
+    size_t item_size
+) {
+    assert(heap);
+    assert(item);
+    assert(item_size > 0);
+
+    uint64_t count = (uint64_t)rows * columns;
+    if (count > (SIZE_MAX - sizeof(MatrixShape)) / item_size) {
+        return NULL;
+    }
+    size_t items_size = (size_t)count * item_size;
+
+    bool is_zero = true;
+    for (size_t i = 0; i < item_size && is_zero; ++i) {
+        is_zero = ((const uint8_t*)item)[i] == 0;
+    }
+
+    Object* matrix = (is_zero ? allocateZeroedObject : allocateEmptyObject)(
+        heap,
+        stack,
+        stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        sizeof(MatrixShape) + items_size
+    );
+    if (!matrix) {
+        return NULL;
+    }
+    MATRIX_SHAPE(matrix)->rows = rows;
+    MATRIX_SHAPE(matrix)->columns = columns;
+    if (!is_zero) {
+        fillArray(matrix, sizeof(MatrixShape), matrix->size, item, item_size);
+    }
+    return matrix;
+}
+
+Object* arrayToMatrix(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    uint32_t columns,
+    size_t item_size
+) {
+    assert(heap);
+    assert(array);
+    assert(columns > 0 && item_size > 0);
+    assert(array->size % ((size_t)columns * item_size) == 0);
+
+    size_t rows = array->size / ((size_t)columns * item_size);
+    if (rows > UINT32_MAX) {
+        return NULL;
+    }
+
+    dontCollectObjectOnNextGC(heap, array);
+    Object* matrix = allocateEmptyObject(
+        heap,
+        stack,
+        stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        sizeof(MatrixShape) + array->size
+    );
+    if (!matrix) {
+        return NULL;
+    }
+    MATRIX_SHAPE(matrix)->rows = (uint32_t)rows;
+    MATRIX_SHAPE(matrix)->columns = columns;
+    memcpy(MATRIX_ITEMS(matrix), array->value, array->size);
+    return matrix;
+}
+
+Object* matrixToArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* matrix
+) {
+    assert(heap);
+    assert(matrix && matrix->size >= sizeof(MatrixShape));
+
+    return sliceArray(
+        heap,
+        stack,
+        stack_references_positions,
+        matrix,
+        sizeof(MatrixShape),
+        matrix->size
+    );
+}
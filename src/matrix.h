@@ -0,0 +1,80 @@
+#ifndef lala_matrix_h
+#define lala_matrix_h
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "heap.h"
+#include "stack.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define MATRIX_SHAPE(matrix) ((MatrixShape*)(matrix)->value)
+#define MATRIX_ITEMS(matrix) ((matrix)->value + sizeof(MatrixShape))
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+// Takes 8 bytes, so that the items after it stay aligned.
+typedef struct {
+    uint32_t rows;
+    uint32_t columns;
+} MatrixShape;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+/* Matrices are plain objects whose value is a MatrixShape followed
+ * by the items row after row. The item [row, column] is found with one
+ * multiplication, and both indices are checked against the shape, which
+ * is right before the items in memory. Items are numbers, so there are
+ * no references to trace. Sizes are in bytes.
+ * */
+
+/* Returns a new matrix with copies of the item. Zero items aren't written
+ * but allocated zeroed, like repeatArray does.
+ * Returns NULL if the allocation fails.
+ * */
+Object* allocateMatrix(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    uint32_t rows,
+    uint32_t columns,
+    const void* item,
+    size_t item_size
+);
+
+/* Returns a new matrix with the items of the array split into rows
+ * of columns items. The length of the array must be a multiple of columns.
+ * The array is pinned, so it isn't moved by the allocation.
+ * Returns NULL if the allocation fails.
+ * */
+Object* arrayToMatrix(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* array,
+    uint32_t columns,
+    size_t item_size
+);
+
+// Returns a new array with the items of the matrix, or NULL if
+// the allocation fails.
+Object* matrixToArray(
+    Heap* heap,
+    Stack* stack,
+    const Stack* stack_references_positions,
+    Object* matrix
+);
+
+
+#endif
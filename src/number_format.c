@@ -0,0 +1,242 @@
+#include "number_format.h"
+
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Significant digits of printf's %g.
+#define FLOAT_DIGITS 6
+
+// Powers of ten up to 10^22 are exact doubles, so the value is scaled
+// to FLOAT_DIGITS digits with a single rounding if its decimal exponent
+// is in this range.
+#define FLOAT_FAST_MIN_EXPONENT (FLOAT_DIGITS - 1 - 22)
+#define FLOAT_FAST_MAX_EXPONENT (FLOAT_DIGITS - 1 + 22)
+
+// The error of the scaled value is below 10^6 * 2^-53, about 10^-10.
+// If it's closer than this to halfway between two integers,
+// the direction of rounding isn't certain.
+#define FLOAT_ROUNDING_MARGIN 1e-9
+
+
+// ┌───────────┐
+// │ Constants │
+// └───────────┘
+
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint32_t INT_POWERS_OF_TEN[] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u,
+};
+
+static const double POWERS_OF_TEN[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+// Writes the digits of value so that they end right before end.
+// Returns the position of the first digit.
+static uint8_t* writeDigitsBackwards(uint32_t value, uint8_t* end);
+
+// Finds the FLOAT_DIGITS significant digits of a positive normal value
+// and its decimal exponent after rounding. Returns false if that can't
+// be done exactly with a double.
+static bool scaleFloat(double magnitude, int* exponent, uint32_t* digits);
+
+static size_t formatFloatWithPrintf(double value, uint8_t* destination);
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+size_t intStringLength(int32_t value) {
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    size_t length = 1;
+    while (length < 10 && magnitude >= INT_POWERS_OF_TEN[length]) {
+        ++length;
+    }
+    return value < 0 ? length + 1 : length;
+}
+
+void formatInt(int32_t value, uint8_t* destination, size_t length) {
+    assert(destination);
+    assert(length == intStringLength(value));
+
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    uint8_t* digit = writeDigitsBackwards(magnitude, destination + length);
+    if (value < 0) {
+        *--digit = '-';
+    }
+    assert(digit == destination);
+}
+
+size_t formatFloat(double value, uint8_t* destination) {
+    assert(destination);
+
+    // Zeros, subnormals, infinities and NaNs are rare.
+    if (fpclassify(value) != FP_NORMAL) {
+        return formatFloatWithPrintf(value, destination);
+    }
+
+    // The magnitude is in [2^(e - 1), 2^e), so the estimate of its
+    // decimal exponent is off by at most one, which scaleFloat corrects.
+    double magnitude = fabs(value);
+    int binary_exponent;
+    frexp(magnitude, &binary_exponent);
+    int exponent = (int)floor((double)(binary_exponent - 1) * 0.30102999566398120);
+
+    uint32_t significand;
+    if (!scaleFloat(magnitude, &exponent, &significand)) {
+        return formatFloatWithPrintf(value, destination);
+    }
+
+    uint8_t digits[FLOAT_DIGITS];
+    writeDigitsBackwards(significand, digits + FLOAT_DIGITS);
+    size_t significant = FLOAT_DIGITS;
+    while (significant > 1 && digits[significant - 1] == '0') {
+        --significant;
+    }
+
+    uint8_t* end = destination;
+    if (value < 0) {
+        *end++ = '-';
+    }
+
+    // The same choice between the styles as printf's.
+    if (exponent < -4 || exponent >= FLOAT_DIGITS) {
+        *end++ = digits[0];
+        if (significant > 1) {
+            *end++ = '.';
+            memcpy(end, digits + 1, significant - 1);
+            end += significant - 1;
+        }
+
+        *end++ = 'e';
+        *end++ = exponent < 0 ? '-' : '+';
+        uint32_t exponent_magnitude = (uint32_t)(exponent < 0 ? -exponent : exponent);
+        size_t exponent_length = exponent_magnitude >= 100 ? 3 : 2;
+        end += exponent_length;
+        uint8_t* exponent_start = writeDigitsBackwards(exponent_magnitude, end);
+        while (exponent_start > end - exponent_length) {
+            *--exponent_start = '0';
+        }
+    } else if (exponent >= 0) {
+        size_t integer_digits = (size_t)exponent + 1;
+        memcpy(end, digits, integer_digits);
+        end += integer_digits;
+        if (significant > integer_digits) {
+            *end++ = '.';
+            memcpy(end, digits + integer_digits, significant - integer_digits);
+            end += significant - integer_digits;
+        }
+    } else {
+        *end++ = '0';
+        *end++ = '.';
+        for (int i = -1; i > exponent; --i) {
+            *end++ = '0';
+        }
+        memcpy(end, digits, significant);
+        end += significant;
+    }
+
+    return (size_t)(end - destination);
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static uint8_t* writeDigitsBackwards(uint32_t value, uint8_t* end) {
+    assert(end);
+
+    uint8_t* digit = end;
+    while (value >= 100) {
+        digit -= 2;
+        memcpy(digit, &DIGIT_PAIRS[value % 100 * 2], 2);
+        value /= 100;
+    }
+    if (value >= 10) {
+        digit -= 2;
+        memcpy(digit, &DIGIT_PAIRS[value * 2], 2);
+    } else {
+        *--digit = (uint8_t)('0' + value);
+    }
+    return digit;
+}
+
+static bool scaleFloat(double magnitude, int* exponent, uint32_t* digits) {
+    assert(exponent);
+    assert(digits);
+
+    const double min_scaled = POWERS_OF_TEN[FLOAT_DIGITS - 1];
+    const double max_scaled = POWERS_OF_TEN[FLOAT_DIGITS];
+
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        if (*exponent < FLOAT_FAST_MIN_EXPONENT || *exponent > FLOAT_FAST_MAX_EXPONENT) {
+            return false;
+        }
+
+        int shift = FLOAT_DIGITS - 1 - *exponent;
+        double scaled = shift >= 0
+            ? magnitude * POWERS_OF_TEN[shift]
+            : magnitude / POWERS_OF_TEN[-shift];
+        if (scaled < min_scaled) {
+            --*exponent;
+            continue;
+        }
+        if (scaled >= max_scaled) {
+            ++*exponent;
+            continue;
+        }
+
+        double whole = (double)(uint32_t)scaled;
+        double fraction = scaled - whole;
+        if (fabs(fraction - 0.5) < FLOAT_ROUNDING_MARGIN) {
+            return false;
+        }
+
+        *digits = (uint32_t)whole + (fraction > 0.5 ? 1 : 0);
+        if (*digits == INT_POWERS_OF_TEN[FLOAT_DIGITS]) {
+            *digits = INT_POWERS_OF_TEN[FLOAT_DIGITS - 1];
+            ++*exponent;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+static size_t formatFloatWithPrintf(double value, uint8_t* destination) {
+    assert(destination);
+
+    char buffer[FLOAT_STRING_MAX_LENGTH + 1];
+    int length = snprintf(buffer, sizeof(buffer), "%g", value);
+    assert(length > 0 && length <= FLOAT_STRING_MAX_LENGTH);
+    memcpy(destination, buffer, (size_t)length);
+    return (size_t)length;
+}
@@ -0,0 +1,41 @@
+#ifndef lala_number_format_h
+#define lala_number_format_h
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Maximum lengths of the strings written by formatInt and formatFloat.
+#define INT_STRING_MAX_LENGTH   11
+#define FLOAT_STRING_MAX_LENGTH 32
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+// Length of the decimal representation of value, the same as printf's %d.
+size_t intStringLength(int32_t value);
+
+// Writes the decimal representation of value, which is length bytes long.
+// Digits are written two at a time from a table of digit pairs.
+void formatInt(int32_t value, uint8_t* destination, size_t length);
+
+/* Writes value the way printf's %g does and returns the number of bytes
+ * written, at most FLOAT_STRING_MAX_LENGTH. Doesn't write a terminating
+ * null byte.
+ *
+ * The 6 significant digits are found with a single multiplication
+ * or division by an exact power of ten. Values too big or too small
+ * for that, and values too close to halfway between two results
+ * for the rounding to be certain, are formatted with snprintf.
+ * */
+size_t formatFloat(double value, uint8_t* destination);
+
+
+#endif
@@ -0,0 +1,1363 @@
+#include "number_kernels.h"
+
+
+#include <assert.h>
+#include <math.h>
+
+#include "bit_array.h"
+#include "cpu_features.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define KERNELS() SELECTED_KERNELS(kernels, selectBestKernels)
+
+// Ints wrap around like unsigned ints do.
+#define WRAP_ADD(a, b)      ((int32_t)((uint32_t)(a) + (uint32_t)(b)))
+#define WRAP_SUBTRACT(a, b) ((int32_t)((uint32_t)(a) - (uint32_t)(b)))
+#define WRAP_MULTIPLY(a, b) ((int32_t)((uint32_t)(a) * (uint32_t)(b)))
+
+#define BIT_IS_SET(bits, i) (((bits)[(i) / 8] >> ((i) % 8)) & 1)
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+// The less and select kernels are given whole bytes of bits,
+// and the count may end in the middle of the last one. The float block
+// kernels are given up to FLOAT_SUM_BLOCK_COUNT items, and the min and
+// max kernels at least one.
+typedef struct {
+    void (*combine_ints)(int32_t* destination, const int32_t* source, size_t count, ItemsOperation operation);
+    void (*combine_floats)(double* destination, const double* source, size_t count, ItemsOperation operation);
+    bool (*divide_ints)(int32_t* destination, const int32_t* source, size_t count);
+    bool (*divide_floats)(double* destination, const double* source, size_t count, double min_divisor);
+    void (*scale_ints)(int32_t* items, size_t count, int32_t factor);
+    void (*scale_floats)(double* items, size_t count, double factor);
+    void (*multiply_add_ints)(int32_t* destination, const int32_t* left, const int32_t* right, size_t count);
+    void (*multiply_add_floats)(double* destination, const double* left, const double* right, size_t count);
+    void (*less_ints)(uint8_t* bits, const int32_t* left, const int32_t* right, size_t count);
+    void (*less_floats)(uint8_t* bits, const double* left, const double* right, size_t count);
+    void (*select_ints)(int32_t* destination, const uint8_t* bits, const int32_t* source, size_t count);
+    void (*select_floats)(double* destination, const uint8_t* bits, const double* source, size_t count);
+    int32_t (*sum_ints)(const int32_t* items, size_t count);
+    int64_t (*sum_ints_wide)(const int32_t* items, size_t count);
+    double  (*sum_float_block)(const double* items, size_t count);
+    int32_t (*dot_ints)(const int32_t* left, const int32_t* right, size_t count);
+    double  (*dot_float_block)(const double* left, const double* right, size_t count);
+    int32_t (*min_ints)(const int32_t* items, size_t count);
+    int32_t (*max_ints)(const int32_t* items, size_t count);
+    double  (*min_floats)(const double* items, size_t count);
+    double  (*max_floats)(const double* items, size_t count);
+    size_t  (*find_int)(const int32_t* items, size_t count, int32_t value);
+    size_t  (*find_float)(const double* items, size_t count, double value);
+} NumberKernels;
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+static const NumberKernels* selectBestKernels(void);
+
+static void combineIntsScalar      (int32_t* destination, const int32_t* source, size_t count, ItemsOperation operation);
+static void combineFloatsScalar    (double* destination, const double* source, size_t count, ItemsOperation operation);
+static bool divideIntsScalar       (int32_t* destination, const int32_t* source, size_t count);
+static bool divideFloatsScalar     (double* destination, const double* source, size_t count, double min_divisor);
+static void scaleIntsScalar        (int32_t* items, size_t count, int32_t factor);
+static void scaleFloatsScalar      (double* items, size_t count, double factor);
+static void multiplyAddIntsScalar  (int32_t* destination, const int32_t* left, const int32_t* right, size_t count);
+static void multiplyAddFloatsScalar(double* destination, const double* left, const double* right, size_t count);
+static void lessIntsScalar         (uint8_t* bits, const int32_t* left, const int32_t* right, size_t count);
+static void lessFloatsScalar       (uint8_t* bits, const double* left, const double* right, size_t count);
+static void selectIntsScalar       (int32_t* destination, const uint8_t* bits, const int32_t* source, size_t count);
+static void selectFloatsScalar     (double* destination, const uint8_t* bits, const double* source, size_t count);
+static int32_t sumIntsScalar        (const int32_t* items, size_t count);
+static int64_t sumIntsWideScalar    (const int32_t* items, size_t count);
+static double  sumFloatBlockScalar  (const double* items, size_t count);
+static int32_t dotIntsScalar        (const int32_t* left, const int32_t* right, size_t count);
+static double  dotFloatBlockScalar  (const double* left, const double* right, size_t count);
+static int32_t minIntsScalar        (const int32_t* items, size_t count);
+static int32_t maxIntsScalar        (const int32_t* items, size_t count);
+static double  minFloatsScalar      (const double* items, size_t count);
+static double  maxFloatsScalar      (const double* items, size_t count);
+static size_t  findIntScalar        (const int32_t* items, size_t count, int32_t value);
+static size_t  findFloatScalar      (const double* items, size_t count, double value);
+
+// The block sum of 8 accumulators, in the same order at every level.
+static double sumAccumulators(const double* accumulators);
+
+// NaNs are greater than the other floats.
+static double minOfFloats(double a, double b);
+static double maxOfFloats(double a, double b);
+
+// The pairwise sums are split at a whole number of blocks,
+// so that only the last block may be partial.
+static size_t pairwiseHalf(size_t count);
+
+#ifdef CPU_FEATURES_X86
+TARGET_SSE2 static void combineIntsSse2    (int32_t* destination, const int32_t* source, size_t count, ItemsOperation operation);
+TARGET_SSE2 static void combineFloatsSse2  (double* destination, const double* source, size_t count, ItemsOperation operation);
+TARGET_SSE2 static bool divideIntsSse2     (int32_t* destination, const int32_t* source, size_t count);
+TARGET_SSE2 static bool divideFloatsSse2   (double* destination, const double* source, size_t count, double min_divisor);
+TARGET_SSE2 static void scaleIntsSse2      (int32_t* items, size_t count, int32_t factor);
+TARGET_SSE2 static void scaleFloatsSse2    (double* items, size_t count, double factor);
+TARGET_SSE2 static void multiplyAddIntsSse2(int32_t* destination, const int32_t* left, const int32_t* right, size_t count);
+TARGET_SSE2 static void lessIntsSse2       (uint8_t* bits, const int32_t* left, const int32_t* right, size_t count);
+TARGET_SSE2 static void lessFloatsSse2     (uint8_t* bits, const double* left, const double* right, size_t count);
+TARGET_SSE2 static void selectIntsSse2     (int32_t* destination, const uint8_t* bits, const int32_t* source, size_t count);
+TARGET_SSE2 static void selectFloatsSse2   (double* destination, const uint8_t* bits, const double* source, size_t count);
+TARGET_SSE2 static int32_t sumIntsSse2      (const int32_t* items, size_t count);
+TARGET_SSE2 static int64_t sumIntsWideSse2  (const int32_t* items, size_t count);
+TARGET_SSE2 static double  sumFloatBlockSse2(const double* items, size_t count);
+TARGET_SSE2 static int32_t dotIntsSse2      (const int32_t* left, const int32_t* right, size_t count);
+TARGET_SSE2 static int32_t minIntsSse2      (const int32_t* items, size_t count);
+TARGET_SSE2 static int32_t maxIntsSse2      (const int32_t* items, size_t count);
+TARGET_SSE2 static double  minFloatsSse2    (const double* items, size_t count);
+TARGET_SSE2 static double  maxFloatsSse2    (const double* items, size_t count);
+TARGET_SSE2 static size_t  findIntSse2      (const int32_t* items, size_t count, int32_t value);
+TARGET_SSE2 static size_t  findFloatSse2    (const double* items, size_t count, double value);
+
+// SSE2 has no 32-bit multiplication, it's made of two 64-bit ones.
+TARGET_SSE2 static __m128i multiplyInt32sSse2(__m128i left, __m128i right);
+
+TARGET_AVX2_FMA static void combineIntsAvx2      (int32_t* destination, const int32_t* source, size_t count, ItemsOperation operation);
+TARGET_AVX2_FMA static void combineFloatsAvx2    (double* destination, const double* source, size_t count, ItemsOperation operation);
+TARGET_AVX2_FMA static bool divideIntsAvx2       (int32_t* destination, const int32_t* source, size_t count);
+TARGET_AVX2_FMA static bool divideFloatsAvx2     (double* destination, const double* source, size_t count, double min_divisor);
+TARGET_AVX2_FMA static void scaleIntsAvx2        (int32_t* items, size_t count, int32_t factor);
+TARGET_AVX2_FMA static void scaleFloatsAvx2      (double* items, size_t count, double factor);
+TARGET_AVX2_FMA static void multiplyAddIntsAvx2  (int32_t* destination, const int32_t* left, const int32_t* right, size_t count);
+TARGET_AVX2_FMA static void multiplyAddFloatsAvx2(double* destination, const double* left, const double* right, size_t count);
+TARGET_AVX2_FMA static void lessIntsAvx2         (uint8_t* bits, const int32_t* left, const int32_t* right, size_t count);
+TARGET_AVX2_FMA static void lessFloatsAvx2       (uint8_t* bits, const double* left, const double* right, size_t count);
+TARGET_AVX2_FMA static void selectIntsAvx2       (int32_t* destination, const uint8_t* bits, const int32_t* source, size_t count);
+TARGET_AVX2_FMA static void selectFloatsAvx2     (double* destination, const uint8_t* bits, const double* source, size_t count);
+TARGET_AVX2_FMA static int32_t sumIntsAvx2      (const int32_t* items, size_t count);
+TARGET_AVX2_FMA static int64_t sumIntsWideAvx2  (const int32_t* items, size_t count);
+TARGET_AVX2_FMA static double  sumFloatBlockAvx2(const double* items, size_t count);
+TARGET_AVX2_FMA static int32_t dotIntsAvx2      (const int32_t* left, const int32_t* right, size_t count);
+TARGET_AVX2_FMA static double  dotFloatBlockAvx2(const double* left, const double* right, size_t count);
+TARGET_AVX2_FMA static int32_t minIntsAvx2      (const int32_t* items, size_t count);
+TARGET_AVX2_FMA static int32_t maxIntsAvx2      (const int32_t* items, size_t count);
+TARGET_AVX2_FMA static double  minFloatsAvx2    (const double* items, size_t count);
+TARGET_AVX2_FMA static double  maxFloatsAvx2    (const double* items, size_t count);
+TARGET_AVX2_FMA static size_t  findIntAvx2      (const int32_t* items, size_t count, int32_t value);
+TARGET_AVX2_FMA static size_t  findFloatAvx2    (const double* items, size_t count, double value);
+#endif
+
+
+// ┌───────────┐
+// │ Constants │
+// └───────────┘
+
+static const NumberKernels SCALAR_KERNELS = {
+    combineIntsScalar,
+    combineFloatsScalar,
+    divideIntsScalar,
+    divideFloatsScalar,
+    scaleIntsScalar,
+    scaleFloatsScalar,
+    multiplyAddIntsScalar,
+    multiplyAddFloatsScalar,
+    lessIntsScalar,
+    lessFloatsScalar,
+    selectIntsScalar,
+    selectFloatsScalar,
+    sumIntsScalar,
+    sumIntsWideScalar,
+    sumFloatBlockScalar,
+    dotIntsScalar,
+    dotFloatBlockScalar,
+    minIntsScalar,
+    maxIntsScalar,
+    minFloatsScalar,
+    maxFloatsScalar,
+    findIntScalar,
+    findFloatScalar,
+};
+
+#ifdef CPU_FEATURES_X86
+// SSE2 has no fused multiply-add, the float dot product uses the scalar one.
+static const NumberKernels SSE2_KERNELS = {
+    combineIntsSse2,
+    combineFloatsSse2,
+    divideIntsSse2,
+    divideFloatsSse2,
+    scaleIntsSse2,
+    scaleFloatsSse2,
+    multiplyAddIntsSse2,
+    multiplyAddFloatsScalar,
+    lessIntsSse2,
+    lessFloatsSse2,
+    selectIntsSse2,
+    selectFloatsSse2,
+    sumIntsSse2,
+    sumIntsWideSse2,
+    sumFloatBlockSse2,
+    dotIntsSse2,
+    dotFloatBlockScalar,
+    minIntsSse2,
+    maxIntsSse2,
+    minFloatsSse2,
+    maxFloatsSse2,
+    findIntSse2,
+    findFloatSse2,
+};
+
+static const NumberKernels AVX2_KERNELS = {
+    combineIntsAvx2,
+    combineFloatsAvx2,
+    divideIntsAvx2,
+    divideFloatsAvx2,
+    scaleIntsAvx2,
+    scaleFloatsAvx2,
+    multiplyAddIntsAvx2,
+    multiplyAddFloatsAvx2,
+    lessIntsAvx2,
+    lessFloatsAvx2,
+    selectIntsAvx2,
+    selectFloatsAvx2,
+    sumIntsAvx2,
+    sumIntsWideAvx2,
+    sumFloatBlockAvx2,
+    dotIntsAvx2,
+    dotFloatBlockAvx2,
+    minIntsAvx2,
+    maxIntsAvx2,
+    minFloatsAvx2,
+    maxFloatsAvx2,
+    findIntAvx2,
+    findFloatAvx2,
+};
+#endif
+
+
+// ┌─────────┐
+// │ Globals │
+// └─────────┘
+
+static const NumberKernels* kernels = NULL;
+static CpuLevel kernels_level = CPU_LEVEL_SCALAR;
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+CpuLevel numberKernelsLevel(void) {
+    KERNELS();
+    return kernels_level;
+}
+
+bool setNumberKernelsLevel(CpuLevel level) {
+    if (!cpuSupportsLevel(level) || (level == CPU_LEVEL_AVX2 && !cpuSupportsFma())) {
+        return false;
+    }
+
+    switch (level) {
+#ifdef CPU_FEATURES_X86
+        case CPU_LEVEL_SSE2: kernels = &SSE2_KERNELS; break;
+        case CPU_LEVEL_AVX2: kernels = &AVX2_KERNELS; break;
+#endif
+        default:             kernels = &SCALAR_KERNELS; break;
+    }
+    kernels_level = level;
+    return true;
+}
+
+void combineInts(int32_t* destination, const int32_t* source, size_t count, ItemsOperation operation) {
+    assert((destination && source) || count == 0);
+    KERNELS()->combine_ints(destination, source, count, operation);
+}
+
+void combineFloats(double* destination, const double* source, size_t count, ItemsOperation operation) {
+    assert((destination && source) || count == 0);
+    KERNELS()->combine_floats(destination, source, count, operation);
+}
+
+bool divideInts(int32_t* destination, const int32_t* source, size_t count) {
+    assert((destination && source) || count == 0);
+    return KERNELS()->divide_ints(destination, source, count);
+}
+
+bool divideFloats(double* destination, const double* source, size_t count, double min_divisor) {
+    assert((destination && source) || count == 0);
+    return KERNELS()->divide_floats(destination, source, count, min_divisor);
+}
+
+void scaleInts(int32_t* items, size_t count, int32_t factor) {
+    assert(items || count == 0);
+    KERNELS()->scale_ints(items, count, factor);
+}
+
+void scaleFloats(double* items, size_t count, double factor) {
+    assert(items || count == 0);
+    KERNELS()->scale_floats(items, count, factor);
+}
+
+void multiplyAddInts(int32_t* destination, const int32_t* left, const int32_t* right, size_t count) {
+    assert((destination && left && right) || count == 0);
+    KERNELS()->multiply_add_ints(destination, left, right, count);
+}
+
+void multiplyAddFloats(double* destination, const double* left, const double* right, size_t count) {
+    assert((destination && left && right) || count == 0);
+    KERNELS()->multiply_add_floats(destination, left, right, count);
+}
+
+void lessInts(uint8_t* bits, const int32_t* left, const int32_t* right, size_t count) {
+    assert((bits && left && right) || count == 0);
+    KERNELS()->less_ints(bits, left, right, count);
+}
+
+void lessFloats(uint8_t* bits, const double* left, const double* right, size_t count) {
+    assert((bits && left && right) || count == 0);
+    KERNELS()->less_floats(bits, left, right, count);
+}
+
+void selectInts(int32_t* destination, const uint8_t* bits, const int32_t* source, size_t count) {
+    assert((destination && bits && source) || count == 0);
+    KERNELS()->select_ints(destination, bits, source, count);
+}
+
+void selectFloats(double* destination, const uint8_t* bits, const double* source, size_t count) {
+    assert((destination && bits && source) || count == 0);
+    KERNELS()->select_floats(destination, bits, source, count);
+}
+
+int32_t sumInts(const int32_t* items, size_t count) {
+    assert(items || count == 0);
+    return KERNELS()->sum_ints(items, count);
+}
+
+int64_t sumIntsWide(const int32_t* items, size_t count) {
+    assert(items || count == 0);
+    return KERNELS()->sum_ints_wide(items, count);
+}
+
+double sumFloats(const double* items, size_t count) {
+    assert(items || count == 0);
+
+    double sum;
+    if (count <= FLOAT_SUM_BLOCK_COUNT) {
+        sum = KERNELS()->sum_float_block(items, count);
+    } else {
+        size_t half = pairwiseHalf(count);
+        sum = sumFloats(items, half) + sumFloats(items + half, count - half);
+    }
+    // The sign of a NaN sum depends on the instructions.
+    return isnan(sum) ? NAN : sum;
+}
+
+int32_t dotInts(const int32_t* left, const int32_t* right, size_t count) {
+    assert((left && right) || count == 0);
+    return KERNELS()->dot_ints(left, right, count);
+}
+
+double dotFloats(const double* left, const double* right, size_t count) {
+    assert((left && right) || count == 0);
+
+    double sum;
+    if (count <= FLOAT_SUM_BLOCK_COUNT) {
+        sum = KERNELS()->dot_float_block(left, right, count);
+    } else {
+        size_t half = pairwiseHalf(count);
+        sum = dotFloats(left, right, half) + dotFloats(left + half, right + half, count - half);
+    }
+    return isnan(sum) ? NAN : sum;
+}
+
+int32_t minInts(const int32_t* items, size_t count) {
+    assert(items && count > 0);
+    return KERNELS()->min_ints(items, count);
+}
+
+int32_t maxInts(const int32_t* items, size_t count) {
+    assert(items && count > 0);
+    return KERNELS()->max_ints(items, count);
+}
+
+double minFloats(const double* items, size_t count) {
+    assert(items && count > 0);
+    return KERNELS()->min_floats(items, count);
+}
+
+double maxFloats(const double* items, size_t count) {
+    assert(items && count > 0);
+    return KERNELS()->max_floats(items, count);
+}
+
+size_t findInt(const int32_t* items, size_t count, int32_t value) {
+    assert(items || count == 0);
+    return KERNELS()->find_int(items, count, value);
+}
+
+size_t findFloat(const double* items, size_t count, double value) {
+    assert(items || count == 0);
+    return KERNELS()->find_float(items, count, value);
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static const NumberKernels* selectBestKernels(void) {
+    selectBestCpuLevel(setNumberKernelsLevel);
+    return kernels;
+}
+
+static double sumAccumulators(const double* accumulators) {
+    return ((accumulators[0] + accumulators[1]) + (accumulators[2] + accumulators[3])) +
+           ((accumulators[4] + accumulators[5]) + (accumulators[6] + accumulators[7]));
+}
+
+static double minOfFloats(double a, double b) {
+    if (isnan(a)) {
+        return b;
+    }
+    return b < a ? b : a;
+}
+
+static double maxOfFloats(double a, double b) {
+    if (isnan(a) || isnan(b)) {
+        return NAN;
+    }
+    return b > a ? b : a;
+}
+
+static size_t pairwiseHalf(size_t count) {
+    return (count / 2 + FLOAT_SUM_BLOCK_COUNT - 1) / FLOAT_SUM_BLOCK_COUNT * FLOAT_SUM_BLOCK_COUNT;
+}
+
+
+// ────────
+//  Scalar
+// ────────
+
+static void combineIntsScalar(int32_t* destination, const int32_t* source, size_t count, ItemsOperation operation) {
+    switch (operation) {
+        case ITEMS_ADD:
+            for (size_t i = 0; i < count; ++i) {
+                destination[i] = WRAP_ADD(destination[i], source[i]);
+            }
+            break;
+        case ITEMS_SUBTRACT:
+            for (size_t i = 0; i < count; ++i) {
+                destination[i] = WRAP_SUBTRACT(destination[i], source[i]);
+            }
+            break;
+        case ITEMS_MULTIPLY:
+            for (size_t i = 0; i < count; ++i) {
+                destination[i] = WRAP_MULTIPLY(destination[i], source[i]);
+            }
+            break;
+    }
+}
+
+static void combineFloatsScalar(double* destination, const double* source, size_t count, ItemsOperation operation) {
+    switch (operation) {
+        case ITEMS_ADD:
+            for (size_t i = 0; i < count; ++i) {
+                destination[i] += source[i];
+            }
+            break;
+        case ITEMS_SUBTRACT:
+            for (size_t i = 0; i < count; ++i) {
+                destination[i] -= source[i];
+            }
+            break;
+        case ITEMS_MULTIPLY:
+            for (size_t i = 0; i < count; ++i) {
+                destination[i] *= source[i];
+            }
+            break;
+    }
+}
+
+static bool divideIntsScalar(int32_t* destination, const int32_t* source, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (source[i] == 0) {
+            return false;
+        }
+        // The minimum int divided by -1 wraps around to itself.
+        destination[i] = source[i] == -1 ? WRAP_SUBTRACT(0, destination[i]) : destination[i] / source[i];
+    }
+    return true;
+}
+
+static bool divideFloatsScalar(double* destination, const double* source, size_t count, double min_divisor) {
+    for (size_t i = 0; i < count; ++i) {
+        if (fabs(source[i]) < min_divisor) {
+            return false;
+        }
+        destination[i] /= source[i];
+    }
+    return true;
+}
+
+static void scaleIntsScalar(int32_t* items, size_t count, int32_t factor) {
+    for (size_t i = 0; i < count; ++i) {
+        items[i] = WRAP_MULTIPLY(items[i], factor);
+    }
+}
+
+static void scaleFloatsScalar(double* items, size_t count, double factor) {
+    for (size_t i = 0; i < count; ++i) {
+        items[i] *= factor;
+    }
+}
+
+static void multiplyAddIntsScalar(int32_t* destination, const int32_t* left, const int32_t* right, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        destination[i] = WRAP_ADD(destination[i], WRAP_MULTIPLY(left[i], right[i]));
+    }
+}
+
+static void multiplyAddFloatsScalar(double* destination, const double* left, const double* right, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        destination[i] = fma(left[i], right[i], destination[i]);
+    }
+}
+
+static void lessIntsScalar(uint8_t* bits, const int32_t* left, const int32_t* right, size_t count) {
+    for (size_t byte = 0; byte < BIT_ARRAY_SIZE(count); ++byte) {
+        size_t end = count - 8 * byte < 8 ? count : 8 * byte + 8;
+        uint8_t value = 0;
+        for (size_t i = 8 * byte; i < end; ++i) {
+            value |= (uint8_t)((left[i] < right[i]) << (i % 8));
+        }
+        bits[byte] = value;
+    }
+}
+
+static void lessFloatsScalar(uint8_t* bits, const double* left, const double* right, size_t count) {
+    for (size_t byte = 0; byte < BIT_ARRAY_SIZE(count); ++byte) {
+        size_t end = count - 8 * byte < 8 ? count : 8 * byte + 8;
+        uint8_t value = 0;
+        for (size_t i = 8 * byte; i < end; ++i) {
+            value |= (uint8_t)((left[i] < right[i]) << (i % 8));
+        }
+        bits[byte] = value;
+    }
+}
+
+static void selectIntsScalar(int32_t* destination, const uint8_t* bits, const int32_t* source, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (BIT_IS_SET(bits, i)) {
+            destination[i] = source[i];
+        }
+    }
+}
+
+static void selectFloatsScalar(double* destination, const uint8_t* bits, const double* source, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (BIT_IS_SET(bits, i)) {
+            destination[i] = source[i];
+        }
+    }
+}
+
+static int32_t sumIntsScalar(const int32_t* items, size_t count) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        sum = WRAP_ADD(sum, items[i]);
+    }
+    return sum;
+}
+
+static int64_t sumIntsWideScalar(const int32_t* items, size_t count) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += items[i];
+    }
+    return sum;
+}
+
+static double sumFloatBlockScalar(const double* items, size_t count) {
+    double accumulators[8] = {0};
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        for (size_t j = 0; j < 8; ++j) {
+            accumulators[j] += items[i + j];
+        }
+    }
+    double sum = sumAccumulators(accumulators);
+    for (; i < count; ++i) {
+        sum += items[i];
+    }
+    return sum;
+}
+
+static int32_t dotIntsScalar(const int32_t* left, const int32_t* right, size_t count) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        sum = WRAP_ADD(sum, WRAP_MULTIPLY(left[i], right[i]));
+    }
+    return sum;
+}
+
+// The products are added with fma, so that every level rounds them
+// the same way.
+static double dotFloatBlockScalar(const double* left, const double* right, size_t count) {
+    double accumulators[8] = {0};
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        for (size_t j = 0; j < 8; ++j) {
+            accumulators[j] = fma(left[i + j], right[i + j], accumulators[j]);
+        }
+    }
+    double sum = sumAccumulators(accumulators);
+    for (; i < count; ++i) {
+        sum = fma(left[i], right[i], sum);
+    }
+    return sum;
+}
+
+static int32_t minIntsScalar(const int32_t* items, size_t count) {
+    int32_t min = items[0];
+    for (size_t i = 1; i < count; ++i) {
+        min = items[i] < min ? items[i] : min;
+    }
+    return min;
+}
+
+static int32_t maxIntsScalar(const int32_t* items, size_t count) {
+    int32_t max = items[0];
+    for (size_t i = 1; i < count; ++i) {
+        max = items[i] > max ? items[i] : max;
+    }
+    return max;
+}
+
+static double minFloatsScalar(const double* items, size_t count) {
+    double min = items[0];
+    for (size_t i = 1; i < count; ++i) {
+        min = minOfFloats(min, items[i]);
+    }
+    return min;
+}
+
+static double maxFloatsScalar(const double* items, size_t count) {
+    double max = items[0];
+    for (size_t i = 1; i < count; ++i) {
+        max = maxOfFloats(max, items[i]);
+    }
+    return max;
+}
+
+static size_t findIntScalar(const int32_t* items, size_t count, int32_t value) {
+    for (size_t i = 0; i < count; ++i) {
+        if (items[i] == value) {
+            return i;
+        }
+    }
+    return count;
+}
+
+static size_t findFloatScalar(const double* items, size_t count, double value) {
+    bool is_nan = isnan(value);
+    for (size_t i = 0; i < count; ++i) {
+        if (is_nan ? isnan(items[i]) : items[i] <= value && items[i] >= value) {
+            return i;
+        }
+    }
+    return count;
+}
+
+
+#ifdef CPU_FEATURES_X86
+
+// ──────
+//  SSE2
+// ──────
+
+TARGET_SSE2 static void combineIntsSse2(int32_t* destination, const int32_t* source, size_t count, ItemsOperation operation) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i l = _mm_loadu_si128((const __m128i*)(destination + i));
+        __m128i r = _mm_loadu_si128((const __m128i*)(source + i));
+        switch (operation) {
+            case ITEMS_ADD:      l = _mm_add_epi32(l, r);      break;
+            case ITEMS_SUBTRACT: l = _mm_sub_epi32(l, r);      break;
+            case ITEMS_MULTIPLY: l = multiplyInt32sSse2(l, r); break;
+        }
+        _mm_storeu_si128((__m128i*)(destination + i), l);
+    }
+    combineIntsScalar(destination + i, source + i, count - i, operation);
+}
+
+TARGET_SSE2 static void combineFloatsSse2(double* destination, const double* source, size_t count, ItemsOperation operation) {
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d l = _mm_loadu_pd(destination + i);
+        __m128d r = _mm_loadu_pd(source + i);
+        switch (operation) {
+            case ITEMS_ADD:      l = _mm_add_pd(l, r); break;
+            case ITEMS_SUBTRACT: l = _mm_sub_pd(l, r); break;
+            case ITEMS_MULTIPLY: l = _mm_mul_pd(l, r); break;
+        }
+        _mm_storeu_pd(destination + i, l);
+    }
+    combineFloatsScalar(destination + i, source + i, count - i, operation);
+}
+
+// Ints are divided as doubles, which hold them and their quotients exactly.
+// Truncating the minimum int divided by -1 gives the minimum int back.
+TARGET_SSE2 static bool divideIntsSse2(int32_t* destination, const int32_t* source, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i divisors = _mm_loadu_si128((const __m128i*)(source + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(divisors, _mm_setzero_si128())) != 0) {
+            return false;
+        }
+        __m128i dividends = _mm_loadu_si128((const __m128i*)(destination + i));
+        __m128d low = _mm_div_pd(_mm_cvtepi32_pd(dividends), _mm_cvtepi32_pd(divisors));
+        __m128d high = _mm_div_pd(
+            _mm_cvtepi32_pd(_mm_srli_si128(dividends, 8)),
+            _mm_cvtepi32_pd(_mm_srli_si128(divisors, 8))
+        );
+        __m128i quotients = _mm_unpacklo_epi64(_mm_cvttpd_epi32(low), _mm_cvttpd_epi32(high));
+        _mm_storeu_si128((__m128i*)(destination + i), quotients);
+    }
+    return divideIntsScalar(destination + i, source + i, count - i);
+}
+
+TARGET_SSE2 static bool divideFloatsSse2(double* destination, const double* source, size_t count, double min_divisor) {
+    __m128d sign = _mm_set1_pd(-0.0);
+    __m128d min = _mm_set1_pd(min_divisor);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d divisors = _mm_loadu_pd(source + i);
+        if (_mm_movemask_pd(_mm_cmplt_pd(_mm_andnot_pd(sign, divisors), min)) != 0) {
+            return false;
+        }
+        _mm_storeu_pd(destination + i, _mm_div_pd(_mm_loadu_pd(destination + i), divisors));
+    }
+    return divideFloatsScalar(destination + i, source + i, count - i, min_divisor);
+}
+
+TARGET_SSE2 static void scaleIntsSse2(int32_t* items, size_t count, int32_t factor) {
+    __m128i factors = _mm_set1_epi32(factor);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(items + i));
+        _mm_storeu_si128((__m128i*)(items + i), multiplyInt32sSse2(block, factors));
+    }
+    scaleIntsScalar(items + i, count - i, factor);
+}
+
+TARGET_SSE2 static void scaleFloatsSse2(double* items, size_t count, double factor) {
+    __m128d factors = _mm_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(items + i, _mm_mul_pd(_mm_loadu_pd(items + i), factors));
+    }
+    scaleFloatsScalar(items + i, count - i, factor);
+}
+
+TARGET_SSE2 static void multiplyAddIntsSse2(int32_t* destination, const int32_t* left, const int32_t* right, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i products = multiplyInt32sSse2(
+            _mm_loadu_si128((const __m128i*)(left + i)),
+            _mm_loadu_si128((const __m128i*)(right + i))
+        );
+        __m128i sums = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(destination + i)), products);
+        _mm_storeu_si128((__m128i*)(destination + i), sums);
+    }
+    multiplyAddIntsScalar(destination + i, left + i, right + i, count - i);
+}
+
+// A byte of bits at a time, so that the rest starts at a whole byte.
+TARGET_SSE2 static void lessIntsSse2(uint8_t* bits, const int32_t* left, const int32_t* right, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int low = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(
+            _mm_loadu_si128((const __m128i*)(left + i)),
+            _mm_loadu_si128((const __m128i*)(right + i))
+        )));
+        int high = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(
+            _mm_loadu_si128((const __m128i*)(left + i + 4)),
+            _mm_loadu_si128((const __m128i*)(right + i + 4))
+        )));
+        bits[i / 8] = (uint8_t)(low | high << 4);
+    }
+    lessIntsScalar(bits + i / 8, left + i, right + i, count - i);
+}
+
+TARGET_SSE2 static void lessFloatsSse2(uint8_t* bits, const double* left, const double* right, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int byte = 0;
+        for (size_t j = 0; j < 8; j += 2) {
+            __m128d less = _mm_cmplt_pd(_mm_loadu_pd(left + i + j), _mm_loadu_pd(right + i + j));
+            byte |= _mm_movemask_pd(less) << j;
+        }
+        bits[i / 8] = (uint8_t)byte;
+    }
+    lessFloatsScalar(bits + i / 8, left + i, right + i, count - i);
+}
+
+// The bits are spread over the lanes and compared with the lane's own bit.
+TARGET_SSE2 static void selectIntsSse2(int32_t* destination, const uint8_t* bits, const int32_t* source, size_t count) {
+    __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        for (size_t j = 0; j < 8; j += 4) {
+            __m128i spread = _mm_set1_epi32((bits[i / 8] >> j) & 0xF);
+            __m128i mask = _mm_cmpeq_epi32(_mm_and_si128(spread, lane_bits), lane_bits);
+            __m128i kept = _mm_andnot_si128(mask, _mm_loadu_si128((const __m128i*)(destination + i + j)));
+            __m128i selected = _mm_and_si128(mask, _mm_loadu_si128((const __m128i*)(source + i + j)));
+            _mm_storeu_si128((__m128i*)(destination + i + j), _mm_or_si128(kept, selected));
+        }
+    }
+    selectIntsScalar(destination + i, bits + i / 8, source + i, count - i);
+}
+
+// Both halves of a double lane are compared with its bit.
+TARGET_SSE2 static void selectFloatsSse2(double* destination, const uint8_t* bits, const double* source, size_t count) {
+    __m128i lane_bits = _mm_setr_epi32(1, 1, 2, 2);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        for (size_t j = 0; j < 8; j += 2) {
+            __m128i spread = _mm_set1_epi32((bits[i / 8] >> j) & 0x3);
+            __m128d mask = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(spread, lane_bits), lane_bits));
+            __m128d kept = _mm_andnot_pd(mask, _mm_loadu_pd(destination + i + j));
+            __m128d selected = _mm_and_pd(mask, _mm_loadu_pd(source + i + j));
+            _mm_storeu_pd(destination + i + j, _mm_or_pd(kept, selected));
+        }
+    }
+    selectFloatsScalar(destination + i, bits + i / 8, source + i, count - i);
+}
+
+TARGET_SSE2 static int32_t sumIntsSse2(const int32_t* items, size_t count) {
+    __m128i sums = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sums = _mm_add_epi32(sums, _mm_loadu_si128((const __m128i*)(items + i)));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, sums);
+    return WRAP_ADD(sumIntsScalar(lanes, 4), sumIntsScalar(items + i, count - i));
+}
+
+// The ints are sign-extended to 64 bits by interleaving them
+// with their signs.
+TARGET_SSE2 static int64_t sumIntsWideSse2(const int32_t* items, size_t count) {
+    __m128i sums = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(items + i));
+        __m128i signs = _mm_cmpgt_epi32(_mm_setzero_si128(), block);
+        sums = _mm_add_epi64(sums, _mm_unpacklo_epi32(block, signs));
+        sums = _mm_add_epi64(sums, _mm_unpackhi_epi32(block, signs));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, sums);
+    return lanes[0] + lanes[1] + sumIntsWideScalar(items + i, count - i);
+}
+
+// Each accumulator of sumFloatBlockScalar is a lane.
+TARGET_SSE2 static double sumFloatBlockSse2(const double* items, size_t count) {
+    __m128d sums_0 = _mm_setzero_pd();
+    __m128d sums_1 = _mm_setzero_pd();
+    __m128d sums_2 = _mm_setzero_pd();
+    __m128d sums_3 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        sums_0 = _mm_add_pd(sums_0, _mm_loadu_pd(items + i));
+        sums_1 = _mm_add_pd(sums_1, _mm_loadu_pd(items + i + 2));
+        sums_2 = _mm_add_pd(sums_2, _mm_loadu_pd(items + i + 4));
+        sums_3 = _mm_add_pd(sums_3, _mm_loadu_pd(items + i + 6));
+    }
+    double accumulators[8];
+    _mm_storeu_pd(accumulators, sums_0);
+    _mm_storeu_pd(accumulators + 2, sums_1);
+    _mm_storeu_pd(accumulators + 4, sums_2);
+    _mm_storeu_pd(accumulators + 6, sums_3);
+    double sum = sumAccumulators(accumulators);
+    for (; i < count; ++i) {
+        sum += items[i];
+    }
+    return sum;
+}
+
+TARGET_SSE2 static int32_t dotIntsSse2(const int32_t* left, const int32_t* right, size_t count) {
+    __m128i sums = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i products = multiplyInt32sSse2(
+            _mm_loadu_si128((const __m128i*)(left + i)),
+            _mm_loadu_si128((const __m128i*)(right + i))
+        );
+        sums = _mm_add_epi32(sums, products);
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, sums);
+    return WRAP_ADD(sumIntsScalar(lanes, 4), dotIntsScalar(left + i, right + i, count - i));
+}
+
+// SSE2 has no 32-bit min and max, they're blended by a comparison.
+TARGET_SSE2 static int32_t minIntsSse2(const int32_t* items, size_t count) {
+    __m128i mins = _mm_set1_epi32(items[0]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(items + i));
+        __m128i less = _mm_cmplt_epi32(block, mins);
+        mins = _mm_or_si128(_mm_and_si128(less, block), _mm_andnot_si128(less, mins));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, mins);
+    int32_t min = minIntsScalar(lanes, 4);
+    return i < count ? minIntsScalar((int32_t[]){ min, minIntsScalar(items + i, count - i) }, 2) : min;
+}
+
+TARGET_SSE2 static int32_t maxIntsSse2(const int32_t* items, size_t count) {
+    __m128i maxes = _mm_set1_epi32(items[0]);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(items + i));
+        __m128i greater = _mm_cmpgt_epi32(block, maxes);
+        maxes = _mm_or_si128(_mm_and_si128(greater, block), _mm_andnot_si128(greater, maxes));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, maxes);
+    int32_t max = maxIntsScalar(lanes, 4);
+    return i < count ? maxIntsScalar((int32_t[]){ max, maxIntsScalar(items + i, count - i) }, 2) : max;
+}
+
+// NaNs are replaced by infinities, the lanes count only if there was
+// a number among them.
+TARGET_SSE2 static double minFloatsSse2(const double* items, size_t count) {
+    __m128d infinities = _mm_set1_pd(INFINITY);
+    __m128d mins = infinities;
+    __m128d numbers = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d block = _mm_loadu_pd(items + i);
+        __m128d is_number = _mm_cmpord_pd(block, block);
+        numbers = _mm_or_pd(numbers, is_number);
+        block = _mm_or_pd(_mm_and_pd(is_number, block), _mm_andnot_pd(is_number, infinities));
+        mins = _mm_min_pd(block, mins);
+    }
+    double min = items[0];
+    if (_mm_movemask_pd(numbers) != 0) {
+        double lanes[2];
+        _mm_storeu_pd(lanes, mins);
+        min = minOfFloats(minOfFloats(min, lanes[0]), lanes[1]);
+    }
+    for (; i < count; ++i) {
+        min = minOfFloats(min, items[i]);
+    }
+    return min;
+}
+
+TARGET_SSE2 static double maxFloatsSse2(const double* items, size_t count) {
+    __m128d maxes = _mm_set1_pd(items[0]);
+    __m128d nans = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d block = _mm_loadu_pd(items + i);
+        nans = _mm_or_pd(nans, _mm_cmpunord_pd(block, block));
+        maxes = _mm_max_pd(block, maxes);
+    }
+    if (_mm_movemask_pd(nans) != 0) {
+        return NAN;
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, maxes);
+    double max = maxOfFloats(maxOfFloats(items[0], lanes[0]), lanes[1]);
+    for (; i < count; ++i) {
+        max = maxOfFloats(max, items[i]);
+    }
+    return max;
+}
+
+TARGET_SSE2 static size_t findIntSse2(const int32_t* items, size_t count, int32_t value) {
+    __m128i values = _mm_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(items + i)), values);
+        int found = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (found != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)found);
+        }
+    }
+    return i + findIntScalar(items + i, count - i, value);
+}
+
+TARGET_SSE2 static size_t findFloatSse2(const double* items, size_t count, double value) {
+    bool is_nan = isnan(value);
+    __m128d values = _mm_set1_pd(value);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d block = _mm_loadu_pd(items + i);
+        __m128d equal = is_nan ? _mm_cmpunord_pd(block, block) : _mm_cmpeq_pd(block, values);
+        int found = _mm_movemask_pd(equal);
+        if (found != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)found);
+        }
+    }
+    return i + findFloatScalar(items + i, count - i, value);
+}
+
+TARGET_SSE2 static __m128i multiplyInt32sSse2(__m128i left, __m128i right) {
+    __m128i even = _mm_mul_epu32(left, right);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(left, 32), _mm_srli_epi64(right, 32));
+    return _mm_unpacklo_epi32(
+        _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+        _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0))
+    );
+}
+
+
+// ──────
+//  AVX2
+// ──────
+
+TARGET_AVX2_FMA static void combineIntsAvx2(int32_t* destination, const int32_t* source, size_t count, ItemsOperation operation) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i l = _mm256_loadu_si256((const __m256i*)(destination + i));
+        __m256i r = _mm256_loadu_si256((const __m256i*)(source + i));
+        switch (operation) {
+            case ITEMS_ADD:      l = _mm256_add_epi32(l, r);   break;
+            case ITEMS_SUBTRACT: l = _mm256_sub_epi32(l, r);   break;
+            case ITEMS_MULTIPLY: l = _mm256_mullo_epi32(l, r); break;
+        }
+        _mm256_storeu_si256((__m256i*)(destination + i), l);
+    }
+    combineIntsScalar(destination + i, source + i, count - i, operation);
+}
+
+TARGET_AVX2_FMA static void combineFloatsAvx2(double* destination, const double* source, size_t count, ItemsOperation operation) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d l = _mm256_loadu_pd(destination + i);
+        __m256d r = _mm256_loadu_pd(source + i);
+        switch (operation) {
+            case ITEMS_ADD:      l = _mm256_add_pd(l, r); break;
+            case ITEMS_SUBTRACT: l = _mm256_sub_pd(l, r); break;
+            case ITEMS_MULTIPLY: l = _mm256_mul_pd(l, r); break;
+        }
+        _mm256_storeu_pd(destination + i, l);
+    }
+    combineFloatsScalar(destination + i, source + i, count - i, operation);
+}
+
+// See divideIntsSse2.
+TARGET_AVX2_FMA static bool divideIntsAvx2(int32_t* destination, const int32_t* source, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i divisors = _mm_loadu_si128((const __m128i*)(source + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(divisors, _mm_setzero_si128())) != 0) {
+            return false;
+        }
+        __m128i dividends = _mm_loadu_si128((const __m128i*)(destination + i));
+        __m256d quotients = _mm256_div_pd(_mm256_cvtepi32_pd(dividends), _mm256_cvtepi32_pd(divisors));
+        _mm_storeu_si128((__m128i*)(destination + i), _mm256_cvttpd_epi32(quotients));
+    }
+    return divideIntsScalar(destination + i, source + i, count - i);
+}
+
+TARGET_AVX2_FMA static bool divideFloatsAvx2(double* destination, const double* source, size_t count, double min_divisor) {
+    __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d min = _mm256_set1_pd(min_divisor);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d divisors = _mm256_loadu_pd(source + i);
+        if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign, divisors), min, _CMP_LT_OQ)) != 0) {
+            return false;
+        }
+        _mm256_storeu_pd(destination + i, _mm256_div_pd(_mm256_loadu_pd(destination + i), divisors));
+    }
+    return divideFloatsScalar(destination + i, source + i, count - i, min_divisor);
+}
+
+TARGET_AVX2_FMA static void scaleIntsAvx2(int32_t* items, size_t count, int32_t factor) {
+    __m256i factors = _mm256_set1_epi32(factor);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(items + i));
+        _mm256_storeu_si256((__m256i*)(items + i), _mm256_mullo_epi32(block, factors));
+    }
+    scaleIntsScalar(items + i, count - i, factor);
+}
+
+TARGET_AVX2_FMA static void scaleFloatsAvx2(double* items, size_t count, double factor) {
+    __m256d factors = _mm256_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(items + i, _mm256_mul_pd(_mm256_loadu_pd(items + i), factors));
+    }
+    scaleFloatsScalar(items + i, count - i, factor);
+}
+
+TARGET_AVX2_FMA static void multiplyAddIntsAvx2(int32_t* destination, const int32_t* left, const int32_t* right, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i products = _mm256_mullo_epi32(
+            _mm256_loadu_si256((const __m256i*)(left + i)),
+            _mm256_loadu_si256((const __m256i*)(right + i))
+        );
+        __m256i sums = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(destination + i)), products);
+        _mm256_storeu_si256((__m256i*)(destination + i), sums);
+    }
+    multiplyAddIntsScalar(destination + i, left + i, right + i, count - i);
+}
+
+TARGET_AVX2_FMA static void multiplyAddFloatsAvx2(double* destination, const double* left, const double* right, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d sums = _mm256_fmadd_pd(
+            _mm256_loadu_pd(left + i),
+            _mm256_loadu_pd(right + i),
+            _mm256_loadu_pd(destination + i)
+        );
+        _mm256_storeu_pd(destination + i, sums);
+    }
+    multiplyAddFloatsScalar(destination + i, left + i, right + i, count - i);
+}
+
+TARGET_AVX2_FMA static void lessIntsAvx2(uint8_t* bits, const int32_t* left, const int32_t* right, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i less = _mm256_cmpgt_epi32(
+            _mm256_loadu_si256((const __m256i*)(right + i)),
+            _mm256_loadu_si256((const __m256i*)(left + i))
+        );
+        bits[i / 8] = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(less));
+    }
+    lessIntsScalar(bits + i / 8, left + i, right + i, count - i);
+}
+
+TARGET_AVX2_FMA static void lessFloatsAvx2(uint8_t* bits, const double* left, const double* right, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256d low = _mm256_cmp_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i), _CMP_LT_OQ);
+        __m256d high = _mm256_cmp_pd(_mm256_loadu_pd(left + i + 4), _mm256_loadu_pd(right + i + 4), _CMP_LT_OQ);
+        bits[i / 8] = (uint8_t)(_mm256_movemask_pd(low) | _mm256_movemask_pd(high) << 4);
+    }
+    lessFloatsScalar(bits + i / 8, left + i, right + i, count - i);
+}
+
+// See selectIntsSse2.
+TARGET_AVX2_FMA static void selectIntsAvx2(int32_t* destination, const uint8_t* bits, const int32_t* source, size_t count) {
+    __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i spread = _mm256_set1_epi32(bits[i / 8]);
+        __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(spread, lane_bits), lane_bits);
+        __m256i selected = _mm256_blendv_epi8(
+            _mm256_loadu_si256((const __m256i*)(destination + i)),
+            _mm256_loadu_si256((const __m256i*)(source + i)),
+            mask
+        );
+        _mm256_storeu_si256((__m256i*)(destination + i), selected);
+    }
+    selectIntsScalar(destination + i, bits + i / 8, source + i, count - i);
+}
+
+TARGET_AVX2_FMA static void selectFloatsAvx2(double* destination, const uint8_t* bits, const double* source, size_t count) {
+    __m256i lane_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        for (size_t j = 0; j < 8; j += 4) {
+            __m256i spread = _mm256_set1_epi64x((bits[i / 8] >> j) & 0xF);
+            __m256d mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(spread, lane_bits), lane_bits));
+            __m256d selected = _mm256_blendv_pd(
+                _mm256_loadu_pd(destination + i + j),
+                _mm256_loadu_pd(source + i + j),
+                mask
+            );
+            _mm256_storeu_pd(destination + i + j, selected);
+        }
+    }
+    selectFloatsScalar(destination + i, bits + i / 8, source + i, count - i);
+}
+
+TARGET_AVX2_FMA static int32_t sumIntsAvx2(const int32_t* items, size_t count) {
+    __m256i sums = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        sums = _mm256_add_epi32(sums, _mm256_loadu_si256((const __m256i*)(items + i)));
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, sums);
+    return WRAP_ADD(sumIntsScalar(lanes, 8), sumIntsScalar(items + i, count - i));
+}
+
+TARGET_AVX2_FMA static int64_t sumIntsWideAvx2(const int32_t* items, size_t count) {
+    __m256i sums = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(items + i))));
+        sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(items + i + 4))));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, sums);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumIntsWideScalar(items + i, count - i);
+}
+
+// See sumFloatBlockSse2.
+TARGET_AVX2_FMA static double sumFloatBlockAvx2(const double* items, size_t count) {
+    __m256d low = _mm256_setzero_pd();
+    __m256d high = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        low = _mm256_add_pd(low, _mm256_loadu_pd(items + i));
+        high = _mm256_add_pd(high, _mm256_loadu_pd(items + i + 4));
+    }
+    double accumulators[8];
+    _mm256_storeu_pd(accumulators, low);
+    _mm256_storeu_pd(accumulators + 4, high);
+    double sum = sumAccumulators(accumulators);
+    for (; i < count; ++i) {
+        sum += items[i];
+    }
+    return sum;
+}
+
+TARGET_AVX2_FMA static int32_t dotIntsAvx2(const int32_t* left, const int32_t* right, size_t count) {
+    __m256i sums = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i products = _mm256_mullo_epi32(
+            _mm256_loadu_si256((const __m256i*)(left + i)),
+            _mm256_loadu_si256((const __m256i*)(right + i))
+        );
+        sums = _mm256_add_epi32(sums, products);
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, sums);
+    return WRAP_ADD(sumIntsScalar(lanes, 8), dotIntsScalar(left + i, right + i, count - i));
+}
+
+TARGET_AVX2_FMA static double dotFloatBlockAvx2(const double* left, const double* right, size_t count) {
+    __m256d low = _mm256_setzero_pd();
+    __m256d high = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        low = _mm256_fmadd_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i), low);
+        high = _mm256_fmadd_pd(_mm256_loadu_pd(left + i + 4), _mm256_loadu_pd(right + i + 4), high);
+    }
+    double accumulators[8];
+    _mm256_storeu_pd(accumulators, low);
+    _mm256_storeu_pd(accumulators + 4, high);
+    double sum = sumAccumulators(accumulators);
+    for (; i < count; ++i) {
+        sum = fma(left[i], right[i], sum);
+    }
+    return sum;
+}
+
+TARGET_AVX2_FMA static int32_t minIntsAvx2(const int32_t* items, size_t count) {
+    __m256i mins = _mm256_set1_epi32(items[0]);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        mins = _mm256_min_epi32(mins, _mm256_loadu_si256((const __m256i*)(items + i)));
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, mins);
+    int32_t min = minIntsScalar(lanes, 8);
+    return i < count ? minIntsScalar((int32_t[]){ min, minIntsScalar(items + i, count - i) }, 2) : min;
+}
+
+TARGET_AVX2_FMA static int32_t maxIntsAvx2(const int32_t* items, size_t count) {
+    __m256i maxes = _mm256_set1_epi32(items[0]);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        maxes = _mm256_max_epi32(maxes, _mm256_loadu_si256((const __m256i*)(items + i)));
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, maxes);
+    int32_t max = maxIntsScalar(lanes, 8);
+    return i < count ? maxIntsScalar((int32_t[]){ max, maxIntsScalar(items + i, count - i) }, 2) : max;
+}
+
+// See minFloatsSse2.
+TARGET_AVX2_FMA static double minFloatsAvx2(const double* items, size_t count) {
+    __m256d infinities = _mm256_set1_pd(INFINITY);
+    __m256d mins = infinities;
+    __m256d numbers = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d block = _mm256_loadu_pd(items + i);
+        __m256d is_number = _mm256_cmp_pd(block, block, _CMP_ORD_Q);
+        numbers = _mm256_or_pd(numbers, is_number);
+        mins = _mm256_min_pd(_mm256_blendv_pd(infinities, block, is_number), mins);
+    }
+    double min = items[0];
+    if (_mm256_movemask_pd(numbers) != 0) {
+        double lanes[4];
+        _mm256_storeu_pd(lanes, mins);
+        for (size_t j = 0; j < 4; ++j) {
+            min = minOfFloats(min, lanes[j]);
+        }
+    }
+    for (; i < count; ++i) {
+        min = minOfFloats(min, items[i]);
+    }
+    return min;
+}
+
+TARGET_AVX2_FMA static double maxFloatsAvx2(const double* items, size_t count) {
+    __m256d maxes = _mm256_set1_pd(items[0]);
+    __m256d nans = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d block = _mm256_loadu_pd(items + i);
+        nans = _mm256_or_pd(nans, _mm256_cmp_pd(block, block, _CMP_UNORD_Q));
+        maxes = _mm256_max_pd(block, maxes);
+    }
+    if (_mm256_movemask_pd(nans) != 0) {
+        return NAN;
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, maxes);
+    double max = items[0];
+    for (size_t j = 0; j < 4; ++j) {
+        max = maxOfFloats(max, lanes[j]);
+    }
+    for (; i < count; ++i) {
+        max = maxOfFloats(max, items[i]);
+    }
+    return max;
+}
+
+TARGET_AVX2_FMA static size_t findIntAvx2(const int32_t* items, size_t count, int32_t value) {
+    __m256i values = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(items + i)), values);
+        int found = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        if (found != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)found);
+        }
+    }
+    return i + findIntScalar(items + i, count - i, value);
+}
+
+TARGET_AVX2_FMA static size_t findFloatAvx2(const double* items, size_t count, double value) {
+    bool is_nan = isnan(value);
+    __m256d values = _mm256_set1_pd(value);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d block = _mm256_loadu_pd(items + i);
+        __m256d equal = is_nan
+            ? _mm256_cmp_pd(block, block, _CMP_UNORD_Q)
+            : _mm256_cmp_pd(block, values, _CMP_EQ_OQ);
+        int found = _mm256_movemask_pd(equal);
+        if (found != 0) {
+            return i + (size_t)__builtin_ctz((unsigned)found);
+        }
+    }
+    return i + findFloatScalar(items + i, count - i, value);
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef lala_number_kernels_h
+#define lala_number_kernels_h
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu_features.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define FLOAT_SUM_BLOCK_COUNT 128
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+typedef enum {
+    ITEMS_ADD,
+    ITEMS_SUBTRACT,
+    ITEMS_MULTIPLY,
+} ItemsOperation;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+// The kernels are selected like cpu_features.h describes. The AVX2
+// kernels use FMA too, so the AVX2 level needs a CPU with both.
+CpuLevel numberKernelsLevel(void);
+bool setNumberKernelsLevel(CpuLevel level);
+
+/* The kernels work on count items of int and float arrays item by item,
+ * so every level gives the same results. Ints wrap around on overflow.
+ * The destination may be the same array as a source, but mustn't
+ * overlap it otherwise.
+ * */
+
+// destination[i] = destination[i] operation source[i]
+void combineInts(int32_t* destination, const int32_t* source, size_t count, ItemsOperation operation);
+void combineFloats(double* destination, const double* source, size_t count, ItemsOperation operation);
+
+// destination[i] = destination[i] / source[i], ints are truncated.
+// Return false, with some items divided, if there's a zero divisor,
+// or for floats one that's closer to zero than min_divisor.
+bool divideInts(int32_t* destination, const int32_t* source, size_t count);
+bool divideFloats(double* destination, const double* source, size_t count, double min_divisor);
+
+// items[i] = items[i] * factor
+void scaleInts(int32_t* items, size_t count, int32_t factor);
+void scaleFloats(double* items, size_t count, double factor);
+
+// destination[i] = destination[i] + left[i] * right[i],
+// floats are rounded once, like fma does.
+void multiplyAddInts(int32_t* destination, const int32_t* left, const int32_t* right, size_t count);
+void multiplyAddFloats(double* destination, const double* left, const double* right, size_t count);
+
+/* Writes left[i] < right[i] into the bit i of the bit array bits,
+ * see bit_array.h. The bits of the last byte past count are zeroed.
+ * NaNs aren't less or greater than anything.
+ * */
+void lessInts(uint8_t* bits, const int32_t* left, const int32_t* right, size_t count);
+void lessFloats(uint8_t* bits, const double* left, const double* right, size_t count);
+
+// destination[i] = source[i] where the bit i of bits is set.
+void selectInts(int32_t* destination, const uint8_t* bits, const int32_t* source, size_t count);
+void selectFloats(double* destination, const uint8_t* bits, const double* source, size_t count);
+
+/* Reductions. Ints are summed wrapping around, or exactly into 64 bits.
+ * Floats are summed pairwise: blocks of FLOAT_SUM_BLOCK_COUNT items
+ * into 8 accumulators each, and the block sums two by two, so that
+ * the rounding error grows with the logarithm of the count.
+ * The dot product adds the products into them with fused multiply-adds.
+ * */
+int32_t sumInts(const int32_t* items, size_t count);
+int64_t sumIntsWide(const int32_t* items, size_t count);
+double sumFloats(const double* items, size_t count);
+int32_t dotInts(const int32_t* left, const int32_t* right, size_t count);
+double dotFloats(const double* left, const double* right, size_t count);
+
+/* The smallest and the largest item of at least one. NaNs are greater
+ * than the other floats, like sort orders them, so the largest float
+ * is NaN if there's one, and the smallest one is NaN only if all are.
+ * */
+int32_t minInts(const int32_t* items, size_t count);
+int32_t maxInts(const int32_t* items, size_t count);
+double minFloats(const double* items, size_t count);
+double maxFloats(const double* items, size_t count);
+
+// Index of the first item equal to the value, or the count if there's
+// none. A NaN value finds the first NaN.
+size_t findInt(const int32_t* items, size_t count, int32_t value);
+size_t findFloat(const double* items, size_t count, double value);
+
+
+#endif
@@ -22,6 +22,7 @@ const char* opCodeName(OpCode op_code) {
         // Heap
         case OP_LOAD_CONSTANT:           return "load constant";
         case OP_DEFINE_ON_HEAP:          return "define on heap";
+        case OP_DEFINE_BITS_ON_HEAP:     return "define bits on heap";
         
         case OP_GET_BYTE_FROM_HEAP:      return "get byte from heap";
         case OP_GET_INT_FROM_HEAP:       return "get int from heap";
@@ -56,6 +57,7 @@ const char* opCodeName(OpCode op_code) {
         case OP_MULTIPLY_INT:            return "multiply int";
         case OP_MULTIPLY_FLOAT:          return "multiply float";
         case OP_MULTIPLY_HEAP_VALUE:     return "multiply heap value";
+        case OP_MULTIPLY_BITS:           return "multiply bits";
         case OP_DIVIDE_INT:              return "divide int";
         case OP_DIVIDE_FLOAT:            return "divide float";
         case OP_MODULO_INT:              return "modulo int";
@@ -65,6 +67,14 @@ const char* opCodeName(OpCode op_code) {
 
         // String
         case OP_CONCATENATE:             return "concatenate";
+        case OP_CONCATENATE_N:           return "concatenate n";
+        case OP_SUBSTRING:               return "substring";
+        case OP_COPY_STRING:             return "copy string";
+        case OP_COMPARE_STRINGS:         return "compare strings";
+        case OP_FIND_SUBSTRING:          return "find substring";
+        case OP_FIND_BYTE:               return "find byte";
+        case OP_COUNT_SUBSTRING:         return "count substring";
+        case OP_SPLIT_STRING:            return "split string";
 
         // Cast
         case OP_CAST_FLOAT_TO_INT:       return "cast float to int";
@@ -105,6 +115,7 @@ const char* opCodeName(OpCode op_code) {
         case OP_READ_INT:                return "read int";
         case OP_READ_FLOAT:              return "read float";
         case OP_READ_STRING:             return "read string";
+        case OP_READ_LINES:              return "read lines";
 
         // Jump
         case OP_JUMP:                    return "jump";
@@ -120,16 +131,137 @@ const char* opCodeName(OpCode op_code) {
         case OP_RETURN_ADDRESS:          return "return address";
 
         // Array
-        case OP_SUBSCRIPT_GET_BYTE:      return "subscript get byte";
+        case OP_SUBSCRIPT_GET_BIT:       return "subscript get bit";
+        case OP_SUBSCRIPT_GET_INT8:      return "subscript get int8";
+        case OP_SUBSCRIPT_GET_INT16:     return "subscript get int16";
         case OP_SUBSCRIPT_GET_INT:       return "subscript get int";
+        case OP_SUBSCRIPT_GET_FLOAT32:   return "subscript get float32";
         case OP_SUBSCRIPT_GET_FLOAT:     return "subscript get float";
         case OP_SUBSCRIPT_GET_ADDRESS:   return "subscript get address";
 
-        case OP_SUBSCRIPT_SET_BYTE:      return "subscript set byte";
+        case OP_SUBSCRIPT_SET_BIT:       return "subscript set bit";
+        case OP_SUBSCRIPT_SET_INT8:      return "subscript set int8";
+        case OP_SUBSCRIPT_SET_INT16:     return "subscript set int16";
         case OP_SUBSCRIPT_SET_INT:       return "subscript set int";
+        case OP_SUBSCRIPT_SET_FLOAT32:   return "subscript set float32";
         case OP_SUBSCRIPT_SET_FLOAT:     return "subscript set float";
         case OP_SUBSCRIPT_SET_ADDRESS:   return "subscript set address";
 
+        case OP_ARRAY_PUSH_BIT:          return "array push bit";
+        case OP_ARRAY_PUSH_INT8:         return "array push int8";
+        case OP_ARRAY_PUSH_INT16:        return "array push int16";
+        case OP_ARRAY_PUSH_INT:          return "array push int";
+        case OP_ARRAY_PUSH_FLOAT32:      return "array push float32";
+        case OP_ARRAY_PUSH_FLOAT:        return "array push float";
+        case OP_ARRAY_PUSH_ADDRESS:      return "array push address";
+        case OP_ARRAY_PUSH_REFERENCE:    return "array push reference";
+
+        case OP_ARRAY_POP_BIT:           return "array pop bit";
+        case OP_ARRAY_POP_INT8:          return "array pop int8";
+        case OP_ARRAY_POP_INT16:         return "array pop int16";
+        case OP_ARRAY_POP_INT:           return "array pop int";
+        case OP_ARRAY_POP_FLOAT32:       return "array pop float32";
+        case OP_ARRAY_POP_FLOAT:         return "array pop float";
+        case OP_ARRAY_POP_ADDRESS:       return "array pop address";
+
+        case OP_ARRAY_LENGTH:            return "array length";
+        case OP_ARRAY_RESERVE:           return "array reserve";
+        case OP_ARRAY_TRUNCATE:          return "array truncate";
+
+        case OP_ARRAY_COPY:              return "array copy";
+        case OP_ARRAY_FILL_BIT:          return "array fill bit";
+        case OP_ARRAY_FILL_INT8:         return "array fill int8";
+        case OP_ARRAY_FILL_INT16:        return "array fill int16";
+        case OP_ARRAY_FILL_INT:          return "array fill int";
+        case OP_ARRAY_FILL_FLOAT32:      return "array fill float32";
+        case OP_ARRAY_FILL_FLOAT:        return "array fill float";
+        case OP_ARRAY_FILL_ADDRESS:      return "array fill address";
+        case OP_ARRAY_SLICE:             return "array slice";
+        case OP_ARRAY_CONCATENATE:       return "array concatenate";
+        case OP_ARRAY_CONCATENATE_BITS:  return "array concatenate bits";
+
+        case OP_ARRAY_SORT_BOOL:         return "array sort bool";
+        case OP_ARRAY_SORT_INT8:         return "array sort int8";
+        case OP_ARRAY_SORT_INT16:        return "array sort int16";
+        case OP_ARRAY_SORT_INT:          return "array sort int";
+        case OP_ARRAY_SORT_FLOAT32:      return "array sort float32";
+        case OP_ARRAY_SORT_FLOAT:        return "array sort float";
+        case OP_ARRAY_SORT_STRING:       return "array sort string";
+        case OP_ARRAY_SORT_BY:           return "array sort by";
+
+        // Bit array
+        case OP_BITS_COUNT:              return "bits count";
+        case OP_BITS_FIND:               return "bits find";
+        case OP_BITS_AND:                return "bits and";
+        case OP_BITS_OR:                 return "bits or";
+        case OP_BITS_XOR:                return "bits xor";
+
+        // Narrow number array
+        case OP_ARRAY_NARROW_INT8:       return "array narrow int8";
+        case OP_ARRAY_NARROW_INT16:      return "array narrow int16";
+        case OP_ARRAY_NARROW_FLOAT32:    return "array narrow float32";
+        case OP_ARRAY_WIDEN_INT8:        return "array widen int8";
+        case OP_ARRAY_WIDEN_INT16:       return "array widen int16";
+        case OP_ARRAY_WIDEN_FLOAT32:     return "array widen float32";
+
+        // Number array
+        case OP_ITEMS_ADD_INT:           return "items add int";
+        case OP_ITEMS_ADD_FLOAT:         return "items add float";
+        case OP_ITEMS_SUBTRACT_INT:      return "items subtract int";
+        case OP_ITEMS_SUBTRACT_FLOAT:    return "items subtract float";
+        case OP_ITEMS_MULTIPLY_INT:      return "items multiply int";
+        case OP_ITEMS_MULTIPLY_FLOAT:    return "items multiply float";
+        case OP_ITEMS_DIVIDE_INT:        return "items divide int";
+        case OP_ITEMS_DIVIDE_FLOAT:      return "items divide float";
+        case OP_ITEMS_SCALE_INT:         return "items scale int";
+        case OP_ITEMS_SCALE_FLOAT:       return "items scale float";
+        case OP_ITEMS_FMA_INT:           return "items fma int";
+        case OP_ITEMS_FMA_FLOAT:         return "items fma float";
+        case OP_ITEMS_LESS_INT:          return "items less int";
+        case OP_ITEMS_LESS_FLOAT:        return "items less float";
+        case OP_ITEMS_SELECT_INT:        return "items select int";
+        case OP_ITEMS_SELECT_FLOAT:      return "items select float";
+        case OP_ITEMS_SUM_INT:           return "items sum int";
+        case OP_ITEMS_SUM_FLOAT:         return "items sum float";
+        case OP_ITEMS_SUM_SATURATE_INT:  return "items sum saturate int";
+        case OP_ITEMS_DOT_INT:           return "items dot int";
+        case OP_ITEMS_DOT_FLOAT:         return "items dot float";
+        case OP_ITEMS_MIN_INT:           return "items min int";
+        case OP_ITEMS_MIN_FLOAT:         return "items min float";
+        case OP_ITEMS_MAX_INT:           return "items max int";
+        case OP_ITEMS_MAX_FLOAT:         return "items max float";
+        case OP_ITEMS_ARGMIN_INT:        return "items argmin int";
+        case OP_ITEMS_ARGMIN_FLOAT:      return "items argmin float";
+        case OP_ITEMS_ARGMAX_INT:        return "items argmax int";
+        case OP_ITEMS_ARGMAX_FLOAT:      return "items argmax float";
+
+        // Matrix
+        case OP_SUBSCRIPT2_GET_INT8:     return "subscript2 get int8";
+        case OP_SUBSCRIPT2_GET_INT16:    return "subscript2 get int16";
+        case OP_SUBSCRIPT2_GET_INT:      return "subscript2 get int";
+        case OP_SUBSCRIPT2_GET_FLOAT32:  return "subscript2 get float32";
+        case OP_SUBSCRIPT2_GET_FLOAT:    return "subscript2 get float";
+
+        case OP_SUBSCRIPT2_SET_INT8:     return "subscript2 set int8";
+        case OP_SUBSCRIPT2_SET_INT16:    return "subscript2 set int16";
+        case OP_SUBSCRIPT2_SET_INT:      return "subscript2 set int";
+        case OP_SUBSCRIPT2_SET_FLOAT32:  return "subscript2 set float32";
+        case OP_SUBSCRIPT2_SET_FLOAT:    return "subscript2 set float";
+
+        case OP_MATRIX_NEW_INT:          return "matrix new int";
+        case OP_MATRIX_NEW_FLOAT:        return "matrix new float";
+        case OP_MATRIX_ROWS:             return "matrix rows";
+        case OP_MATRIX_COLUMNS:          return "matrix columns";
+        case OP_ARRAY_TO_MATRIX:         return "array to matrix";
+        case OP_MATRIX_TO_ARRAY:         return "matrix to array";
+
+        // Map
+        case OP_DEFINE_MAP:              return "define map";
+        case OP_MAP_GET:                 return "map get";
+        case OP_MAP_SET:                 return "map set";
+        case OP_MAP_CONTAINS:            return "map contains";
+        case OP_MAP_DELETE:              return "map delete";
+
         default:                         return "INVALID";
     }
 }
@@ -26,6 +26,7 @@ typedef enum {
     // Heap
     OP_LOAD_CONSTANT,
     OP_DEFINE_ON_HEAP,
+    OP_DEFINE_BITS_ON_HEAP,
     
     OP_GET_BYTE_FROM_HEAP,
     OP_GET_INT_FROM_HEAP,
@@ -60,6 +61,7 @@ typedef enum {
     OP_MULTIPLY_INT,
     OP_MULTIPLY_FLOAT,
     OP_MULTIPLY_HEAP_VALUE,
+    OP_MULTIPLY_BITS,
     OP_DIVIDE_INT,
     OP_DIVIDE_FLOAT,
     OP_MODULO_INT,
@@ -69,6 +71,14 @@ typedef enum {
 
     // String
     OP_CONCATENATE,
+    OP_CONCATENATE_N,
+    OP_SUBSTRING,
+    OP_COPY_STRING,
+    OP_COMPARE_STRINGS,
+    OP_FIND_SUBSTRING,
+    OP_FIND_BYTE,
+    OP_COUNT_SUBSTRING,
+    OP_SPLIT_STRING,
 
     // Cast
     OP_CAST_FLOAT_TO_INT,
@@ -109,6 +119,7 @@ typedef enum {
     OP_READ_INT,
     OP_READ_FLOAT,
     OP_READ_STRING,
+    OP_READ_LINES,
 
     // Jump
     OP_JUMP,
@@ -124,17 +135,172 @@ typedef enum {
     OP_RETURN_ADDRESS,
     
     // Array
-    OP_SUBSCRIPT_GET_BYTE,
+    OP_SUBSCRIPT_GET_BIT,
+    OP_SUBSCRIPT_GET_INT8,
+    OP_SUBSCRIPT_GET_INT16,
     OP_SUBSCRIPT_GET_INT,
+    OP_SUBSCRIPT_GET_FLOAT32,
     OP_SUBSCRIPT_GET_FLOAT,
     OP_SUBSCRIPT_GET_ADDRESS,
 
-    OP_SUBSCRIPT_SET_BYTE,
+    OP_SUBSCRIPT_SET_BIT,
+    OP_SUBSCRIPT_SET_INT8,
+    OP_SUBSCRIPT_SET_INT16,
     OP_SUBSCRIPT_SET_INT,
+    OP_SUBSCRIPT_SET_FLOAT32,
     OP_SUBSCRIPT_SET_FLOAT,
     OP_SUBSCRIPT_SET_ADDRESS,
+
+    OP_ARRAY_PUSH_BIT,
+    OP_ARRAY_PUSH_INT8,
+    OP_ARRAY_PUSH_INT16,
+    OP_ARRAY_PUSH_INT,
+    OP_ARRAY_PUSH_FLOAT32,
+    OP_ARRAY_PUSH_FLOAT,
+    OP_ARRAY_PUSH_ADDRESS,
+    // Makes an empty array literal [] an array of references.
+    OP_ARRAY_PUSH_REFERENCE,
+
+    OP_ARRAY_POP_BIT,
+    OP_ARRAY_POP_INT8,
+    OP_ARRAY_POP_INT16,
+    OP_ARRAY_POP_INT,
+    OP_ARRAY_POP_FLOAT32,
+    OP_ARRAY_POP_FLOAT,
+    OP_ARRAY_POP_ADDRESS,
+
+    OP_ARRAY_LENGTH,
+    OP_ARRAY_RESERVE,
+    OP_ARRAY_TRUNCATE,
+
+    OP_ARRAY_COPY,
+    OP_ARRAY_FILL_BIT,
+    OP_ARRAY_FILL_INT8,
+    OP_ARRAY_FILL_INT16,
+    OP_ARRAY_FILL_INT,
+    OP_ARRAY_FILL_FLOAT32,
+    OP_ARRAY_FILL_FLOAT,
+    OP_ARRAY_FILL_ADDRESS,
+    OP_ARRAY_SLICE,
+    OP_ARRAY_CONCATENATE,
+    OP_ARRAY_CONCATENATE_BITS,
+
+    OP_ARRAY_SORT_BOOL,
+    OP_ARRAY_SORT_INT8,
+    OP_ARRAY_SORT_INT16,
+    OP_ARRAY_SORT_INT,
+    OP_ARRAY_SORT_FLOAT32,
+    OP_ARRAY_SORT_FLOAT,
+    OP_ARRAY_SORT_STRING,
+    OP_ARRAY_SORT_BY,
+
+    // Bit array
+    OP_BITS_COUNT,
+    OP_BITS_FIND,
+    OP_BITS_AND,
+    OP_BITS_OR,
+    OP_BITS_XOR,
+
+    // Narrow number array
+    OP_ARRAY_NARROW_INT8,
+    OP_ARRAY_NARROW_INT16,
+    OP_ARRAY_NARROW_FLOAT32,
+    OP_ARRAY_WIDEN_INT8,
+    OP_ARRAY_WIDEN_INT16,
+    OP_ARRAY_WIDEN_FLOAT32,
+
+    // Number array
+    OP_ITEMS_ADD_INT,
+    OP_ITEMS_ADD_FLOAT,
+    OP_ITEMS_SUBTRACT_INT,
+    OP_ITEMS_SUBTRACT_FLOAT,
+    OP_ITEMS_MULTIPLY_INT,
+    OP_ITEMS_MULTIPLY_FLOAT,
+    OP_ITEMS_DIVIDE_INT,
+    OP_ITEMS_DIVIDE_FLOAT,
+    OP_ITEMS_SCALE_INT,
+    OP_ITEMS_SCALE_FLOAT,
+    OP_ITEMS_FMA_INT,
+    OP_ITEMS_FMA_FLOAT,
+    OP_ITEMS_LESS_INT,
+    OP_ITEMS_LESS_FLOAT,
+    OP_ITEMS_SELECT_INT,
+    OP_ITEMS_SELECT_FLOAT,
+    OP_ITEMS_SUM_INT,
+    OP_ITEMS_SUM_FLOAT,
+    OP_ITEMS_SUM_SATURATE_INT,
+    OP_ITEMS_DOT_INT,
+    OP_ITEMS_DOT_FLOAT,
+    OP_ITEMS_MIN_INT,
+    OP_ITEMS_MIN_FLOAT,
+    OP_ITEMS_MAX_INT,
+    OP_ITEMS_MAX_FLOAT,
+    OP_ITEMS_ARGMIN_INT,
+    OP_ITEMS_ARGMIN_FLOAT,
+    OP_ITEMS_ARGMAX_INT,
+    OP_ITEMS_ARGMAX_FLOAT,
+
+    // Matrix
+    OP_SUBSCRIPT2_GET_INT8,
+    OP_SUBSCRIPT2_GET_INT16,
+    OP_SUBSCRIPT2_GET_INT,
+    OP_SUBSCRIPT2_GET_FLOAT32,
+    OP_SUBSCRIPT2_GET_FLOAT,
+
+    OP_SUBSCRIPT2_SET_INT8,
+    OP_SUBSCRIPT2_SET_INT16,
+    OP_SUBSCRIPT2_SET_INT,
+    OP_SUBSCRIPT2_SET_FLOAT32,
+    OP_SUBSCRIPT2_SET_FLOAT,
+
+    OP_MATRIX_NEW_INT,
+    OP_MATRIX_NEW_FLOAT,
+    OP_MATRIX_ROWS,
+    OP_MATRIX_COLUMNS,
+    OP_ARRAY_TO_MATRIX,
+    OP_MATRIX_TO_ARRAY,
+
+    // Map
+    OP_DEFINE_MAP,
+    OP_MAP_GET,
+    OP_MAP_SET,
+    OP_MAP_CONTAINS,
+    OP_MAP_DELETE,
 } OpCode;
 
+// OP_CONCATENATE_N is followed by the number of operands and a byte
+// for each of them, telling what's on the stack. Numbers are formatted
+// right into the result.
+typedef enum {
+    CONCATENATE_OPERAND_STRING,
+    CONCATENATE_OPERAND_INT,
+    CONCATENATE_OPERAND_FLOAT,
+} ConcatenateOperand;
+
+// OP_ARRAY_LENGTH, OP_ARRAY_RESERVE, OP_ARRAY_TRUNCATE, OP_ARRAY_COPY and
+// OP_ARRAY_SLICE are followed by a byte with the size of the items,
+// and take lengths and indices in items. OP_ARRAY_SORT_BY is followed
+// by the size of the items and a byte that's 1 if they are references.
+// The size is 0 for arrays of bools, which are packed into bits,
+// see bit_array.h. OP_DEFINE_BITS_ON_HEAP is followed by the number
+// of bools on the stack, a byte each.
+
+// Items of arrays of int8, int16 and float32 are ints and floats
+// on the stack. They are widened when they're read, and the ops that
+// write them fail if the value doesn't fit.
+
+// The number array op codes work on whole [int] and [float] arrays,
+// see number_kernels.h.
+
+// The subscript2 op codes take a matrix, a row and a column,
+// and check both indices at once. OP_ARRAY_TO_MATRIX is followed
+// by a byte with the size of the items.
+
+// Map op codes are followed by a byte with the kind of the keys and
+// a byte with the kind of the values, see MapItemKind. OP_DEFINE_MAP
+// has the number of items before them, and the items are on the stack
+// as key, value, key, value...
+
 
 const char* opCodeName(OpCode op_code);
 
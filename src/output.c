@@ -0,0 +1,221 @@
+#include "output.h"
+
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "number_format.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define VALIDATE_OUTPUT(output)                \
+    (                                          \
+        output                              && \
+        output->buffer                      && \
+        output->size <= OUTPUT_BUFFER_SIZE     \
+    )
+
+#define ASSERT_OUTPUT(output)                            \
+    if (!VALIDATE_OUTPUT(output)) {                      \
+        fprintf(stderr,                                  \
+            "%s:%d, in %s:\noutput assertion failed.\n", \
+            __FILENAME__,                                \
+            __LINE__,                                    \
+            __FUNCTION_NAME__                            \
+        );                                               \
+        fdumpOutput(stderr, output, 0);                  \
+        exit(1);                                         \
+    }
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+// Flushes the output if there's less than size bytes of free space.
+static void reserveOutput(Output* output, size_t size);
+
+// Writes all the bytes to the file descriptor, retrying
+// on interrupts and partial writes.
+static void writeAll(int file_descriptor, const uint8_t* bytes, size_t size);
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+void initOutput(Output* output, int file_descriptor) {
+    assert(output);
+
+    output->file_descriptor = file_descriptor;
+    output->buffer = malloc(OUTPUT_BUFFER_SIZE);
+    output->size = 0;
+    setOutputBuffering(output, OUTPUT_BUFFERING_AUTO);
+
+    ASSERT_OUTPUT(output);
+}
+
+void freeOutput(Output* output) {
+    ASSERT_OUTPUT(output);
+
+    flushOutput(output);
+
+    free(output->buffer);
+    output->buffer = NULL;
+}
+
+void dumpOutput(const Output* output) {
+    fdumpOutput(stdout, output, 0);
+}
+
+void fdumpOutput(FILE* out, const Output* output, int padding) {
+    assert(out);
+
+#define printf(...)                                \
+    {                                              \
+        if (padding > 0) {                         \
+            fprintf(out, "%*s", padding * 2, " "); \
+        }                                          \
+        fprintf(out, __VA_ARGS__);                 \
+    }
+
+    if (!output) {
+        fprintf(out, "Output *(NULL)\n");
+    } else {
+        fprintf(out, "Output *(%p) %s {\n",
+            (const void*)output,
+            VALIDATE_OUTPUT(output) ? "VALID" : "INVALID"
+        );
+        printf("  file_descriptor = %d\n", output->file_descriptor);
+        printf("  buffer = *(%p)\n", (const void*)output->buffer);
+        printf("  size = %zu\n", output->size);
+        printf("  line_buffered = %s\n", output->line_buffered ? "true" : "false");
+        printf("}\n");
+    }
+
+#undef printf
+}
+
+void setOutputBuffering(Output* output, OutputBuffering buffering) {
+    assert(output);
+
+    switch (buffering) {
+        case OUTPUT_BUFFERING_AUTO:
+            output->line_buffered = isatty(output->file_descriptor);
+            break;
+        case OUTPUT_BUFFERING_FULL:
+            output->line_buffered = false;
+            break;
+        case OUTPUT_BUFFERING_LINE:
+            output->line_buffered = true;
+            break;
+        default:
+            assert(false);
+    }
+}
+
+const char* outputBufferingName(OutputBuffering buffering) {
+    switch (buffering) {
+        case OUTPUT_BUFFERING_AUTO: return "auto";
+        case OUTPUT_BUFFERING_FULL: return "full";
+        case OUTPUT_BUFFERING_LINE: return "line";
+        default:
+            assert(false);
+            return NULL;
+    }
+}
+
+void flushOutput(Output* output) {
+    ASSERT_OUTPUT(output);
+
+    if (output->size > 0) {
+        writeAll(output->file_descriptor, output->buffer, output->size);
+        output->size = 0;
+    }
+}
+
+void writeOutput(Output* output, const uint8_t* bytes, size_t size) {
+    ASSERT_OUTPUT(output);
+    assert(bytes || size == 0);
+
+    // A write bigger than the buffer isn't copied.
+    if (size > OUTPUT_BUFFER_SIZE) {
+        flushOutput(output);
+        writeAll(output->file_descriptor, bytes, size);
+        return;
+    }
+
+    reserveOutput(output, size);
+    memcpy(output->buffer + output->size, bytes, size);
+    output->size += size;
+}
+
+void writeBool(Output* output, bool value) {
+    if (value) {
+        writeOutput(output, (const uint8_t*)"true", 4);
+    } else {
+        writeOutput(output, (const uint8_t*)"false", 5);
+    }
+}
+
+void writeInt(Output* output, int32_t value) {
+    reserveOutput(output, INT_STRING_MAX_LENGTH);
+
+    size_t length = intStringLength(value);
+    formatInt(value, output->buffer + output->size, length);
+    output->size += length;
+}
+
+void writeFloat(Output* output, double value) {
+    reserveOutput(output, FLOAT_STRING_MAX_LENGTH);
+
+    output->size += formatFloat(value, output->buffer + output->size);
+}
+
+void endOutputLine(Output* output) {
+    reserveOutput(output, 1);
+    output->buffer[output->size++] = '\n';
+
+    if (output->line_buffered) {
+        flushOutput(output);
+    }
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static void reserveOutput(Output* output, size_t size) {
+    ASSERT_OUTPUT(output);
+    assert(size <= OUTPUT_BUFFER_SIZE);
+
+    if (OUTPUT_BUFFER_SIZE - output->size < size) {
+        flushOutput(output);
+    }
+}
+
+static void writeAll(int file_descriptor, const uint8_t* bytes, size_t size) {
+    while (size > 0) {
+        ssize_t count = write(file_descriptor, bytes, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return;
+        }
+        bytes += count;
+        size -= (size_t)count;
+    }
+}
+
+
+#undef ASSERT_OUTPUT
+#undef VALIDATE_OUTPUT
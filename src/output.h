@@ -0,0 +1,73 @@
+#ifndef lala_output_h
+#define lala_output_h
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Buffered output is written with a single write(2) when this much is buffered.
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+typedef enum {
+    // Line buffered if the file descriptor is a terminal,
+    // fully buffered otherwise, like stdout in stdio.
+    OUTPUT_BUFFERING_AUTO,
+    // Written when the buffer is full, before reading input and at the end.
+    OUTPUT_BUFFERING_FULL,
+    // Also written after every line, for interactive programs.
+    OUTPUT_BUFFERING_LINE,
+} OutputBuffering;
+
+/* Buffered writer to a file descriptor.
+ *
+ * The buffered bytes are buffer[0, size). Numbers are formatted
+ * right into the buffer.
+ * */
+typedef struct {
+    int file_descriptor;
+    uint8_t* buffer;
+    size_t size;
+    bool line_buffered;
+} Output;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+// The output is initialized with OUTPUT_BUFFERING_AUTO.
+void initOutput(Output* output, int file_descriptor);
+// Flushes the output.
+void freeOutput(Output* output);
+void dumpOutput(const Output* output);
+void fdumpOutput(FILE* out, const Output* output, int padding);
+
+void setOutputBuffering(Output* output, OutputBuffering buffering);
+const char* outputBufferingName(OutputBuffering buffering);
+
+// Writes the buffered bytes. Bytes that can't be written, for example
+// because the reader of a pipe has exited, are dropped.
+void flushOutput(Output* output);
+
+void writeOutput(Output* output, const uint8_t* bytes, size_t size);
+void writeBool  (Output* output, bool value);
+void writeInt   (Output* output, int32_t value);
+void writeFloat (Output* output, double value);
+
+// Writes a line break and flushes a line buffered output.
+void endOutputLine(Output* output);
+
+
+#endif
@@ -4,9 +4,11 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#include "builtin.h"
 #include "ccf.h"
 #include "debug.h"
 #include "heap.h"
+#include "map.h"
 
 
 // ┌────────┐
@@ -113,12 +115,60 @@ static StatementProperties parseBlock     (Parser* parser);
 // Expression
 static ValueType* parseOr        (Parser* parser);
 static ValueType* parseAnd       (Parser* parser);
+// Emits the jump of 'and' and 'or' to the right operand, and the result
+// the left operand decides with the jump over the right operand. Returns
+// the position of the address of that jump, filled after the right operand.
+static size_t     emitShortCircuit(Parser* parser, OpCode jump_to_right_operand, OpCode push_result);
 static ValueType* parseComparison(Parser* parser);
 static ValueType* parseTerm      (Parser* parser);
+static void       parseConcatenation(Parser* parser, Token expression_start_token);
+static ConcatenateOperand takeConcatenateOperand(Parser* parser);
 static ValueType* parseFactor    (Parser* parser);
 static ValueType* parsePrefix    (Parser* parser);
 static ValueType* parsePostfix   (Parser* parser, ExpressionKind expression_kind);
 static ValueType* parsePrimary   (Parser* parser, ExpressionKind expression_kind);
+static ValueType* parseBuiltinCall(Parser* parser, Builtin builtin, ExpressionKind expression_kind);
+static ValueType* parseBuiltinArgument(
+    Parser* parser,
+    Builtin builtin,
+    ValueType* parameter_type,
+    bool is_last
+);
+// Parses an argument of any type with the given basic type,
+// like a map with any keys and values.
+static ValueType* parseBuiltinArgumentOfBasicType(
+    Parser* parser,
+    Builtin builtin,
+    BasicValueType basic_type,
+    bool is_last
+);
+// Parses an array argument with a known item type.
+static ValueType* parseArrayBuiltinArgument(Parser* parser, Builtin builtin, bool is_last);
+// Parses an array argument with items of the basic type, like [bool].
+static ValueType* parseArrayOfBuiltinArgument(
+    Parser* parser,
+    Builtin builtin,
+    BasicValueType item_type,
+    bool is_last
+);
+// Parses an [int] or a [float] argument.
+static ValueType* parseNumberArrayBuiltinArgument(Parser* parser, Builtin builtin, bool is_last);
+// Emits the op code for the item type of the [int] or [float] array.
+static void emitNumberArrayOpCode(Parser* parser, ValueType* array_type, OpCode int_op_code, OpCode float_op_code);
+// Parses an int or a float argument.
+static ValueType* parseNumberBuiltinArgument(Parser* parser, Builtin builtin, bool is_last);
+// Parses matrix[row, column] after the bracket, or matrix[row, column] = value
+// in an expression statement, in which case NULL is returned.
+static ValueType* parseMatrixSubscript(Parser* parser, ValueType* matrix_type, ExpressionKind expression_kind);
+// Parses map[key] after the bracket, or map[key] = value in an
+// expression statement, in which case NULL is returned.
+static ValueType* parseMapSubscript(Parser* parser, ValueType* map_type, ExpressionKind expression_kind);
+
+// Returns MAP_ITEM_UNKNOWN for types that can't be map keys or values.
+static MapItemKind mapKeyKindForValueType(ValueType* value_type);
+static MapItemKind mapValueKindForValueType(ValueType* value_type);
+// Emits a map op code followed by the kinds of the keys and the values.
+static void emitMapOpCode(Parser* parser, OpCode op_code, ValueType* map_type);
 
 
 // —————————————————————
@@ -182,6 +232,9 @@ void initParser(Parser* parser, Stack* chunk) {
     parser->had_error = false;
     parser->scope = createScope(NULL);
     parser->constants.count = 0;
+    parser->number_to_string_cast_end = 0;
+    parser->parsing_map_key = false;
+    parser->map_key_ended = false;
     initStack(&parser->free_on_end);
 
     ASSERT_HALF_INITIALIZED_PARSER(parser);
@@ -989,11 +1042,83 @@ static ValueType* parseValueType(Parser* parser) {
         case TOKEN_STRING:   return &VALUE_TYPE_STRING;
         
         case TOKEN_LBRACKET: {
-            ValueType* element_type = parseValueType(parser);
+            // Narrow numbers may only be array items.
+            ValueType* element_type;
+            if (match(parser, TOKEN_INT8)) {
+                element_type = &VALUE_TYPE_INT8;
+            } else if (match(parser, TOKEN_INT16)) {
+                element_type = &VALUE_TYPE_INT16;
+            } else if (match(parser, TOKEN_FLOAT32)) {
+                element_type = &VALUE_TYPE_FLOAT32;
+            } else {
+                element_type = parseValueType(parser);
+            }
+
+            // [T,] is a matrix.
+            if (match(parser, TOKEN_COMMA)) {
+                if (!isMatrixItemValueType(element_type)) {
+                    errorAtPrevious(
+                        parser,
+                        "Semantic",
+                        "Invalid matrix item type %s. Only numbers can be matrix items.",
+                        valueTypeName(element_type)
+                    );
+                    return &VALUE_TYPE_INVALID;
+                }
+                forceMatch(parser, TOKEN_RBRACKET);
+                return createMatrixValueType(element_type);
+            }
+
             forceMatch(parser, TOKEN_RBRACKET);
             return createArrayValueType(element_type);
         }
+
+        case TOKEN_LBRACE: {
+            Token key_type_start_token = next(parser);
+            ValueType* key_type = parseValueType(parser);
+            if (mapKeyKindForValueType(key_type) == MAP_ITEM_UNKNOWN) {
+                errorAt(
+                    parser,
+                    "Semantic",
+                    key_type_start_token,
+                    "Invalid map key type %s. Only bool, int and string can be map keys.",
+                    valueTypeName(key_type)
+                );
+                return &VALUE_TYPE_INVALID;
+            }
+            forceMatch(parser, TOKEN_COLON);
+
+            Token element_type_start_token = next(parser);
+            ValueType* element_type = parseValueType(parser);
+            if (mapValueKindForValueType(element_type) == MAP_ITEM_UNKNOWN) {
+                errorAt(
+                    parser,
+                    "Semantic",
+                    element_type_start_token,
+                    "Invalid map value type %s.",
+                    valueTypeName(element_type)
+                );
+                return &VALUE_TYPE_INVALID;
+            }
+            forceMatch(parser, TOKEN_RBRACE);
+
+            return createMapValueType(key_type, element_type);
+        }
         
+        case TOKEN_INT8:
+        case TOKEN_INT16:
+        case TOKEN_FLOAT32:
+            errorAtPrevious(
+                parser,
+                "Semantic",
+                "%.*s can only be an array item type, like in [%.*s].",
+                previous(parser).length,
+                previous(parser).start,
+                previous(parser).length,
+                previous(parser).start
+            );
+            return &VALUE_TYPE_INVALID;
+
         case TOKEN_IDENTIFIER: {
             // Find the structure variable.
             Variable variable;
@@ -1033,7 +1158,7 @@ static ValueType* parseValueType(Parser* parser) {
             errorAtPrevious(
                 parser,
                 "Syntactic",
-                "Expected type specifier: bool, int, float, string or array. Got %s.",
+                "Expected type specifier: bool, int, float, string, array or map. Got %s.",
                 tokenTypeName(previous(parser).type)
             );
             return &VALUE_TYPE_INVALID;
@@ -1357,10 +1482,14 @@ static ValueType* parseOr(Parser* parser) {
     ValueType* value_type_l = parseAnd(parser);
 
     while (match(parser, TOKEN_OR)) {
-        ValueType* value_type_r = parseAnd(parser);
+        // The right operand is evaluated only if the left one is false,
+        // otherwise the result is true; fill the jump over it later
+        size_t after_or_address_position_in_chunk = emitShortCircuit(parser, OP_JUMP_IF_FALSE, OP_PUSH_TRUE);
 
+        ValueType* value_type_r = parseAnd(parser);
         validateOperatorTypes(parser, expression_start_token, TOKEN_OR, value_type_l->basic_type, value_type_r->basic_type);
-        emitOpCodesForTokenAndValueTypesCombination(parser, 2, TOKEN_OR, value_type_l->basic_type);
+
+        setAddressOnStack(parser->chunk, after_or_address_position_in_chunk, stackSize(parser->chunk));
     }
 
     ASSERT_PARSER(parser);
@@ -1375,10 +1504,14 @@ static ValueType* parseAnd(Parser* parser) {
     ValueType* value_type_l = parseComparison(parser);
     
     while (match(parser, TOKEN_AND)) {
-        ValueType* value_type_r = parseComparison(parser);
+        // The right operand is evaluated only if the left one is true,
+        // otherwise the result is false; fill the jump over it later
+        size_t after_and_address_position_in_chunk = emitShortCircuit(parser, OP_JUMP_IF_TRUE, OP_PUSH_FALSE);
 
+        ValueType* value_type_r = parseComparison(parser);
         validateOperatorTypes(parser, expression_start_token, TOKEN_AND, value_type_l->basic_type, value_type_r->basic_type);
-        emitOpCodesForTokenAndValueTypesCombination(parser, 2, TOKEN_AND, value_type_l->basic_type);
+
+        setAddressOnStack(parser->chunk, after_and_address_position_in_chunk, stackSize(parser->chunk));
     }
 
     ASSERT_PARSER(parser);
@@ -1386,6 +1519,25 @@ static ValueType* parseAnd(Parser* parser) {
     return value_type_l;
 }
 
+static size_t emitShortCircuit(Parser* parser, OpCode jump_to_right_operand, OpCode push_result) {
+    ASSERT_PARSER(parser);
+
+    pushOpCodeOnStack(parser->chunk, jump_to_right_operand);
+    size_t right_operand_address_position_in_chunk = stackSize(parser->chunk);
+    pushAddressOnStack(parser->chunk, (size_t)0);
+
+    pushOpCodeOnStack(parser->chunk, push_result);
+    pushOpCodeOnStack(parser->chunk, OP_JUMP);
+    size_t after_right_operand_address_position_in_chunk = stackSize(parser->chunk);
+    pushAddressOnStack(parser->chunk, (size_t)0);
+
+    size_t right_operand_address = stackSize(parser->chunk);
+    setAddressOnStack(parser->chunk, right_operand_address_position_in_chunk, right_operand_address);
+
+    ASSERT_PARSER(parser);
+    return after_right_operand_address_position_in_chunk;
+}
+
 static ValueType* parseComparison(Parser* parser) {
     ASSERT_PARSER(parser);
 
@@ -1408,6 +1560,49 @@ static ValueType* parseComparison(Parser* parser) {
         value_type_l = &VALUE_TYPE_BOOL;
     }
 
+    // Map membership
+    else if (match(parser, TOKEN_IN)) {
+        Token map_start_token = next(parser);
+        ValueType* map_type = parseTerm(parser);
+
+        if (map_type->basic_type != BASIC_VALUE_TYPE_MAP) {
+            error(
+                parser,
+                "Semantic",
+                map_start_token,
+                previous(parser),
+                "Expected a map after in, got a %s.",
+                valueTypeName(map_type)
+            );
+            return &VALUE_TYPE_INVALID;
+        }
+        if (map_type->as.map.key_type == NULL) {
+            error(
+                parser,
+                "Semantic",
+                map_start_token,
+                previous(parser),
+                "Can't look up a key in an empty map literal."
+            );
+            return &VALUE_TYPE_INVALID;
+        }
+        if (!valueTypesEqual(map_type->as.map.key_type, value_type_l)) {
+            error(
+                parser,
+                "Semantic",
+                expression_start_token,
+                previous(parser),
+                "Key type %s doesn't match map key type %s.",
+                valueTypeName(value_type_l),
+                valueTypeName(map_type->as.map.key_type)
+            );
+            return &VALUE_TYPE_INVALID;
+        }
+
+        emitMapOpCode(parser, OP_MAP_CONTAINS, map_type);
+        value_type_l = &VALUE_TYPE_BOOL;
+    }
+
     ASSERT_PARSER(parser);
     assert(value_type_l);
     return value_type_l;
@@ -1418,6 +1613,15 @@ static ValueType* parseTerm(Parser* parser) {
 
     Token expression_start_token = next(parser);
     ValueType* value_type_l = parseFactor(parser);
+
+    if (
+        value_type_l->basic_type == BASIC_VALUE_TYPE_STRING &&
+        peekNext(parser) == TOKEN_PLUS
+    ) {
+        parseConcatenation(parser, expression_start_token);
+        ASSERT_PARSER(parser);
+        return value_type_l;
+    }
     
     while (match(parser, TOKEN_PLUS) || match(parser, TOKEN_MINUS)) {
         TokenType operator_token_type = previous(parser).type;
@@ -1432,6 +1636,75 @@ static ValueType* parseTerm(Parser* parser) {
     return value_type_l;
 }
 
+// Parses a chain of string additions after its first operand, so that
+// the result is allocated once. Casts of numbers to string in the chain
+// are left to OP_CONCATENATE_N.
+static void parseConcatenation(Parser* parser, Token expression_start_token) {
+    ASSERT_PARSER(parser);
+
+    uint8_t operands[UINT8_MAX];
+    uint8_t count = 0;
+    operands[count++] = (uint8_t)takeConcatenateOperand(parser);
+
+    while (match(parser, TOKEN_PLUS) || match(parser, TOKEN_MINUS)) {
+        TokenType operator_token_type = previous(parser).type;
+
+        // There's no space for the next operand. Concatenate
+        // the ones on the stack first.
+        if (count == UINT8_MAX) {
+            pushOpCodeOnStack(parser->chunk, OP_CONCATENATE_N);
+            pushByteOnStack(parser->chunk, count);
+            for (uint8_t i = 0; i < count; ++i) {
+                pushByteOnStack(parser->chunk, operands[i]);
+            }
+            count = 0;
+            operands[count++] = CONCATENATE_OPERAND_STRING;
+        }
+
+        ValueType* value_type_r = parseFactor(parser);
+        validateOperatorTypes(parser, expression_start_token, operator_token_type, BASIC_VALUE_TYPE_STRING, value_type_r->basic_type);
+        operands[count++] = (uint8_t)takeConcatenateOperand(parser);
+    }
+
+    if (
+        count == 2 &&
+        operands[0] == CONCATENATE_OPERAND_STRING &&
+        operands[1] == CONCATENATE_OPERAND_STRING
+    ) {
+        pushOpCodeOnStack(parser->chunk, OP_CONCATENATE);
+    } else {
+        pushOpCodeOnStack(parser->chunk, OP_CONCATENATE_N);
+        pushByteOnStack(parser->chunk, count);
+        for (uint8_t i = 0; i < count; ++i) {
+            pushByteOnStack(parser->chunk, operands[i]);
+        }
+    }
+
+    ASSERT_PARSER(parser);
+}
+
+// If the string operand just parsed ends with a cast of a number to string,
+// removes the cast and returns the number type.
+static ConcatenateOperand takeConcatenateOperand(Parser* parser) {
+    ASSERT_PARSER(parser);
+
+    if (
+        parser->number_to_string_cast_end == 0 ||
+        parser->number_to_string_cast_end != stackSize(parser->chunk)
+    ) {
+        return CONCATENATE_OPERAND_STRING;
+    }
+
+    parser->number_to_string_cast_end = 0;
+    switch (popByteFromStack(parser->chunk)) {
+        case OP_CAST_INT_TO_STRING:   return CONCATENATE_OPERAND_INT;
+        case OP_CAST_FLOAT_TO_STRING: return CONCATENATE_OPERAND_FLOAT;
+        default:
+            assert(false);
+            return CONCATENATE_OPERAND_STRING;
+    }
+}
+
 static ValueType* parseFactor(Parser* parser) {
     ASSERT_PARSER(parser);
 
@@ -1461,7 +1734,13 @@ static ValueType* parseFactor(Parser* parser) {
                      valueTypeName(value_type_r)
                  );
             }
-            pushOpCodeOnStack(parser->chunk, OP_MULTIPLY_HEAP_VALUE);
+            ValueType* element_type = value_type_l->as.array.element_type;
+            pushOpCodeOnStack(
+                parser->chunk,
+                element_type && element_type->basic_type == BASIC_VALUE_TYPE_BOOL
+                    ? OP_MULTIPLY_BITS
+                    : OP_MULTIPLY_HEAP_VALUE
+            );
         }
 
         // Other
@@ -1688,12 +1967,27 @@ static ValueType* parsePostfix(Parser* parser, ExpressionKind expression_kind) {
             
             // Subscript
             case TOKEN_LBRACKET: {
+                if (value_type->basic_type == BASIC_VALUE_TYPE_MAP) {
+                    value_type = parseMapSubscript(parser, value_type, expression_kind);
+                    if (value_type == &VALUE_TYPE_INVALID) {
+                        return &VALUE_TYPE_INVALID;
+                    }
+                    break;
+                }
+                if (value_type->basic_type == BASIC_VALUE_TYPE_MATRIX) {
+                    value_type = parseMatrixSubscript(parser, value_type, expression_kind);
+                    if (value_type == &VALUE_TYPE_INVALID) {
+                        return &VALUE_TYPE_INVALID;
+                    }
+                    break;
+                }
+
                 // Make sure the value is array.
                 if (value_type->basic_type != BASIC_VALUE_TYPE_ARRAY) {
                     errorAtPrevious(
                         parser,
                         "Semantic",
-                        "Trying to subscript a %s. Only arrays may be subscripted.",
+                        "Trying to subscript a %s. Only arrays, matrices and maps may be subscripted.",
                         valueTypeName(value_type)
                     );
                     return &VALUE_TYPE_INVALID;
@@ -1726,6 +2020,7 @@ static ValueType* parsePostfix(Parser* parser, ExpressionKind expression_kind) {
                 }
 
                 OpCode op_code = getOpSubscriptGetForValueType(value_type->as.array.element_type);
+                ValueType* item_value_type = arrayItemValueType(value_type->as.array.element_type);
 
                 // If it's an expression statement and this postfix is the last postfix in the lhs,
                 // parse the assignment.
@@ -1735,14 +2030,14 @@ static ValueType* parsePostfix(Parser* parser, ExpressionKind expression_kind) {
                     ValueType* expression_value_type = parseExpression(parser);
 
                     // Make sure the array elements and value types match.
-                    if (!valueTypesEqual(value_type->as.array.element_type, expression_value_type)) {
+                    if (!valueTypesEqual(item_value_type, expression_value_type)) {
                         error(
                             parser,
                             "Semantic",
                             expression_start_token,
                             previous(parser),
                             "Array element type (%s) and expression type (%s) don't match in an assignment.",
-                            valueTypeName(value_type->as.array.element_type),
+                            valueTypeName(item_value_type),
                             valueTypeName(expression_value_type)
                         );
                     }
@@ -1751,7 +2046,7 @@ static ValueType* parsePostfix(Parser* parser, ExpressionKind expression_kind) {
                     op_code = getOpSubscriptSetForValueType(value_type->as.array.element_type);
                     value_type = NULL;
                 } else {
-                    value_type = value_type->as.array.element_type;
+                    value_type = item_value_type;
                 }
 
                 // Get or set the array element.
@@ -1760,8 +2055,20 @@ static ValueType* parsePostfix(Parser* parser, ExpressionKind expression_kind) {
                 break;
             }
 
-            // Type cast
+            // Type cast, or the end of a map literal key.
             case TOKEN_COLON:
+                if (
+                    parser->parsing_map_key         &&
+                    peekNext(parser) != TOKEN_INT   &&
+                    peekNext(parser) != TOKEN_FLOAT &&
+                    peekNext(parser) != TOKEN_STRING
+                ) {
+                    assert(expression_kind == EXPRESSION);
+                    parser->map_key_ended = true;
+                    ASSERT_PARSER(parser);
+                    return value_type;
+                }
+
                 switch (advance(parser)) {
                     
                     // Cast float to int
@@ -1793,9 +2100,11 @@ static ValueType* parsePostfix(Parser* parser, ExpressionKind expression_kind) {
                                 break;
                             case BASIC_VALUE_TYPE_INT:
                                 pushOpCodeOnStack(parser->chunk, OP_CAST_INT_TO_STRING);
+                                parser->number_to_string_cast_end = stackSize(parser->chunk);
                                 break;
                             case BASIC_VALUE_TYPE_FLOAT:
                                 pushOpCodeOnStack(parser->chunk, OP_CAST_FLOAT_TO_STRING);
+                                parser->number_to_string_cast_end = stackSize(parser->chunk);
                                 break;
                             default:
                                 assert(false);
@@ -1871,7 +2180,7 @@ static ValueType* parsePostfix(Parser* parser, ExpressionKind expression_kind) {
 static ValueType* parsePrimary(Parser* parser, ExpressionKind expression_kind) {
     ASSERT_PARSER(parser);
 
-    ValueType* value_type;
+    ValueType* value_type = NULL;
 
     if (expression_kind == EXPRESSION_STATEMENT) {
         assert(peekNext(parser) == TOKEN_IDENTIFIER);
@@ -1935,11 +2244,18 @@ static ValueType* parsePrimary(Parser* parser, ExpressionKind expression_kind) {
                     pushOpCodeOnStack(parser->chunk, OP_READ_STRING);
                     value_type = &VALUE_TYPE_STRING;
                     break;
+                // All the remaining lines.
+                case TOKEN_LBRACKET:
+                    forceMatch(parser, TOKEN_STRING);
+                    forceMatch(parser, TOKEN_RBRACKET);
+                    pushOpCodeOnStack(parser->chunk, OP_READ_LINES);
+                    value_type = createArrayValueType(&VALUE_TYPE_STRING);
+                    break;
                 default:
                     errorAtPrevious(
                         parser,
                         "Semantic",
-                        "Expected read to be followed by bool, int, float or string. Got %s.",
+                        "Expected read to be followed by bool, int, float, string or [string]. Got %s.",
                         tokenTypeName(previous(parser).type)
                     );
                     break;
@@ -1956,6 +2272,16 @@ static ValueType* parsePrimary(Parser* parser, ExpressionKind expression_kind) {
                 &variable
             );
 
+            // Builtin call, unless a variable hides the builtin.
+            Builtin builtin;
+            if (
+                !found_variable &&
+                peekNext(parser) == TOKEN_LPAREN &&
+                findBuiltin(previous(parser).start, previous(parser).length, &builtin)
+            ) {
+                return parseBuiltinCall(parser, builtin, expression_kind);
+            }
+
             // Make sure the variable is present.
             if (!found_variable) {
                 errorAtPrevious(
@@ -2122,30 +2448,137 @@ static ValueType* parsePrimary(Parser* parser, ExpressionKind expression_kind) {
                 assert(element_type);
             }
 
-            pushOpCodeOnStack(parser->chunk, OP_DEFINE_ON_HEAP);
-            pushAddressOnStack(
-                parser->chunk,
-                element_type ? elements_count * valueTypeSize(element_type) : 0
-            );
-            pushByteOnStack(
-                parser->chunk,
-                element_type
-                    ? (isReferenceValueType(element_type) ? REFERENCE_RULE_REF_ARRAY : REFERENCE_RULE_PLAIN)
-                    : REFERENCE_RULE_PLAIN  // In case it's an empty array [], reference rule is set to plain.
-                                            // It might cause problems in future when arrays may be resized.
-            );
+            // Bools are packed into bits.
+            if (element_type && element_type->basic_type == BASIC_VALUE_TYPE_BOOL) {
+                pushOpCodeOnStack(parser->chunk, OP_DEFINE_BITS_ON_HEAP);
+                pushAddressOnStack(parser->chunk, elements_count);
+            } else {
+                pushOpCodeOnStack(parser->chunk, OP_DEFINE_ON_HEAP);
+                pushAddressOnStack(
+                    parser->chunk,
+                    element_type ? elements_count * valueTypeSize(element_type) : 0
+                );
+                pushByteOnStack(
+                    parser->chunk,
+                    element_type
+                        ? (isReferenceValueType(element_type) ? REFERENCE_RULE_REF_ARRAY : REFERENCE_RULE_PLAIN)
+                        : REFERENCE_RULE_PLAIN  // In case it's an empty array [], reference rule is set to plain.
+                                                // It becomes a ref array when a reference is pushed onto it.
+                );
+            }
 
             value_type = createArrayValueType(element_type);
             break;
         }
         
-        case TOKEN_LBRACE:
-            errorAtPrevious(
-                parser,
-                "Syntactic",
-                "Maps not implemented yet."
-            );
-            return &VALUE_TYPE_INVALID;
+        case TOKEN_LBRACE: {
+            ValueType* key_type = NULL;
+            ValueType* element_type = NULL;
+            size_t items_count = 0;
+
+            // The literal may be a part of a key of an outer one.
+            bool parsing_outer_map_key = parser->parsing_map_key;
+
+            while (!match(parser, TOKEN_RBRACE) && peekNext(parser) != TOKEN_END) {
+                // Key. It ends at a colon that isn't a type cast.
+                Token key_start_token = next(parser);
+                parser->parsing_map_key = true;
+                parser->map_key_ended = false;
+                ValueType* current_key_type = parseExpression(parser);
+                parser->parsing_map_key = false;
+                if (current_key_type == &VALUE_TYPE_INVALID) {
+                    parser->parsing_map_key = parsing_outer_map_key;
+                    return &VALUE_TYPE_INVALID;
+                }
+                if (!parser->map_key_ended) {
+                    forceMatch(parser, TOKEN_COLON);
+                }
+                parser->map_key_ended = false;
+
+                if (key_type == NULL) {
+                    if (mapKeyKindForValueType(current_key_type) == MAP_ITEM_UNKNOWN) {
+                        error(
+                            parser,
+                            "Semantic",
+                            key_start_token,
+                            previous(parser),
+                            "Invalid map key type %s. Only bool, int and string can be map keys.",
+                            valueTypeName(current_key_type)
+                        );
+                        parser->parsing_map_key = parsing_outer_map_key;
+                        return &VALUE_TYPE_INVALID;
+                    }
+                    key_type = current_key_type;
+                }
+                if (!valueTypesEqual(key_type, current_key_type)) {
+                    error(
+                        parser,
+                        "Semantic",
+                        key_start_token,
+                        previous(parser),
+                        "Invalid map key type %s in a map with %s keys.",
+                        valueTypeName(current_key_type),
+                        valueTypeName(key_type)
+                    );
+                    parser->parsing_map_key = parsing_outer_map_key;
+                    return &VALUE_TYPE_INVALID;
+                }
+
+                // Value
+                Token value_start_token = next(parser);
+                ValueType* current_element_type = parseExpression(parser);
+                if (current_element_type == &VALUE_TYPE_INVALID) {
+                    parser->parsing_map_key = parsing_outer_map_key;
+                    return &VALUE_TYPE_INVALID;
+                }
+
+                if (element_type == NULL) {
+                    if (mapValueKindForValueType(current_element_type) == MAP_ITEM_UNKNOWN) {
+                        error(
+                            parser,
+                            "Semantic",
+                            value_start_token,
+                            previous(parser),
+                            "Invalid map value type %s.",
+                            valueTypeName(current_element_type)
+                        );
+                        parser->parsing_map_key = parsing_outer_map_key;
+                        return &VALUE_TYPE_INVALID;
+                    }
+                    element_type = current_element_type;
+                }
+                if (!valueTypesEqual(element_type, current_element_type)) {
+                    error(
+                        parser,
+                        "Semantic",
+                        value_start_token,
+                        previous(parser),
+                        "Invalid map value type %s in a map of %s",
+                        valueTypeName(current_element_type),
+                        valueTypeName(element_type)
+                    );
+                    parser->parsing_map_key = parsing_outer_map_key;
+                    return &VALUE_TYPE_INVALID;
+                }
+
+                if (peekNext(parser) != TOKEN_RBRACE) {
+                    forceMatch(parser, TOKEN_COMMA);
+                }
+
+                items_count += 1;
+            }
+
+            parser->parsing_map_key = parsing_outer_map_key;
+
+            // An empty map {} has no types, it takes the types
+            // of the first item inserted at run time.
+            value_type = createMapValueType(key_type, element_type);
+            pushOpCodeOnStack(parser->chunk, OP_DEFINE_MAP);
+            pushAddressOnStack(parser->chunk, items_count);
+            pushByteOnStack(parser->chunk, key_type ? mapKeyKindForValueType(key_type) : MAP_ITEM_UNKNOWN);
+            pushByteOnStack(parser->chunk, element_type ? mapValueKindForValueType(element_type) : MAP_ITEM_UNKNOWN);
+            break;
+        }
         
         case TOKEN_LPAREN:
             value_type = parseExpression(parser);
@@ -2169,41 +2602,1095 @@ static ValueType* parsePrimary(Parser* parser, ExpressionKind expression_kind) {
     return value_type;
 }
 
+static ValueType* parseBuiltinCall(Parser* parser, Builtin builtin, ExpressionKind expression_kind) {
+    ASSERT_PARSER(parser);
 
-// ─────────────────────
-//  Operator type rules 
-// ─────────────────────
+    ValueType* value_type = NULL;
+    forceMatch(parser, TOKEN_LPAREN);
 
-typedef struct {
-    BasicValueType  left_operand_expected_types[4];
-    BasicValueType right_operand_expected_types[4];
-    bool types_have_to_match;
-} OperatorTypeRules;
+    switch (builtin) {
+        // add-items(destination: [T], source: [T]) void, for int and float items
+        case BUILTIN_ADD_ITEMS: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type, true);
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_ADD_INT, OP_ITEMS_ADD_FLOAT);
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
 
-#define B    { BASIC_VALUE_TYPE_BOOL }
-#define I    { BASIC_VALUE_TYPE_INT }
-#define IF   { BASIC_VALUE_TYPE_INT,  BASIC_VALUE_TYPE_FLOAT }
-#define IFS  { BASIC_VALUE_TYPE_INT,  BASIC_VALUE_TYPE_FLOAT, BASIC_VALUE_TYPE_STRING }
-#define BIFS { BASIC_VALUE_TYPE_BOOL, BASIC_VALUE_TYPE_INT,   BASIC_VALUE_TYPE_FLOAT, BASIC_VALUE_TYPE_STRING }
-#define A    { BASIC_VALUE_TYPE_ARRAY }
+        // and-items(destination: [bool], source: [bool]) void
+        case BUILTIN_AND_ITEMS:
+            if (
+                parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_BOOL, false) == &VALUE_TYPE_INVALID ||
+                parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_BOOL, true)  == &VALUE_TYPE_INVALID
+            ) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_BITS_AND);
+            value_type = &VALUE_TYPE_VOID;
+            break;
 
-OperatorTypeRules operator_type_rules[] = {
-    [TOKEN_OR]                = { B,     B,     true  },
-    [TOKEN_AND]               = { B,     B,     true  },
-    [TOKEN_EQUAL_EQUAL]       = { BIFS,  BIFS,  true  },
-    [TOKEN_EXCLAMATION_EQUAL] = { BIFS,  BIFS,  true  },
-    [TOKEN_GREATER_EQUAL]     = { IFS,   IFS,   true  },
-    [TOKEN_LESS_EQUAL]        = { IFS,   IFS,   true  },
-    [TOKEN_GREATER]           = { IFS,   IFS,   true  },
-    [TOKEN_LESS]              = { IFS,   IFS,   true  },
-    [TOKEN_PLUS]              = { IFS,   IFS,   true  },
-    [TOKEN_MINUS]             = { IF,    IF,    true  },
-    [TOKEN_STAR]              = { IF,    IF,    true  },
-    [TOKEN_SLASH]             = { IF,    IF,    true  },
-    [TOKEN_PERCENT]           = { IF,    I,     false },
-    [TOKEN_EXCLAMATION]       = { B,     B,     true  },
-    [TOKEN_LBRACKET]          = { A,     I,     false },  // Subscript
-};
+        // argmax(array: [T]) int, for int and float items, -1 if the array is empty
+        case BUILTIN_ARGMAX: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, true);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_ARGMAX_INT, OP_ITEMS_ARGMAX_FLOAT);
+            value_type = &VALUE_TYPE_INT;
+            break;
+        }
+
+        // argmin(array: [T]) int, for int and float items, -1 if the array is empty
+        case BUILTIN_ARGMIN: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, true);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_ARGMIN_INT, OP_ITEMS_ARGMIN_FLOAT);
+            value_type = &VALUE_TYPE_INT;
+            break;
+        }
+
+        // columns(matrix: [T,]) int
+        case BUILTIN_COLUMNS:
+            if (parseBuiltinArgumentOfBasicType(parser, builtin, BASIC_VALUE_TYPE_MATRIX, true) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_MATRIX_COLUMNS);
+            value_type = &VALUE_TYPE_INT;
+            break;
+
+        // compare(a: string, b: string) int
+        case BUILTIN_COMPARE:
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, true);
+            pushOpCodeOnStack(parser->chunk, OP_COMPARE_STRINGS);
+            value_type = &VALUE_TYPE_INT;
+            break;
+
+        // concat(left: [T], right: [T]) [T]
+        case BUILTIN_CONCAT: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type, true);
+            pushOpCodeOnStack(
+                parser->chunk,
+                arrayItemSize(array_type->as.array.element_type) == 0
+                    ? OP_ARRAY_CONCATENATE_BITS
+                    : OP_ARRAY_CONCATENATE
+            );
+            value_type = array_type;
+            break;
+        }
+
+        // copy(s: string) string
+        case BUILTIN_COPY:
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, true);
+            pushOpCodeOnStack(parser->chunk, OP_COPY_STRING);
+            value_type = &VALUE_TYPE_STRING;
+            break;
+
+        // copy-items(destination: [T], at: int, source: [T], start: int, end: int) void
+        case BUILTIN_COPY_ITEMS: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, false);
+            parseBuiltinArgument(parser, builtin, array_type,      false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, true);
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_COPY);
+            pushByteOnStack(parser->chunk, (uint8_t)arrayItemSize(array_type->as.array.element_type));
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // count(s: string, substring: string) int
+        case BUILTIN_COUNT:
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, true);
+            pushOpCodeOnStack(parser->chunk, OP_COUNT_SUBSTRING);
+            value_type = &VALUE_TYPE_INT;
+            break;
+
+        // count-true(array: [bool]) int
+        case BUILTIN_COUNT_TRUE:
+            if (parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_BOOL, true) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_BITS_COUNT);
+            value_type = &VALUE_TYPE_INT;
+            break;
+
+        // delete(map: {K: V}, key: K) bool
+        case BUILTIN_DELETE: {
+            ValueType* map_type = parseBuiltinArgumentOfBasicType(parser, builtin, BASIC_VALUE_TYPE_MAP, false);
+            if (map_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            if (map_type->as.map.key_type == NULL) {
+                errorAtPrevious(
+                    parser,
+                    "Semantic",
+                    "Can't delete a key from an empty map literal."
+                );
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, map_type->as.map.key_type, true);
+            emitMapOpCode(parser, OP_MAP_DELETE, map_type);
+            value_type = &VALUE_TYPE_BOOL;
+            break;
+        }
+
+        // divide-items(destination: [T], source: [T]) void, for int and float items
+        case BUILTIN_DIVIDE_ITEMS: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type, true);
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_DIVIDE_INT, OP_ITEMS_DIVIDE_FLOAT);
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // dot(left: [T], right: [T]) T, for int and float items
+        case BUILTIN_DOT: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type, true);
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_DOT_INT, OP_ITEMS_DOT_FLOAT);
+            value_type = array_type->as.array.element_type;
+            break;
+        }
+
+        // fill(array: [T], start: int, end: int, item: T) void
+        case BUILTIN_FILL: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, false);
+            parseBuiltinArgument(parser, builtin, arrayItemValueType(array_type->as.array.element_type), true);
+            pushOpCodeOnStack(parser->chunk, getOpArrayFillForValueType(array_type->as.array.element_type));
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // find(s: string, substring: string) int
+        case BUILTIN_FIND:
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, true);
+            pushOpCodeOnStack(parser->chunk, OP_FIND_SUBSTRING);
+            value_type = &VALUE_TYPE_INT;
+            break;
+
+        // find-byte(s: string, byte: int) int
+        case BUILTIN_FIND_BYTE:
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT,    true);
+            pushOpCodeOnStack(parser->chunk, OP_FIND_BYTE);
+            value_type = &VALUE_TYPE_INT;
+            break;
+
+        // find-true(array: [bool], start: int) int
+        case BUILTIN_FIND_TRUE:
+            if (parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_BOOL, false) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, true);
+            pushOpCodeOnStack(parser->chunk, OP_BITS_FIND);
+            value_type = &VALUE_TYPE_INT;
+            break;
+
+        // length(array: [T]) int
+        case BUILTIN_LENGTH: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, true);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_LENGTH);
+            pushByteOnStack(parser->chunk, (uint8_t)arrayItemSize(array_type->as.array.element_type));
+            value_type = &VALUE_TYPE_INT;
+            break;
+        }
+
+        // less-items(left: [T], right: [T]) [bool], for int and float items
+        case BUILTIN_LESS_ITEMS: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type, true);
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_LESS_INT, OP_ITEMS_LESS_FLOAT);
+            value_type = createArrayValueType(&VALUE_TYPE_BOOL);
+            break;
+        }
+
+        // matrix(rows: int, columns: int, item: T) [T,], for int and float items
+        case BUILTIN_MATRIX: {
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, false);
+            ValueType* item_type = parseNumberBuiltinArgument(parser, builtin, true);
+            if (item_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            bool is_int = item_type->basic_type == BASIC_VALUE_TYPE_INT;
+            pushOpCodeOnStack(parser->chunk, is_int ? OP_MATRIX_NEW_INT : OP_MATRIX_NEW_FLOAT);
+            value_type = createMatrixValueType(item_type);
+            break;
+        }
+
+        // max(array: [T]) T, for int and float items
+        case BUILTIN_MAX: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, true);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_MAX_INT, OP_ITEMS_MAX_FLOAT);
+            value_type = array_type->as.array.element_type;
+            break;
+        }
+
+        // min(array: [T]) T, for int and float items
+        case BUILTIN_MIN: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, true);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_MIN_INT, OP_ITEMS_MIN_FLOAT);
+            value_type = array_type->as.array.element_type;
+            break;
+        }
+
+        // multiply-add-items(destination: [T], left: [T], right: [T]) void, for int and float items
+        case BUILTIN_MULTIPLY_ADD_ITEMS: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type, false);
+            parseBuiltinArgument(parser, builtin, array_type, true);
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_FMA_INT, OP_ITEMS_FMA_FLOAT);
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // multiply-items(destination: [T], source: [T]) void, for int and float items
+        case BUILTIN_MULTIPLY_ITEMS: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type, true);
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_MULTIPLY_INT, OP_ITEMS_MULTIPLY_FLOAT);
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // or-items(destination: [bool], source: [bool]) void
+        case BUILTIN_OR_ITEMS:
+            if (
+                parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_BOOL, false) == &VALUE_TYPE_INVALID ||
+                parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_BOOL, true)  == &VALUE_TYPE_INVALID
+            ) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_BITS_OR);
+            value_type = &VALUE_TYPE_VOID;
+            break;
+
+        // pop(array: [T]) T
+        case BUILTIN_POP: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, true);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, getOpArrayPopForValueType(array_type->as.array.element_type));
+            value_type = arrayItemValueType(array_type->as.array.element_type);
+            break;
+        }
+
+        // push(array: [T], value: T) void
+        case BUILTIN_PUSH: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, arrayItemValueType(array_type->as.array.element_type), true);
+            pushOpCodeOnStack(parser->chunk, getOpArrayPushForValueType(array_type->as.array.element_type));
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // reserve(array: [T], length: int) void
+        case BUILTIN_RESERVE: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, true);
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_RESERVE);
+            pushByteOnStack(parser->chunk, (uint8_t)arrayItemSize(array_type->as.array.element_type));
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // rows(matrix: [T,]) int
+        case BUILTIN_ROWS:
+            if (parseBuiltinArgumentOfBasicType(parser, builtin, BASIC_VALUE_TYPE_MATRIX, true) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_MATRIX_ROWS);
+            value_type = &VALUE_TYPE_INT;
+            break;
+
+        // saturating-sum(array: [int]) int
+        case BUILTIN_SATURATING_SUM:
+            if (parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_INT, true) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_ITEMS_SUM_SATURATE_INT);
+            value_type = &VALUE_TYPE_INT;
+            break;
+
+        // scale-items(items: [T], factor: T) void, for int and float items
+        case BUILTIN_SCALE_ITEMS: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type->as.array.element_type, true);
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_SCALE_INT, OP_ITEMS_SCALE_FLOAT);
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // select-items(destination: [T], mask: [bool], source: [T]) void, for int and float items
+        case BUILTIN_SELECT_ITEMS: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            if (parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_BOOL, false) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type, true);
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_SELECT_INT, OP_ITEMS_SELECT_FLOAT);
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // slice(array: [T], start: int, end: int) [T]
+        case BUILTIN_SLICE: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, true);
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_SLICE);
+            pushByteOnStack(parser->chunk, (uint8_t)arrayItemSize(array_type->as.array.element_type));
+            value_type = array_type;
+            break;
+        }
+
+        // sort(array: [T]) void, for bool, number and string items
+        // sort(array: [T], less: function(a: T, b: T): bool) void, for items that aren't narrow numbers
+        case BUILTIN_SORT: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, true);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            ValueType* element_type = array_type->as.array.element_type;
+
+            if (peekNext(parser) == TOKEN_RPAREN) {
+                switch (element_type->basic_type) {
+                    case BASIC_VALUE_TYPE_BOOL:    pushOpCodeOnStack(parser->chunk, OP_ARRAY_SORT_BOOL);    break;
+                    case BASIC_VALUE_TYPE_INT8:    pushOpCodeOnStack(parser->chunk, OP_ARRAY_SORT_INT8);    break;
+                    case BASIC_VALUE_TYPE_INT16:   pushOpCodeOnStack(parser->chunk, OP_ARRAY_SORT_INT16);   break;
+                    case BASIC_VALUE_TYPE_INT:     pushOpCodeOnStack(parser->chunk, OP_ARRAY_SORT_INT);     break;
+                    case BASIC_VALUE_TYPE_FLOAT32: pushOpCodeOnStack(parser->chunk, OP_ARRAY_SORT_FLOAT32); break;
+                    case BASIC_VALUE_TYPE_FLOAT:   pushOpCodeOnStack(parser->chunk, OP_ARRAY_SORT_FLOAT);   break;
+                    case BASIC_VALUE_TYPE_STRING:  pushOpCodeOnStack(parser->chunk, OP_ARRAY_SORT_STRING);  break;
+                    default:
+                        errorAtNext(
+                            parser,
+                            "Semantic",
+                            "Can't sort %s without a function telling the order of the items.",
+                            valueTypeName(array_type)
+                        );
+                        return &VALUE_TYPE_INVALID;
+                }
+                value_type = &VALUE_TYPE_VOID;
+                break;
+            }
+
+            // The function would get the items widened, which the sort doesn't do.
+            if (arrayItemValueType(element_type) != element_type) {
+                errorAtNext(
+                    parser,
+                    "Semantic",
+                    "Can't sort %s with a function. Sort it without one, or widen it with %s first.",
+                    valueTypeName(array_type),
+                    element_type->basic_type == BASIC_VALUE_TYPE_FLOAT32 ? "to-float" : "to-int"
+                );
+                return &VALUE_TYPE_INVALID;
+            }
+
+            Token function_start_token = next(parser);
+            ValueType* function_type = parseBuiltinArgumentOfBasicType(parser, builtin, BASIC_VALUE_TYPE_FUNCTION, true);
+            if (function_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            FunctionValueType function = function_type->as.function;
+            if (
+                function.arity != 2 ||
+                !valueTypesEqual(function.parameter_types[0], element_type) ||
+                !valueTypesEqual(function.parameter_types[1], element_type) ||
+                function.return_type->basic_type != BASIC_VALUE_TYPE_BOOL
+            ) {
+                error(
+                    parser,
+                    "Semantic",
+                    function_start_token,
+                    previous(parser),
+                    "The function passed to sort must take two %s items and return bool.",
+                    valueTypeName(element_type)
+                );
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_SORT_BY);
+            pushByteOnStack(parser->chunk, (uint8_t)arrayItemSize(element_type));
+            pushByteOnStack(parser->chunk, isReferenceValueType(element_type));
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // split(s: string, separator: string) [string]
+        case BUILTIN_SPLIT:
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, true);
+            pushOpCodeOnStack(parser->chunk, OP_SPLIT_STRING);
+            value_type = createArrayValueType(&VALUE_TYPE_STRING);
+            break;
+
+        // substring(s: string, start: int, end: int) string
+        case BUILTIN_SUBSTRING:
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_STRING, false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT,    false);
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT,    true);
+            pushOpCodeOnStack(parser->chunk, OP_SUBSTRING);
+            value_type = &VALUE_TYPE_STRING;
+            break;
+
+        // subtract-items(destination: [T], source: [T]) void, for int and float items
+        case BUILTIN_SUBTRACT_ITEMS: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, array_type, true);
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_SUBTRACT_INT, OP_ITEMS_SUBTRACT_FLOAT);
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // sum(array: [T]) T, for int and float items
+        case BUILTIN_SUM: {
+            ValueType* array_type = parseNumberArrayBuiltinArgument(parser, builtin, true);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            emitNumberArrayOpCode(parser, array_type, OP_ITEMS_SUM_INT, OP_ITEMS_SUM_FLOAT);
+            value_type = array_type->as.array.element_type;
+            break;
+        }
+
+        // to-array(matrix: [T,]) [T]
+        case BUILTIN_TO_ARRAY: {
+            ValueType* matrix_type = parseBuiltinArgumentOfBasicType(parser, builtin, BASIC_VALUE_TYPE_MATRIX, true);
+            if (matrix_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_MATRIX_TO_ARRAY);
+            value_type = createArrayValueType(matrix_type->as.matrix.element_type);
+            break;
+        }
+
+        // to-float(array: [float32]) [float]
+        case BUILTIN_TO_FLOAT:
+            if (parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_FLOAT32, true) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_WIDEN_FLOAT32);
+            value_type = createArrayValueType(&VALUE_TYPE_FLOAT);
+            break;
+
+        // to-float32(array: [float]) [float32]
+        case BUILTIN_TO_FLOAT32:
+            if (parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_FLOAT, true) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_NARROW_FLOAT32);
+            value_type = createArrayValueType(&VALUE_TYPE_FLOAT32);
+            break;
+
+        // to-int(array: [int8]) [int]
+        // to-int(array: [int16]) [int]
+        case BUILTIN_TO_INT: {
+            Token argument_expression_start_token = next(parser);
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, true);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            switch (array_type->as.array.element_type->basic_type) {
+                case BASIC_VALUE_TYPE_INT8:  pushOpCodeOnStack(parser->chunk, OP_ARRAY_WIDEN_INT8);  break;
+                case BASIC_VALUE_TYPE_INT16: pushOpCodeOnStack(parser->chunk, OP_ARRAY_WIDEN_INT16); break;
+                default:
+                    error(
+                        parser,
+                        "Semantic",
+                        argument_expression_start_token,
+                        previous(parser),
+                        "Argument type %s isn't a [int8] or a [int16], as %s expects.",
+                        valueTypeName(array_type),
+                        builtinName(builtin)
+                    );
+                    return &VALUE_TYPE_INVALID;
+            }
+            value_type = createArrayValueType(&VALUE_TYPE_INT);
+            break;
+        }
+
+        // to-int16(array: [int]) [int16]
+        case BUILTIN_TO_INT16:
+            if (parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_INT, true) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_NARROW_INT16);
+            value_type = createArrayValueType(&VALUE_TYPE_INT16);
+            break;
+
+        // to-int8(array: [int]) [int8]
+        case BUILTIN_TO_INT8:
+            if (parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_INT, true) == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_NARROW_INT8);
+            value_type = createArrayValueType(&VALUE_TYPE_INT8);
+            break;
+
+        // to-matrix(array: [T], columns: int) [T,], for number items
+        case BUILTIN_TO_MATRIX: {
+            Token argument_expression_start_token = next(parser);
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            ValueType* element_type = array_type->as.array.element_type;
+            if (!isMatrixItemValueType(element_type)) {
+                error(
+                    parser,
+                    "Semantic",
+                    argument_expression_start_token,
+                    previous(parser),
+                    "Argument type %s isn't an array of numbers, as %s expects.",
+                    valueTypeName(array_type),
+                    builtinName(builtin)
+                );
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, true);
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_TO_MATRIX);
+            pushByteOnStack(parser->chunk, (uint8_t)arrayItemSize(element_type));
+            value_type = createMatrixValueType(element_type);
+            break;
+        }
+
+        // truncate(array: [T], length: int) void
+        case BUILTIN_TRUNCATE: {
+            ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, false);
+            if (array_type == &VALUE_TYPE_INVALID) {
+                return &VALUE_TYPE_INVALID;
+            }
+            parseBuiltinArgument(parser, builtin, &VALUE_TYPE_INT, true);
+            pushOpCodeOnStack(parser->chunk, OP_ARRAY_TRUNCATE);
+            pushByteOnStack(parser->chunk, (uint8_t)arrayItemSize(array_type->as.array.element_type));
+            value_type = &VALUE_TYPE_VOID;
+            break;
+        }
+
+        // xor-items(destination: [bool], source: [bool]) void
+        case BUILTIN_XOR_ITEMS:
+            if (
+                parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_BOOL, false) == &VALUE_TYPE_INVALID ||
+                parseArrayOfBuiltinArgument(parser, builtin, BASIC_VALUE_TYPE_BOOL, true)  == &VALUE_TYPE_INVALID
+            ) {
+                return &VALUE_TYPE_INVALID;
+            }
+            pushOpCodeOnStack(parser->chunk, OP_BITS_XOR);
+            value_type = &VALUE_TYPE_VOID;
+            break;
+
+        default:
+            assert(false);
+    }
+
+    forceMatch(parser, TOKEN_RPAREN);
+
+    // Remove the result in an expression statement.
+    if (expression_kind == EXPRESSION_STATEMENT) {
+        pushOpCodeOnStack(parser->chunk, getOpPopForValueType(value_type));
+        value_type = NULL;
+    }
+
+    ASSERT_PARSER(parser);
+    return value_type;
+}
+
+static ValueType* parseBuiltinArgument(
+    Parser* parser,
+    Builtin builtin,
+    ValueType* parameter_type,
+    bool is_last
+) {
+    ASSERT_PARSER(parser);
+
+    // Make sure the arguments list isn't over.
+    if (peekNext(parser) == TOKEN_RPAREN) {
+        errorAtNext(
+            parser,
+            "Semantic",
+            "Expected the next argument %s of %s.",
+            valueTypeName(parameter_type),
+            builtinName(builtin)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    Token argument_expression_start_token = next(parser);
+    ValueType* argument_type = parseExpression(parser);
+
+    // Make sure the argument type matches the parameter type.
+    if (!valueTypesEqual(parameter_type, argument_type)) {
+        error(
+            parser,
+            "Semantic",
+            argument_expression_start_token,
+            previous(parser),
+            "Argument type %s doesn't match parameter type %s of %s.",
+            valueTypeName(argument_type),
+            valueTypeName(parameter_type),
+            builtinName(builtin)
+        );
+    }
+
+    // The last argument may optionally be followed by a comma.
+    if (!match(parser, TOKEN_COMMA) && !is_last) {
+        errorAtNext(
+            parser,
+            "Syntactic",
+            "Expected a comma and the next argument of %s.",
+            builtinName(builtin)
+        );
+    }
+
+    ASSERT_PARSER(parser);
+    return argument_type;
+}
+
+static ValueType* parseBuiltinArgumentOfBasicType(
+    Parser* parser,
+    Builtin builtin,
+    BasicValueType basic_type,
+    bool is_last
+) {
+    ASSERT_PARSER(parser);
+
+    // Make sure the arguments list isn't over.
+    if (peekNext(parser) == TOKEN_RPAREN) {
+        errorAtNext(
+            parser,
+            "Semantic",
+            "Expected the next argument %s of %s.",
+            basicValueTypeName(basic_type),
+            builtinName(builtin)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    Token argument_expression_start_token = next(parser);
+    ValueType* argument_type = parseExpression(parser);
+
+    // Make sure the argument has the basic type.
+    if (argument_type->basic_type != basic_type) {
+        error(
+            parser,
+            "Semantic",
+            argument_expression_start_token,
+            previous(parser),
+            "Argument type %s isn't a %s, as %s expects.",
+            valueTypeName(argument_type),
+            basicValueTypeName(basic_type),
+            builtinName(builtin)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    // The last argument may optionally be followed by a comma.
+    if (!match(parser, TOKEN_COMMA) && !is_last) {
+        errorAtNext(
+            parser,
+            "Syntactic",
+            "Expected a comma and the next argument of %s.",
+            builtinName(builtin)
+        );
+    }
+
+    ASSERT_PARSER(parser);
+    return argument_type;
+}
+
+static ValueType* parseArrayBuiltinArgument(Parser* parser, Builtin builtin, bool is_last) {
+    ASSERT_PARSER(parser);
+
+    ValueType* array_type = parseBuiltinArgumentOfBasicType(parser, builtin, BASIC_VALUE_TYPE_ARRAY, is_last);
+    if (array_type == &VALUE_TYPE_INVALID) {
+        return &VALUE_TYPE_INVALID;
+    }
+    if (array_type->as.array.element_type == NULL) {
+        errorAtPrevious(
+            parser,
+            "Semantic",
+            "The item type of an empty array literal passed to %s isn't known.",
+            builtinName(builtin)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    ASSERT_PARSER(parser);
+    return array_type;
+}
+
+static ValueType* parseArrayOfBuiltinArgument(
+    Parser* parser,
+    Builtin builtin,
+    BasicValueType item_type,
+    bool is_last
+) {
+    ASSERT_PARSER(parser);
+
+    Token argument_expression_start_token = next(parser);
+    ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, is_last);
+    if (array_type == &VALUE_TYPE_INVALID) {
+        return &VALUE_TYPE_INVALID;
+    }
+    if (array_type->as.array.element_type->basic_type != item_type) {
+        error(
+            parser,
+            "Semantic",
+            argument_expression_start_token,
+            previous(parser),
+            "Argument type %s isn't a [%s], as %s expects.",
+            valueTypeName(array_type),
+            basicValueTypeName(item_type),
+            builtinName(builtin)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    ASSERT_PARSER(parser);
+    return array_type;
+}
+
+static ValueType* parseNumberArrayBuiltinArgument(Parser* parser, Builtin builtin, bool is_last) {
+    ASSERT_PARSER(parser);
+
+    Token argument_expression_start_token = next(parser);
+    ValueType* array_type = parseArrayBuiltinArgument(parser, builtin, is_last);
+    if (array_type == &VALUE_TYPE_INVALID) {
+        return &VALUE_TYPE_INVALID;
+    }
+    BasicValueType item_type = array_type->as.array.element_type->basic_type;
+    if (item_type != BASIC_VALUE_TYPE_INT && item_type != BASIC_VALUE_TYPE_FLOAT) {
+        error(
+            parser,
+            "Semantic",
+            argument_expression_start_token,
+            previous(parser),
+            "Argument type %s isn't a [int] or a [float], as %s expects.",
+            valueTypeName(array_type),
+            builtinName(builtin)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    ASSERT_PARSER(parser);
+    return array_type;
+}
+
+static void emitNumberArrayOpCode(Parser* parser, ValueType* array_type, OpCode int_op_code, OpCode float_op_code) {
+    ASSERT_PARSER(parser);
+
+    bool is_int = array_type->as.array.element_type->basic_type == BASIC_VALUE_TYPE_INT;
+    pushOpCodeOnStack(parser->chunk, is_int ? int_op_code : float_op_code);
+}
+
+static ValueType* parseNumberBuiltinArgument(Parser* parser, Builtin builtin, bool is_last) {
+    ASSERT_PARSER(parser);
+
+    // Make sure the arguments list isn't over.
+    if (peekNext(parser) == TOKEN_RPAREN) {
+        errorAtNext(
+            parser,
+            "Semantic",
+            "Expected the next argument int or float of %s.",
+            builtinName(builtin)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    Token argument_expression_start_token = next(parser);
+    ValueType* argument_type = parseExpression(parser);
+    if (argument_type->basic_type != BASIC_VALUE_TYPE_INT && argument_type->basic_type != BASIC_VALUE_TYPE_FLOAT) {
+        error(
+            parser,
+            "Semantic",
+            argument_expression_start_token,
+            previous(parser),
+            "Argument type %s isn't an int or a float, as %s expects.",
+            valueTypeName(argument_type),
+            builtinName(builtin)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    // The last argument may optionally be followed by a comma.
+    if (!match(parser, TOKEN_COMMA) && !is_last) {
+        errorAtNext(
+            parser,
+            "Syntactic",
+            "Expected a comma and the next argument of %s.",
+            builtinName(builtin)
+        );
+    }
+
+    ASSERT_PARSER(parser);
+    return argument_type;
+}
+
+static ValueType* parseMatrixSubscript(Parser* parser, ValueType* matrix_type, ExpressionKind expression_kind) {
+    ASSERT_PARSER(parser);
+    assert(matrix_type->basic_type == BASIC_VALUE_TYPE_MATRIX);
+
+    // Row and column expressions
+    Token expression_start_token = next(parser);
+    ValueType* row_type = parseExpression(parser);
+    forceMatch(parser, TOKEN_COMMA);
+    ValueType* column_type = parseExpression(parser);
+    forceMatch(parser, TOKEN_RBRACKET);
+
+    // Make sure both indices are ints.
+    if (row_type->basic_type != BASIC_VALUE_TYPE_INT || column_type->basic_type != BASIC_VALUE_TYPE_INT) {
+        error(
+            parser,
+            "Semantic",
+            expression_start_token,
+            previous(parser),
+            "Invalid matrix index types %s and %s. Only ints can be matrix indices.",
+            valueTypeName(row_type),
+            valueTypeName(column_type)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    ValueType* element_type = matrix_type->as.matrix.element_type;
+    ValueType* value_type = arrayItemValueType(element_type);
+    OpCode op_code = getOpSubscript2GetForValueType(element_type);
+
+    // If it's an expression statement and this postfix is the last postfix in the lhs,
+    // parse the assignment.
+    if (expression_kind == EXPRESSION_STATEMENT && match(parser, TOKEN_EQUAL)) {
+        // The assignment rhs.
+        Token expression_start_token = next(parser);
+        ValueType* expression_value_type = parseExpression(parser);
+
+        // Make sure the matrix items and value types match.
+        if (!valueTypesEqual(value_type, expression_value_type)) {
+            error(
+                parser,
+                "Semantic",
+                expression_start_token,
+                previous(parser),
+                "Matrix item type (%s) and expression type (%s) don't match in an assignment.",
+                valueTypeName(value_type),
+                valueTypeName(expression_value_type)
+            );
+        }
+
+        op_code = getOpSubscript2SetForValueType(element_type);
+        value_type = NULL;
+    }
+
+    // Get or set the item.
+    pushOpCodeOnStack(parser->chunk, op_code);
+
+    ASSERT_PARSER(parser);
+    return value_type;
+}
+
+static ValueType* parseMapSubscript(Parser* parser, ValueType* map_type, ExpressionKind expression_kind) {
+    ASSERT_PARSER(parser);
+    assert(map_type->basic_type == BASIC_VALUE_TYPE_MAP);
+
+    if (map_type->as.map.key_type == NULL) {
+        errorAtPrevious(
+            parser,
+            "Semantic",
+            "Can't subscript an empty map literal."
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    // Key expression
+    Token expression_start_token = next(parser);
+    ValueType* key_type = parseExpression(parser);
+    forceMatch(parser, TOKEN_RBRACKET);
+
+    // Make sure the key has the map key type.
+    if (!valueTypesEqual(map_type->as.map.key_type, key_type)) {
+        error(
+            parser,
+            "Semantic",
+            expression_start_token,
+            previous(parser),
+            "Invalid map key type %s. The map keys are %s.",
+            valueTypeName(key_type),
+            valueTypeName(map_type->as.map.key_type)
+        );
+        return &VALUE_TYPE_INVALID;
+    }
+
+    ValueType* value_type = map_type->as.map.element_type;
+    OpCode op_code = OP_MAP_GET;
+
+    // If it's an expression statement and this postfix is the last postfix in the lhs,
+    // parse the assignment.
+    if (expression_kind == EXPRESSION_STATEMENT && match(parser, TOKEN_EQUAL)) {
+        // The assignment rhs.
+        Token expression_start_token = next(parser);
+        ValueType* expression_value_type = parseExpression(parser);
+
+        // Make sure the map values and value types match.
+        if (!valueTypesEqual(map_type->as.map.element_type, expression_value_type)) {
+            error(
+                parser,
+                "Semantic",
+                expression_start_token,
+                previous(parser),
+                "Map value type (%s) and expression type (%s) don't match in an assignment.",
+                valueTypeName(map_type->as.map.element_type),
+                valueTypeName(expression_value_type)
+            );
+        }
+
+        op_code = OP_MAP_SET;
+        value_type = NULL;
+    }
+
+    // Get or set the value.
+    emitMapOpCode(parser, op_code, map_type);
+
+    ASSERT_PARSER(parser);
+    return value_type;
+}
+
+static MapItemKind mapKeyKindForValueType(ValueType* value_type) {
+    assert(value_type);
+
+    switch (value_type->basic_type) {
+        case BASIC_VALUE_TYPE_BOOL:   return MAP_ITEM_BOOL;
+        case BASIC_VALUE_TYPE_INT:    return MAP_ITEM_INT;
+        case BASIC_VALUE_TYPE_STRING: return MAP_ITEM_STRING;
+        default:                      return MAP_ITEM_UNKNOWN;
+    }
+}
+
+static MapItemKind mapValueKindForValueType(ValueType* value_type) {
+    assert(value_type);
+
+    switch (value_type->basic_type) {
+        case BASIC_VALUE_TYPE_BOOL:   return MAP_ITEM_BOOL;
+        case BASIC_VALUE_TYPE_INT:    return MAP_ITEM_INT;
+        case BASIC_VALUE_TYPE_FLOAT:  return MAP_ITEM_FLOAT;
+        case BASIC_VALUE_TYPE_STRING: return MAP_ITEM_STRING;
+
+        case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
+        case BASIC_VALUE_TYPE_MAP:
+        case BASIC_VALUE_TYPE_OBJECT:
+            return MAP_ITEM_REFERENCE;
+
+        default:
+            return MAP_ITEM_UNKNOWN;
+    }
+}
+
+static void emitMapOpCode(Parser* parser, OpCode op_code, ValueType* map_type) {
+    ASSERT_PARSER(parser);
+    assert(map_type->basic_type == BASIC_VALUE_TYPE_MAP);
+
+    pushOpCodeOnStack(parser->chunk, op_code);
+    pushByteOnStack(parser->chunk, mapKeyKindForValueType(map_type->as.map.key_type));
+    pushByteOnStack(parser->chunk, mapValueKindForValueType(map_type->as.map.element_type));
+}
+
+
+// ─────────────────────
+//  Operator type rules 
+// ─────────────────────
+
+typedef struct {
+    BasicValueType  left_operand_expected_types[4];
+    BasicValueType right_operand_expected_types[4];
+    bool types_have_to_match;
+} OperatorTypeRules;
+
+#define B    { BASIC_VALUE_TYPE_BOOL }
+#define I    { BASIC_VALUE_TYPE_INT }
+#define IF   { BASIC_VALUE_TYPE_INT,  BASIC_VALUE_TYPE_FLOAT }
+#define IFS  { BASIC_VALUE_TYPE_INT,  BASIC_VALUE_TYPE_FLOAT, BASIC_VALUE_TYPE_STRING }
+#define BIFS { BASIC_VALUE_TYPE_BOOL, BASIC_VALUE_TYPE_INT,   BASIC_VALUE_TYPE_FLOAT, BASIC_VALUE_TYPE_STRING }
+#define A    { BASIC_VALUE_TYPE_ARRAY }
+
+OperatorTypeRules operator_type_rules[] = {
+    [TOKEN_OR]                = { B,     B,     true  },
+    [TOKEN_AND]               = { B,     B,     true  },
+    [TOKEN_EQUAL_EQUAL]       = { BIFS,  BIFS,  true  },
+    [TOKEN_EXCLAMATION_EQUAL] = { BIFS,  BIFS,  true  },
+    [TOKEN_GREATER_EQUAL]     = { IFS,   IFS,   true  },
+    [TOKEN_LESS_EQUAL]        = { IFS,   IFS,   true  },
+    [TOKEN_GREATER]           = { IFS,   IFS,   true  },
+    [TOKEN_LESS]              = { IFS,   IFS,   true  },
+    [TOKEN_PLUS]              = { IFS,   IFS,   true  },
+    [TOKEN_MINUS]             = { IF,    IF,    true  },
+    [TOKEN_STAR]              = { IF,    IF,    true  },
+    [TOKEN_SLASH]             = { IF,    IF,    true  },
+    [TOKEN_PERCENT]           = { IF,    I,     false },
+    [TOKEN_EXCLAMATION]       = { B,     B,     true  },
+    [TOKEN_LBRACKET]          = { A,     I,     false },  // Subscript
+};
 
 #undef BIFS
 #undef IFS
@@ -2278,10 +3765,6 @@ static void validateOperatorTypes(
 #define KEY(arity, token_type, value_type) ((token_type * 4 + value_type) * 3 + arity)
 
 OpCode token_and_value_type_to_opcodes[][2] = {
-    // Logic
-    [KEY(2, TOKEN_OR,                 BASIC_VALUE_TYPE_BOOL)  ] = { OP_OR,                OP_EMPTY       },
-    [KEY(2, TOKEN_AND,                BASIC_VALUE_TYPE_BOOL)  ] = { OP_AND,               OP_EMPTY       },
-    
     // Comparison
     [KEY(2, TOKEN_EQUAL_EQUAL,        BASIC_VALUE_TYPE_BOOL)  ] = { OP_EQUALS_BOOL,       OP_EMPTY       },
     [KEY(2, TOKEN_EQUAL_EQUAL,        BASIC_VALUE_TYPE_INT)   ] = { OP_EQUALS_INT,        OP_EMPTY       },
@@ -2364,6 +3847,7 @@ OpCode getOpGetFromStackForValueType(
 
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_FUNCTION:
         case BASIC_VALUE_TYPE_REFERENCE_STRUCTURE:
@@ -2391,6 +3875,7 @@ OpCode getOpSetOnStackForValueType(
 
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_FUNCTION:
         case BASIC_VALUE_TYPE_OBJECT:
@@ -48,6 +48,16 @@ typedef struct {
     Scope* scope;
     Constants constants;
 
+    // Chunk size right after the last cast of a number to string.
+    // See takeConcatenateOperand.
+    size_t number_to_string_cast_end;
+
+    // Set while parsing a key of a map literal. A colon that isn't
+    // followed by a type then ends the key instead of being a type cast,
+    // and map_key_ended is set. See parsePostfix.
+    bool parsing_map_key;
+    bool map_key_ended;
+
     // File names and contents strings to be freed after parsing.
     Stack free_on_end;
 } Parser;
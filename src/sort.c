@@ -0,0 +1,368 @@
+#include "sort.h"
+
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Shorter ranges are sorted by insertion.
+#define INSERTION_SORT_MAX_COUNT 16
+
+/* Defines static void name(Type* items, size_t count, size_t depth_limit),
+ * an introsort: quicksort with median-of-three pivots, which falls back
+ * to heapsort when it recurses deeper than depth_limit, and finishes short
+ * ranges by insertion. less(a, b) must be a strict weak ordering.
+ * */
+#define DEFINE_INTROSORT(name, Type, less)                                           \
+    static void name##SiftDown(Type* items, size_t root, size_t count) {             \
+        Type item = items[root];                                                     \
+        for (size_t child = 2 * root + 1; child < count; child = 2 * root + 1) {     \
+            if (child + 1 < count && less(items[child], items[child + 1])) {         \
+                ++child;                                                             \
+            }                                                                        \
+            if (!less(item, items[child])) {                                         \
+                break;                                                               \
+            }                                                                        \
+            items[root] = items[child];                                              \
+            root = child;                                                            \
+        }                                                                            \
+        items[root] = item;                                                          \
+    }                                                                                \
+                                                                                     \
+    static void name##HeapSort(Type* items, size_t count) {                          \
+        for (size_t i = count / 2; i-- > 0;) {                                       \
+            name##SiftDown(items, i, count);                                         \
+        }                                                                            \
+        for (size_t end = count; end-- > 1;) {                                       \
+            Type item = items[0];                                                    \
+            items[0] = items[end];                                                   \
+            items[end] = item;                                                       \
+            name##SiftDown(items, 0, end);                                           \
+        }                                                                            \
+    }                                                                                \
+                                                                                     \
+    static void name##InsertionSort(Type* items, size_t count) {                     \
+        for (size_t i = 1; i < count; ++i) {                                         \
+            Type item = items[i];                                                    \
+            size_t j = i;                                                            \
+            for (; j > 0 && less(item, items[j - 1]); --j) {                         \
+                items[j] = items[j - 1];                                             \
+            }                                                                        \
+            items[j] = item;                                                         \
+        }                                                                            \
+    }                                                                                \
+                                                                                     \
+    static void name(Type* items, size_t count, size_t depth_limit) {                \
+        while (count > INSERTION_SORT_MAX_COUNT) {                                   \
+            if (depth_limit == 0) {                                                  \
+                name##HeapSort(items, count);                                        \
+                return;                                                              \
+            }                                                                        \
+            --depth_limit;                                                           \
+                                                                                     \
+            /* Order the first, middle and last items,                               \
+             * the middle one is the pivot. */                                       \
+            size_t middle = (count - 1) / 2;                                         \
+            Type swap;                                                               \
+            if (less(items[middle], items[0])) {                                     \
+                swap = items[middle]; items[middle] = items[0]; items[0] = swap;     \
+            }                                                                        \
+            if (less(items[count - 1], items[middle])) {                             \
+                swap = items[middle];                                                \
+                items[middle] = items[count - 1];                                    \
+                items[count - 1] = swap;                                             \
+                if (less(items[middle], items[0])) {                                 \
+                    swap = items[middle]; items[middle] = items[0]; items[0] = swap; \
+                }                                                                    \
+            }                                                                        \
+            Type pivot = items[middle];                                              \
+                                                                                     \
+            /* Hoare partition, the first and last items stop the scans. */          \
+            size_t i = 0;                                                            \
+            size_t j = count - 1;                                                    \
+            for (;;) {                                                               \
+                while (less(items[i], pivot)) {                                      \
+                    ++i;                                                             \
+                }                                                                    \
+                while (less(pivot, items[j])) {                                      \
+                    --j;                                                             \
+                }                                                                    \
+                if (i >= j) {                                                        \
+                    break;                                                           \
+                }                                                                    \
+                swap = items[i]; items[i] = items[j]; items[j] = swap;               \
+                ++i;                                                                 \
+                --j;                                                                 \
+            }                                                                        \
+                                                                                     \
+            /* Recurse into the smaller part, so that the stack depth                \
+             * is logarithmic, and loop on the larger one. */                        \
+            size_t left_count = j + 1;                                               \
+            if (left_count < count - left_count) {                                   \
+                name(items, left_count, depth_limit);                                \
+                items += left_count;                                                 \
+                count -= left_count;                                                 \
+            } else {                                                                 \
+                name(items + left_count, count - left_count, depth_limit);           \
+                count = left_count;                                                  \
+            }                                                                        \
+        }                                                                            \
+        name##InsertionSort(items, count);                                           \
+    }
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+// A string with the first 8 bytes of its value as a big-endian number,
+// so that the numbers compare like the prefixes.
+typedef struct {
+    uint64_t prefix;
+    Object*  string;
+} StringSortKey;
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+static size_t depthLimit(size_t count);
+
+// NaNs are equal to each other and greater than the other floats.
+static bool isFloatLess(double a, double b);
+static bool isFloat32Less(float a, float b);
+static bool isStringSortKeyLess(StringSortKey a, StringSortKey b);
+
+static uint64_t stringPrefix(const Object* string);
+
+DEFINE_INTROSORT(introsortFloat32s, float, isFloat32Less)
+DEFINE_INTROSORT(introsortFloats, double, isFloatLess)
+DEFINE_INTROSORT(introsortStringSortKeys, StringSortKey, isStringSortKeyLess)
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+void sortInt8s(int8_t* items, size_t count) {
+    assert(items || count == 0);
+
+    size_t counts[256] = {0};
+    for (size_t i = 0; i < count; ++i) {
+        ++counts[items[i] - INT8_MIN];
+    }
+    for (size_t digit = 0; digit < 256; ++digit) {
+        memset(items, (int)digit + INT8_MIN, counts[digit]);
+        items += counts[digit];
+    }
+}
+
+bool sortInt16s(int16_t* items, size_t count) {
+    assert(items || count == 0);
+
+    if (count <= INSERTION_SORT_MAX_COUNT) {
+        for (size_t i = 1; i < count; ++i) {
+            int16_t item = items[i];
+            size_t j = i;
+            for (; j > 0 && item < items[j - 1]; --j) {
+                items[j] = items[j - 1];
+            }
+            items[j] = item;
+        }
+        return true;
+    }
+
+    uint16_t* buffer = malloc(count * sizeof(uint16_t));
+    if (!buffer) {
+        return false;
+    }
+
+    // The same as for ints, with two bytes.
+    uint16_t* keys = (uint16_t*)items;
+    size_t counts[2][256] = {0};
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] ^= 0x8000u;
+        ++counts[0][keys[i] & 0xFF];
+        ++counts[1][keys[i] >> 8];
+    }
+
+    uint16_t* source = keys;
+    uint16_t* destination = buffer;
+    for (size_t byte = 0; byte < 2; ++byte) {
+        size_t* byte_counts = counts[byte];
+        if (byte_counts[(source[0] >> (8 * byte)) & 0xFF] == count) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            size_t digit_count = byte_counts[digit];
+            byte_counts[digit] = offset;
+            offset += digit_count;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            destination[byte_counts[(source[i] >> (8 * byte)) & 0xFF]++] = source[i];
+        }
+
+        uint16_t* swap = source;
+        source = destination;
+        destination = swap;
+    }
+
+    if (source != keys) {
+        memcpy(keys, source, count * sizeof(uint16_t));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] ^= 0x8000u;
+    }
+
+    free(buffer);
+    return true;
+}
+
+bool sortInts(int32_t* items, size_t count) {
+    assert(items || count == 0);
+
+    if (count <= INSERTION_SORT_MAX_COUNT) {
+        for (size_t i = 1; i < count; ++i) {
+            int32_t item = items[i];
+            size_t j = i;
+            for (; j > 0 && item < items[j - 1]; --j) {
+                items[j] = items[j - 1];
+            }
+            items[j] = item;
+        }
+        return true;
+    }
+
+    uint32_t* buffer = malloc(count * sizeof(uint32_t));
+    if (!buffer) {
+        return false;
+    }
+
+    // Flipping the sign bit makes the ints compare as unsigned ones.
+    // The counts of all the bytes are taken in one pass.
+    uint32_t* keys = (uint32_t*)items;
+    size_t counts[4][256] = {0};
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] ^= 0x80000000u;
+        for (size_t byte = 0; byte < 4; ++byte) {
+            ++counts[byte][(keys[i] >> (8 * byte)) & 0xFF];
+        }
+    }
+
+    uint32_t* source = keys;
+    uint32_t* destination = buffer;
+    for (size_t byte = 0; byte < 4; ++byte) {
+        size_t* byte_counts = counts[byte];
+        if (byte_counts[(source[0] >> (8 * byte)) & 0xFF] == count) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            size_t digit_count = byte_counts[digit];
+            byte_counts[digit] = offset;
+            offset += digit_count;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            destination[byte_counts[(source[i] >> (8 * byte)) & 0xFF]++] = source[i];
+        }
+
+        uint32_t* swap = source;
+        source = destination;
+        destination = swap;
+    }
+
+    if (source != keys) {
+        memcpy(keys, source, count * sizeof(uint32_t));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] ^= 0x80000000u;
+    }
+
+    free(buffer);
+    return true;
+}
+
+void sortFloat32s(float* items, size_t count) {
+    assert(items || count == 0);
+
+    introsortFloat32s(items, count, depthLimit(count));
+}
+
+void sortFloats(double* items, size_t count) {
+    assert(items || count == 0);
+
+    introsortFloats(items, count, depthLimit(count));
+}
+
+bool sortStrings(Object** strings, size_t count) {
+    assert(strings || count == 0);
+
+    if (count < 2) {
+        return true;
+    }
+
+    StringSortKey* keys = malloc(count * sizeof(StringSortKey));
+    if (!keys) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        keys[i].prefix = stringPrefix(strings[i]);
+        keys[i].string = strings[i];
+    }
+
+    introsortStringSortKeys(keys, count, depthLimit(count));
+
+    for (size_t i = 0; i < count; ++i) {
+        strings[i] = keys[i].string;
+    }
+
+    free(keys);
+    return true;
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static size_t depthLimit(size_t count) {
+    size_t limit = 0;
+    for (; count > 1; count /= 2) {
+        limit += 2;
+    }
+    return limit;
+}
+
+static bool isFloatLess(double a, double b) {
+    return a < b || (isnan(b) && !isnan(a));
+}
+
+static bool isFloat32Less(float a, float b) {
+    return a < b || (isnan(b) && !isnan(a));
+}
+
+static bool isStringSortKeyLess(StringSortKey a, StringSortKey b) {
+    if (a.prefix != b.prefix) {
+        return a.prefix < b.prefix;
+    }
+    return compareStrings(a.string, b.string) < 0;
+}
+
+static uint64_t stringPrefix(const Object* string) {
+    uint64_t prefix = 0;
+    size_t size = string->size < 8 ? string->size : 8;
+    for (size_t i = 0; i < size; ++i) {
+        prefix |= (uint64_t)string->value[i] << (56 - 8 * i);
+    }
+    return prefix;
+}
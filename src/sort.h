@@ -0,0 +1,35 @@
+#ifndef lala_sort_h
+#define lala_sort_h
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "heap.h"
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+/* Sort the items in ascending order.
+ *
+ * Ints and int16s are sorted with an LSD radix sort, a byte at a time,
+ * skipping the bytes that are the same in all of them, and int8s
+ * by counting them. Floats are sorted with introsort, NaNs go last.
+ * Strings are compared like compareStrings does, by cached 8-byte
+ * prefixes first, so that most comparisons don't dereference the strings.
+ *
+ * sortInt16s, sortInts and sortStrings return false if there's no memory
+ * for the buffer they need.
+ * */
+void sortInt8s(int8_t* items, size_t count);
+bool sortInt16s(int16_t* items, size_t count);
+bool sortInts(int32_t* items, size_t count);
+void sortFloat32s(float* items, size_t count);
+void sortFloats(double* items, size_t count);
+bool sortStrings(Object** strings, size_t count);
+
+
+#endif
@@ -0,0 +1,514 @@
+#include "string_kernels.h"
+
+
+#include <assert.h>
+#include <string.h>
+
+#include "cpu_features.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define KERNELS() SELECTED_KERNELS(kernels, selectBestKernels)
+
+// Byte counters of the count kernels overflow after this many blocks.
+#define COUNT_MAX_BLOCKS 255
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+// The find substring kernels expect a needle of at least 2 bytes,
+// which isn't longer than the haystack.
+typedef struct {
+    int    (*compare)(const uint8_t* left, const uint8_t* right, size_t size);
+    size_t (*find_byte)(const uint8_t* haystack, size_t size, uint8_t byte);
+    size_t (*count_byte)(const uint8_t* haystack, size_t size, uint8_t byte);
+    size_t (*find_substring)(
+        const uint8_t* haystack,
+        size_t size,
+        const uint8_t* needle,
+        size_t needle_size
+    );
+} StringKernels;
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+static const StringKernels* selectBestKernels(void);
+
+static int    compareScalar      (const uint8_t* left, const uint8_t* right, size_t size);
+static size_t findByteScalar     (const uint8_t* haystack, size_t size, uint8_t byte);
+static size_t countByteScalar    (const uint8_t* haystack, size_t size, uint8_t byte);
+static size_t findSubstringScalar(const uint8_t* haystack, size_t size, const uint8_t* needle, size_t needle_size);
+
+#ifdef CPU_FEATURES_X86
+TARGET_SSE2 static int    compareSse2      (const uint8_t* left, const uint8_t* right, size_t size);
+TARGET_SSE2 static size_t findByteSse2     (const uint8_t* haystack, size_t size, uint8_t byte);
+TARGET_SSE2 static size_t countByteSse2    (const uint8_t* haystack, size_t size, uint8_t byte);
+TARGET_SSE2 static size_t findSubstringSse2(const uint8_t* haystack, size_t size, const uint8_t* needle, size_t needle_size);
+
+TARGET_AVX2 static int    compareAvx2      (const uint8_t* left, const uint8_t* right, size_t size);
+TARGET_AVX2 static size_t findByteAvx2     (const uint8_t* haystack, size_t size, uint8_t byte);
+TARGET_AVX2 static size_t countByteAvx2    (const uint8_t* haystack, size_t size, uint8_t byte);
+TARGET_AVX2 static size_t findSubstringAvx2(const uint8_t* haystack, size_t size, const uint8_t* needle, size_t needle_size);
+#endif
+
+
+// ┌───────────┐
+// │ Constants │
+// └───────────┘
+
+static const StringKernels SCALAR_KERNELS = {
+    compareScalar,
+    findByteScalar,
+    countByteScalar,
+    findSubstringScalar,
+};
+
+#ifdef CPU_FEATURES_X86
+static const StringKernels SSE2_KERNELS = {
+    compareSse2,
+    findByteSse2,
+    countByteSse2,
+    findSubstringSse2,
+};
+
+static const StringKernels AVX2_KERNELS = {
+    compareAvx2,
+    findByteAvx2,
+    countByteAvx2,
+    findSubstringAvx2,
+};
+#endif
+
+
+// ┌─────────┐
+// │ Globals │
+// └─────────┘
+
+static const StringKernels* kernels = NULL;
+static CpuLevel kernels_level = CPU_LEVEL_SCALAR;
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+CpuLevel stringKernelsLevel(void) {
+    KERNELS();
+    return kernels_level;
+}
+
+bool setStringKernelsLevel(CpuLevel level) {
+    if (!cpuSupportsLevel(level)) {
+        return false;
+    }
+
+    switch (level) {
+#ifdef CPU_FEATURES_X86
+        case CPU_LEVEL_SSE2: kernels = &SSE2_KERNELS; break;
+        case CPU_LEVEL_AVX2: kernels = &AVX2_KERNELS; break;
+#endif
+        default:             kernels = &SCALAR_KERNELS; break;
+    }
+    kernels_level = level;
+    return true;
+}
+
+int compareBytes(const uint8_t* left, const uint8_t* right, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    assert(left);
+    assert(right);
+
+    return KERNELS()->compare(left, right, size);
+}
+
+size_t findByte(const uint8_t* haystack, size_t size, uint8_t byte) {
+    if (size == 0) {
+        return STRING_NOT_FOUND;
+    }
+    assert(haystack);
+
+    return KERNELS()->find_byte(haystack, size, byte);
+}
+
+size_t findSubstring(
+    const uint8_t* haystack,
+    size_t size,
+    const uint8_t* needle,
+    size_t needle_size
+) {
+    if (needle_size == 0) {
+        return 0;
+    }
+    if (needle_size > size) {
+        return STRING_NOT_FOUND;
+    }
+    assert(haystack);
+    assert(needle);
+
+    if (needle_size == 1) {
+        return KERNELS()->find_byte(haystack, size, needle[0]);
+    }
+    return KERNELS()->find_substring(haystack, size, needle, needle_size);
+}
+
+size_t countSubstring(
+    const uint8_t* haystack,
+    size_t size,
+    const uint8_t* needle,
+    size_t needle_size
+) {
+    if (needle_size == 0) {
+        return size + 1;
+    }
+    if (needle_size > size) {
+        return 0;
+    }
+    assert(haystack);
+    assert(needle);
+
+    if (needle_size == 1) {
+        return KERNELS()->count_byte(haystack, size, needle[0]);
+    }
+
+    size_t count = 0;
+    size_t position = 0;
+    for (;;) {
+        size_t found = findSubstring(haystack + position, size - position, needle, needle_size);
+        if (found == STRING_NOT_FOUND) {
+            return count;
+        }
+        ++count;
+        position += found + needle_size;
+    }
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static const StringKernels* selectBestKernels(void) {
+    selectBestCpuLevel(setStringKernelsLevel);
+    return kernels;
+}
+
+
+// ────────
+//  Scalar
+// ────────
+
+static int compareScalar(const uint8_t* left, const uint8_t* right, size_t size) {
+    int result = memcmp(left, right, size);
+    return (result > 0) - (result < 0);
+}
+
+static size_t findByteScalar(const uint8_t* haystack, size_t size, uint8_t byte) {
+    const uint8_t* found = memchr(haystack, byte, size);
+    return found ? (size_t)(found - haystack) : STRING_NOT_FOUND;
+}
+
+static size_t countByteScalar(const uint8_t* haystack, size_t size, uint8_t byte) {
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i) {
+        count += haystack[i] == byte;
+    }
+    return count;
+}
+
+static size_t findSubstringScalar(
+    const uint8_t* haystack,
+    size_t size,
+    const uint8_t* needle,
+    size_t needle_size
+) {
+    if (needle_size > size) {
+        return STRING_NOT_FOUND;
+    }
+
+    // Candidates are found by the first byte.
+    size_t candidates_end = size - needle_size + 1;
+    size_t position = 0;
+    while (position < candidates_end) {
+        const uint8_t* candidate = memchr(haystack + position, needle[0], candidates_end - position);
+        if (!candidate) {
+            return STRING_NOT_FOUND;
+        }
+        position = (size_t)(candidate - haystack);
+        if (memcmp(candidate + 1, needle + 1, needle_size - 1) == 0) {
+            return position;
+        }
+        ++position;
+    }
+    return STRING_NOT_FOUND;
+}
+
+
+#ifdef CPU_FEATURES_X86
+
+// ──────
+//  SSE2
+// ──────
+
+TARGET_SSE2 static int compareSse2(const uint8_t* left, const uint8_t* right, size_t size) {
+    size_t i = 0;
+
+    // Blocks of 4 vectors are skipped while they are equal.
+    for (; i + 64 <= size; i += 64) {
+        __m128i equal = _mm_and_si128(
+            _mm_and_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(left + i)),      _mm_loadu_si128((const __m128i*)(right + i))),
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(left + i + 16)), _mm_loadu_si128((const __m128i*)(right + i + 16)))
+            ),
+            _mm_and_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(left + i + 32)), _mm_loadu_si128((const __m128i*)(right + i + 32))),
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(left + i + 48)), _mm_loadu_si128((const __m128i*)(right + i + 48)))
+            )
+        );
+        if (_mm_movemask_epi8(equal) != 0xFFFF) {
+            break;
+        }
+    }
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i l = _mm_loadu_si128((const __m128i*)(left + i));
+        __m128i r = _mm_loadu_si128((const __m128i*)(right + i));
+        uint32_t different = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(l, r)) ^ 0xFFFFu;
+        if (different != 0) {
+            size_t j = i + (size_t)__builtin_ctz(different);
+            return left[j] < right[j] ? -1 : 1;
+        }
+    }
+    return compareScalar(left + i, right + i, size - i);
+}
+
+TARGET_SSE2 static size_t findByteSse2(const uint8_t* haystack, size_t size, uint8_t byte) {
+    __m128i bytes = _mm_set1_epi8((char)byte);
+    size_t i = 0;
+
+    // Blocks of 4 vectors are skipped while they don't contain the byte.
+    for (; i + 64 <= size; i += 64) {
+        __m128i found = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(haystack + i)),      bytes),
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(haystack + i + 16)), bytes)
+            ),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(haystack + i + 32)), bytes),
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(haystack + i + 48)), bytes)
+            )
+        );
+        if (_mm_movemask_epi8(found) != 0) {
+            break;
+        }
+    }
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(haystack + i));
+        uint32_t found = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, bytes));
+        if (found != 0) {
+            return i + (size_t)__builtin_ctz(found);
+        }
+    }
+    size_t rest = findByteScalar(haystack + i, size - i, byte);
+    return rest == STRING_NOT_FOUND ? STRING_NOT_FOUND : i + rest;
+}
+
+// Matches are subtracted from byte counters, which are summed up
+// before they overflow.
+TARGET_SSE2 static size_t countByteSse2(const uint8_t* haystack, size_t size, uint8_t byte) {
+    __m128i bytes = _mm_set1_epi8((char)byte);
+    size_t count = 0;
+    size_t i = 0;
+    while (i + 16 <= size) {
+        size_t blocks = (size - i) / 16;
+        if (blocks > COUNT_MAX_BLOCKS) {
+            blocks = COUNT_MAX_BLOCKS;
+        }
+
+        __m128i counters = _mm_setzero_si128();
+        for (size_t block_i = 0; block_i < blocks; ++block_i, i += 16) {
+            __m128i block = _mm_loadu_si128((const __m128i*)(haystack + i));
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(block, bytes));
+        }
+
+        __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+        count += (size_t)_mm_cvtsi128_si32(sums);
+        count += (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+    return count + countByteScalar(haystack + i, size - i, byte);
+}
+
+// Candidates are the positions where both the first and the last bytes
+// of the needle match, so only a few of them are compared completely.
+TARGET_SSE2 static size_t findSubstringSse2(
+    const uint8_t* haystack,
+    size_t size,
+    const uint8_t* needle,
+    size_t needle_size
+) {
+    size_t last = needle_size - 1;
+    __m128i first_bytes = _mm_set1_epi8((char)needle[0]);
+    __m128i last_bytes = _mm_set1_epi8((char)needle[last]);
+
+    size_t i = 0;
+    for (; i + last + 16 <= size; i += 16) {
+        __m128i first_block = _mm_loadu_si128((const __m128i*)(haystack + i));
+        __m128i last_block = _mm_loadu_si128((const __m128i*)(haystack + i + last));
+        uint32_t candidates = (uint32_t)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(first_block, first_bytes),
+            _mm_cmpeq_epi8(last_block, last_bytes)
+        ));
+        while (candidates != 0) {
+            size_t position = i + (size_t)__builtin_ctz(candidates);
+            if (memcmp(haystack + position + 1, needle + 1, needle_size - 2) == 0) {
+                return position;
+            }
+            candidates &= candidates - 1;
+        }
+    }
+
+    size_t rest = findSubstringScalar(haystack + i, size - i, needle, needle_size);
+    return rest == STRING_NOT_FOUND ? STRING_NOT_FOUND : i + rest;
+}
+
+
+// ──────
+//  AVX2
+// ──────
+
+TARGET_AVX2 static int compareAvx2(const uint8_t* left, const uint8_t* right, size_t size) {
+    size_t i = 0;
+
+    for (; i + 128 <= size; i += 128) {
+        __m256i equal = _mm256_and_si256(
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(left + i)),      _mm256_loadu_si256((const __m256i*)(right + i))),
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(left + i + 32)), _mm256_loadu_si256((const __m256i*)(right + i + 32)))
+            ),
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(left + i + 64)), _mm256_loadu_si256((const __m256i*)(right + i + 64))),
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(left + i + 96)), _mm256_loadu_si256((const __m256i*)(right + i + 96)))
+            )
+        );
+        if ((uint32_t)_mm256_movemask_epi8(equal) != 0xFFFFFFFFu) {
+            break;
+        }
+    }
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i l = _mm256_loadu_si256((const __m256i*)(left + i));
+        __m256i r = _mm256_loadu_si256((const __m256i*)(right + i));
+        uint32_t different = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(l, r));
+        if (different != 0) {
+            size_t j = i + (size_t)__builtin_ctz(different);
+            return left[j] < right[j] ? -1 : 1;
+        }
+    }
+    return compareSse2(left + i, right + i, size - i);
+}
+
+TARGET_AVX2 static size_t findByteAvx2(const uint8_t* haystack, size_t size, uint8_t byte) {
+    __m256i bytes = _mm256_set1_epi8((char)byte);
+    size_t i = 0;
+
+    for (; i + 128 <= size; i += 128) {
+        __m256i found = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(haystack + i)),      bytes),
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(haystack + i + 32)), bytes)
+            ),
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(haystack + i + 64)), bytes),
+                _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(haystack + i + 96)), bytes)
+            )
+        );
+        if (_mm256_movemask_epi8(found) != 0) {
+            break;
+        }
+    }
+
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(haystack + i));
+        uint32_t found = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, bytes));
+        if (found != 0) {
+            return i + (size_t)__builtin_ctz(found);
+        }
+    }
+    size_t rest = findByteSse2(haystack + i, size - i, byte);
+    return rest == STRING_NOT_FOUND ? STRING_NOT_FOUND : i + rest;
+}
+
+TARGET_AVX2 static size_t countByteAvx2(const uint8_t* haystack, size_t size, uint8_t byte) {
+    __m256i bytes = _mm256_set1_epi8((char)byte);
+    size_t count = 0;
+    size_t i = 0;
+    while (i + 32 <= size) {
+        size_t blocks = (size - i) / 32;
+        if (blocks > COUNT_MAX_BLOCKS) {
+            blocks = COUNT_MAX_BLOCKS;
+        }
+
+        __m256i counters = _mm256_setzero_si256();
+        for (size_t block_i = 0; block_i < blocks; ++block_i, i += 32) {
+            __m256i block = _mm256_loadu_si256((const __m256i*)(haystack + i));
+            counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(block, bytes));
+        }
+
+        __m256i wide_sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+        __m128i sums = _mm_add_epi64(
+            _mm256_castsi256_si128(wide_sums),
+            _mm256_extracti128_si256(wide_sums, 1)
+        );
+        count += (size_t)_mm_cvtsi128_si32(sums);
+        count += (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+    return count + countByteSse2(haystack + i, size - i, byte);
+}
+
+TARGET_AVX2 static size_t findSubstringAvx2(
+    const uint8_t* haystack,
+    size_t size,
+    const uint8_t* needle,
+    size_t needle_size
+) {
+    size_t last = needle_size - 1;
+    __m256i first_bytes = _mm256_set1_epi8((char)needle[0]);
+    __m256i last_bytes = _mm256_set1_epi8((char)needle[last]);
+
+    size_t i = 0;
+    for (; i + last + 32 <= size; i += 32) {
+        __m256i first_block = _mm256_loadu_si256((const __m256i*)(haystack + i));
+        __m256i last_block = _mm256_loadu_si256((const __m256i*)(haystack + i + last));
+        uint32_t candidates = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(first_block, first_bytes),
+            _mm256_cmpeq_epi8(last_block, last_bytes)
+        ));
+        while (candidates != 0) {
+            size_t position = i + (size_t)__builtin_ctz(candidates);
+            if (memcmp(haystack + position + 1, needle + 1, needle_size - 2) == 0) {
+                return position;
+            }
+            candidates &= candidates - 1;
+        }
+    }
+
+    size_t rest = findSubstringSse2(haystack + i, size - i, needle, needle_size);
+    return rest == STRING_NOT_FOUND ? STRING_NOT_FOUND : i + rest;
+}
+
+#endif
+
+
+#undef COUNT_MAX_BLOCKS
+
+#undef KERNELS
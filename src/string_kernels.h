@@ -0,0 +1,52 @@
+#ifndef lala_string_kernels_h
+#define lala_string_kernels_h
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu_features.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+// Returned by the find functions if there's no match.
+#define STRING_NOT_FOUND SIZE_MAX
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+// The kernels are selected like cpu_features.h describes.
+CpuLevel stringKernelsLevel(void);
+bool setStringKernelsLevel(CpuLevel level);
+
+// Compares bytes as unsigned values, like memcmp, and returns -1, 0 or 1.
+// Unlike strncmp, doesn't stop at null bytes.
+int compareBytes(const uint8_t* left, const uint8_t* right, size_t size);
+
+// Position of the first occurrence, or STRING_NOT_FOUND.
+// An empty needle is found at 0.
+size_t findByte(const uint8_t* haystack, size_t size, uint8_t byte);
+size_t findSubstring(
+    const uint8_t* haystack,
+    size_t size,
+    const uint8_t* needle,
+    size_t needle_size
+);
+
+// Number of non-overlapping occurrences.
+// An empty needle occurs size + 1 times, before and after every byte.
+size_t countSubstring(
+    const uint8_t* haystack,
+    size_t size,
+    const uint8_t* needle,
+    size_t needle_size
+);
+
+
+#endif
@@ -49,12 +49,15 @@ const char* tokenTypeName(TokenType type) {
         case TOKEN_ENUM:               return "ENUM";
         case TOKEN_FALSE:              return "FALSE";
         case TOKEN_FLOAT:              return "FLOAT";
+        case TOKEN_FLOAT32:            return "FLOAT32";
         case TOKEN_FOR:                return "FOR";
         case TOKEN_FUNCTION:           return "FUNCTION";
         case TOKEN_IF:                 return "IF";
         case TOKEN_IN:                 return "IN";
         case TOKEN_INCLUDE:            return "INCLUDE";
         case TOKEN_INT:                return "INT";
+        case TOKEN_INT8:               return "INT8";
+        case TOKEN_INT16:              return "INT16";
         case TOKEN_MUTABLE:            return "MUTABLE";
         case TOKEN_OR:                 return "OR";
         case TOKEN_PREDICATE:          return "PREDICATE";
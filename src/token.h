@@ -58,12 +58,15 @@ typedef enum {
     TOKEN_ENUM,
     TOKEN_FALSE,
     TOKEN_FLOAT,
+    TOKEN_FLOAT32,
     TOKEN_FOR,
     TOKEN_FUNCTION,
     TOKEN_IF,
     TOKEN_IN,
     TOKEN_INCLUDE,
     TOKEN_INT,
+    TOKEN_INT8,
+    TOKEN_INT16,
     TOKEN_MUTABLE,
     TOKEN_OR,
     TOKEN_PREDICATE,
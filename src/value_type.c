@@ -15,6 +15,9 @@ ValueType VALUE_TYPE_BOOL    = { BASIC_VALUE_TYPE_BOOL,    {{NULL}}, NULL };
 ValueType VALUE_TYPE_INT     = { BASIC_VALUE_TYPE_INT,     {{NULL}}, NULL };
 ValueType VALUE_TYPE_FLOAT   = { BASIC_VALUE_TYPE_FLOAT,   {{NULL}}, NULL };
 ValueType VALUE_TYPE_STRING  = { BASIC_VALUE_TYPE_STRING,  {{NULL}}, NULL };
+ValueType VALUE_TYPE_INT8    = { BASIC_VALUE_TYPE_INT8,    {{NULL}}, NULL };
+ValueType VALUE_TYPE_INT16   = { BASIC_VALUE_TYPE_INT16,   {{NULL}}, NULL };
+ValueType VALUE_TYPE_FLOAT32 = { BASIC_VALUE_TYPE_FLOAT32, {{NULL}}, NULL };
 
 // ┌──────────────────────────┐
 // │ Function implementations │
@@ -28,6 +31,25 @@ ValueType* createArrayValueType(ValueType* element_type) {
     return type;
 }
 
+ValueType* createMatrixValueType(ValueType* element_type) {
+    assert(element_type);
+
+    ValueType* type = calloc(1, sizeof(ValueType));
+    type->basic_type = BASIC_VALUE_TYPE_MATRIX;
+    type->as.matrix.element_type = element_type;
+    type->name = NULL;
+    return type;
+}
+
+ValueType* createMapValueType(ValueType* key_type, ValueType* element_type) {
+    ValueType* type = calloc(1, sizeof(ValueType));
+    type->basic_type = BASIC_VALUE_TYPE_MAP;
+    type->as.map.key_type = key_type;
+    type->as.map.element_type = element_type;
+    type->name = NULL;
+    return type;
+}
+
 ValueType* createFunctionValueType() {
     ValueType* type = calloc(1, sizeof(ValueType));
     type->basic_type = BASIC_VALUE_TYPE_FUNCTION;
@@ -137,6 +159,9 @@ void deleteValueType(ValueType* value_type) {
         case BASIC_VALUE_TYPE_FLOAT:
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_OBJECT:
+        case BASIC_VALUE_TYPE_INT8:
+        case BASIC_VALUE_TYPE_INT16:
+        case BASIC_VALUE_TYPE_FLOAT32:
             assert(false);
 
         case BASIC_VALUE_TYPE_FUNCTION:
@@ -180,6 +205,10 @@ const char* basicValueTypeName(BasicValueType basic_value_type) {
             return "structure";
 
         case BASIC_VALUE_TYPE_OBJECT:    return "object";
+        case BASIC_VALUE_TYPE_INT8:      return "int8";
+        case BASIC_VALUE_TYPE_INT16:     return "int16";
+        case BASIC_VALUE_TYPE_FLOAT32:   return "float32";
+        case BASIC_VALUE_TYPE_MATRIX:    return "matrix";
         default:                         return "INVALID TYPE";
     }
 }
@@ -194,6 +223,9 @@ const char* valueTypeName(ValueType* value_type) {
         case BASIC_VALUE_TYPE_INT:
         case BASIC_VALUE_TYPE_FLOAT:
         case BASIC_VALUE_TYPE_STRING:
+        case BASIC_VALUE_TYPE_INT8:
+        case BASIC_VALUE_TYPE_INT16:
+        case BASIC_VALUE_TYPE_FLOAT32:
             return basicValueTypeName(value_type->basic_type);
 
 #define INIT_VALUE_TYPE_NAME_IF_NEEDED(...)                   \
@@ -212,13 +244,26 @@ const char* valueTypeName(ValueType* value_type) {
     }
 
         case BASIC_VALUE_TYPE_ARRAY:
+            if (value_type->as.array.element_type == NULL) {
+                return "[]";
+            }
             INIT_VALUE_TYPE_NAME_IF_NEEDED(
                 "[%s]", 
                 valueTypeName(value_type->as.array.element_type)
             );
             return value_type->name;
 
+        case BASIC_VALUE_TYPE_MATRIX:
+            INIT_VALUE_TYPE_NAME_IF_NEEDED(
+                "[%s,]",
+                valueTypeName(value_type->as.matrix.element_type)
+            );
+            return value_type->name;
+
         case BASIC_VALUE_TYPE_MAP:
+            if (value_type->as.map.key_type == NULL) {
+                return "{}";
+            }
             INIT_VALUE_TYPE_NAME_IF_NEEDED(
                 "{%s:%s}",
                 valueTypeName(value_type->as.map.key_type),
@@ -284,8 +329,14 @@ size_t valueTypeSize(ValueType* value_type) {
         case BASIC_VALUE_TYPE_INT:    return sizeof(uint32_t);
         case BASIC_VALUE_TYPE_FLOAT:  return sizeof(double);
 
+        // Narrow numbers only take this much in arrays.
+        case BASIC_VALUE_TYPE_INT8:    return sizeof(int8_t);
+        case BASIC_VALUE_TYPE_INT16:   return sizeof(int16_t);
+        case BASIC_VALUE_TYPE_FLOAT32: return sizeof(float);
+
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_FUNCTION:
         case BASIC_VALUE_TYPE_REFERENCE_STRUCTURE:
@@ -306,10 +357,14 @@ bool isReferenceValueType(ValueType* value_type) {
         case BASIC_VALUE_TYPE_INT:
         case BASIC_VALUE_TYPE_FLOAT:
         case BASIC_VALUE_TYPE_FUNCTION:
+        case BASIC_VALUE_TYPE_INT8:
+        case BASIC_VALUE_TYPE_INT16:
+        case BASIC_VALUE_TYPE_FLOAT32:
             return false;
 
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_OBJECT:
             return true;
@@ -348,26 +403,37 @@ bool valueTypesEqual(ValueType* a, ValueType* b) {
         case BASIC_VALUE_TYPE_INT:
         case BASIC_VALUE_TYPE_FLOAT:
         case BASIC_VALUE_TYPE_STRING:
+        case BASIC_VALUE_TYPE_INT8:
+        case BASIC_VALUE_TYPE_INT16:
+        case BASIC_VALUE_TYPE_FLOAT32:
             return true;
 
         case BASIC_VALUE_TYPE_ARRAY:
             return (
-                b->as.array.element_type == NULL || 
+                a->as.array.element_type == NULL ||
+                b->as.array.element_type == NULL ||
                 valueTypesEqual(
                     a->as.array.element_type,
                     b->as.array.element_type
                 )
             );
 
+        case BASIC_VALUE_TYPE_MATRIX:
+            return valueTypesEqual(a->as.matrix.element_type, b->as.matrix.element_type);
+
         case BASIC_VALUE_TYPE_MAP:
             return (
-                valueTypesEqual(
-                    a->as.map.key_type,
-                    b->as.map.key_type
-                ) &&
-                valueTypesEqual(
-                    a->as.map.element_type,
-                    b->as.map.element_type
+                a->as.map.key_type == NULL ||
+                b->as.map.key_type == NULL ||
+                (
+                    valueTypesEqual(
+                        a->as.map.key_type,
+                        b->as.map.key_type
+                    ) &&
+                    valueTypesEqual(
+                        a->as.map.element_type,
+                        b->as.map.element_type
+                    )
                 )
             );
 
@@ -400,6 +466,45 @@ bool valueTypesEqual(ValueType* a, ValueType* b) {
     }
 }
 
+size_t arrayItemSize(ValueType* element_type) {
+    assert(element_type);
+
+    // Bools are packed into bits, see bit_array.h.
+    if (element_type->basic_type == BASIC_VALUE_TYPE_BOOL) {
+        return 0;
+    }
+    return valueTypeSize(element_type);
+}
+
+ValueType* arrayItemValueType(ValueType* element_type) {
+    assert(element_type);
+
+    switch (element_type->basic_type) {
+        case BASIC_VALUE_TYPE_INT8:
+        case BASIC_VALUE_TYPE_INT16:
+            return &VALUE_TYPE_INT;
+        case BASIC_VALUE_TYPE_FLOAT32:
+            return &VALUE_TYPE_FLOAT;
+        default:
+            return element_type;
+    }
+}
+
+bool isMatrixItemValueType(ValueType* element_type) {
+    assert(element_type);
+
+    switch (element_type->basic_type) {
+        case BASIC_VALUE_TYPE_INT:
+        case BASIC_VALUE_TYPE_FLOAT:
+        case BASIC_VALUE_TYPE_INT8:
+        case BASIC_VALUE_TYPE_INT16:
+        case BASIC_VALUE_TYPE_FLOAT32:
+            return true;
+        default:
+            return false;
+    }
+}
+
 OpCode getOpPopForValueType(ValueType* value_type) {
     assert(value_type);
 
@@ -410,6 +515,7 @@ OpCode getOpPopForValueType(ValueType* value_type) {
 
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_FUNCTION:
         case BASIC_VALUE_TYPE_REFERENCE_STRUCTURE:
@@ -436,6 +542,7 @@ OpCode getOpReturnForValueType(ValueType* value_type) {
 
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_FUNCTION:
         case BASIC_VALUE_TYPE_OBJECT:
@@ -458,6 +565,7 @@ OpCode getOpGetFromHeapForValueType(ValueType* value_type) {
 
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_FUNCTION:
         case BASIC_VALUE_TYPE_OBJECT:
@@ -481,6 +589,7 @@ OpCode getOpSetOnHeapForValueType(ValueType* value_type) {
 
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_FUNCTION:
         case BASIC_VALUE_TYPE_OBJECT:
@@ -498,12 +607,16 @@ OpCode getOpSubscriptGetForValueType(ValueType* value_type) {
     assert(value_type);
 
     switch (value_type->basic_type) {
-        case BASIC_VALUE_TYPE_BOOL:  return OP_SUBSCRIPT_GET_BYTE;
-        case BASIC_VALUE_TYPE_INT:   return OP_SUBSCRIPT_GET_INT;
-        case BASIC_VALUE_TYPE_FLOAT: return OP_SUBSCRIPT_GET_FLOAT;
+        case BASIC_VALUE_TYPE_BOOL:    return OP_SUBSCRIPT_GET_BIT;
+        case BASIC_VALUE_TYPE_INT:     return OP_SUBSCRIPT_GET_INT;
+        case BASIC_VALUE_TYPE_FLOAT:   return OP_SUBSCRIPT_GET_FLOAT;
+        case BASIC_VALUE_TYPE_INT8:    return OP_SUBSCRIPT_GET_INT8;
+        case BASIC_VALUE_TYPE_INT16:   return OP_SUBSCRIPT_GET_INT16;
+        case BASIC_VALUE_TYPE_FLOAT32: return OP_SUBSCRIPT_GET_FLOAT32;
 
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_FUNCTION:
         case BASIC_VALUE_TYPE_OBJECT:
@@ -521,12 +634,16 @@ OpCode getOpSubscriptSetForValueType(ValueType* value_type) {
     assert(value_type);
 
     switch (value_type->basic_type) {
-        case BASIC_VALUE_TYPE_BOOL:  return OP_SUBSCRIPT_SET_BYTE;
-        case BASIC_VALUE_TYPE_INT:   return OP_SUBSCRIPT_SET_INT;
-        case BASIC_VALUE_TYPE_FLOAT: return OP_SUBSCRIPT_SET_FLOAT;
+        case BASIC_VALUE_TYPE_BOOL:    return OP_SUBSCRIPT_SET_BIT;
+        case BASIC_VALUE_TYPE_INT:     return OP_SUBSCRIPT_SET_INT;
+        case BASIC_VALUE_TYPE_FLOAT:   return OP_SUBSCRIPT_SET_FLOAT;
+        case BASIC_VALUE_TYPE_INT8:    return OP_SUBSCRIPT_SET_INT8;
+        case BASIC_VALUE_TYPE_INT16:   return OP_SUBSCRIPT_SET_INT16;
+        case BASIC_VALUE_TYPE_FLOAT32: return OP_SUBSCRIPT_SET_FLOAT32;
 
         case BASIC_VALUE_TYPE_STRING:
         case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
         case BASIC_VALUE_TYPE_MAP:
         case BASIC_VALUE_TYPE_FUNCTION:
         case BASIC_VALUE_TYPE_OBJECT:
@@ -540,3 +657,111 @@ OpCode getOpSubscriptSetForValueType(ValueType* value_type) {
     }
 }
 
+OpCode getOpArrayPushForValueType(ValueType* value_type) {
+    assert(value_type);
+
+    switch (value_type->basic_type) {
+        case BASIC_VALUE_TYPE_BOOL:     return OP_ARRAY_PUSH_BIT;
+        case BASIC_VALUE_TYPE_INT:      return OP_ARRAY_PUSH_INT;
+        case BASIC_VALUE_TYPE_FLOAT:    return OP_ARRAY_PUSH_FLOAT;
+        case BASIC_VALUE_TYPE_FUNCTION: return OP_ARRAY_PUSH_ADDRESS;
+        case BASIC_VALUE_TYPE_INT8:     return OP_ARRAY_PUSH_INT8;
+        case BASIC_VALUE_TYPE_INT16:    return OP_ARRAY_PUSH_INT16;
+        case BASIC_VALUE_TYPE_FLOAT32:  return OP_ARRAY_PUSH_FLOAT32;
+
+        case BASIC_VALUE_TYPE_STRING:
+        case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
+        case BASIC_VALUE_TYPE_MAP:
+        case BASIC_VALUE_TYPE_OBJECT:
+            return OP_ARRAY_PUSH_REFERENCE;
+
+        case BASIC_VALUE_TYPE_VOID:
+        case BASIC_VALUE_TYPE_PLAIN_STRUCTURE:
+        case BASIC_VALUE_TYPE_REFERENCE_STRUCTURE:
+        default:
+            assert(false);
+    }
+}
+
+OpCode getOpArrayPopForValueType(ValueType* value_type) {
+    assert(value_type);
+
+    switch (value_type->basic_type) {
+        case BASIC_VALUE_TYPE_BOOL:    return OP_ARRAY_POP_BIT;
+        case BASIC_VALUE_TYPE_INT:     return OP_ARRAY_POP_INT;
+        case BASIC_VALUE_TYPE_FLOAT:   return OP_ARRAY_POP_FLOAT;
+        case BASIC_VALUE_TYPE_INT8:    return OP_ARRAY_POP_INT8;
+        case BASIC_VALUE_TYPE_INT16:   return OP_ARRAY_POP_INT16;
+        case BASIC_VALUE_TYPE_FLOAT32: return OP_ARRAY_POP_FLOAT32;
+
+        case BASIC_VALUE_TYPE_STRING:
+        case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
+        case BASIC_VALUE_TYPE_MAP:
+        case BASIC_VALUE_TYPE_FUNCTION:
+        case BASIC_VALUE_TYPE_OBJECT:
+            return OP_ARRAY_POP_ADDRESS;
+
+        case BASIC_VALUE_TYPE_VOID:
+        case BASIC_VALUE_TYPE_PLAIN_STRUCTURE:
+        case BASIC_VALUE_TYPE_REFERENCE_STRUCTURE:
+        default:
+            assert(false);
+    }
+}
+
+OpCode getOpArrayFillForValueType(ValueType* value_type) {
+    assert(value_type);
+
+    switch (value_type->basic_type) {
+        case BASIC_VALUE_TYPE_BOOL:    return OP_ARRAY_FILL_BIT;
+        case BASIC_VALUE_TYPE_INT:     return OP_ARRAY_FILL_INT;
+        case BASIC_VALUE_TYPE_FLOAT:   return OP_ARRAY_FILL_FLOAT;
+        case BASIC_VALUE_TYPE_INT8:    return OP_ARRAY_FILL_INT8;
+        case BASIC_VALUE_TYPE_INT16:   return OP_ARRAY_FILL_INT16;
+        case BASIC_VALUE_TYPE_FLOAT32: return OP_ARRAY_FILL_FLOAT32;
+
+        case BASIC_VALUE_TYPE_STRING:
+        case BASIC_VALUE_TYPE_ARRAY:
+        case BASIC_VALUE_TYPE_MATRIX:
+        case BASIC_VALUE_TYPE_MAP:
+        case BASIC_VALUE_TYPE_FUNCTION:
+        case BASIC_VALUE_TYPE_OBJECT:
+            return OP_ARRAY_FILL_ADDRESS;
+
+        case BASIC_VALUE_TYPE_VOID:
+        case BASIC_VALUE_TYPE_PLAIN_STRUCTURE:
+        case BASIC_VALUE_TYPE_REFERENCE_STRUCTURE:
+        default:
+            assert(false);
+    }
+}
+
+OpCode getOpSubscript2GetForValueType(ValueType* value_type) {
+    assert(value_type);
+
+    switch (value_type->basic_type) {
+        case BASIC_VALUE_TYPE_INT:     return OP_SUBSCRIPT2_GET_INT;
+        case BASIC_VALUE_TYPE_FLOAT:   return OP_SUBSCRIPT2_GET_FLOAT;
+        case BASIC_VALUE_TYPE_INT8:    return OP_SUBSCRIPT2_GET_INT8;
+        case BASIC_VALUE_TYPE_INT16:   return OP_SUBSCRIPT2_GET_INT16;
+        case BASIC_VALUE_TYPE_FLOAT32: return OP_SUBSCRIPT2_GET_FLOAT32;
+        default:
+            assert(false);
+    }
+}
+
+OpCode getOpSubscript2SetForValueType(ValueType* value_type) {
+    assert(value_type);
+
+    switch (value_type->basic_type) {
+        case BASIC_VALUE_TYPE_INT:     return OP_SUBSCRIPT2_SET_INT;
+        case BASIC_VALUE_TYPE_FLOAT:   return OP_SUBSCRIPT2_SET_FLOAT;
+        case BASIC_VALUE_TYPE_INT8:    return OP_SUBSCRIPT2_SET_INT8;
+        case BASIC_VALUE_TYPE_INT16:   return OP_SUBSCRIPT2_SET_INT16;
+        case BASIC_VALUE_TYPE_FLOAT32: return OP_SUBSCRIPT2_SET_FLOAT32;
+        default:
+            assert(false);
+    }
+}
@@ -32,6 +32,16 @@ typedef enum {
     BASIC_VALUE_TYPE_REFERENCE_STRUCTURE,
 
     BASIC_VALUE_TYPE_OBJECT,
+
+    // Narrow numbers are only items of arrays,
+    // values of them are ints and floats, see arrayItemValueType.
+    BASIC_VALUE_TYPE_INT8,
+    BASIC_VALUE_TYPE_INT16,
+    BASIC_VALUE_TYPE_FLOAT32,
+
+    // Matrices have numbers as items, in a single buffer
+    // row after row, see matrix.h.
+    BASIC_VALUE_TYPE_MATRIX,
 } BasicValueType;
 
 struct ValueType;
@@ -43,6 +53,11 @@ typedef struct {
 } ArrayValueType;
 
 typedef struct {
+    ValueType* element_type;
+} MatrixValueType;
+
+typedef struct {
+    // These are NULL for a literal like {}.
     ValueType* key_type;
     ValueType* element_type;
 } MapValueType;
@@ -74,6 +89,7 @@ struct ValueType {
     BasicValueType basic_type;
     union {
         ArrayValueType     array;
+        MatrixValueType    matrix;
         MapValueType       map;
         FunctionValueType  function;
         StructureValueType structure;
@@ -93,6 +109,9 @@ extern ValueType VALUE_TYPE_BOOL;
 extern ValueType VALUE_TYPE_INT;
 extern ValueType VALUE_TYPE_FLOAT;
 extern ValueType VALUE_TYPE_STRING;
+extern ValueType VALUE_TYPE_INT8;
+extern ValueType VALUE_TYPE_INT16;
+extern ValueType VALUE_TYPE_FLOAT32;
 
 
 // ┌───────────────────────┐
@@ -100,6 +119,8 @@ extern ValueType VALUE_TYPE_STRING;
 // └───────────────────────┘
 
 ValueType* createArrayValueType(ValueType* element_type);
+ValueType* createMatrixValueType(ValueType* element_type);
+ValueType* createMapValueType(ValueType* key_type, ValueType* element_type);
 ValueType* createFunctionValueType();
 void addParameterToFunctionValueType(
     FunctionValueType* function,
@@ -124,12 +145,26 @@ bool   isReferenceValueType(ValueType* value_type);
 bool   isStructureValueType(ValueType* value_type);
 bool   valueTypesEqual(ValueType* a, ValueType* b);
 
-OpCode getOpPopForValueType         (ValueType* value_type);
-OpCode getOpReturnForValueType      (ValueType* value_type);
-OpCode getOpGetFromHeapForValueType (ValueType* value_type);
-OpCode getOpSetOnHeapForValueType   (ValueType* value_type);
-OpCode getOpSubscriptGetForValueType(ValueType* value_type);
-OpCode getOpSubscriptSetForValueType(ValueType* value_type);
+// Size of an item of an array of the element type in bytes,
+// or 0 for bools, which are packed into bits.
+size_t arrayItemSize(ValueType* element_type);
+// Type of the values read from and written to an array of the element
+// type: int for int8 and int16, float for float32, else the element type.
+ValueType* arrayItemValueType(ValueType* element_type);
+// Matrix items are ints, floats and their narrow types.
+bool isMatrixItemValueType(ValueType* element_type);
+
+OpCode getOpPopForValueType          (ValueType* value_type);
+OpCode getOpReturnForValueType       (ValueType* value_type);
+OpCode getOpGetFromHeapForValueType  (ValueType* value_type);
+OpCode getOpSetOnHeapForValueType    (ValueType* value_type);
+OpCode getOpSubscriptGetForValueType (ValueType* value_type);
+OpCode getOpSubscriptSetForValueType (ValueType* value_type);
+OpCode getOpArrayPushForValueType    (ValueType* value_type);
+OpCode getOpArrayPopForValueType     (ValueType* value_type);
+OpCode getOpArrayFillForValueType    (ValueType* value_type);
+OpCode getOpSubscript2GetForValueType(ValueType* value_type);
+OpCode getOpSubscript2SetForValueType(ValueType* value_type);
 
 
 #endif
@@ -2,11 +2,23 @@
 
 
 #include <assert.h>
+#include <float.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
+#include "array.h"
+#include "bit_array.h"
 #include "debug.h"
+#include "map.h"
+#include "matrix.h"
+#include "number_format.h"
+#include "number_kernels.h"
+#include "sort.h"
+#include "string_kernels.h"
 
 
 // ┌────────┐
@@ -36,6 +48,7 @@
 
 #define error(vm, ...)                                      \
     {                                                       \
+        flushOutput(&vm->output);                           \
         fprintf(                                            \
             stderr,                                         \
             "Runtime error at instruction '%s' at 0x%lx:\n", \
@@ -61,6 +74,11 @@
 // │ Static function declarations │
 // └──────────────────────────────┘
 
+// Runs the program from ip. Returns at the end of the program, or when
+// a function returns to return_frame, so that native code may call
+// functions back.
+static void run(VM* vm, const CallFrame* return_frame);
+
 static void pushCallFrame(VM* vm);
 static void popCallFrame(VM* vm);
 
@@ -71,6 +89,56 @@ static uint8_t readByteFromSource(   VM* vm);
 static int32_t readIntFromSource(    VM* vm);
 static double  readFloatFromSource(  VM* vm);
 static size_t  readAddressFromSource(VM* vm);
+// MAP_ITEM_UNKNOWN is only valid for an empty map literal.
+static MapItemKind readMapItemKindFromSource(VM* vm, bool allow_unknown);
+
+// Map items are widened to size_t, see MapSlot.
+static size_t getMapItemFromStack(const VM* vm, MapItemKind kind, size_t address);
+static double floatFromMapItem(size_t item);
+
+// Return the value if it fits into an item of a narrow number array,
+// report a runtime error otherwise. Infinities and NaNs fit into float32.
+static int32_t narrowInt(VM* vm, int32_t value, int32_t min, int32_t max, const char* type_name);
+static float   narrowFloat(VM* vm, double value);
+
+// Strings of up to heap.config.intern_max_size bytes are interned.
+// allocateString returns NULL if the allocation fails.
+static Object* allocateString(VM* vm, const uint8_t* value, size_t size);
+static Object* internShortString(VM* vm, Object* string);
+
+// A substring is a view of the string, so it's made in constant time.
+// Short substrings are copied and interned instead, because
+// a view isn't any smaller and would keep the whole string alive.
+static Object* makeSubstring(VM* vm, Object* string, size_t start, size_t size);
+
+// Returns a plain string with size bytes of the value of string
+// starting at offset, so that it doesn't keep a view's base alive.
+static Object* copyString(VM* vm, Object* string, size_t offset, size_t size);
+
+// Calls the function(a: T, b: T): bool at function_position on the stack,
+// which tells if a goes before b, with items of item_size bytes.
+static bool callLessFunction(
+    VM* vm,
+    size_t function_position,
+    const uint8_t* a,
+    const uint8_t* b,
+    size_t item_size,
+    bool items_are_references
+);
+/* Sorts the array at array_position on the stack with the function
+ * after it by a stable bottom-up merge sort. The function may allocate,
+ * so the array and the buffer the runs are merged into stay on the stack
+ * and are found anew after every call.
+ * */
+static void sortArrayWithFunction(
+    VM* vm,
+    size_t array_position,
+    size_t item_size,
+    bool items_are_references
+);
+// Bools have two values, so the function is called on them
+// once each way and the array is rearranged by the counts.
+static void sortBitsWithFunction(VM* vm, size_t array_position);
 
 
 // ┌──────────────────────────┐
@@ -84,6 +152,7 @@ void initVM(
     Constants* constants
 ) {
     assert(vm);
+    assert(constants);
 
     vm->source_size     = source_size;
     vm->source          = source;
@@ -91,14 +160,36 @@ void initVM(
     vm->ip              = source;
     vm->constants       = constants;
 
+    for (uint8_t i = 0; i < constants->count; ++i) {
+        Object* object = &vm->constant_objects[i];
+        object->reference_rule        = REFERENCE_RULE_PLAIN;
+        object->immortal              = true;
+        object->string_buffer         = false;
+        object->interned              = false;
+        object->unused_bits           = 0;
+        object->hash                  = 0;
+        object->custom_reference_rule = NULL;
+        object->size                  = constants->constants[i].length;
+        // Strings are never modified in place.
+        object->value                 = (uint8_t*)(uintptr_t)constants->constants[i].value;
+    }
+
     initStack(&vm->stack);
     initHeap(&vm->heap);
 
+    for (uint8_t i = 0; i < constants->count; ++i) {
+        internString(&vm->heap, &vm->constant_objects[i]);
+    }
+
     vm->call_frame = NULL;
     pushCallFrame(vm);
 
     initStack(&vm->stack_references_positions);
 
+    initInput(&vm->input, STDIN_FILENO);
+    initOutput(&vm->output, STDOUT_FILENO);
+    vm->input.tied_output = &vm->output;
+
     ASSERT_VM(vm);
 }
 
@@ -113,6 +204,8 @@ void freeVM(VM* vm) {
 
     freeStack(&vm->stack);
     freeHeap(&vm->heap);
+    freeInput(&vm->input);
+    freeOutput(&vm->output);
 
     assert(vm->call_frame == NULL);
 
@@ -196,12 +289,20 @@ void fdumpVM(FILE* out, const VM* vm, int padding) {
 void interpret(VM* vm) {
     ASSERT_VM(vm);
 
+    run(vm, NULL);
+
+    ASSERT_VM(vm);
+}
+
+static void run(VM* vm, const CallFrame* return_frame) {
+    ASSERT_VM(vm);
+
 #define CLEAN_STACK_REFERENCES()                                                \
 {                                                                               \
     while (                                                                     \
         stackSize(&vm->stack_references_positions) > 0 &&                       \
-        *(size_t*)(vm->stack_references_positions.stack_top - sizeof(size_t)) > \
-        stackSize(&vm->stack) - sizeof(size_t)                                  \
+        *(size_t*)(vm->stack_references_positions.stack_top - sizeof(size_t)) + \
+        sizeof(size_t) > stackSize(&vm->stack)                                  \
     ) {                                                                         \
         popAddressFromStack(&vm->stack_references_positions);                   \
     }                                                                           \
@@ -251,6 +352,40 @@ void interpret(VM* vm) {
         value;                                          \
     })
 
+#define NARROW_INT8(   value) ((int8_t)narrowInt(vm, (value), INT8_MIN, INT8_MAX, "int8"))
+#define NARROW_INT16(  value) ((int16_t)narrowInt(vm, (value), INT16_MIN, INT16_MAX, "int16"))
+#define NARROW_FLOAT32(value) narrowFloat(vm, (value))
+
+#define POP_INT8()    NARROW_INT8(POP_INT())
+#define POP_INT16()   NARROW_INT16(POP_INT())
+#define POP_FLOAT32() NARROW_FLOAT32(POP_FLOAT())
+
+// Allocation fails if the heap limit is exceeded.
+#define CHECK_ALLOCATION(object)                                          \
+    if (!(object)) {                                                      \
+        error(                                                            \
+            vm,                                                           \
+            "Out of memory. Heap size is %lu bytes, limit is %lu bytes.", \
+            vm->heap.size,                                                \
+            vm->heap.config.limit                                         \
+        );                                                                \
+    }
+
+// Item size 0 stands for bools packed into bits.
+#define ARRAY_LENGTH(array, item_size) \
+    ((item_size) == 0 ? bitArrayLength(array) : (array)->size / (item_size))
+
+#define CHECK_ARRAY_RANGE(array, start, end, item_size)                                     \
+    if ((start) < 0 || (end) < (start) || (size_t)(end) > ARRAY_LENGTH(array, item_size)) { \
+        error(                                                                              \
+            vm,                                                                             \
+            "Range [%d, %d) is out of bounds of an array of length %lu.",                   \
+            start,                                                                          \
+            end,                                                                            \
+            ARRAY_LENGTH(array, item_size)                                                  \
+        );                                                                                  \
+    }
+
 
     while (!isAtEnd(vm)) {
         vm->current_op_code = vm->ip;
@@ -285,17 +420,7 @@ void interpret(VM* vm) {
                     );
                 }
 
-                Constant constant = vm->constants->constants[constant_index];
-                Object* object = allocateObjectFromValue(
-                    &vm->heap,
-                    &vm->stack,
-                    &vm->stack_references_positions,
-                    REFERENCE_RULE_PLAIN,
-                    NULL,
-                    constant.length,
-                    constant.value
-                );
-                PUSH_REF_ADDRESS((size_t)object);
+                PUSH_REF_ADDRESS((size_t)&vm->constant_objects[constant_index]);
                 break;
             }
 
@@ -305,8 +430,8 @@ void interpret(VM* vm) {
                 Object* custom_reference_rule = NULL;
                 if (reference_rule == REFERENCE_RULE_CUSTOM) {
                     custom_reference_rule = (Object*)POP_ADDRESS();
-                    // Mark in order for custom reference rule to not be deleted by gc before object allocation.
-                    custom_reference_rule->marked = true;
+                    // Pin in order for custom reference rule to not be deleted by gc before object allocation.
+                    dontCollectObjectOnNextGC(&vm->heap, custom_reference_rule);
                 }
                 Object* object = allocateObjectFromValue(
                     &vm->heap,
@@ -317,12 +442,29 @@ void interpret(VM* vm) {
                     length,
                     vm->stack.stack_top - length * sizeof(uint8_t)
                 );
+                CHECK_ALLOCATION(object);
                 popBytesFromStack(&vm->stack, length);
                 CLEAN_STACK_REFERENCES();
                 PUSH_REF_ADDRESS((size_t)object);
                 break;
             }
 
+            case OP_DEFINE_BITS_ON_HEAP: {
+                size_t length = readAddressFromSource(vm);
+                Object* array = packBits(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    vm->stack.stack_top - length * sizeof(uint8_t),
+                    length
+                );
+                CHECK_ALLOCATION(array);
+                popBytesFromStack(&vm->stack, length);
+                CLEAN_STACK_REFERENCES();
+                PUSH_REF_ADDRESS((size_t)array);
+                break;
+            }
+
 #define GET_FROM_HEAP_OP(type, push)                                          \
     {                                                                         \
         Object* object = (Object*)POP_ADDRESS();                              \
@@ -372,9 +514,20 @@ void interpret(VM* vm) {
 
 #undef SET_ON_HEAP_OP
 
-            // Logical
-            case OP_OR:  PUSH_BYTE(POP_BYTE() || POP_BYTE()); break;
-            case OP_AND: PUSH_BYTE(POP_BYTE() && POP_BYTE()); break;
+            // Logical, both operands are popped before
+            // they're combined, || and && would skip the second pop.
+            case OP_OR: {
+                uint8_t r = POP_BYTE();
+                uint8_t l = POP_BYTE();
+                PUSH_BYTE(l || r);
+                break;
+            }
+            case OP_AND: {
+                uint8_t r = POP_BYTE();
+                uint8_t l = POP_BYTE();
+                PUSH_BYTE(l && r);
+                break;
+            }
             case OP_NEGATE_BOOL: PUSH_BYTE(!POP_BYTE()); break;
 
             // Comparison
@@ -384,15 +537,7 @@ void interpret(VM* vm) {
             case OP_EQUALS_STRING: {
                 Object* r_str = (Object*)POP_ADDRESS();
                 Object* l_str = (Object*)POP_ADDRESS();
-                if (l_str->size != r_str->size) {
-                    PUSH_BYTE(0);
-                } else {
-                    if (strncmp((char*)l_str->value, (char*)r_str->value, l_str->size) == 0) {
-                        PUSH_BYTE(1);
-                    } else {
-                        PUSH_BYTE(0);
-                    }
-                }
+                PUSH_BYTE(stringsEqual(l_str, r_str));
                 break;
             }
 
@@ -403,16 +548,7 @@ void interpret(VM* vm) {
             case OP_LESS_STRING: {
                 Object* r_str = (Object*)POP_ADDRESS();
                 Object* l_str = (Object*)POP_ADDRESS();
-                int cmp = strncmp(
-                    (char*)l_str->value,
-                    (char*)r_str->value, 
-                    l_str->size < r_str->size ? l_str->size : r_str->size
-                );
-                if (cmp == 0) {
-                    PUSH_BYTE(l_str->size < r_str->size);
-                } else {
-                    PUSH_BYTE(cmp < 0);
-                }
+                PUSH_BYTE(compareStrings(l_str, r_str) < 0);
                 break;
             }
 
@@ -421,16 +557,7 @@ void interpret(VM* vm) {
             case OP_GREATER_STRING: {
                 Object* r_str = (Object*)POP_ADDRESS();
                 Object* l_str = (Object*)POP_ADDRESS();
-                int cmp = strncmp(
-                    (char*)l_str->value,
-                    (char*)r_str->value, 
-                    l_str->size < r_str->size ? l_str->size : r_str->size
-                );
-                if (cmp == 0) {
-                    PUSH_BYTE(l_str->size > r_str->size);
-                } else {
-                    PUSH_BYTE(cmp > 0);
-                }
+                PUSH_BYTE(compareStrings(l_str, r_str) > 0);
                 break;
             }
 
@@ -450,28 +577,69 @@ void interpret(VM* vm) {
                     );
                 }
                 Object* source = (Object*)POP_ADDRESS();
-                dontCollectObjectOnNextGC(source);
 
-                if (source->custom_reference_rule != NULL) {
+                ReferenceRule reference_rule = source->reference_rule;
+                if (reference_rule == REFERENCE_RULE_VIEW) {
+                    reference_rule = source->base->reference_rule;
+                }
+                if (reference_rule != REFERENCE_RULE_PLAIN && reference_rule != REFERENCE_RULE_REF_ARRAY) {
+                    error(
+                        vm,
+                        "Trying to multiply a heap value with a %s reference rule.",
+                        referenceRuleName(reference_rule)
+                    );
+                }
+                if (times != 0 && source->size > SIZE_MAX / (size_t)times) {
                     error(
                         vm,
-                        "Trying to multiply a heap value with a custom reference rule."
+                        "Out of memory. Can't multiply a heap value of %lu bytes by %d.",
+                        source->size,
+                        times
                     );
                 }
 
-                Object* result = allocateEmptyObject(
+                Object* result = repeatArray(
                     &vm->heap,
                     &vm->stack,
                     &vm->stack_references_positions,
-                    source->reference_rule,
-                    NULL,
-                    source->size * (size_t)times
+                    source,
+                    (size_t)times
                 );
+                CHECK_ALLOCATION(result);
 
-                for (size_t i = 0; i < (size_t)times; ++i) {
-                    memcpy(result->value + source->size * i, source->value, source->size);
+                PUSH_REF_ADDRESS((size_t)result);
+                break;
+            }
+
+            // Bools are packed into bits, see bit_array.h.
+            case OP_MULTIPLY_BITS: {
+                int32_t times = POP_INT();
+                if (times < 0) {
+                    error(
+                        vm,
+                        "Trying to multiply a heap value by a negative integer %d.",
+                        times
+                    );
+                }
+                Object* source = (Object*)POP_ADDRESS();
+                if (times != 0 && source->size > SIZE_MAX / 8 / (size_t)times) {
+                    error(
+                        vm,
+                        "Out of memory. Can't multiply an array of %lu bools by %d.",
+                        bitArrayLength(source),
+                        times
+                    );
                 }
 
+                Object* result = repeatBits(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    source,
+                    (size_t)times
+                );
+                CHECK_ALLOCATION(result);
+
                 PUSH_REF_ADDRESS((size_t)result);
                 break;
             }
@@ -522,24 +690,239 @@ void interpret(VM* vm) {
                 Object* r_address = (Object*)POP_ADDRESS();
                 Object* l_address = (Object*)POP_ADDRESS();
 
-                dontCollectObjectOnNextGC(r_address);
-                dontCollectObjectOnNextGC(l_address);
+                Object* object = concatenateStrings(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    l_address,
+                    r_address
+                );
+                CHECK_ALLOCATION(object);
+
+                PUSH_REF_ADDRESS((size_t)internShortString(vm, object));
+                break;
+            }
+
+            case OP_CONCATENATE_N: {
+                uint8_t count = readByteFromSource(vm);
+                if (!hasEnoughInputBytes(vm, count)) {
+                    error(vm, "Expected %u operand kinds, but got end of program.", count);
+                }
+                const uint8_t* operands = vm->ip;
+                vm->ip += count;
+                if (count == 0) {
+                    error(vm, "Trying to concatenate 0 operands.");
+                }
+
+                // Find the operands on the stack and the lengths of their strings.
+                // Floats are formatted right away, ints while copying.
+                size_t positions[UINT8_MAX];
+                size_t lengths[UINT8_MAX];
+                uint8_t floats[UINT8_MAX][FLOAT_STRING_MAX_LENGTH];
+                size_t position = stackSize(&vm->stack);
+                for (uint8_t i = count; i-- > 0;) {
+                    size_t operand_size;
+                    switch (operands[i]) {
+                        case CONCATENATE_OPERAND_STRING: operand_size = sizeof(size_t);  break;
+                        case CONCATENATE_OPERAND_INT:    operand_size = sizeof(int32_t); break;
+                        case CONCATENATE_OPERAND_FLOAT:  operand_size = sizeof(double);  break;
+                        default:
+                            error(vm, "Invalid concatenate operand kind %u.", operands[i]);
+                    }
+                    if (operand_size > position) {
+                        error(vm, "Not enough operands on the stack to concatenate %u values.", count);
+                    }
+                    position -= operand_size;
+                    positions[i] = position;
+
+                    switch (operands[i]) {
+                        case CONCATENATE_OPERAND_STRING:
+                            lengths[i] = ((Object*)getAddressFromStack(&vm->stack, position))->size;
+                            break;
+                        case CONCATENATE_OPERAND_INT:
+                            lengths[i] = intStringLength(getIntFromStack(&vm->stack, position));
+                            break;
+                        case CONCATENATE_OPERAND_FLOAT:
+                            lengths[i] = formatFloat(getFloatFromStack(&vm->stack, position), floats[i]);
+                            break;
+                    }
+                }
+
+                // Append the rest of the operands to the first string,
+                // which is done in place if it was built by concatenation.
+                Object* left = &OBJECT_STRING_EMPTY;
+                uint8_t first = 0;
+                if (operands[0] == CONCATENATE_OPERAND_STRING) {
+                    left = (Object*)getAddressFromStack(&vm->stack, positions[0]);
+                    first = 1;
+                }
+                size_t left_size = left->size;
+                size_t size = 0;
+                for (uint8_t i = first; i < count; ++i) {
+                    if (lengths[i] > SIZE_MAX / 4 - size) {
+                        error(vm, "Out of memory. Concatenation result is too long.");
+                    }
+                    size += lengths[i];
+                }
 
-                Object* object = allocateEmptyObject(
+                Object* object = appendToString(
                     &vm->heap,
                     &vm->stack,
                     &vm->stack_references_positions,
-                    REFERENCE_RULE_PLAIN,
-                    NULL,
-                    l_address->size + r_address->size
+                    left,
+                    size
                 );
-                memcpy(object->value, l_address->value, l_address->size);
-                memcpy(object->value + l_address->size, r_address->value, r_address->size);
+                CHECK_ALLOCATION(object);
+
+                // The operands are roots, so gc could have moved them.
+                uint8_t* destination = object->value + left_size;
+                for (uint8_t i = first; i < count; ++i) {
+                    switch (operands[i]) {
+                        case CONCATENATE_OPERAND_STRING: {
+                            Object* operand = (Object*)getAddressFromStack(&vm->stack, positions[i]);
+                            memcpy(destination, operand->value, lengths[i]);
+                            break;
+                        }
+                        case CONCATENATE_OPERAND_INT:
+                            formatInt(getIntFromStack(&vm->stack, positions[i]), destination, lengths[i]);
+                            break;
+                        case CONCATENATE_OPERAND_FLOAT:
+                            memcpy(destination, floats[i], lengths[i]);
+                            break;
+                    }
+                    destination += lengths[i];
+                }
+
+                popBytesFromStack(&vm->stack, stackSize(&vm->stack) - positions[0]);
+                CLEAN_STACK_REFERENCES();
+                PUSH_REF_ADDRESS((size_t)internShortString(vm, object));
+                break;
+            }
+
+            case OP_SUBSTRING: {
+                int32_t end = POP_INT();
+                int32_t start = POP_INT();
+                Object* string = (Object*)POP_ADDRESS();
+                if (start < 0 || end < start || (size_t)end > string->size) {
+                    error(
+                        vm,
+                        "Substring [%d, %d) is out of bounds of a string of length %lu.",
+                        start,
+                        end,
+                        string->size
+                    );
+                }
+
+                Object* object = makeSubstring(vm, string, (size_t)start, (size_t)(end - start));
+                CHECK_ALLOCATION(object);
 
                 PUSH_REF_ADDRESS((size_t)object);
                 break;
             }
 
+            // Strings are immutable, so only views need to be copied.
+            case OP_COPY_STRING: {
+                Object* string = (Object*)POP_ADDRESS();
+                if (string->reference_rule == REFERENCE_RULE_VIEW) {
+                    string = copyString(vm, string, 0, string->size);
+                    CHECK_ALLOCATION(string);
+                }
+                PUSH_REF_ADDRESS((size_t)string);
+                break;
+            }
+
+            case OP_COMPARE_STRINGS: {
+                Object* r_str = (Object*)POP_ADDRESS();
+                Object* l_str = (Object*)POP_ADDRESS();
+                PUSH_INT(compareStrings(l_str, r_str));
+                break;
+            }
+
+            case OP_FIND_SUBSTRING: {
+                Object* substring = (Object*)POP_ADDRESS();
+                Object* string = (Object*)POP_ADDRESS();
+                size_t position = findSubstring(string->value, string->size, substring->value, substring->size);
+                PUSH_INT(position == STRING_NOT_FOUND ? -1 : (int32_t)position);
+                break;
+            }
+
+            case OP_FIND_BYTE: {
+                int32_t byte = POP_INT();
+                Object* string = (Object*)POP_ADDRESS();
+                if (byte < 0 || byte > UINT8_MAX) {
+                    error(vm, "Byte %d is out of range [0, %d].", byte, UINT8_MAX);
+                }
+                size_t position = findByte(string->value, string->size, (uint8_t)byte);
+                PUSH_INT(position == STRING_NOT_FOUND ? -1 : (int32_t)position);
+                break;
+            }
+
+            case OP_COUNT_SUBSTRING: {
+                Object* substring = (Object*)POP_ADDRESS();
+                Object* string = (Object*)POP_ADDRESS();
+                PUSH_INT((int32_t)countSubstring(string->value, string->size, substring->value, substring->size));
+                break;
+            }
+
+            // The pieces are made like substrings. The operands and the array
+            // stay on the stack while the pieces are allocated, so that gc
+            // finds them and updates them if they are moved.
+            case OP_SPLIT_STRING: {
+                size_t separator_position = stackSize(&vm->stack) - sizeof(size_t);
+                size_t string_position = separator_position - sizeof(size_t);
+                size_t array_position = stackSize(&vm->stack);
+
+                Object* separator = (Object*)getAddressFromStack(&vm->stack, separator_position);
+                Object* string = (Object*)getAddressFromStack(&vm->stack, string_position);
+                if (separator->size == 0) {
+                    error(vm, "Trying to split a string by an empty separator.");
+                }
+                size_t separator_size = separator->size;
+                size_t count = countSubstring(string->value, string->size, separator->value, separator_size) + 1;
+
+                Object* array = allocateEmptyObject(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    REFERENCE_RULE_REF_ARRAY,
+                    NULL,
+                    count * sizeof(size_t)
+                );
+                CHECK_ALLOCATION(array);
+                for (size_t i = 0; i < count; ++i) {
+                    ((size_t*)array->value)[i] = (size_t)&OBJECT_STRING_EMPTY;
+                }
+                PUSH_REF_ADDRESS((size_t)array);
+
+                size_t start = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    separator = (Object*)getAddressFromStack(&vm->stack, separator_position);
+                    string = (Object*)getAddressFromStack(&vm->stack, string_position);
+
+                    size_t end = string->size;
+                    if (i + 1 < count) {
+                        end = start + findSubstring(
+                            string->value + start,
+                            string->size - start,
+                            separator->value,
+                            separator_size
+                        );
+                    }
+
+                    Object* piece = makeSubstring(vm, string, start, end - start);
+                    CHECK_ALLOCATION(piece);
+                    array = (Object*)getAddressFromStack(&vm->stack, array_position);
+                    ((size_t*)array->value)[i] = (size_t)piece;
+
+                    start = end + separator_size;
+                }
+
+                popBytesFromStack(&vm->stack, 3 * sizeof(size_t));
+                CLEAN_STACK_REFERENCES();
+                PUSH_REF_ADDRESS((size_t)array);
+                break;
+            }
+
             // Cast
             case OP_CAST_FLOAT_TO_INT: PUSH_INT((int32_t)POP_FLOAT()); break;
             case OP_CAST_INT_TO_FLOAT: PUSH_FLOAT((double)POP_INT()); break;
@@ -547,27 +930,28 @@ void interpret(VM* vm) {
                 PUSH_REF_ADDRESS((size_t)(POP_BYTE() ? &OBJECT_STRING_TRUE : &OBJECT_STRING_FALSE));
                 break;
 
-#define CAST_NUMBER_TO_STRING_OP(format, value)             \
-    {                                                       \
-        char buffer[128];                                   \
-        int length = snprintf(buffer, 128, format, value);  \
-                                                            \
-        Object* object = allocateObjectFromValue(           \
-            &vm->heap,                                      \
-            &vm->stack,                                     \
-            &vm->stack_references_positions,                \
-            REFERENCE_RULE_PLAIN,                           \
-            NULL,                                           \
-            (size_t)length,                                 \
-            (uint8_t*)buffer                                \
-        );                                                  \
-        PUSH_REF_ADDRESS((size_t)object);                   \
-    }
+            // Short strings are usually interned already,
+            // so they are formatted on the stack first.
+            case OP_CAST_INT_TO_STRING: {
+                int32_t value = POP_INT();
+                uint8_t buffer[INT_STRING_MAX_LENGTH];
+                size_t length = intStringLength(value);
+                formatInt(value, buffer, length);
 
-            case OP_CAST_INT_TO_STRING:   CAST_NUMBER_TO_STRING_OP("%d", POP_INT());   break;
-            case OP_CAST_FLOAT_TO_STRING: CAST_NUMBER_TO_STRING_OP("%g", POP_FLOAT()); break;
+                Object* object = allocateString(vm, buffer, length);
+                CHECK_ALLOCATION(object);
+                PUSH_REF_ADDRESS((size_t)object);
+                break;
+            }
+            case OP_CAST_FLOAT_TO_STRING: {
+                uint8_t buffer[FLOAT_STRING_MAX_LENGTH];
+                size_t length = formatFloat(POP_FLOAT(), buffer);
 
-#undef CAST_NUMBER_TO_STRING_OP
+                Object* object = allocateString(vm, buffer, length);
+                CHECK_ALLOCATION(object);
+                PUSH_REF_ADDRESS((size_t)object);
+                break;
+            }
 
 #define GET_FROM_STACK_OP(type_name, local)                  \
     push ## type_name ## OnStack(                            \
@@ -581,22 +965,38 @@ void interpret(VM* vm) {
         )                                                    \
     )
 
-#define SET_ON_STACK_OP(type_name, local)                \
-    set ## type_name ## OnStack(                         \
-        &vm->stack,                                      \
-        (                                                \
-            (local ? vm->call_frame->stack_offset : 0) + \
-            readAddressFromSource(vm)                    \
-        ),                                               \
-        pop ## type_name ## FromStack(&vm->stack)        \
+// References are pushed with PUSH_REF_ADDRESS, so that gc finds
+// and updates the copies of the variables as well.
+#define GET_REF_FROM_STACK_OP(local)                         \
+    PUSH_REF_ADDRESS(                                        \
+        getAddressFromStack(                                 \
+            &vm->stack,                                      \
+            (                                                \
+                (local ? vm->call_frame->stack_offset : 0) + \
+                readAddressFromSource(vm)                    \
+            )                                                \
+        )                                                    \
     )
 
+#define SET_ON_STACK_OP(type_name, local)                    \
+    {                                                        \
+        set ## type_name ## OnStack(                         \
+            &vm->stack,                                      \
+            (                                                \
+                (local ? vm->call_frame->stack_offset : 0) + \
+                readAddressFromSource(vm)                    \
+            ),                                               \
+            pop ## type_name ## FromStack(&vm->stack)        \
+        );                                                   \
+        CLEAN_STACK_REFERENCES();                            \
+    }
+
             // Variables
 
             case OP_GET_LOCAL_BYTE:    GET_FROM_STACK_OP(Byte,    true); break;
             case OP_GET_LOCAL_INT:     GET_FROM_STACK_OP(Int,     true); break;
             case OP_GET_LOCAL_FLOAT:   GET_FROM_STACK_OP(Float,   true); break;
-            case OP_GET_LOCAL_ADDRESS: GET_FROM_STACK_OP(Address, true); break;
+            case OP_GET_LOCAL_ADDRESS: GET_REF_FROM_STACK_OP(true); break;
 
             case OP_SET_LOCAL_BYTE:    SET_ON_STACK_OP(Byte,    true); break;
             case OP_SET_LOCAL_INT:     SET_ON_STACK_OP(Int,     true); break;
@@ -606,7 +1006,7 @@ void interpret(VM* vm) {
             case OP_GET_GLOBAL_BYTE:    GET_FROM_STACK_OP(Byte,    false); break;
             case OP_GET_GLOBAL_INT:     GET_FROM_STACK_OP(Int,     false); break;
             case OP_GET_GLOBAL_FLOAT:   GET_FROM_STACK_OP(Float,   false); break;
-            case OP_GET_GLOBAL_ADDRESS: GET_FROM_STACK_OP(Address, false); break;
+            case OP_GET_GLOBAL_ADDRESS: GET_REF_FROM_STACK_OP(false); break;
 
             case OP_SET_GLOBAL_BYTE:    SET_ON_STACK_OP(Byte,    false); break;
             case OP_SET_GLOBAL_INT:     SET_ON_STACK_OP(Int,     false); break;
@@ -614,45 +1014,41 @@ void interpret(VM* vm) {
             case OP_SET_GLOBAL_ADDRESS: SET_ON_STACK_OP(Address, false); break;
 
 #undef SET_ON_STACK_OP
+#undef GET_REF_FROM_STACK_OP
 #undef GET_FROM_STACK_OP
 
             // Print
             case OP_PRINT_BOOL:
-                printf("%s\n", POP_BYTE() ? "true" : "false");
+                writeBool(&vm->output, POP_BYTE());
+                endOutputLine(&vm->output);
                 break;
             case OP_PRINT_INT:
-                printf("%d\n", POP_INT());
+                writeInt(&vm->output, POP_INT());
+                endOutputLine(&vm->output);
                 break;
             case OP_PRINT_FLOAT:
-                printf("%g\n", POP_FLOAT());
+                writeFloat(&vm->output, POP_FLOAT());
+                endOutputLine(&vm->output);
                 break;
             case OP_PRINT_STRING: {
                 Object* object = (Object*)POP_ADDRESS();
-                printf("%.*s\n", (int)object->size, object->value);
+                writeOutput(&vm->output, object->value, object->size);
+                endOutputLine(&vm->output);
                 break;
             }
 
             // Rea
             case OP_READ_BOOL: {
-                int chars_read = 0;
-                scanf("true%n", &chars_read);
-                if (chars_read == 4) {
-                    PUSH_BYTE(1);
-                    break;
-                }
-
-                scanf("false%n", &chars_read);
-                if (chars_read == 5) {
-                    PUSH_BYTE(0);
-                    break;
+                bool value;
+                if (!readBool(&vm->input, &value)) {
+                    error(vm, "Couldn't read a bool.");
                 }
-
-                error(vm, "Couldn't read a bool.");
+                PUSH_BYTE(value);
                 break;
             }
             case OP_READ_INT: {
                 int32_t value;
-                if (scanf("%d", &value) != 1) {
+                if (!readInt(&vm->input, &value)) {
                     error(vm, "Couldn't read an int.");
                 }
                 PUSH_INT(value);
@@ -660,41 +1056,67 @@ void interpret(VM* vm) {
             }
             case OP_READ_FLOAT: {
                 double value;
-                if (scanf("%lf", &value) != 1) {
+                if (!readFloat(&vm->input, &value)) {
                     error(vm, "Couldn't read a float.");
                 }
                 PUSH_FLOAT(value);
                 break;
             }
+            // The line is copied from the input buffer right into
+            // a string allocated at its final size.
             case OP_READ_STRING: {
-                char* value = NULL;
+                const uint8_t* line;
                 size_t length;
-                do {
-                    if (value != NULL) {
-                        free(value);
-                        value = NULL;
-                    }
-                    if (getline(&value, &length, stdin) == -1) {
-                        if (value != NULL) {
-                            free(value);
-                        }
-                        error(vm, "Couldn't read a string.");
-                    }
-                } while (length == 2);
-                length = strlen(value) - 1;
+                if (!readLine(&vm->input, &line, &length)) {
+                    error(vm, "Couldn't read a string.");
+                }
 
-                Object* object = allocateObjectFromValue(
+                Object* object = allocateString(vm, line, length);
+                CHECK_ALLOCATION(object);
+                PUSH_REF_ADDRESS((size_t)object);
+                break;
+            }
+            // All the remaining lines are read at once, so that
+            // the array is allocated once at its final size.
+            case OP_READ_LINES: {
+                readAll(&vm->input);
+                const uint8_t* input_start = vm->input.buffer + vm->input.start;
+                size_t input_size = vm->input.end - vm->input.start;
+
+                size_t count = countSubstring(input_start, input_size, (const uint8_t*)"\n", 1);
+                if (input_size > 0 && input_start[input_size - 1] != '\n') {
+                    ++count;
+                }
+
+                Object* array = allocateEmptyObject(
                     &vm->heap,
                     &vm->stack,
                     &vm->stack_references_positions,
-                    REFERENCE_RULE_PLAIN,
+                    REFERENCE_RULE_REF_ARRAY,
                     NULL,
-                    length,
-                    (uint8_t*)value
+                    count * sizeof(size_t)
                 );
-                PUSH_REF_ADDRESS((size_t)object);
+                CHECK_ALLOCATION(array);
+                for (size_t i = 0; i < count; ++i) {
+                    ((size_t*)array->value)[i] = (size_t)&OBJECT_STRING_EMPTY;
+                }
+
+                // The array stays on the stack, so that gc finds it.
+                size_t array_position = stackSize(&vm->stack);
+                PUSH_REF_ADDRESS((size_t)array);
 
-                free(value);
+                for (size_t i = 0; i < count; ++i) {
+                    const uint8_t* line;
+                    size_t length;
+                    if (!readLine(&vm->input, &line, &length)) {
+                        error(vm, "Couldn't read a string.");
+                    }
+
+                    Object* object = allocateString(vm, line, length);
+                    CHECK_ALLOCATION(object);
+                    array = (Object*)getAddressFromStack(&vm->stack, array_position);
+                    ((size_t*)array->value)[i] = (size_t)object;
+                }
                 break;
             }
 
@@ -760,7 +1182,10 @@ void interpret(VM* vm) {
                 popCallFrame(vm);
 
                 vm->ip = vm->source + return_address;
-                break;                          
+                if (vm->call_frame == return_frame) {
+                    return;
+                }
+                break;
             }
 
 #define RETURN_OP(type, pop, push)                                                \
@@ -775,6 +1200,9 @@ void interpret(VM* vm) {
                                                                                   \
         push(return_value);                                                       \
         vm->ip = vm->source + return_address;                                     \
+        if (vm->call_frame == return_frame) {                                     \
+            return;                                                               \
+        }                                                                         \
     }
 
             case OP_RETURN_BYTE:    RETURN_OP(uint8_t, POP_BYTE,    PUSH_BYTE);        break;
@@ -784,73 +1212,953 @@ void interpret(VM* vm) {
 
 #undef RETURN_OP
 
-#define SUBSCRIPT_GET_OP(type, push)                             \
-    {                                                            \
-        int32_t index = POP_INT();                               \
-        if (index < 0) {                                         \
-            error(vm, "Negative array index.");                  \
-            break;                                               \
-        }                                                        \
-        Object* array_object = (Object*)POP_ADDRESS();           \
-        if ((size_t)index + sizeof(type) > array_object->size) { \
-            error(vm, "Array index out of bounds.");             \
-            break;                                               \
-        }                                                        \
-        push(((type*)array_object->value)[index]);               \
-    }
-
-#define SUBSCRIPT_SET_OP(type, pop)                              \
-    {                                                            \
-        type value = pop();                                      \
-        int32_t index = POP_INT();                               \
-        if (index < 0) {                                         \
-            error(vm, "Negative array index.");                  \
-            break;                                               \
-        }                                                        \
-        Object* array_object = (Object*)POP_ADDRESS();           \
-        if ((size_t)index + sizeof(type) > array_object->size) { \
-            error(vm, "Array index out of bounds.");             \
-            break;                                               \
-        }                                                        \
-        ((type*)array_object->value)[index] = value;             \
+#define SUBSCRIPT_GET_OP(type, push)                              \
+    {                                                             \
+        int32_t index = POP_INT();                                \
+        if (index < 0) {                                          \
+            error(vm, "Negative array index.");                   \
+            break;                                                \
+        }                                                         \
+        Object* array_object = (Object*)POP_ADDRESS();            \
+        if ((size_t)index >= array_object->size / sizeof(type)) { \
+            error(vm, "Array index out of bounds.");              \
+            break;                                                \
+        }                                                         \
+        push(((type*)array_object->value)[index]);                \
+    }
+
+#define SUBSCRIPT_SET_OP(type, pop)                               \
+    {                                                             \
+        type value = pop();                                       \
+        int32_t index = POP_INT();                                \
+        if (index < 0) {                                          \
+            error(vm, "Negative array index.");                   \
+            break;                                                \
+        }                                                         \
+        Object* array_object = (Object*)POP_ADDRESS();            \
+        if ((size_t)index >= array_object->size / sizeof(type)) { \
+            error(vm, "Array index out of bounds.");              \
+            break;                                                \
+        }                                                         \
+        ((type*)array_object->value)[index] = value;              \
     }
 
             // Array
-            case OP_SUBSCRIPT_GET_BYTE:    SUBSCRIPT_GET_OP(uint8_t, PUSH_BYTE);        break;
+            case OP_SUBSCRIPT_GET_BIT: {
+                int32_t index = POP_INT();
+                Object* array = (Object*)POP_ADDRESS();
+                if (index < 0) {
+                    error(vm, "Negative array index.");
+                }
+                if ((size_t)index >= bitArrayLength(array)) {
+                    error(vm, "Array index out of bounds.");
+                }
+                PUSH_BYTE((array->value[index / 8] >> (index % 8)) & 1);
+                break;
+            }
+            case OP_SUBSCRIPT_GET_INT8:    SUBSCRIPT_GET_OP(int8_t,  PUSH_INT);         break;
+            case OP_SUBSCRIPT_GET_INT16:   SUBSCRIPT_GET_OP(int16_t, PUSH_INT);         break;
             case OP_SUBSCRIPT_GET_INT:     SUBSCRIPT_GET_OP(int32_t, PUSH_INT);         break;
+            case OP_SUBSCRIPT_GET_FLOAT32: SUBSCRIPT_GET_OP(float,   PUSH_FLOAT);       break;
             case OP_SUBSCRIPT_GET_FLOAT:   SUBSCRIPT_GET_OP(double,  PUSH_FLOAT);       break;
             case OP_SUBSCRIPT_GET_ADDRESS: SUBSCRIPT_GET_OP(size_t,  PUSH_REF_ADDRESS); break;
 
-            case OP_SUBSCRIPT_SET_BYTE:    SUBSCRIPT_SET_OP(uint8_t, POP_BYTE);    break;
+            case OP_SUBSCRIPT_SET_BIT: {
+                uint8_t value = POP_BYTE();
+                int32_t index = POP_INT();
+                Object* array = (Object*)POP_ADDRESS();
+                if (index < 0) {
+                    error(vm, "Negative array index.");
+                }
+                if ((size_t)index >= bitArrayLength(array)) {
+                    error(vm, "Array index out of bounds.");
+                }
+                uint8_t mask = (uint8_t)(1 << (index % 8));
+                array->value[index / 8] = (uint8_t)(value ? array->value[index / 8] | mask : array->value[index / 8] & ~mask);
+                break;
+            }
+            case OP_SUBSCRIPT_SET_INT8:    SUBSCRIPT_SET_OP(int8_t,  POP_INT8);    break;
+            case OP_SUBSCRIPT_SET_INT16:   SUBSCRIPT_SET_OP(int16_t, POP_INT16);   break;
             case OP_SUBSCRIPT_SET_INT:     SUBSCRIPT_SET_OP(int32_t, POP_INT);     break;
+            case OP_SUBSCRIPT_SET_FLOAT32: SUBSCRIPT_SET_OP(float,   POP_FLOAT32); break;
             case OP_SUBSCRIPT_SET_FLOAT:   SUBSCRIPT_SET_OP(double,  POP_FLOAT);   break;
             case OP_SUBSCRIPT_SET_ADDRESS: SUBSCRIPT_SET_OP(size_t,  POP_ADDRESS); break;
 
 #undef SUBSCRIPT_SET_OP
 #undef SUBSCRIPT_GET_OP
 
-            default: error(vm, "Invalid instruction."); break;
-        }
+// The value stays on the stack while the array grows, so that gc finds it.
+// It's a stack_type there, which is wider than the type for narrow numbers.
+#define ARRAY_PUSH_OP(type, stack_type, pop, is_reference)                                   \
+    {                                                                                        \
+        size_t array_position = stackSize(&vm->stack) - sizeof(stack_type) - sizeof(size_t); \
+        Object* array = (Object*)getAddressFromStack(&vm->stack, array_position);            \
+        if (array->size / sizeof(type) >= INT32_MAX) {                                       \
+            error(vm, "Trying to push onto an array of the maximum length.");                \
+        }                                                                                    \
+        if (is_reference) {                                                                  \
+            makeArrayOfReferences(array);                                                    \
+        }                                                                                    \
+        CHECK_ALLOCATION(reserveArray(                                                       \
+            &vm->heap,                                                                       \
+            &vm->stack,                                                                      \
+            &vm->stack_references_positions,                                                 \
+            array,                                                                           \
+            array->size + sizeof(type)                                                       \
+        ));                                                                                  \
+        type value = pop();                                                                  \
+        POP_ADDRESS();                                                                       \
+        *(type*)(array->value + array->size) = value;                                        \
+        array->size += sizeof(type);                                                         \
     }
 
-#undef POP_ADDRESS
-#undef POP_FLOAT
-#undef POP_INT
-#undef POP_BYTE
+#define ARRAY_POP_OP(type, push)                                          \
+    {                                                                     \
+        Object* array = (Object*)POP_ADDRESS();                           \
+        if (array->size < sizeof(type)) {                                 \
+            error(vm, "Trying to pop from an empty array.");              \
+        }                                                                 \
+        type value = *(type*)(array->value + array->size - sizeof(type)); \
+        truncateArray(array, array->size - sizeof(type));                 \
+        push(value);                                                      \
+    }
 
-#undef PUSH_REF_ADDRESS
-#undef PUSH_PLAIN_ADDRESS
-#undef PUSH_FLOAT
-#undef PUSH_INT
-#undef PUSH_BYTE
+            case OP_ARRAY_PUSH_BIT: {
+                size_t array_position = stackSize(&vm->stack) - sizeof(uint8_t) - sizeof(size_t);
+                Object* array = (Object*)getAddressFromStack(&vm->stack, array_position);
+                size_t length = bitArrayLength(array);
+                if (length >= INT32_MAX) {
+                    error(vm, "Trying to push onto an array of the maximum length.");
+                }
+                CHECK_ALLOCATION(reserveArray(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    array,
+                    BIT_ARRAY_SIZE(length + 1)
+                ));
+                uint8_t value = POP_BYTE();
+                POP_ADDRESS();
+                setBitArrayLength(array, length + 1);
+                array->value[length / 8] |= (uint8_t)((value != 0) << (length % 8));
+                break;
+            }
+            case OP_ARRAY_PUSH_INT8:      ARRAY_PUSH_OP(int8_t,  int32_t, POP_INT8,    false); break;
+            case OP_ARRAY_PUSH_INT16:     ARRAY_PUSH_OP(int16_t, int32_t, POP_INT16,   false); break;
+            case OP_ARRAY_PUSH_INT:       ARRAY_PUSH_OP(int32_t, int32_t, POP_INT,     false); break;
+            case OP_ARRAY_PUSH_FLOAT32:   ARRAY_PUSH_OP(float,   double,  POP_FLOAT32, false); break;
+            case OP_ARRAY_PUSH_FLOAT:     ARRAY_PUSH_OP(double,  double,  POP_FLOAT,   false); break;
+            case OP_ARRAY_PUSH_ADDRESS:   ARRAY_PUSH_OP(size_t,  size_t,  POP_ADDRESS, false); break;
+            case OP_ARRAY_PUSH_REFERENCE: ARRAY_PUSH_OP(size_t,  size_t,  POP_ADDRESS, true);  break;
+
+            case OP_ARRAY_POP_BIT: {
+                Object* array = (Object*)POP_ADDRESS();
+                size_t length = bitArrayLength(array);
+                if (length == 0) {
+                    error(vm, "Trying to pop from an empty array.");
+                }
+                uint8_t value = (array->value[(length - 1) / 8] >> ((length - 1) % 8)) & 1;
+                setBitArrayLength(array, length - 1);
+                PUSH_BYTE(value);
+                break;
+            }
+            case OP_ARRAY_POP_INT8:    ARRAY_POP_OP(int8_t,  PUSH_INT);         break;
+            case OP_ARRAY_POP_INT16:   ARRAY_POP_OP(int16_t, PUSH_INT);         break;
+            case OP_ARRAY_POP_INT:     ARRAY_POP_OP(int32_t, PUSH_INT);         break;
+            case OP_ARRAY_POP_FLOAT32: ARRAY_POP_OP(float,   PUSH_FLOAT);       break;
+            case OP_ARRAY_POP_FLOAT:   ARRAY_POP_OP(double,  PUSH_FLOAT);       break;
+            case OP_ARRAY_POP_ADDRESS: ARRAY_POP_OP(size_t,  PUSH_REF_ADDRESS); break;
+
+#undef ARRAY_POP_OP
+#undef ARRAY_PUSH_OP
+
+            case OP_ARRAY_LENGTH: {
+                size_t item_size = readByteFromSource(vm);
+                Object* array = (Object*)POP_ADDRESS();
+                PUSH_INT((int32_t)ARRAY_LENGTH(array, item_size));
+                break;
+            }
 
-    ASSERT_VM(vm);
-}
+            case OP_ARRAY_RESERVE: {
+                size_t item_size = readByteFromSource(vm);
+                int32_t length = POP_INT();
+                if (length < 0) {
+                    error(vm, "Trying to reserve space for a negative number %d of array items.", length);
+                }
+                Object* array = (Object*)getAddressFromStack(&vm->stack, stackSize(&vm->stack) - sizeof(size_t));
+                CHECK_ALLOCATION(reserveArray(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    array,
+                    item_size == 0 ? BIT_ARRAY_SIZE((size_t)length) : (size_t)length * item_size
+                ));
+                POP_ADDRESS();
+                break;
+            }
 
+            case OP_ARRAY_TRUNCATE: {
+                size_t item_size = readByteFromSource(vm);
+                int32_t length = POP_INT();
+                Object* array = (Object*)POP_ADDRESS();
+                if (length < 0 || (size_t)length > ARRAY_LENGTH(array, item_size)) {
+                    error(
+                        vm,
+                        "Trying to truncate an array of length %lu to length %d.",
+                        ARRAY_LENGTH(array, item_size),
+                        length
+                    );
+                }
+                if (item_size == 0) {
+                    setBitArrayLength(array, (size_t)length);
+                } else {
+                    truncateArray(array, (size_t)length * item_size);
+                }
+                break;
+            }
 
-// ┌─────────────────────────────────┐
-// │ Static function implementations │
-// └─────────────────────────────────┘
+            // There's no write barrier to maintain, as gc doesn't run
+            // while the items are copied, so references are moved as bytes.
+            case OP_ARRAY_COPY: {
+                size_t item_size = readByteFromSource(vm);
+                int32_t end = POP_INT();
+                int32_t start = POP_INT();
+                Object* source = (Object*)POP_ADDRESS();
+                int32_t at = POP_INT();
+                Object* destination = (Object*)POP_ADDRESS();
+                CHECK_ARRAY_RANGE(source, start, end, item_size);
+                if (at < 0 || (size_t)at + (size_t)(end - start) > ARRAY_LENGTH(destination, item_size)) {
+                    error(
+                        vm,
+                        "Trying to copy %d items to index %d of an array of length %lu.",
+                        end - start,
+                        at,
+                        ARRAY_LENGTH(destination, item_size)
+                    );
+                }
+                if (item_size == 0) {
+                    copyBits(destination, (size_t)at, source, (size_t)start, (size_t)end);
+                    break;
+                }
+                memmove(
+                    destination->value + (size_t)at * item_size,
+                    source->value + (size_t)start * item_size,
+                    (size_t)(end - start) * item_size
+                );
+                break;
+            }
+
+#define ARRAY_FILL_OP(type, pop)                            \
+    {                                                       \
+        type item = pop();                                  \
+        int32_t end = POP_INT();                            \
+        int32_t start = POP_INT();                          \
+        Object* array = (Object*)POP_ADDRESS();             \
+        CHECK_ARRAY_RANGE(array, start, end, sizeof(type)); \
+        fillArray(                                          \
+            array,                                          \
+            (size_t)start * sizeof(type),                   \
+            (size_t)end * sizeof(type),                     \
+            &item,                                          \
+            sizeof(type)                                    \
+        );                                                  \
+    }
+
+            case OP_ARRAY_FILL_BIT: {
+                uint8_t item = POP_BYTE();
+                int32_t end = POP_INT();
+                int32_t start = POP_INT();
+                Object* array = (Object*)POP_ADDRESS();
+                CHECK_ARRAY_RANGE(array, start, end, 0);
+                fillBits(array, (size_t)start, (size_t)end, item != 0);
+                break;
+            }
+            case OP_ARRAY_FILL_INT8:    ARRAY_FILL_OP(int8_t,  POP_INT8);    break;
+            case OP_ARRAY_FILL_INT16:   ARRAY_FILL_OP(int16_t, POP_INT16);   break;
+            case OP_ARRAY_FILL_INT:     ARRAY_FILL_OP(int32_t, POP_INT);     break;
+            case OP_ARRAY_FILL_FLOAT32: ARRAY_FILL_OP(float,   POP_FLOAT32); break;
+            case OP_ARRAY_FILL_FLOAT:   ARRAY_FILL_OP(double,  POP_FLOAT);   break;
+            case OP_ARRAY_FILL_ADDRESS: ARRAY_FILL_OP(size_t,  POP_ADDRESS); break;
+
+#undef ARRAY_FILL_OP
+
+            case OP_ARRAY_SLICE: {
+                size_t item_size = readByteFromSource(vm);
+                int32_t end = POP_INT();
+                int32_t start = POP_INT();
+                Object* array = (Object*)POP_ADDRESS();
+                CHECK_ARRAY_RANGE(array, start, end, item_size);
+
+                Object* slice = item_size == 0
+                    ? sliceBits(
+                        &vm->heap,
+                        &vm->stack,
+                        &vm->stack_references_positions,
+                        array,
+                        (size_t)start,
+                        (size_t)end
+                    )
+                    : sliceArray(
+                        &vm->heap,
+                        &vm->stack,
+                        &vm->stack_references_positions,
+                        array,
+                        (size_t)start * item_size,
+                        (size_t)end * item_size
+                    );
+                CHECK_ALLOCATION(slice);
+
+                PUSH_REF_ADDRESS((size_t)slice);
+                break;
+            }
+
+            case OP_ARRAY_CONCATENATE: {
+                Object* right = (Object*)POP_ADDRESS();
+                Object* left = (Object*)POP_ADDRESS();
+
+                Object* result = concatenateArrays(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    left,
+                    right
+                );
+                CHECK_ALLOCATION(result);
+
+                PUSH_REF_ADDRESS((size_t)result);
+                break;
+            }
+
+            case OP_ARRAY_CONCATENATE_BITS: {
+                Object* right = (Object*)POP_ADDRESS();
+                Object* left = (Object*)POP_ADDRESS();
+
+                Object* result = concatenateBits(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    left,
+                    right
+                );
+                CHECK_ALLOCATION(result);
+
+                PUSH_REF_ADDRESS((size_t)result);
+                break;
+            }
+
+            // Sorting doesn't allocate on the heap, so the items stay in place.
+            case OP_ARRAY_SORT_BOOL: sortBits((Object*)POP_ADDRESS()); break;
+
+            case OP_ARRAY_SORT_INT8: {
+                Object* array = (Object*)POP_ADDRESS();
+                sortInt8s((int8_t*)array->value, array->size);
+                break;
+            }
+
+            case OP_ARRAY_SORT_INT16: {
+                Object* array = (Object*)POP_ADDRESS();
+                if (!sortInt16s((int16_t*)array->value, array->size / sizeof(int16_t))) {
+                    error(vm, "Out of memory. Can't sort an array of %lu int16s.", array->size / sizeof(int16_t));
+                }
+                break;
+            }
+
+            case OP_ARRAY_SORT_INT: {
+                Object* array = (Object*)POP_ADDRESS();
+                if (!sortInts((int32_t*)array->value, array->size / sizeof(int32_t))) {
+                    error(vm, "Out of memory. Can't sort an array of %lu ints.", array->size / sizeof(int32_t));
+                }
+                break;
+            }
+
+            case OP_ARRAY_SORT_FLOAT32: {
+                Object* array = (Object*)POP_ADDRESS();
+                sortFloat32s((float*)array->value, array->size / sizeof(float));
+                break;
+            }
+
+            case OP_ARRAY_SORT_FLOAT: {
+                Object* array = (Object*)POP_ADDRESS();
+                sortFloats((double*)array->value, array->size / sizeof(double));
+                break;
+            }
+
+            case OP_ARRAY_SORT_STRING: {
+                Object* array = (Object*)POP_ADDRESS();
+                if (!sortStrings((Object**)array->value, array->size / sizeof(size_t))) {
+                    error(vm, "Out of memory. Can't sort an array of %lu strings.", array->size / sizeof(size_t));
+                }
+                break;
+            }
+
+            // The function is kept on the stack as a reference,
+            // so that it's updated if gc moves it.
+            case OP_ARRAY_SORT_BY: {
+                size_t item_size = readByteFromSource(vm);
+                bool items_are_references = readByteFromSource(vm) != 0;
+                size_t function = POP_ADDRESS();
+                size_t array_position = stackSize(&vm->stack) - sizeof(size_t);
+                PUSH_REF_ADDRESS(function);
+
+                if (item_size == 0) {
+                    sortBitsWithFunction(vm, array_position);
+                } else {
+                    sortArrayWithFunction(vm, array_position, item_size, items_are_references);
+                }
+
+                POP_ADDRESS();
+                POP_ADDRESS();
+                break;
+            }
+
+            // Bit array
+            case OP_BITS_COUNT: {
+                Object* array = (Object*)POP_ADDRESS();
+                PUSH_INT((int32_t)countBits(array));
+                break;
+            }
+            case OP_BITS_FIND: {
+                int32_t start = POP_INT();
+                Object* array = (Object*)POP_ADDRESS();
+                if (start < 0) {
+                    error(vm, "Negative array index.");
+                }
+                size_t length = bitArrayLength(array);
+                size_t index = (size_t)start < length ? findBit(array, (size_t)start) : length;
+                PUSH_INT(index < length ? (int32_t)index : -1);
+                break;
+            }
+
+#define BITS_COMBINE_OP(operation)                                   \
+    do {                                                             \
+        Object* source = (Object*)POP_ADDRESS();                     \
+        Object* destination = (Object*)POP_ADDRESS();                \
+        if (bitArrayLength(destination) != bitArrayLength(source)) { \
+            error(                                                   \
+                vm,                                                  \
+                "Trying to combine arrays of %lu and %lu bools.",    \
+                bitArrayLength(destination),                         \
+                bitArrayLength(source)                               \
+            );                                                       \
+        }                                                            \
+        combineBits(destination, source, operation);                 \
+    } while (false)
+
+            case OP_BITS_AND: BITS_COMBINE_OP(BITWISE_AND); break;
+            case OP_BITS_OR:  BITS_COMBINE_OP(BITWISE_OR);  break;
+            case OP_BITS_XOR: BITS_COMBINE_OP(BITWISE_XOR); break;
+
+#undef BITS_COMBINE_OP
+
+// The array stays on the stack while the result is allocated,
+// so that it's updated if gc moves it.
+#define ARRAY_CONVERT_OP(from_type, to_type, convert)                             \
+    {                                                                             \
+        size_t array_position = stackSize(&vm->stack) - sizeof(size_t);           \
+        Object* array = (Object*)getAddressFromStack(&vm->stack, array_position); \
+        size_t length = array->size / sizeof(from_type);                          \
+        Object* result = allocateEmptyObject(                                     \
+            &vm->heap,                                                            \
+            &vm->stack,                                                           \
+            &vm->stack_references_positions,                                      \
+            REFERENCE_RULE_PLAIN,                                                 \
+            NULL,                                                                 \
+            length * sizeof(to_type)                                              \
+        );                                                                        \
+        CHECK_ALLOCATION(result);                                                 \
+        array = (Object*)POP_ADDRESS();                                           \
+        const from_type* items = (const from_type*)array->value;                  \
+        to_type* converted_items = (to_type*)result->value;                       \
+        for (size_t i = 0; i < length; ++i) {                                     \
+            converted_items[i] = convert(items[i]);                               \
+        }                                                                         \
+        PUSH_REF_ADDRESS((size_t)result);                                         \
+    }
+
+#define WIDEN(value) (value)
+
+            // Narrow number array
+            case OP_ARRAY_NARROW_INT8:    ARRAY_CONVERT_OP(int32_t, int8_t,  NARROW_INT8);    break;
+            case OP_ARRAY_NARROW_INT16:   ARRAY_CONVERT_OP(int32_t, int16_t, NARROW_INT16);   break;
+            case OP_ARRAY_NARROW_FLOAT32: ARRAY_CONVERT_OP(double,  float,   NARROW_FLOAT32); break;
+            case OP_ARRAY_WIDEN_INT8:     ARRAY_CONVERT_OP(int8_t,  int32_t, WIDEN);          break;
+            case OP_ARRAY_WIDEN_INT16:    ARRAY_CONVERT_OP(int16_t, int32_t, WIDEN);          break;
+            case OP_ARRAY_WIDEN_FLOAT32:  ARRAY_CONVERT_OP(float,   double,  WIDEN);          break;
+
+#undef WIDEN
+#undef ARRAY_CONVERT_OP
+
+#define CHECK_SAME_LENGTHS(left_length, right_length)         \
+    if ((left_length) != (right_length)) {                    \
+        error(                                                \
+            vm,                                               \
+            "Trying to combine arrays of %lu and %lu items.", \
+            (left_length),                                    \
+            (right_length)                                    \
+        );                                                    \
+    }
+
+#define ITEMS_COMBINE_OP(type, combine, operation)                                         \
+    {                                                                                      \
+        Object* source = (Object*)POP_ADDRESS();                                           \
+        Object* destination = (Object*)POP_ADDRESS();                                      \
+        size_t length = destination->size / sizeof(type);                                  \
+        CHECK_SAME_LENGTHS(length, source->size / sizeof(type));                           \
+        combine((type*)destination->value, (const type*)source->value, length, operation); \
+    }
+
+#define ITEMS_SCALE_OP(type, pop, scale)                                \
+    {                                                                   \
+        type factor = pop();                                            \
+        Object* array = (Object*)POP_ADDRESS();                         \
+        scale((type*)array->value, array->size / sizeof(type), factor); \
+    }
+
+#define ITEMS_FMA_OP(type, multiply_add)                        \
+    {                                                           \
+        Object* right = (Object*)POP_ADDRESS();                 \
+        Object* left = (Object*)POP_ADDRESS();                  \
+        Object* destination = (Object*)POP_ADDRESS();           \
+        size_t length = destination->size / sizeof(type);       \
+        CHECK_SAME_LENGTHS(length, left->size / sizeof(type));  \
+        CHECK_SAME_LENGTHS(length, right->size / sizeof(type)); \
+        multiply_add(                                           \
+            (type*)destination->value,                          \
+            (const type*)left->value,                           \
+            (const type*)right->value,                          \
+            length                                              \
+        );                                                      \
+    }
+
+// The operands stay on the stack while the mask is allocated,
+// so that they're updated if gc moves them.
+#define ITEMS_LESS_OP(type, less)                                                                 \
+    {                                                                                             \
+        size_t right_position = stackSize(&vm->stack) - sizeof(size_t);                           \
+        Object* left = (Object*)getAddressFromStack(&vm->stack, right_position - sizeof(size_t)); \
+        Object* right = (Object*)getAddressFromStack(&vm->stack, right_position);                 \
+        size_t length = left->size / sizeof(type);                                                \
+        CHECK_SAME_LENGTHS(length, right->size / sizeof(type));                                   \
+        Object* mask = allocateBitArray(                                                          \
+            &vm->heap,                                                                            \
+            &vm->stack,                                                                           \
+            &vm->stack_references_positions,                                                      \
+            length                                                                                \
+        );                                                                                        \
+        CHECK_ALLOCATION(mask);                                                                   \
+        right = (Object*)POP_ADDRESS();                                                           \
+        left = (Object*)POP_ADDRESS();                                                            \
+        less(mask->value, (const type*)left->value, (const type*)right->value, length);           \
+        PUSH_REF_ADDRESS((size_t)mask);                                                           \
+    }
+
+#define ITEMS_SELECT_OP(type, select)                                                       \
+    {                                                                                       \
+        Object* source = (Object*)POP_ADDRESS();                                            \
+        Object* mask = (Object*)POP_ADDRESS();                                              \
+        Object* destination = (Object*)POP_ADDRESS();                                       \
+        size_t length = destination->size / sizeof(type);                                   \
+        CHECK_SAME_LENGTHS(length, bitArrayLength(mask));                                   \
+        CHECK_SAME_LENGTHS(length, source->size / sizeof(type));                            \
+        select((type*)destination->value, mask->value, (const type*)source->value, length); \
+    }
+
+#define ITEMS_SUM_OP(type, push, sum)                                     \
+    {                                                                     \
+        Object* array = (Object*)POP_ADDRESS();                           \
+        push(sum((const type*)array->value, array->size / sizeof(type))); \
+    }
+
+#define ITEMS_DOT_OP(type, push, dot)                                           \
+    {                                                                           \
+        Object* right = (Object*)POP_ADDRESS();                                 \
+        Object* left = (Object*)POP_ADDRESS();                                  \
+        size_t length = left->size / sizeof(type);                              \
+        CHECK_SAME_LENGTHS(length, right->size / sizeof(type));                 \
+        push(dot((const type*)left->value, (const type*)right->value, length)); \
+    }
+
+#define ITEMS_EXTREME_OP(type, push, extreme, name)             \
+    {                                                           \
+        Object* array = (Object*)POP_ADDRESS();                 \
+        size_t length = array->size / sizeof(type);             \
+        if (length == 0) {                                      \
+            error(                                              \
+                vm,                                             \
+                "Trying to get the " name " of an empty array." \
+            );                                                  \
+        }                                                       \
+        push(extreme((const type*)array->value, length));       \
+    }
+
+// The index of the first extreme item, -1 for an empty array.
+#define ITEMS_ARG_EXTREME_OP(type, extreme, find)                                          \
+    {                                                                                      \
+        Object* array = (Object*)POP_ADDRESS();                                            \
+        const type* items = (const type*)array->value;                                     \
+        size_t length = array->size / sizeof(type);                                        \
+        PUSH_INT(length == 0 ? -1 : (int32_t)find(items, length, extreme(items, length))); \
+    }
+
+            // Number array
+            case OP_ITEMS_ADD_INT:        ITEMS_COMBINE_OP(int32_t, combineInts,   ITEMS_ADD);      break;
+            case OP_ITEMS_ADD_FLOAT:      ITEMS_COMBINE_OP(double,  combineFloats, ITEMS_ADD);      break;
+            case OP_ITEMS_SUBTRACT_INT:   ITEMS_COMBINE_OP(int32_t, combineInts,   ITEMS_SUBTRACT); break;
+            case OP_ITEMS_SUBTRACT_FLOAT: ITEMS_COMBINE_OP(double,  combineFloats, ITEMS_SUBTRACT); break;
+            case OP_ITEMS_MULTIPLY_INT:   ITEMS_COMBINE_OP(int32_t, combineInts,   ITEMS_MULTIPLY); break;
+            case OP_ITEMS_MULTIPLY_FLOAT: ITEMS_COMBINE_OP(double,  combineFloats, ITEMS_MULTIPLY); break;
+            case OP_ITEMS_DIVIDE_INT: {
+                Object* source = (Object*)POP_ADDRESS();
+                Object* destination = (Object*)POP_ADDRESS();
+                size_t length = destination->size / sizeof(int32_t);
+                CHECK_SAME_LENGTHS(length, source->size / sizeof(int32_t));
+                if (!divideInts((int32_t*)destination->value, (const int32_t*)source->value, length)) {
+                    error(
+                        vm,
+                        "Division right operand is zero."
+                    );
+                }
+                break;
+            }
+            case OP_ITEMS_DIVIDE_FLOAT: {
+                Object* source = (Object*)POP_ADDRESS();
+                Object* destination = (Object*)POP_ADDRESS();
+                size_t length = destination->size / sizeof(double);
+                CHECK_SAME_LENGTHS(length, source->size / sizeof(double));
+                if (!divideFloats((double*)destination->value, (const double*)source->value, length, EPSILON)) {
+                    error(
+                        vm,
+                        "Division right operand is zero."
+                    );
+                }
+                break;
+            }
+            case OP_ITEMS_SCALE_INT:      ITEMS_SCALE_OP(int32_t, POP_INT,   scaleInts);            break;
+            case OP_ITEMS_SCALE_FLOAT:    ITEMS_SCALE_OP(double,  POP_FLOAT, scaleFloats);          break;
+            case OP_ITEMS_FMA_INT:        ITEMS_FMA_OP(int32_t, multiplyAddInts);                   break;
+            case OP_ITEMS_FMA_FLOAT:      ITEMS_FMA_OP(double,  multiplyAddFloats);                 break;
+            case OP_ITEMS_LESS_INT:       ITEMS_LESS_OP(int32_t, lessInts);                         break;
+            case OP_ITEMS_LESS_FLOAT:     ITEMS_LESS_OP(double,  lessFloats);                       break;
+            case OP_ITEMS_SELECT_INT:     ITEMS_SELECT_OP(int32_t, selectInts);                     break;
+            case OP_ITEMS_SELECT_FLOAT:   ITEMS_SELECT_OP(double,  selectFloats);                   break;
+            case OP_ITEMS_SUM_INT:        ITEMS_SUM_OP(int32_t, PUSH_INT,   sumInts);               break;
+            case OP_ITEMS_SUM_FLOAT:      ITEMS_SUM_OP(double,  PUSH_FLOAT, sumFloats);             break;
+            case OP_ITEMS_SUM_SATURATE_INT: {
+                Object* array = (Object*)POP_ADDRESS();
+                int64_t sum = sumIntsWide((const int32_t*)array->value, array->size / sizeof(int32_t));
+                PUSH_INT(sum > INT32_MAX ? INT32_MAX : sum < INT32_MIN ? INT32_MIN : (int32_t)sum);
+                break;
+            }
+            case OP_ITEMS_DOT_INT:        ITEMS_DOT_OP(int32_t, PUSH_INT,   dotInts);               break;
+            case OP_ITEMS_DOT_FLOAT:      ITEMS_DOT_OP(double,  PUSH_FLOAT, dotFloats);             break;
+            case OP_ITEMS_MIN_INT:        ITEMS_EXTREME_OP(int32_t, PUSH_INT,   minInts,   "min");  break;
+            case OP_ITEMS_MIN_FLOAT:      ITEMS_EXTREME_OP(double,  PUSH_FLOAT, minFloats, "min");  break;
+            case OP_ITEMS_MAX_INT:        ITEMS_EXTREME_OP(int32_t, PUSH_INT,   maxInts,   "max");  break;
+            case OP_ITEMS_MAX_FLOAT:      ITEMS_EXTREME_OP(double,  PUSH_FLOAT, maxFloats, "max");  break;
+            case OP_ITEMS_ARGMIN_INT:     ITEMS_ARG_EXTREME_OP(int32_t, minInts,   findInt);        break;
+            case OP_ITEMS_ARGMIN_FLOAT:   ITEMS_ARG_EXTREME_OP(double,  minFloats, findFloat);      break;
+            case OP_ITEMS_ARGMAX_INT:     ITEMS_ARG_EXTREME_OP(int32_t, maxInts,   findInt);        break;
+            case OP_ITEMS_ARGMAX_FLOAT:   ITEMS_ARG_EXTREME_OP(double,  maxFloats, findFloat);      break;
+
+#undef ITEMS_ARG_EXTREME_OP
+#undef ITEMS_EXTREME_OP
+#undef ITEMS_DOT_OP
+#undef ITEMS_SUM_OP
+#undef ITEMS_SELECT_OP
+#undef ITEMS_LESS_OP
+#undef ITEMS_FMA_OP
+#undef ITEMS_SCALE_OP
+#undef ITEMS_COMBINE_OP
+#undef CHECK_SAME_LENGTHS
+
+// Both indices are checked in one comparison each, as unsigned,
+// so negative ones are out of bounds too.
+#define CHECK_MATRIX_INDICES(shape, row, column)                                      \
+    if ((uint32_t)(row) >= (shape)->rows || (uint32_t)(column) >= (shape)->columns) { \
+        error(                                                                        \
+            vm,                                                                       \
+            "Matrix index [%d, %d] is out of bounds of a %ux%u matrix.",              \
+            row,                                                                      \
+            column,                                                                   \
+            (shape)->rows,                                                            \
+            (shape)->columns                                                          \
+        );                                                                            \
+    }
+
+#define SUBSCRIPT2_GET_OP(type, push)                                                       \
+    {                                                                                       \
+        int32_t column = POP_INT();                                                         \
+        int32_t row = POP_INT();                                                            \
+        Object* matrix = (Object*)POP_ADDRESS();                                            \
+        MatrixShape* shape = MATRIX_SHAPE(matrix);                                          \
+        CHECK_MATRIX_INDICES(shape, row, column);                                           \
+        push(((type*)MATRIX_ITEMS(matrix))[(size_t)row * shape->columns + (size_t)column]); \
+    }
+
+#define SUBSCRIPT2_SET_OP(type, pop)                                                          \
+    {                                                                                         \
+        type value = pop();                                                                   \
+        int32_t column = POP_INT();                                                           \
+        int32_t row = POP_INT();                                                              \
+        Object* matrix = (Object*)POP_ADDRESS();                                              \
+        MatrixShape* shape = MATRIX_SHAPE(matrix);                                            \
+        CHECK_MATRIX_INDICES(shape, row, column);                                             \
+        ((type*)MATRIX_ITEMS(matrix))[(size_t)row * shape->columns + (size_t)column] = value; \
+    }
+
+#define MATRIX_NEW_OP(type, pop)                                                                \
+    {                                                                                           \
+        type item = pop();                                                                      \
+        int32_t columns = POP_INT();                                                            \
+        int32_t rows = POP_INT();                                                               \
+        if (rows < 0 || columns < 0) {                                                          \
+            error(vm, "Trying to create a matrix with a negative shape %dx%d.", rows, columns); \
+        }                                                                                       \
+        Object* matrix = allocateMatrix(                                                        \
+            &vm->heap,                                                                          \
+            &vm->stack,                                                                         \
+            &vm->stack_references_positions,                                                    \
+            (uint32_t)rows,                                                                     \
+            (uint32_t)columns,                                                                  \
+            &item,                                                                              \
+            sizeof(type)                                                                        \
+        );                                                                                      \
+        CHECK_ALLOCATION(matrix);                                                               \
+        PUSH_REF_ADDRESS((size_t)matrix);                                                       \
+    }
+
+            // Matrix
+            case OP_SUBSCRIPT2_GET_INT8:    SUBSCRIPT2_GET_OP(int8_t,  PUSH_INT);   break;
+            case OP_SUBSCRIPT2_GET_INT16:   SUBSCRIPT2_GET_OP(int16_t, PUSH_INT);   break;
+            case OP_SUBSCRIPT2_GET_INT:     SUBSCRIPT2_GET_OP(int32_t, PUSH_INT);   break;
+            case OP_SUBSCRIPT2_GET_FLOAT32: SUBSCRIPT2_GET_OP(float,   PUSH_FLOAT); break;
+            case OP_SUBSCRIPT2_GET_FLOAT:   SUBSCRIPT2_GET_OP(double,  PUSH_FLOAT); break;
+
+            case OP_SUBSCRIPT2_SET_INT8:    SUBSCRIPT2_SET_OP(int8_t,  POP_INT8);    break;
+            case OP_SUBSCRIPT2_SET_INT16:   SUBSCRIPT2_SET_OP(int16_t, POP_INT16);   break;
+            case OP_SUBSCRIPT2_SET_INT:     SUBSCRIPT2_SET_OP(int32_t, POP_INT);     break;
+            case OP_SUBSCRIPT2_SET_FLOAT32: SUBSCRIPT2_SET_OP(float,   POP_FLOAT32); break;
+            case OP_SUBSCRIPT2_SET_FLOAT:   SUBSCRIPT2_SET_OP(double,  POP_FLOAT);   break;
+
+            case OP_MATRIX_NEW_INT:   MATRIX_NEW_OP(int32_t, POP_INT);   break;
+            case OP_MATRIX_NEW_FLOAT: MATRIX_NEW_OP(double,  POP_FLOAT); break;
+
+            case OP_MATRIX_ROWS:    PUSH_INT((int32_t)MATRIX_SHAPE((Object*)POP_ADDRESS())->rows);    break;
+            case OP_MATRIX_COLUMNS: PUSH_INT((int32_t)MATRIX_SHAPE((Object*)POP_ADDRESS())->columns); break;
+
+            case OP_ARRAY_TO_MATRIX: {
+                uint8_t item_size = readByteFromSource(vm);
+                int32_t columns = POP_INT();
+                Object* array = (Object*)POP_ADDRESS();
+                size_t length = array->size / item_size;
+                if (columns <= 0 || length % (size_t)columns != 0) {
+                    error(
+                        vm,
+                        "Can't split an array of %lu items into rows of %d items.",
+                        length,
+                        columns
+                    );
+                }
+
+                Object* matrix = arrayToMatrix(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    array,
+                    (uint32_t)columns,
+                    item_size
+                );
+                CHECK_ALLOCATION(matrix);
+
+                PUSH_REF_ADDRESS((size_t)matrix);
+                break;
+            }
+
+            case OP_MATRIX_TO_ARRAY: {
+                Object* array = matrixToArray(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    (Object*)POP_ADDRESS()
+                );
+                CHECK_ALLOCATION(array);
+
+                PUSH_REF_ADDRESS((size_t)array);
+                break;
+            }
+
+#undef MATRIX_NEW_OP
+#undef SUBSCRIPT2_SET_OP
+#undef SUBSCRIPT2_GET_OP
+#undef CHECK_MATRIX_INDICES
+
+#define PUSH_MAP_ITEM(kind, item)                                             \
+    switch (kind) {                                                           \
+        case MAP_ITEM_BOOL:      PUSH_BYTE((uint8_t)(item));           break; \
+        case MAP_ITEM_INT:       PUSH_INT((int32_t)(uint32_t)(item));  break; \
+        case MAP_ITEM_FLOAT:     PUSH_FLOAT(floatFromMapItem(item));   break; \
+        case MAP_ITEM_STRING:                                                 \
+        case MAP_ITEM_REFERENCE: PUSH_REF_ADDRESS(item);               break; \
+        default:                 assert(false);                               \
+    }
+
+            // Map
+            case OP_DEFINE_MAP: {
+                size_t count = readAddressFromSource(vm);
+                MapItemKind key_kind = readMapItemKindFromSource(vm, count == 0);
+                MapItemKind value_kind = readMapItemKindFromSource(vm, count == 0);
+                size_t key_size = count == 0 ? 0 : mapItemSize(key_kind);
+                size_t item_size = count == 0 ? 0 : key_size + mapItemSize(value_kind);
+                size_t items_position = stackSize(&vm->stack) - count * item_size;
+
+                Object* map = allocateMap(
+                    &vm->heap,
+                    &vm->stack,
+                    &vm->stack_references_positions,
+                    key_kind,
+                    value_kind,
+                    count
+                );
+                CHECK_ALLOCATION(map);
+
+                // A key repeated in the literal gets the last value.
+                for (size_t i = 0; i < count; ++i) {
+                    size_t key_position = items_position + i * item_size;
+                    MapSlot* slot = insertIntoMap(
+                        map,
+                        key_kind,
+                        value_kind,
+                        getMapItemFromStack(vm, key_kind, key_position)
+                    );
+                    assert(slot);
+                    slot->value = getMapItemFromStack(vm, value_kind, key_position + key_size);
+                }
+
+                popBytesFromStack(&vm->stack, count * item_size);
+                CLEAN_STACK_REFERENCES();
+                PUSH_REF_ADDRESS((size_t)map);
+                break;
+            }
+
+            case OP_MAP_GET: {
+                MapItemKind key_kind = readMapItemKindFromSource(vm, false);
+                MapItemKind value_kind = readMapItemKindFromSource(vm, false);
+                size_t key_position = stackSize(&vm->stack) - mapItemSize(key_kind);
+                size_t map_position = key_position - sizeof(size_t);
+
+                Object* map = (Object*)getAddressFromStack(&vm->stack, map_position);
+                MapSlot* slot = findInMap(map, getMapItemFromStack(vm, key_kind, key_position));
+                if (!slot) {
+                    error(vm, "Trying to get a value of a key that isn't in the map.");
+                }
+                size_t value = slot->value;
+
+                popBytesFromStack(&vm->stack, stackSize(&vm->stack) - map_position);
+                CLEAN_STACK_REFERENCES();
+                PUSH_MAP_ITEM(value_kind, value);
+                break;
+            }
+
+            case OP_MAP_SET: {
+                MapItemKind key_kind = readMapItemKindFromSource(vm, false);
+                MapItemKind value_kind = readMapItemKindFromSource(vm, false);
+                size_t value_position = stackSize(&vm->stack) - mapItemSize(value_kind);
+                size_t key_position = value_position - mapItemSize(key_kind);
+                size_t map_position = key_position - sizeof(size_t);
+
+                Object* map = (Object*)getAddressFromStack(&vm->stack, map_position);
+                MapSlot* slot = insertIntoMap(
+                    map,
+                    key_kind,
+                    value_kind,
+                    getMapItemFromStack(vm, key_kind, key_position)
+                );
+                if (!slot) {
+                    // The map isn't moved by growing, but the key may be.
+                    CHECK_ALLOCATION(reserveMap(
+                        &vm->heap,
+                        &vm->stack,
+                        &vm->stack_references_positions,
+                        map,
+                        1
+                    ));
+                    slot = insertIntoMap(
+                        map,
+                        key_kind,
+                        value_kind,
+                        getMapItemFromStack(vm, key_kind, key_position)
+                    );
+                    assert(slot);
+                }
+                slot->value = getMapItemFromStack(vm, value_kind, value_position);
+
+                popBytesFromStack(&vm->stack, stackSize(&vm->stack) - map_position);
+                CLEAN_STACK_REFERENCES();
+                break;
+            }
+
+            case OP_MAP_CONTAINS: {
+                MapItemKind key_kind = readMapItemKindFromSource(vm, false);
+                readMapItemKindFromSource(vm, false);
+                Object* map = (Object*)POP_ADDRESS();
+                size_t key_position = stackSize(&vm->stack) - mapItemSize(key_kind);
+
+                bool contains = findInMap(map, getMapItemFromStack(vm, key_kind, key_position)) != NULL;
+
+                popBytesFromStack(&vm->stack, mapItemSize(key_kind));
+                CLEAN_STACK_REFERENCES();
+                PUSH_BYTE(contains);
+                break;
+            }
+
+            case OP_MAP_DELETE: {
+                MapItemKind key_kind = readMapItemKindFromSource(vm, false);
+                readMapItemKindFromSource(vm, false);
+                size_t key_position = stackSize(&vm->stack) - mapItemSize(key_kind);
+                size_t map_position = key_position - sizeof(size_t);
+
+                Object* map = (Object*)getAddressFromStack(&vm->stack, map_position);
+                bool deleted = deleteFromMap(map, getMapItemFromStack(vm, key_kind, key_position));
+
+                popBytesFromStack(&vm->stack, stackSize(&vm->stack) - map_position);
+                CLEAN_STACK_REFERENCES();
+                PUSH_BYTE(deleted);
+                break;
+            }
+
+#undef PUSH_MAP_ITEM
+
+            default: error(vm, "Invalid instruction."); break;
+        }
+    }
+
+#undef CHECK_ARRAY_RANGE
+#undef ARRAY_LENGTH
+#undef CHECK_ALLOCATION
+#undef POP_FLOAT32
+#undef POP_INT16
+#undef POP_INT8
+#undef NARROW_FLOAT32
+#undef NARROW_INT16
+#undef NARROW_INT8
+#undef POP_ADDRESS
+#undef POP_FLOAT
+#undef POP_INT
+#undef POP_BYTE
+
+#undef PUSH_REF_ADDRESS
+#undef PUSH_PLAIN_ADDRESS
+#undef PUSH_FLOAT
+#undef PUSH_INT
+#undef PUSH_BYTE
+
+    ASSERT_VM(vm);
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
 
 static void pushCallFrame(VM* vm) {
     assert(vm);
@@ -932,10 +2240,340 @@ static size_t readAddressFromSource(VM* vm) {
     return value;
 }
 
+static MapItemKind readMapItemKindFromSource(VM* vm, bool allow_unknown) {
+    ASSERT_VM(vm);
+
+    uint8_t kind = readByteFromSource(vm);
+    if (kind > MAP_ITEM_REFERENCE || (kind == MAP_ITEM_UNKNOWN && !allow_unknown)) {
+        error(vm, "Invalid map item kind %u.", kind);
+    }
+    return (MapItemKind)kind;
+}
+
+static size_t getMapItemFromStack(const VM* vm, MapItemKind kind, size_t address) {
+    assert(vm);
+
+    switch (kind) {
+        case MAP_ITEM_BOOL: return getByteFromStack(&vm->stack, address);
+        case MAP_ITEM_INT:  return (uint32_t)getIntFromStack(&vm->stack, address);
+        case MAP_ITEM_FLOAT: {
+            double value = getFloatFromStack(&vm->stack, address);
+            size_t item;
+            memcpy(&item, &value, sizeof(item));
+            return item;
+        }
+        case MAP_ITEM_STRING:
+        case MAP_ITEM_REFERENCE:
+            return getAddressFromStack(&vm->stack, address);
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+static double floatFromMapItem(size_t item) {
+    double value;
+    memcpy(&value, &item, sizeof(value));
+    return value;
+}
+
+static int32_t narrowInt(VM* vm, int32_t value, int32_t min, int32_t max, const char* type_name) {
+    ASSERT_VM(vm);
+    assert(type_name);
+
+    if (value < min || value > max) {
+        error(vm, "Int %d doesn't fit into %s.", value, type_name);
+    }
+    return value;
+}
+
+static float narrowFloat(VM* vm, double value) {
+    ASSERT_VM(vm);
+
+    if (isfinite(value) && (value < -FLT_MAX || value > FLT_MAX)) {
+        error(vm, "Float %g doesn't fit into float32.", value);
+    }
+    return (float)value;
+}
+
+static Object* allocateString(VM* vm, const uint8_t* value, size_t size) {
+    ASSERT_VM(vm);
+    assert(value);
+
+    if (size <= vm->heap.config.intern_max_size) {
+        Object* interned = findInternedString(&vm->heap, value, size);
+        if (interned) {
+            return interned;
+        }
+    }
+
+    Object* string = allocateObjectFromValue(
+        &vm->heap,
+        &vm->stack,
+        &vm->stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        size,
+        value
+    );
+    if (!string) {
+        return NULL;
+    }
+    return internShortString(vm, string);
+}
+
+static Object* internShortString(VM* vm, Object* string) {
+    ASSERT_VM(vm);
+
+    if (string->size > vm->heap.config.intern_max_size) {
+        return string;
+    }
+    return internString(&vm->heap, string);
+}
+
+static Object* makeSubstring(VM* vm, Object* string, size_t start, size_t size) {
+    ASSERT_VM(vm);
+    assert(string);
+    assert(start + size <= string->size);
+
+    if (size == string->size) {
+        return string;
+    }
+    if (size == 0) {
+        return &OBJECT_STRING_EMPTY;
+    }
+    if (size <= vm->heap.config.intern_max_size) {
+        return copyString(vm, string, start, size);
+    }
+    return allocateView(
+        &vm->heap,
+        &vm->stack,
+        &vm->stack_references_positions,
+        string,
+        start,
+        size
+    );
+}
+
+static Object* copyString(VM* vm, Object* string, size_t offset, size_t size) {
+    ASSERT_VM(vm);
+    assert(string);
+    assert(offset + size <= string->size);
+
+    if (size <= vm->heap.config.intern_max_size) {
+        Object* interned = findInternedString(&vm->heap, string->value + offset, size);
+        if (interned) {
+            return interned;
+        }
+    }
+
+    // The string isn't on the stack anymore, and gc could move its value.
+    dontCollectObjectOnNextGC(&vm->heap, string);
+    Object* copy = allocateEmptyObject(
+        &vm->heap,
+        &vm->stack,
+        &vm->stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        size
+    );
+    if (!copy) {
+        return NULL;
+    }
+    memcpy(copy->value, string->value + offset, size);
+
+    return internShortString(vm, copy);
+}
+
+
+static bool callLessFunction(
+    VM* vm,
+    size_t function_position,
+    const uint8_t* a,
+    const uint8_t* b,
+    size_t item_size,
+    bool items_are_references
+) {
+    ASSERT_VM(vm);
+    assert(a);
+    assert(b);
+
+    // Lay the call frame out the way a call in the program does.
+    Object* function = (Object*)getAddressFromStack(&vm->stack, function_position);
+    size_t call_frame_start = stackSize(&vm->stack);
+    pushAddressOnStack(&vm->stack, (size_t)function);
+    pushAddressOnStack(&vm->stack, (size_t)(vm->ip - vm->source));
+    const uint8_t* items[] = { a, b };
+    for (size_t i = 0; i < 2; ++i) {
+        if (items_are_references) {
+            pushAddressOnStack(&vm->stack_references_positions, stackSize(&vm->stack));
+        }
+        switch (item_size) {
+            case sizeof(uint8_t): pushByteOnStack(&vm->stack, *items[i]); break;
+            case sizeof(int32_t): {
+                int32_t item;
+                memcpy(&item, items[i], sizeof(item));
+                pushIntOnStack(&vm->stack, item);
+                break;
+            }
+            case sizeof(size_t): {
+                size_t item;
+                memcpy(&item, items[i], sizeof(item));
+                pushAddressOnStack(&vm->stack, item);
+                break;
+            }
+            default:
+                error(vm, "Can't pass items of %lu bytes to a function.", item_size);
+        }
+    }
+
+    const CallFrame* caller_call_frame = vm->call_frame;
+    pushCallFrame(vm);
+    vm->call_frame->stack_offset = call_frame_start;
+    vm->ip = vm->source + *(size_t*)function->value;
+    run(vm, caller_call_frame);
+
+    return popByteFromStack(&vm->stack) != 0;
+}
+
+static void sortArrayWithFunction(
+    VM* vm,
+    size_t array_position,
+    size_t item_size,
+    bool items_are_references
+) {
+    ASSERT_VM(vm);
+
+    Object* array = (Object*)getAddressFromStack(&vm->stack, array_position);
+    size_t size = array->size;
+    size_t count = size / item_size;
+    if (count < 2) {
+        return;
+    }
+
+    size_t function_position = array_position + sizeof(size_t);
+    size_t buffer_position = stackSize(&vm->stack);
+    Object* buffer = allocateZeroedObject(
+        &vm->heap,
+        &vm->stack,
+        &vm->stack_references_positions,
+        items_are_references ? REFERENCE_RULE_REF_ARRAY : REFERENCE_RULE_PLAIN,
+        NULL,
+        size
+    );
+    if (!buffer) {
+        error(vm, "Out of memory. Can't allocate a buffer to sort an array of %lu items.", count);
+    }
+    pushAddressOnStack(&vm->stack_references_positions, buffer_position);
+    pushAddressOnStack(&vm->stack, (size_t)buffer);
+
+    // Errors in the function are reported at its instructions,
+    // and errors of the sort at the sort instruction.
+    uint8_t* current_op_code = vm->current_op_code;
+
+#define ITEM(position, index) \
+    (((Object*)getAddressFromStack(&vm->stack, (position)))->value + (index) * item_size)
+
+#define IS_LESS(position, a_index, b_index)                                             \
+    __extension__ ({                                                                    \
+        uint8_t a[sizeof(size_t)];                                                      \
+        uint8_t b[sizeof(size_t)];                                                      \
+        memcpy(a, ITEM(position, a_index), item_size);                                  \
+        memcpy(b, ITEM(position, b_index), item_size);                                  \
+        bool is_less = callLessFunction(                                                \
+            vm,                                                                         \
+            function_position,                                                          \
+            a,                                                                          \
+            b,                                                                          \
+            item_size,                                                                  \
+            items_are_references                                                        \
+        );                                                                              \
+        vm->current_op_code = current_op_code;                                          \
+        if (((Object*)getAddressFromStack(&vm->stack, array_position))->size != size) { \
+            error(vm, "The array was changed while it was being sorted.");              \
+        }                                                                               \
+        is_less;                                                                        \
+    })
+
+    // Runs of width items are merged from positions[0] into positions[1].
+    size_t positions[2] = { array_position, buffer_position };
+    for (size_t width = 1; width < count; width *= 2) {
+        for (size_t start = 0; start < count; start += 2 * width) {
+            size_t middle = start + width < count ? start + width : count;
+            size_t end = start + 2 * width < count ? start + 2 * width : count;
+
+            // Runs that are in order already are copied as they are.
+            size_t i = start;
+            size_t j = middle;
+            if (middle < end && IS_LESS(positions[0], middle, middle - 1)) {
+                size_t k = start;
+                while (i < middle && j < end) {
+                    if (IS_LESS(positions[0], j, i)) {
+                        memcpy(ITEM(positions[1], k), ITEM(positions[0], j), item_size);
+                        ++j;
+                    } else {
+                        memcpy(ITEM(positions[1], k), ITEM(positions[0], i), item_size);
+                        ++i;
+                    }
+                    ++k;
+                }
+                memcpy(ITEM(positions[1], k), ITEM(positions[0], i), (middle - i) * item_size);
+                k += middle - i;
+                memcpy(ITEM(positions[1], k), ITEM(positions[0], j), (end - j) * item_size);
+            } else {
+                memcpy(ITEM(positions[1], start), ITEM(positions[0], start), (end - start) * item_size);
+            }
+        }
+
+        size_t swap = positions[0];
+        positions[0] = positions[1];
+        positions[1] = swap;
+    }
+
+    if (positions[0] != array_position) {
+        memcpy(ITEM(array_position, 0), ITEM(buffer_position, 0), size);
+    }
+
+#undef IS_LESS
+#undef ITEM
+
+    popAddressFromStack(&vm->stack);
+    popAddressFromStack(&vm->stack_references_positions);
+}
+
+static void sortBitsWithFunction(VM* vm, size_t array_position) {
+    ASSERT_VM(vm);
+
+    Object* array = (Object*)getAddressFromStack(&vm->stack, array_position);
+    size_t length = bitArrayLength(array);
+    if (length < 2) {
+        return;
+    }
+
+    size_t function_position = array_position + sizeof(size_t);
+    uint8_t* current_op_code = vm->current_op_code;
+    const uint8_t values[] = { false, true };
+    bool true_is_less = callLessFunction(vm, function_position, &values[1], &values[0], 1, false);
+    bool false_is_less = callLessFunction(vm, function_position, &values[0], &values[1], 1, false);
+    vm->current_op_code = current_op_code;
+
+    array = (Object*)getAddressFromStack(&vm->stack, array_position);
+    if (bitArrayLength(array) != length) {
+        error(vm, "The array was changed while it was being sorted.");
+    }
+
+    // Equal bools stay where they are, the sort is stable.
+    if (true_is_less) {
+        size_t trues_count = countBits(array);
+        fillBits(array, 0, trues_count, true);
+        fillBits(array, trues_count, length, false);
+    } else if (false_is_less) {
+        sortBits(array);
+    }
+}
 
 #undef notImplemented
 #undef error
 
 #undef ASSERT_VM
 #undef VALIDATE_VM
-
@@ -4,7 +4,9 @@
 
 #include "constant.h"
 #include "heap.h"
+#include "input.h"
 #include "op_code.h"
+#include "output.h"
 #include "stack.h"
 
 
@@ -35,6 +37,9 @@ typedef struct {
     uint8_t* ip;
 
     Constants* constants;
+    // Immortal string objects pointing to the values of the constants,
+    // so that loading a constant doesn't allocate.
+    Object     constant_objects[MAX_CONSTANTS];
     Stack      stack;
     Heap       heap;
 
@@ -43,6 +48,11 @@ typedef struct {
     // Contains stack positions for all reference 
     // values on the stack.
     Stack stack_references_positions;
+
+    // Buffered standard input and output.
+    // The output is flushed before reading input.
+    Input  input;
+    Output output;
 } VM;
 
 
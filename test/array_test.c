@@ -0,0 +1,295 @@
+#include "cut.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "array.h"
+#include "heap_fixture.h"
+
+
+// Pushes an item the way OP_ARRAY_PUSH_INT does.
+static void pushInt(HeapFixture* fixture, Object* array, int32_t value) {
+    reserveArray(
+        &fixture->heap,
+        &fixture->stack,
+        &fixture->stack_references_positions,
+        array,
+        array->size + sizeof(int32_t)
+    );
+    *(int32_t*)(array->value + array->size) = value;
+    array->size += sizeof(int32_t);
+}
+
+
+TEST(ArrayGrowsGeometrically) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* array = allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+    pushReference(&fixture, array);
+
+    size_t buffers_count = 0;
+    Object* buffer = NULL;
+    for (int32_t i = 0; i < 100000; ++i) {
+        // Garbage after the buffer, so that it can't always grow in place.
+        if (i % 1000 == 0) {
+            allocate(&fixture, REFERENCE_RULE_PLAIN, 64);
+        }
+        pushInt(&fixture, array, i);
+        if (array->base != buffer) {
+            buffer = array->base;
+            ++buffers_count;
+        }
+    }
+
+    EXPECT(array == (Object*)getAddressFromStack(&fixture.stack, 0));
+    EXPECT(array->reference_rule == REFERENCE_RULE_VIEW);
+    EXPECT(array->size == 100000 * sizeof(int32_t));
+    EXPECT(arrayCapacity(array) >= array->size);
+    EXPECT(buffers_count <= 20);
+
+    bool all_match = true;
+    for (int32_t i = 0; i < 100000; ++i) {
+        all_match &= ((int32_t*)array->value)[i] == i;
+    }
+    EXPECT(all_match);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(ArrayBufferGrowsInPlace) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* array = allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+    pushReference(&fixture, array);
+    pushInt(&fixture, array, 1);
+
+    // The buffer is the last object allocated, so it grows
+    // without being copied until its segment is full.
+    Object* buffer = array->base;
+    size_t capacity = arrayCapacity(array);
+    reserveArray(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        array,
+        capacity + 1
+    );
+    EXPECT(array->base == buffer);
+    EXPECT(arrayCapacity(array) >= 2 * capacity);
+    EXPECT(*(int32_t*)array->value == 1);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(TruncatedReferencesAreCollected) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+    fixture.heap.config.compaction_threshold = 0;
+
+    Object* array = allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+    pushReference(&fixture, array);
+    makeArrayOfReferences(array);
+    EXPECT(array->reference_rule == REFERENCE_RULE_REF_ARRAY);
+
+    for (size_t i = 0; i < 4; ++i) {
+        reserveArray(
+            &fixture.heap,
+            &fixture.stack,
+            &fixture.stack_references_positions,
+            array,
+            array->size + sizeof(size_t)
+        );
+        Object* item = allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+        memset(item->value, (int)i, item->size);
+        *(size_t*)(array->value + array->size) = (size_t)item;
+        array->size += sizeof(size_t);
+    }
+    Object* kept = ((Object**)array->value)[1];
+
+    fixture.heap.next_gc = 0;
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+    size_t size_before = fixture.heap.size;
+
+    truncateArray(array, 2 * sizeof(size_t));
+    EXPECT(arrayCapacity(array) >= 4 * sizeof(size_t));
+    EXPECT(((size_t*)array->value)[2] == 0 && ((size_t*)array->value)[3] == 0);
+
+    // The spare capacity is traced, but the dropped items are no longer there.
+    fixture.heap.next_gc = 0;
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+    size_t item_size = (sizeof(Object) + 16 + HEAP_GRANULE_SIZE - 1) / HEAP_GRANULE_SIZE * HEAP_GRANULE_SIZE;
+    EXPECT(size_before - fixture.heap.size == 2 * item_size);
+    EXPECT(((Object**)array->value)[1] == kept);
+    EXPECT(kept->value[0] == 1);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(ArrayItemsSurviveCompaction) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+    fixture.heap.config.compaction_threshold = 1;
+
+    Object* array = allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+    pushReference(&fixture, array);
+    for (int32_t i = 0; i < 1000; ++i) {
+        allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_SEGMENT_SIZE / 256);
+        array = (Object*)getAddressFromStack(&fixture.stack, 0);
+        pushInt(&fixture, array, i);
+    }
+
+    // A new buffer with enough garbage in front of it to compact the heap.
+    fixture.heap.next_gc = SIZE_MAX;
+    for (size_t i = 0; i < 12; ++i) {
+        allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_SEGMENT_SIZE / 8);
+    }
+    array = (Object*)getAddressFromStack(&fixture.stack, 0);
+    reserveArray(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        array,
+        2 * arrayCapacity(array)
+    );
+
+    Object* buffer = array->base;
+    fixture.heap.next_gc = 0;
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+    array = (Object*)getAddressFromStack(&fixture.stack, 0);
+
+    EXPECT(array->base != buffer);
+    EXPECT(array->value == array->base->value);
+    bool all_match = true;
+    for (int32_t i = 0; i < 1000; ++i) {
+        all_match &= ((int32_t*)array->value)[i] == i;
+    }
+    EXPECT(all_match);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(FillArrayRepeatsItem) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* array = allocate(&fixture, REFERENCE_RULE_PLAIN, 1000 * sizeof(size_t));
+    memset(array->value, 0, array->size);
+
+    size_t item = 0x0123456789abcdef;
+    fillArray(array, 3 * sizeof(size_t), 997 * sizeof(size_t), &item, sizeof(size_t));
+
+    bool all_match = true;
+    for (size_t i = 0; i < 1000; ++i) {
+        all_match &= ((size_t*)array->value)[i] == (i >= 3 && i < 997 ? item : 0);
+    }
+    EXPECT(all_match);
+
+    uint8_t byte = 7;
+    fillArray(array, 0, 5, &byte, 1);
+    EXPECT(array->value[4] == 7 && array->value[5] == 0);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(SlicesAndConcatenationsOfReferencesAreTraced) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* array = allocate(&fixture, REFERENCE_RULE_REF_ARRAY, 4 * sizeof(size_t));
+    memset(array->value, 0, array->size);
+    pushReference(&fixture, array);
+    for (size_t i = 0; i < 4; ++i) {
+        Object* item = allocate(&fixture, REFERENCE_RULE_PLAIN, sizeof(int32_t));
+        *(int32_t*)item->value = (int32_t)i;
+        array = (Object*)getAddressFromStack(&fixture.stack, 0);
+        ((size_t*)array->value)[i] = (size_t)item;
+    }
+
+    // The empty operand is plain, as an empty array literal is.
+    Object* empty = allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+    pushReference(&fixture, empty);
+    array = (Object*)getAddressFromStack(&fixture.stack, 0);
+    Object* concatenation = concatenateArrays(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        empty,
+        array
+    );
+    EXPECT(concatenation->reference_rule == REFERENCE_RULE_REF_ARRAY);
+    pushReference(&fixture, concatenation);
+
+    array = (Object*)getAddressFromStack(&fixture.stack, 0);
+    Object* slice = sliceArray(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        array,
+        1 * sizeof(size_t),
+        3 * sizeof(size_t)
+    );
+    EXPECT(slice->reference_rule == REFERENCE_RULE_REF_ARRAY);
+    EXPECT(slice->size == 2 * sizeof(size_t));
+    pushReference(&fixture, slice);
+
+    // The items are reachable through the slice and the concatenation only.
+    setAddressOnStack(&fixture.stack, 0, getAddressFromStack(&fixture.stack, sizeof(size_t)));
+    fixture.heap.next_gc = 0;
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+
+    concatenation = (Object*)getAddressFromStack(&fixture.stack, 2 * sizeof(size_t));
+    slice = (Object*)getAddressFromStack(&fixture.stack, 3 * sizeof(size_t));
+    EXPECT(*(int32_t*)((Object**)slice->value)[0]->value == 1);
+    EXPECT(*(int32_t*)((Object**)slice->value)[1]->value == 2);
+    EXPECT(*(int32_t*)((Object**)concatenation->value)[3]->value == 3);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(RepeatedArraysHaveTheItemsOfTheSource) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* zero = allocate(&fixture, REFERENCE_RULE_PLAIN, sizeof(int32_t));
+    *(int32_t*)zero->value = 0;
+    Object* zeros = repeatArray(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        zero,
+        1000000
+    );
+    EXPECT(zeros->size == 1000000 * sizeof(int32_t));
+    EXPECT(((int32_t*)zeros->value)[0] == 0 && ((int32_t*)zeros->value)[999999] == 0);
+    pushReference(&fixture, zeros);
+
+    Object* pair = allocate(&fixture, REFERENCE_RULE_PLAIN, 2 * sizeof(int32_t));
+    ((int32_t*)pair->value)[0] = 1;
+    ((int32_t*)pair->value)[1] = 2;
+    Object* pairs = repeatArray(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        pair,
+        1001
+    );
+    bool all_match = pairs->size == 2002 * sizeof(int32_t);
+    for (size_t i = 0; i < 2002 && all_match; ++i) {
+        all_match &= ((int32_t*)pairs->value)[i] == (int32_t)(i % 2 + 1);
+    }
+    EXPECT(all_match);
+
+    Object* empty = repeatArray(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        pair,
+        0
+    );
+    EXPECT(empty->size == 0);
+
+    freeHeapFixture(&fixture);
+}
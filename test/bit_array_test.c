@@ -0,0 +1,224 @@
+#include "cut.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bit_array.h"
+#include "heap_fixture.h"
+
+
+#define BOOLS_COUNT 1000
+
+
+static Object* pack(HeapFixture* fixture, const uint8_t* bools, size_t length) {
+    Object* array = packBits(
+        &fixture->heap,
+        &fixture->stack,
+        &fixture->stack_references_positions,
+        bools,
+        length
+    );
+    pushReference(fixture, array);
+    return array;
+}
+
+static bool bitAt(const Object* array, size_t index) {
+    return (array->value[index / 8] >> (index % 8)) & 1;
+}
+
+static bool bitsEqualBools(const Object* array, const uint8_t* bools, size_t length) {
+    if (bitArrayLength(array) != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (bitAt(array, i) != (bools[i] != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool unusedBitsAreZero(const Object* array) {
+    return array->size == 0 || (array->value[array->size - 1] >> (8 - array->unused_bits)) == 0;
+}
+
+
+TEST(BoolsArePackedEightInAByte) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    uint8_t bools[] = { 1, 0, 1, 1, 0, 0, 0, 1, 0, 1, 0, 0, 1 };
+    Object* array = pack(&fixture, bools, 13);
+    EXPECT(array->size == 2);
+    EXPECT(array->unused_bits == 3);
+    EXPECT(array->value[0] == 0x8D && array->value[1] == 0x12);
+    EXPECT(bitsEqualBools(array, bools, 13));
+
+    // Shortening clears the bits that stop being items.
+    setBitArrayLength(array, 10);
+    EXPECT(array->size == 2 && array->unused_bits == 6);
+    EXPECT(array->value[1] == 0x02);
+    setBitArrayLength(array, 13);
+    EXPECT(bitArrayLength(array) == 13 && !bitAt(array, 12));
+
+    Object* empty = pack(&fixture, NULL, 0);
+    EXPECT(bitArrayLength(empty) == 0);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(CopiedBitsMatchBoolsCopiedOneByOne) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    uint8_t bools[BOOLS_COUNT];
+    uint8_t expected[BOOLS_COUNT];
+    srand(3);
+    for (size_t i = 0; i < BOOLS_COUNT; ++i) {
+        bools[i] = (uint8_t)(rand() % 2);
+    }
+    Object* array = pack(&fixture, bools, BOOLS_COUNT);
+    Object* other = pack(&fixture, bools, BOOLS_COUNT);
+    memcpy(expected, bools, BOOLS_COUNT);
+
+    // Overlapping ranges both ways, byte-aligned or not, within the array
+    // and into another one.
+    bool copied = true;
+    for (size_t round = 0; round < 2000; ++round) {
+        size_t start = (size_t)rand() % BOOLS_COUNT;
+        size_t at = (size_t)rand() % BOOLS_COUNT;
+        if (round % 4 == 0) {
+            start = start / 8 * 8;
+            at = at / 8 * 8;
+        }
+        size_t max_length = BOOLS_COUNT - (start > at ? start : at);
+        size_t length = (size_t)rand() % (max_length + 1);
+        Object* destination = round % 3 == 0 ? other : array;
+        uint8_t* destination_bools = round % 3 == 0 ? expected : bools;
+
+        memmove(destination_bools + at, bools + start, length);
+        copyBits(destination, at, array, start, start + length);
+        copied &= bitsEqualBools(array, bools, BOOLS_COUNT);
+        copied &= bitsEqualBools(other, expected, BOOLS_COUNT);
+    }
+    EXPECT(copied);
+    EXPECT(unusedBitsAreZero(array) && unusedBitsAreZero(other));
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(RepeatedBitsRepeatTheItems) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    uint8_t pattern[] = { 1, 0, 1 };
+    Object* array = pack(&fixture, pattern, 3);
+    Object* repeated = repeatBits(&fixture.heap, &fixture.stack, &fixture.stack_references_positions, array, 333);
+    bool repeats = bitArrayLength(repeated) == 999;
+    for (size_t i = 0; i < 999; ++i) {
+        repeats &= bitAt(repeated, i) == (pattern[i % 3] != 0);
+    }
+    EXPECT(repeats);
+    EXPECT(unusedBitsAreZero(repeated));
+
+    uint8_t all_true[] = { 1, 1 };
+    array = pack(&fixture, all_true, 2);
+    repeated = repeatBits(&fixture.heap, &fixture.stack, &fixture.stack_references_positions, array, 50);
+    EXPECT(bitArrayLength(repeated) == 100 && countBits(repeated) == 100);
+    EXPECT(unusedBitsAreZero(repeated));
+
+    uint8_t all_false[] = { 0 };
+    array = pack(&fixture, all_false, 1);
+    repeated = repeatBits(&fixture.heap, &fixture.stack, &fixture.stack_references_positions, array, 77);
+    EXPECT(bitArrayLength(repeated) == 77 && countBits(repeated) == 0);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(TrueItemsAreCountedAndFound) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    uint8_t bools[BOOLS_COUNT] = {0};
+    bools[3] = bools[64] = bools[65] = bools[700] = bools[BOOLS_COUNT - 1] = 1;
+    Object* array = pack(&fixture, bools, BOOLS_COUNT);
+
+    EXPECT(countBits(array) == 5);
+    EXPECT(findBit(array, 0) == 3);
+    EXPECT(findBit(array, 4) == 64);
+    EXPECT(findBit(array, 65) == 65);
+    EXPECT(findBit(array, 66) == 700);
+    EXPECT(findBit(array, 701) == BOOLS_COUNT - 1);
+    EXPECT(findBit(array, BOOLS_COUNT) == BOOLS_COUNT);
+
+    sortBits(array);
+    EXPECT(countBits(array) == 5 && findBit(array, 0) == BOOLS_COUNT - 5);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(BitsAreCombinedItemByItem) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    uint8_t left[BOOLS_COUNT];
+    uint8_t right[BOOLS_COUNT];
+    uint8_t expected[BOOLS_COUNT];
+    srand(4);
+    for (size_t i = 0; i < BOOLS_COUNT; ++i) {
+        left[i] = (uint8_t)(rand() % 2);
+        right[i] = (uint8_t)(rand() % 2);
+    }
+    Object* right_array = pack(&fixture, right, BOOLS_COUNT);
+
+    Object* array = pack(&fixture, left, BOOLS_COUNT);
+    combineBits(array, right_array, BITWISE_AND);
+    for (size_t i = 0; i < BOOLS_COUNT; ++i) {
+        expected[i] = left[i] & right[i];
+    }
+    EXPECT(bitsEqualBools(array, expected, BOOLS_COUNT));
+
+    array = pack(&fixture, left, BOOLS_COUNT);
+    combineBits(array, right_array, BITWISE_OR);
+    for (size_t i = 0; i < BOOLS_COUNT; ++i) {
+        expected[i] = left[i] | right[i];
+    }
+    EXPECT(bitsEqualBools(array, expected, BOOLS_COUNT));
+
+    array = pack(&fixture, left, BOOLS_COUNT);
+    combineBits(array, right_array, BITWISE_XOR);
+    for (size_t i = 0; i < BOOLS_COUNT; ++i) {
+        expected[i] = left[i] ^ right[i];
+    }
+    EXPECT(bitsEqualBools(array, expected, BOOLS_COUNT));
+    EXPECT(unusedBitsAreZero(array));
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(FillingSetsOnlyTheRange) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    uint8_t bools[100] = {0};
+    Object* array = pack(&fixture, bools, 100);
+
+    // Within a byte, across bytes, up to the end and an empty range.
+    size_t ranges[][2] = { { 2, 5 }, { 7, 9 }, { 13, 40 }, { 95, 100 }, { 50, 50 } };
+    bool filled = true;
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r) {
+        fillBits(array, ranges[r][0], ranges[r][1], true);
+        memset(bools + ranges[r][0], 1, ranges[r][1] - ranges[r][0]);
+        filled &= bitsEqualBools(array, bools, 100);
+    }
+    EXPECT(filled);
+    EXPECT(countBits(array) == 3 + 2 + 27 + 5);
+    EXPECT(unusedBitsAreZero(array));
+
+    fillBits(array, 0, 100, false);
+    EXPECT(countBits(array) == 0);
+
+    freeHeapFixture(&fixture);
+}
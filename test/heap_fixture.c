@@ -0,0 +1,34 @@
+#include "heap_fixture.h"
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+void initHeapFixture(HeapFixture* fixture) {
+    initHeap(&fixture->heap);
+    initStack(&fixture->stack);
+    initStack(&fixture->stack_references_positions);
+}
+
+void freeHeapFixture(HeapFixture* fixture) {
+    freeHeap(&fixture->heap);
+    freeStack(&fixture->stack);
+    freeStack(&fixture->stack_references_positions);
+}
+
+Object* allocate(HeapFixture* fixture, ReferenceRule reference_rule, size_t size) {
+    return allocateEmptyObject(
+        &fixture->heap,
+        &fixture->stack,
+        &fixture->stack_references_positions,
+        reference_rule,
+        NULL,
+        size
+    );
+}
+
+void pushReference(HeapFixture* fixture, Object* object) {
+    pushAddressOnStack(&fixture->stack_references_positions, stackSize(&fixture->stack));
+    pushAddressOnStack(&fixture->stack, (size_t)object);
+}
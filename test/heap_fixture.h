@@ -0,0 +1,36 @@
+#ifndef lala_heap_fixture_h
+#define lala_heap_fixture_h
+
+
+#include <stddef.h>
+
+#include "heap.h"
+#include "stack.h"
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+// A heap with the stacks gc reads the references from, for the tests
+// of the modules that allocate on the heap.
+typedef struct {
+    Heap  heap;
+    Stack stack;
+    Stack stack_references_positions;
+} HeapFixture;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+void initHeapFixture(HeapFixture* fixture);
+void freeHeapFixture(HeapFixture* fixture);
+
+Object* allocate(HeapFixture* fixture, ReferenceRule reference_rule, size_t size);
+// Pushes the object onto the stack as a reference, so that gc keeps it.
+void pushReference(HeapFixture* fixture, Object* object);
+
+
+#endif
@@ -0,0 +1,544 @@
+#include "cut.h"
+
+#include <string.h>
+
+#include "heap.h"
+#include "heap_fixture.h"
+
+
+static void forceGCOnNextAllocation(HeapFixture* fixture) {
+    fixture->heap.next_gc = 0;
+}
+
+
+TEST(SweepIsLazy) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+    fixture.heap.config.compaction_threshold = 0;
+
+    // Fill several segments with every other object reachable.
+    for (size_t i = 0; i < 1024; ++i) {
+        Object* object = allocate(&fixture, REFERENCE_RULE_PLAIN, 1000);
+        if (i % 2 == 0) {
+            pushReference(&fixture, object);
+        }
+    }
+
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 1000);
+
+    // The allocation only swept the first segment.
+    EXPECT(fixture.heap.sweeping);
+    EXPECT(fixture.heap.sweep_cursor != NULL);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(DeadObjectSpaceIsReused) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+    fixture.heap.config.compaction_threshold = 0;
+
+    Object* dead = allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+    pushReference(&fixture, allocate(&fixture, REFERENCE_RULE_PLAIN, 16));
+
+    forceGCOnNextAllocation(&fixture);
+    Object* reused = allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+
+    EXPECT(reused == dead);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(EmptySegmentsAreReleased) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    for (size_t i = 0; i < 16; ++i) {
+        allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE / 2);
+    }
+    EXPECT(fixture.heap.segments->next != NULL);
+
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+
+    EXPECT(!fixture.heap.sweeping);
+    EXPECT(fixture.heap.segments->next == NULL);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(LargeObjectsAreAllocatedSeparately) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* dead = allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE);
+    Object* live = allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE);
+    memset(live->value, 0xAB, live->size);
+    pushReference(&fixture, live);
+
+    EXPECT(fixture.heap.segments == NULL);
+    EXPECT(fixture.heap.large_objects != NULL);
+    EXPECT(fixture.heap.large_objects->next != NULL);
+
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+
+    // The dead object's mapping is released right away,
+    // and the live one isn't moved.
+    EXPECT(fixture.heap.large_objects->next == NULL);
+    EXPECT(fixture.heap.large_objects->large);
+    EXPECT((Object*)getAddressFromStack(&fixture.stack, 0) == live);
+    EXPECT(live->value[0] == 0xAB && live->value[live->size - 1] == 0xAB);
+
+    // A mapping of a similar size is reused.
+    EXPECT(allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE) == dead);
+    EXPECT(dead->value[0] == 0);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(ZeroedObjectsAreZeroedInReusedMemory) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* small = allocate(&fixture, REFERENCE_RULE_PLAIN, 1000);
+    Object* large = allocate(&fixture, REFERENCE_RULE_PLAIN, 4 * HEAP_LARGE_OBJECT_SIZE);
+    memset(small->value, 0xAB, small->size);
+    memset(large->value, 0xAB, large->size);
+
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+
+    // The cached mapping of the dead large object is reused.
+    small = allocateZeroedObject(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        1000
+    );
+    Object* zeroed = allocateZeroedObject(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        4 * HEAP_LARGE_OBJECT_SIZE - 100
+    );
+    EXPECT(zeroed == large);
+
+    bool all_zero = true;
+    for (size_t i = 0; i < small->size; ++i) {
+        all_zero &= small->value[i] == 0;
+    }
+    for (size_t i = 0; i < zeroed->size; ++i) {
+        all_zero &= zeroed->value[i] == 0;
+    }
+    EXPECT(all_zero);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(ReachableObjectsSurviveGC) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* string = allocate(&fixture, REFERENCE_RULE_PLAIN, 4);
+    memcpy(string->value, "lala", 4);
+
+    Object* array = allocate(&fixture, REFERENCE_RULE_REF_ARRAY, sizeof(size_t));
+    *(size_t*)array->value = (size_t)string;
+    pushReference(&fixture, array);
+
+    // Marks are kept aside, so collection doesn't write to the objects.
+    Object string_copy = *string;
+    Object array_copy  = *array;
+
+    for (size_t i = 0; i < 256; ++i) {
+        forceGCOnNextAllocation(&fixture);
+        allocate(&fixture, REFERENCE_RULE_PLAIN, 4);
+    }
+
+    EXPECT(memcmp(string, &string_copy, sizeof(Object)) == 0);
+    EXPECT(memcmp(array,  &array_copy,  sizeof(Object)) == 0);
+    EXPECT(*(size_t*)array->value == (size_t)string);
+    EXPECT(memcmp(string->value, "lala", 4) == 0);
+    EXPECT(fixture.heap.size < 16 * HEAP_GRANULE_SIZE);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(PinnedObjectSurvivesNextGC) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* pinned = allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+
+    dontCollectObjectOnNextGC(&fixture.heap, pinned);
+    forceGCOnNextAllocation(&fixture);
+    Object* object = allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+
+    EXPECT(object != pinned);
+    EXPECT(fixture.heap.pinned_count == 0);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(CompactionMovesObjectsAndUpdatesReferences) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+    fixture.heap.config.compaction_threshold = 1;
+
+    Object* rule = allocate(&fixture, REFERENCE_RULE_PLAIN, sizeof(size_t));
+    *(size_t*)rule->value = 0;
+
+    // Leave garbage in front of every reachable object.
+    Object* objects[8];
+    for (size_t i = 0; i < 8; ++i) {
+        allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE / 2);
+        objects[i] = allocate(&fixture, REFERENCE_RULE_PLAIN, sizeof(int32_t));
+        *(int32_t*)objects[i]->value = (int32_t)i;
+    }
+
+    // Large objects aren't moved, but the references in them are updated.
+    Object* array = allocate(&fixture, REFERENCE_RULE_REF_ARRAY, HEAP_LARGE_OBJECT_SIZE);
+    memset(array->value, 0, array->size);
+    for (size_t i = 4; i < array->size / sizeof(size_t); ++i) {
+        ((size_t*)array->value)[i] = (size_t)objects[6];
+    }
+    Object* structure = allocateEmptyObject(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        REFERENCE_RULE_CUSTOM,
+        rule,
+        sizeof(size_t)
+    );
+    for (size_t i = 0; i < 4; ++i) {
+        ((size_t*)array->value)[i] = (size_t)objects[i];
+    }
+    *(size_t*)structure->value = (size_t)objects[4];
+    pushReference(&fixture, array);
+    pushReference(&fixture, structure);
+    pushReference(&fixture, objects[5]);
+
+    Segment* segments = fixture.heap.segments;
+    size_t segments_count = 0;
+    for (Segment* segment = segments; segment != NULL; segment = segment->next) {
+        ++segments_count;
+    }
+
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+
+    array     = (Object*)getAddressFromStack(&fixture.stack, 0);
+    structure = (Object*)getAddressFromStack(&fixture.stack, sizeof(size_t));
+    Object* root = (Object*)getAddressFromStack(&fixture.stack, 2 * sizeof(size_t));
+
+    for (size_t i = 0; i < 4; ++i) {
+        Object* item = (Object*)((size_t*)array->value)[i];
+        EXPECT(*(int32_t*)item->value == (int32_t)i);
+        EXPECT(item->value == (uint8_t*)(item + 1));
+    }
+    for (size_t i = 4; i < array->size / sizeof(size_t); ++i) {
+        Object* item = (Object*)((size_t*)array->value)[i];
+        EXPECT(*(int32_t*)item->value == 6);
+    }
+    Object* field = (Object*)*(size_t*)structure->value;
+    EXPECT(*(int32_t*)field->value == 4);
+    EXPECT(*(size_t*)structure->custom_reference_rule->value == 0);
+    EXPECT(*(int32_t*)root->value == 5);
+
+    EXPECT(root != objects[5]);
+
+    size_t compacted_segments_count = 0;
+    for (Segment* segment = fixture.heap.segments; segment != NULL; segment = segment->next) {
+        ++compacted_segments_count;
+    }
+    EXPECT(compacted_segments_count < segments_count);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(CompactionDoesntMovePinnedObjects) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+    fixture.heap.config.compaction_threshold = 1;
+
+    Object* objects[8];
+    for (size_t i = 0; i < 8; ++i) {
+        allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE / 2);
+        objects[i] = allocate(&fixture, REFERENCE_RULE_PLAIN, sizeof(int32_t));
+        *(int32_t*)objects[i]->value = (int32_t)i;
+        pushReference(&fixture, objects[i]);
+    }
+
+    dontCollectObjectOnNextGC(&fixture.heap, objects[3]);
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+
+    EXPECT((Object*)getAddressFromStack(&fixture.stack, 3 * sizeof(size_t)) == objects[3]);
+    for (size_t i = 0; i < 8; ++i) {
+        Object* object = (Object*)getAddressFromStack(&fixture.stack, i * sizeof(size_t));
+        EXPECT(*(int32_t*)object->value == (int32_t)i);
+    }
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(RepeatedConcatenationAppendsInPlace) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* piece = allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+    memset(piece->value, 'a', piece->size);
+    pushReference(&fixture, piece);
+    pushReference(&fixture, piece);
+
+    size_t buffers_count = 0;
+    Object* buffer = NULL;
+    for (size_t i = 0; i < 1000; ++i) {
+        Object* string = (Object*)getAddressFromStack(&fixture.stack, sizeof(size_t));
+        piece = (Object*)getAddressFromStack(&fixture.stack, 0);
+        string = concatenateStrings(
+            &fixture.heap,
+            &fixture.stack,
+            &fixture.stack_references_positions,
+            string,
+            piece
+        );
+        setAddressOnStack(&fixture.stack, sizeof(size_t), (size_t)string);
+
+        if (string->reference_rule == REFERENCE_RULE_VIEW && string->base != buffer) {
+            buffer = string->base;
+            ++buffers_count;
+        }
+    }
+
+    Object* string = (Object*)getAddressFromStack(&fixture.stack, sizeof(size_t));
+    EXPECT(string->size == 1001 * 16);
+    EXPECT(string->value[0] == 'a' && string->value[string->size - 1] == 'a');
+    EXPECT(buffers_count <= 16);
+
+    // Strings stay immutable when concatenated to more than once.
+    Object* left = string;
+    dontCollectObjectOnNextGC(&fixture.heap, left);
+    Object* first = concatenateStrings(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        left,
+        &OBJECT_STRING_TRUE
+    );
+    pushReference(&fixture, first);
+    Object* second = concatenateStrings(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        left,
+        &OBJECT_STRING_FALSE
+    );
+    EXPECT(memcmp(first->value + left->size, "true", 4) == 0);
+    EXPECT(memcmp(second->value + left->size, "false", 5) == 0);
+    EXPECT(first->value != second->value);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(LastAllocatedObjectGrowsInPlace) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* first = allocate(&fixture, REFERENCE_RULE_PLAIN, 100);
+    Object* last = allocate(&fixture, REFERENCE_RULE_PLAIN, 100);
+    size_t heap_size = fixture.heap.size;
+
+    EXPECT(!growObjectInPlace(&fixture.heap, first, 200));
+    EXPECT(first->size == 100);
+
+    EXPECT(growObjectInPlace(&fixture.heap, last, 1000));
+    EXPECT(last->size == 1000);
+    EXPECT(fixture.heap.size > heap_size);
+
+    // The next object is allocated after the grown one.
+    Object* next = allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+    EXPECT((uint8_t*)next >= last->value + last->size);
+    EXPECT(!growObjectInPlace(&fixture.heap, last, 2000));
+
+    // Small objects don't grow into large ones.
+    EXPECT(!growObjectInPlace(&fixture.heap, next, HEAP_LARGE_OBJECT_SIZE));
+
+    // A large object grows within the pages of its mapping.
+    Object* large = allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE + 1);
+    EXPECT(growObjectInPlace(&fixture.heap, large, HEAP_LARGE_OBJECT_SIZE + 2));
+    EXPECT(!growObjectInPlace(&fixture.heap, large, 2 * HEAP_LARGE_OBJECT_SIZE));
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(CompactionUpdatesViews) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+    fixture.heap.config.compaction_threshold = 1;
+
+    allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE / 2);
+    Object* base = allocate(&fixture, REFERENCE_RULE_PLAIN, 128);
+    for (size_t i = 0; i < base->size; ++i) {
+        base->value[i] = (uint8_t)i;
+    }
+    for (size_t i = 0; i < 8; ++i) {
+        allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE / 2);
+    }
+    Object* view = allocateView(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        base,
+        32,
+        64
+    );
+    pushReference(&fixture, view);
+
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+
+    Object* moved = (Object*)getAddressFromStack(&fixture.stack, 0);
+    EXPECT(moved != view);
+    EXPECT(moved->base != base);
+    EXPECT(moved->value == moved->base->value + 32);
+    EXPECT(moved->size == 64);
+    for (size_t i = 0; i < moved->size; ++i) {
+        EXPECT(moved->value[i] == (uint8_t)(32 + i));
+    }
+
+    freeHeapFixture(&fixture);
+}
+
+static Object* allocateString(HeapFixture* fixture, const char* value) {
+    return allocateObjectFromValue(
+        &fixture->heap,
+        &fixture->stack,
+        &fixture->stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        strlen(value),
+        (const uint8_t*)value
+    );
+}
+
+TEST(InternedStringsAreShared) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* first = internString(&fixture.heap, allocateString(&fixture, "lala"));
+    Object* second = allocateString(&fixture, "lala");
+    Object* other = internString(&fixture.heap, allocateString(&fixture, "papa"));
+
+    EXPECT(first->interned);
+    EXPECT(!second->interned);
+    EXPECT(internString(&fixture.heap, second) == first);
+    EXPECT(findInternedString(&fixture.heap, (const uint8_t*)"lala", 4) == first);
+    EXPECT(findInternedString(&fixture.heap, (const uint8_t*)"lal", 3) == NULL);
+
+    EXPECT(stringsEqual(first, second));
+    EXPECT(!stringsEqual(first, other));
+    EXPECT(stringHash(first) == stringHash(second));
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(GCRemovesDeadInternedStringsAndUpdatesMovedOnes) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+    fixture.heap.config.compaction_threshold = 1;
+
+    allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE / 2);
+    internString(&fixture.heap, allocateString(&fixture, "dead"));
+    Object* alive = internString(&fixture.heap, allocateString(&fixture, "alive"));
+    pushReference(&fixture, alive);
+    for (size_t i = 0; i < 8; ++i) {
+        allocate(&fixture, REFERENCE_RULE_PLAIN, HEAP_LARGE_OBJECT_SIZE / 2);
+    }
+
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 0);
+
+    Object* moved = (Object*)getAddressFromStack(&fixture.stack, 0);
+    EXPECT(moved != alive);
+    EXPECT(moved->interned);
+    EXPECT(findInternedString(&fixture.heap, (const uint8_t*)"alive", 5) == moved);
+    EXPECT(findInternedString(&fixture.heap, (const uint8_t*)"dead", 4) == NULL);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(AllocationFailsWhenHeapLimitIsExceeded) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    HeapConfig config;
+    initHeapConfig(&config);
+    config.limit = 64 * 1024;
+    setHeapConfig(&fixture.heap, &config);
+
+    // Garbage is collected to fit into the limit.
+    for (size_t i = 0; i < 64; ++i) {
+        EXPECT(allocate(&fixture, REFERENCE_RULE_PLAIN, 16 * 1024) != NULL);
+    }
+
+    Object* object;
+    size_t reachable_size = 0;
+    while ((object = allocate(&fixture, REFERENCE_RULE_PLAIN, 16 * 1024)) != NULL) {
+        pushReference(&fixture, object);
+        reachable_size += 16 * 1024;
+    }
+    EXPECT(reachable_size > 0);
+    EXPECT(reachable_size <= config.limit);
+    EXPECT(fixture.heap.size <= config.limit);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(GCThresholdIsBoundedByHeapMinAndMax) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    HeapConfig config;
+    initHeapConfig(&config);
+    config.initial_threshold = 0;
+    config.min_size = 4096;
+    config.max_size = 8192;
+    setHeapConfig(&fixture.heap, &config);
+
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+    EXPECT(fixture.heap.next_gc == 4096);
+
+    for (size_t i = 0; i < 16; ++i) {
+        pushReference(&fixture, allocate(&fixture, REFERENCE_RULE_PLAIN, 1024));
+    }
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+    EXPECT(fixture.heap.next_gc == 8192);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(GCThresholdIsClampedToTheLargestSize) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    HeapConfig config;
+    initHeapConfig(&config);
+    config.initial_threshold = 0;
+    config.growth_factor = 1e300;
+    setHeapConfig(&fixture.heap, &config);
+
+    pushReference(&fixture, allocate(&fixture, REFERENCE_RULE_PLAIN, 16));
+    forceGCOnNextAllocation(&fixture);
+    allocate(&fixture, REFERENCE_RULE_PLAIN, 16);
+    EXPECT(fixture.heap.next_gc == SIZE_MAX);
+
+    freeHeapFixture(&fixture);
+}
@@ -0,0 +1,204 @@
+#include "cut.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "input.h"
+
+
+// Writes data to a temporary file and opens an input reading it.
+static FILE* createInput(Input* input, const char* data, size_t size) {
+    FILE* file = tmpfile();
+    fwrite(data, 1, size, file);
+    fflush(file);
+    rewind(file);
+    initInput(input, fileno(file));
+    return file;
+}
+
+#define EXPECT_LINE(input, expected)                                                \
+    {                                                                               \
+        const uint8_t* line;                                                        \
+        size_t length;                                                              \
+        EXPECT(readLine(input, &line, &length));                                    \
+        EXPECT(length == strlen(expected) && memcmp(line, expected, length) == 0);  \
+    }
+
+
+TEST(InputReadsLinesAndValues) {
+    const char data[] = "first line\n\n  -42 0.5\ntrue false\nlast";
+
+    Input input;
+    FILE* file = createInput(&input, data, sizeof(data) - 1);
+
+    EXPECT_LINE(&input, "first line");
+    EXPECT_LINE(&input, "");
+
+    int32_t int_value;
+    double float_value;
+    EXPECT(readInt(&input, &int_value) && int_value == -42);
+    EXPECT(readFloat(&input, &float_value) && fabs(float_value - 0.5) < 1e-12);
+    EXPECT_LINE(&input, "");
+
+    bool bool_value;
+    EXPECT(readBool(&input, &bool_value) && bool_value);
+    EXPECT(readBool(&input, &bool_value) && !bool_value);
+    EXPECT_LINE(&input, "");
+    EXPECT_FALSE(readInt(&input, &int_value));
+    EXPECT_LINE(&input, "last");
+
+    const uint8_t* line;
+    size_t length;
+    EXPECT_FALSE(readLine(&input, &line, &length));
+    EXPECT_FALSE(readBool(&input, &bool_value));
+
+    freeInput(&input);
+    fclose(file);
+}
+
+TEST(InputReadsLinesLongerThanBlock) {
+    size_t size = INPUT_BLOCK_SIZE * 3 + 100;
+    char* data = malloc(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = (char)('a' + i % 26);
+    }
+    data[10] = '\n';
+    data[INPUT_BLOCK_SIZE * 2 + 7] = '\n';
+    data[size - 1] = '\n';
+
+    Input input;
+    FILE* file = createInput(&input, data, size);
+
+    const uint8_t* line;
+    size_t length;
+    EXPECT(readLine(&input, &line, &length) && length == 10);
+    EXPECT(readLine(&input, &line, &length) && length == INPUT_BLOCK_SIZE * 2 - 4);
+    EXPECT(memcmp(line, data + 11, length) == 0);
+    EXPECT(readLine(&input, &line, &length) && length == size - INPUT_BLOCK_SIZE * 2 - 9);
+    EXPECT(memcmp(line, data + INPUT_BLOCK_SIZE * 2 + 8, length) == 0);
+    EXPECT_FALSE(readLine(&input, &line, &length));
+
+    freeInput(&input);
+    fclose(file);
+    free(data);
+}
+
+TEST(InputParsesFloatsLikeStrtod) {
+    // One per line, so that the rest strtod doesn't parse, like "e" in "1e",
+    // can be checked with readLine.
+    const char* tokens[] = {
+        "0", "-0", "+7", ".5", "5.", "-.25", "1e3", "1E-3", "2.5e+2", "1e", "3e-",
+        "0.1", "123456.789", "9007199254740993", "12345678901234567890123",
+        "1e22", "1e23", "4.9e-324", "1e400", "0.000000000000000000000000001",
+        "inf", "-Infinity", "nan", "0x1p3", "-0x.8",
+    };
+    size_t tokens_count = sizeof(tokens) / sizeof(tokens[0]);
+
+    // Random values cover the rounding of the fast path.
+    size_t random_count = 10000;
+    char* data = malloc(tokens_count * 32 + random_count * 32);
+    size_t size = 0;
+    for (size_t i = 0; i < tokens_count; ++i) {
+        size += (size_t)sprintf(data + size, "%s\n", tokens[i]);
+    }
+    size_t random_start = size;
+    srand(1);
+    for (size_t i = 0; i < random_count; ++i) {
+        double random = (double)(rand() % 2000000 - 1000000) / (double)(rand() % 1000 + 1);
+        const char* format = i % 3 == 0 ? "%.17g " : i % 3 == 1 ? "%.6f " : "%.3e ";
+        size += (size_t)sprintf(data + size, format, random);
+    }
+
+    Input input;
+    FILE* file = createInput(&input, data, size);
+
+    for (size_t i = 0; i < tokens_count; ++i) {
+        char* token_end;
+        double expected = strtod(tokens[i], &token_end);
+
+        double value;
+        EXPECT(readFloat(&input, &value));
+        EXPECT(memcmp(&value, &expected, sizeof(double)) == 0 || (isnan(value) && isnan(expected)));
+        EXPECT_LINE(&input, token_end);
+    }
+
+    bool all_match = true;
+    char* token = data + random_start;
+    for (size_t i = 0; i < random_count; ++i) {
+        double expected = strtod(token, &token);
+        double value;
+        all_match = all_match && readFloat(&input, &value) && memcmp(&value, &expected, sizeof(double)) == 0;
+    }
+    EXPECT(all_match);
+
+    double value;
+    EXPECT_FALSE(readFloat(&input, &value));
+
+    freeInput(&input);
+    fclose(file);
+    free(data);
+}
+
+TEST(InputParsesLongFloatTokens) {
+    // Longer than a block, and starting near the end of the first one.
+    size_t digits_count = INPUT_BLOCK_SIZE + 100;
+    size_t padding = INPUT_BLOCK_SIZE - 10;
+    char* data = malloc(padding + digits_count + 32);
+    memset(data, ' ', padding);
+    size_t size = padding;
+    data[size++] = '1';
+    memset(data + size, '0', digits_count);
+    size += digits_count;
+    size += (size_t)sprintf(data + size, "1e-%zu 2.5\n", digits_count);
+
+    Input input;
+    FILE* file = createInput(&input, data, size);
+
+    double expected = strtod(data, NULL);
+    double value;
+    EXPECT(readFloat(&input, &value) && memcmp(&value, &expected, sizeof(double)) == 0);
+    EXPECT(readFloat(&input, &value) && value > 2.4 && value < 2.6);
+    EXPECT_FALSE(readFloat(&input, &value));
+
+    freeInput(&input);
+    fclose(file);
+    free(data);
+}
+
+TEST(InputParsesIntsAcrossBlocks) {
+    size_t values_count = INPUT_BLOCK_SIZE;
+    char* data = malloc(values_count * 16);
+    size_t size = 0;
+    srand(1);
+    for (size_t i = 0; i < values_count; ++i) {
+        int32_t value = (int32_t)((uint32_t)rand() << 1) / (int32_t)(i % 1000 + 1);
+        size += (size_t)sprintf(data + size, i % 2 == 0 ? "%d " : "%+d\n", value);
+    }
+
+    Input input;
+    FILE* file = createInput(&input, data, size);
+
+    bool all_match = true;
+    char* token = data;
+    for (size_t i = 0; i < values_count; ++i) {
+        int32_t value;
+        all_match = all_match && readInt(&input, &value) && value == (int32_t)strtol(token, &token, 10);
+    }
+    EXPECT(all_match);
+
+    int32_t value;
+    EXPECT_FALSE(readInt(&input, &value));
+    freeInput(&input);
+    fclose(file);
+
+    // Overflowing values wrap around, and a sign alone isn't an int.
+    const char wrapping[] = "2147483648 -2147483649 - 5";
+    file = createInput(&input, wrapping, sizeof(wrapping) - 1);
+    EXPECT(readInt(&input, &value) && value == INT32_MIN);
+    EXPECT(readInt(&input, &value) && value == INT32_MAX);
+    EXPECT_FALSE(readInt(&input, &value));
+
+    freeInput(&input);
+    fclose(file);
+    free(data);
+}
@@ -93,6 +93,13 @@ TEST_LEXER(Identifiers,
     TOKEN_STRUCTURE, TOKEN_TRUE,       TOKEN_VAR,        TOKEN_WHILE
 );
 
+TEST_LEXER(TypeNames,
+    "bool  int   int8     int16  int32  \n"
+    "float float32 float64 string  void \n",
+    TOKEN_BOOL,  TOKEN_INT,     TOKEN_INT8,       TOKEN_INT16,  TOKEN_IDENTIFIER,
+    TOKEN_FLOAT, TOKEN_FLOAT32, TOKEN_IDENTIFIER, TOKEN_STRING, TOKEN_VOID
+);
+
 TEST_LEXER(Numbers,
     "0 0.1",
     TOKEN_INTEGER_VALUE, TOKEN_FLOAT_VALUE
@@ -0,0 +1,199 @@
+#include "cut.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "heap_fixture.h"
+#include "map.h"
+#include "random.h"
+
+
+#define KEYS_COUNT 4096
+
+
+static Object* allocateMapOnStack(HeapFixture* fixture, MapItemKind key_kind, MapItemKind value_kind) {
+    Object* map = allocateMap(
+        &fixture->heap,
+        &fixture->stack,
+        &fixture->stack_references_positions,
+        key_kind,
+        value_kind,
+        0
+    );
+    pushReference(fixture, map);
+    return map;
+}
+
+static Object* allocateString(HeapFixture* fixture, const char* value) {
+    return allocateObjectFromValue(
+        &fixture->heap,
+        &fixture->stack,
+        &fixture->stack_references_positions,
+        REFERENCE_RULE_PLAIN,
+        NULL,
+        strlen(value),
+        (const uint8_t*)value
+    );
+}
+
+// Grows the table if it's full, like OP_MAP_SET does.
+static void setInMap(HeapFixture* fixture, Object* map, MapItemKind key_kind, MapItemKind value_kind, size_t key, size_t value) {
+    MapSlot* slot = insertIntoMap(map, key_kind, value_kind, key);
+    if (!slot) {
+        reserveMap(&fixture->heap, &fixture->stack, &fixture->stack_references_positions, map, 1);
+        slot = insertIntoMap(map, key_kind, value_kind, key);
+    }
+    slot->value = value;
+}
+
+static size_t mapCapacity(Object* map) {
+    return ((MapTable*)(*(Object**)map->value)->value)->capacity;
+}
+
+
+TEST(MapFindsInsertedKeys) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* map = allocateMapOnStack(&fixture, MAP_ITEM_INT, MAP_ITEM_INT);
+    EXPECT(findInMap(map, 0) == NULL);
+
+    for (size_t i = 0; i < KEYS_COUNT; ++i) {
+        setInMap(&fixture, map, MAP_ITEM_INT, MAP_ITEM_INT, i * 3, i);
+    }
+    map = (Object*)getAddressFromStack(&fixture.stack, 0);
+
+    EXPECT(mapCount(map) == KEYS_COUNT);
+    EXPECT(mapCapacity(map) / MAP_MAX_LOAD_DENOMINATOR * MAP_MAX_LOAD_NUMERATOR >= KEYS_COUNT);
+    EXPECT(mapCapacity(map) / 2 / MAP_MAX_LOAD_DENOMINATOR * MAP_MAX_LOAD_NUMERATOR < KEYS_COUNT);
+
+    bool all_found = true;
+    for (size_t i = 0; i < 3 * KEYS_COUNT; ++i) {
+        MapSlot* slot = findInMap(map, i);
+        all_found &= i % 3 == 0 ? slot && slot->value == i / 3 : slot == NULL;
+    }
+    EXPECT(all_found);
+
+    // Setting an existing key replaces its value.
+    setInMap(&fixture, map, MAP_ITEM_INT, MAP_ITEM_INT, 9, 100);
+    EXPECT(mapCount(map) == KEYS_COUNT);
+    EXPECT(findInMap(map, 9)->value == 100);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(MapDeletionMatchesNaiveSet) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* map = allocateMapOnStack(&fixture, MAP_ITEM_INT, MAP_ITEM_BOOL);
+    static bool present[1024];
+    memset(present, 0, sizeof(present));
+    size_t count = 0;
+
+    // Churn through a small range of keys, so that deleted slots pile up
+    // and are either reused or dropped when the table is rebuilt.
+    uint64_t state = 42;
+    bool all_match = true;
+    for (size_t i = 0; i < 200000; ++i) {
+        size_t key = nextRandom(&state) % 1024;
+        if (nextRandom(&state) % 2 == 0) {
+            count += !present[key];
+            present[key] = true;
+            setInMap(&fixture, map, MAP_ITEM_INT, MAP_ITEM_BOOL, key, 1);
+        } else {
+            all_match &= deleteFromMap(map, key) == present[key];
+            count -= present[key];
+            present[key] = false;
+        }
+        map = (Object*)getAddressFromStack(&fixture.stack, 0);
+    }
+    EXPECT(all_match);
+    EXPECT(mapCount(map) == count);
+    EXPECT(mapCapacity(map) <= 2048);
+
+    for (size_t key = 0; key < 1024; ++key) {
+        all_match &= (findInMap(map, key) != NULL) == present[key];
+    }
+    EXPECT(all_match);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(MapStringKeysAreComparedByValue) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* map = allocateMapOnStack(&fixture, MAP_ITEM_STRING, MAP_ITEM_INT);
+    Object* key = allocateString(&fixture, "lala");
+    pushReference(&fixture, key);
+    map = (Object*)getAddressFromStack(&fixture.stack, 0);
+    setInMap(&fixture, map, MAP_ITEM_STRING, MAP_ITEM_INT, (size_t)key, 7);
+
+    pushReference(&fixture, allocateString(&fixture, "lala"));
+    Object* other = allocateString(&fixture, "papa");
+    map = (Object*)getAddressFromStack(&fixture.stack, 0);
+    key = (Object*)getAddressFromStack(&fixture.stack, sizeof(size_t));
+    Object* same = (Object*)getAddressFromStack(&fixture.stack, 2 * sizeof(size_t));
+
+    EXPECT(same != key);
+    EXPECT(findInMap(map, (size_t)same) && findInMap(map, (size_t)same)->value == 7);
+    EXPECT(findInMap(map, (size_t)other) == NULL);
+    EXPECT(deleteFromMap(map, (size_t)same));
+    EXPECT(findInMap(map, (size_t)key) == NULL);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(MapKeysAndValuesSurviveCompaction) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+    fixture.heap.config.compaction_threshold = 1;
+
+    Object* map = allocateMapOnStack(&fixture, MAP_ITEM_STRING, MAP_ITEM_STRING);
+
+    // Every key and value has garbage in front of it, and the table
+    // grows several times. It grows before the key and the value are
+    // allocated, so that they can't be collected by the growth.
+    char buffer[32];
+    for (size_t i = 0; i < 256; ++i) {
+        reserveMap(&fixture.heap, &fixture.stack, &fixture.stack_references_positions, map, 1);
+
+        allocateEmptyObject(
+            &fixture.heap,
+            &fixture.stack,
+            &fixture.stack_references_positions,
+            REFERENCE_RULE_PLAIN,
+            NULL,
+            HEAP_SEGMENT_SIZE / 128
+        );
+        snprintf(buffer, sizeof(buffer), "key %zu", i);
+        pushReference(&fixture, allocateString(&fixture, buffer));
+        snprintf(buffer, sizeof(buffer), "value %zu", i);
+        Object* value = allocateString(&fixture, buffer);
+
+        Object* key = (Object*)popAddressFromStack(&fixture.stack);
+        popAddressFromStack(&fixture.stack_references_positions);
+        map = (Object*)getAddressFromStack(&fixture.stack, 0);
+        MapSlot* slot = insertIntoMap(map, MAP_ITEM_STRING, MAP_ITEM_STRING, (size_t)key);
+        slot->value = (size_t)value;
+    }
+
+    Object* table = *(Object**)map->value;
+    fixture.heap.next_gc = 0;
+    Object* probe = allocateString(&fixture, "key 200");
+    map = (Object*)getAddressFromStack(&fixture.stack, 0);
+
+    EXPECT(map->value == (uint8_t*)(map + 1));
+    EXPECT(*(Object**)map->value != table);
+    EXPECT(mapCount(map) == 256);
+
+    MapSlot* slot = findInMap(map, (size_t)probe);
+    EXPECT(slot);
+    Object* value = (Object*)slot->value;
+    EXPECT(value->size == 9 && memcmp(value->value, "value 200", 9) == 0);
+
+    freeHeapFixture(&fixture);
+}
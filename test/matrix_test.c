@@ -0,0 +1,88 @@
+#include "cut.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "heap_fixture.h"
+#include "matrix.h"
+
+
+static Object* allocateFilled(HeapFixture* fixture, uint32_t rows, uint32_t columns, const void* item, size_t item_size) {
+    return allocateMatrix(
+        &fixture->heap,
+        &fixture->stack,
+        &fixture->stack_references_positions,
+        rows,
+        columns,
+        item,
+        item_size
+    );
+}
+
+
+TEST(MatricesAreFilledRowAfterRow) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    int32_t seven = 7;
+    Object* ints = allocateFilled(&fixture, 3, 4, &seven, sizeof(int32_t));
+    EXPECT(MATRIX_SHAPE(ints)->rows == 3 && MATRIX_SHAPE(ints)->columns == 4);
+    EXPECT(ints->size == sizeof(MatrixShape) + 12 * sizeof(int32_t));
+    bool all_seven = true;
+    for (size_t i = 0; i < 12; ++i) {
+        all_seven &= ((int32_t*)MATRIX_ITEMS(ints))[i] == 7;
+    }
+    EXPECT(all_seven);
+
+    double zero = 0.0;
+    Object* floats = allocateFilled(&fixture, 100, 100, &zero, sizeof(double));
+    bool all_zero = true;
+    for (size_t i = 0; i < 10000; ++i) {
+        all_zero &= memcmp((double*)MATRIX_ITEMS(floats) + i, &zero, sizeof(double)) == 0;
+    }
+    EXPECT(all_zero);
+
+    Object* empty = allocateFilled(&fixture, 0, 5, &seven, sizeof(int32_t));
+    EXPECT(MATRIX_SHAPE(empty)->rows == 0 && MATRIX_SHAPE(empty)->columns == 5);
+    EXPECT(empty->size == sizeof(MatrixShape));
+
+    // The size of the items doesn't fit into memory.
+    EXPECT(allocateFilled(&fixture, UINT32_MAX, UINT32_MAX, &zero, sizeof(double)) == NULL);
+
+    freeHeapFixture(&fixture);
+}
+
+TEST(ArraysAreSplitIntoRowsAndJoinedBack) {
+    HeapFixture fixture;
+    initHeapFixture(&fixture);
+
+    Object* array = allocate(&fixture, REFERENCE_RULE_PLAIN, 12 * sizeof(int16_t));
+    for (int16_t i = 0; i < 12; ++i) {
+        ((int16_t*)array->value)[i] = (int16_t)(i * 100);
+    }
+    pushReference(&fixture, array);
+
+    Object* matrix = arrayToMatrix(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        array,
+        4,
+        sizeof(int16_t)
+    );
+    EXPECT(MATRIX_SHAPE(matrix)->rows == 3 && MATRIX_SHAPE(matrix)->columns == 4);
+    // The item [2, 1] is the item 2 * 4 + 1 of the array.
+    EXPECT(((int16_t*)MATRIX_ITEMS(matrix))[2 * 4 + 1] == 900);
+
+    Object* joined = matrixToArray(
+        &fixture.heap,
+        &fixture.stack,
+        &fixture.stack_references_positions,
+        matrix
+    );
+    EXPECT(joined->size == 12 * sizeof(int16_t));
+    EXPECT(memcmp(joined->value, array->value, joined->size) == 0);
+
+    freeHeapFixture(&fixture);
+}
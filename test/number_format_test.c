@@ -0,0 +1,93 @@
+#include "cut.h"
+
+#include <limits.h>
+#include <math.h>
+
+#include "number_format.h"
+#include "random.h"
+
+
+#define EXPECT_INT_FORMATTED_LIKE_PRINTF(value)                           \
+    {                                                                     \
+        int32_t int_value = (value);                                      \
+        char expected[INT_STRING_MAX_LENGTH + 1];                         \
+        snprintf(expected, sizeof(expected), "%d", int_value);            \
+                                                                          \
+        char actual[INT_STRING_MAX_LENGTH + 1];                           \
+        size_t length = intStringLength(int_value);                       \
+        formatInt(int_value, (uint8_t*)actual, length);                   \
+        actual[length] = '\0';                                            \
+                                                                          \
+        EXPECT_INTERNAL(                                                  \
+            strcmp(actual, expected) == 0,                                \
+            "Expected %d to be formatted as '%s', got '%s'",              \
+            int_value, expected, actual                                   \
+        );                                                                \
+    }
+
+#define EXPECT_FLOAT_FORMATTED_LIKE_PRINTF(value)                         \
+    {                                                                     \
+        double float_value = (value);                                     \
+        char expected[FLOAT_STRING_MAX_LENGTH + 1];                       \
+        snprintf(expected, sizeof(expected), "%g", float_value);          \
+                                                                          \
+        char actual[FLOAT_STRING_MAX_LENGTH + 1];                         \
+        size_t length = formatFloat(float_value, (uint8_t*)actual);       \
+        actual[length] = '\0';                                            \
+                                                                          \
+        EXPECT_INTERNAL(                                                  \
+            strcmp(actual, expected) == 0,                                \
+            "Expected %.17g to be formatted as '%s', got '%s'",           \
+            float_value, expected, actual                                 \
+        );                                                                \
+    }
+
+
+TEST(IntsAreFormattedLikePrintf) {
+    int32_t values[] = { 0, 1, -1, 9, 10, 99, 100, -100, 12345, INT_MAX, INT_MIN, INT_MIN + 1 };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        EXPECT_INT_FORMATTED_LIKE_PRINTF(values[i]);
+    }
+
+    for (int32_t power = 1; power <= 100000000; power *= 10) {
+        EXPECT_INT_FORMATTED_LIKE_PRINTF(power - 1);
+        EXPECT_INT_FORMATTED_LIKE_PRINTF(power);
+        EXPECT_INT_FORMATTED_LIKE_PRINTF(-power);
+    }
+
+    uint64_t state = 1;
+    for (size_t i = 0; i < 100000; ++i) {
+        EXPECT_INT_FORMATTED_LIKE_PRINTF((int32_t)(uint32_t)nextRandom(&state));
+    }
+}
+
+TEST(FloatsAreFormattedLikePrintf) {
+    double values[] = {
+        0.0, -0.0, 1.0, -1.0, 0.5, 2.5, 0.1, 1.0 / 3.0, 100000.0, 999999.0,
+        999999.5, 9999995.0, 1234565.0, 0.0001, 0.00001, 1e-5, 123456789.0,
+        1e15, 1e21, 1e22, 1e27, 1e28, 1e-17, 1e-18, 1e100, -1e-300,
+        5e-324, INFINITY, -INFINITY, NAN,
+    };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        EXPECT_FLOAT_FORMATTED_LIKE_PRINTF(values[i]);
+    }
+
+    uint64_t state = 1;
+    for (size_t i = 0; i < 100000; ++i) {
+        // Random decimals with few digits, which are close to ties.
+        double decimal = (double)(int64_t)(nextRandom(&state) % 20000001 - 10000000);
+        EXPECT_FLOAT_FORMATTED_LIKE_PRINTF(decimal / 8.0);
+        EXPECT_FLOAT_FORMATTED_LIKE_PRINTF(decimal / 1000.0);
+        EXPECT_FLOAT_FORMATTED_LIKE_PRINTF(decimal * 1e12);
+
+        // Random values of the magnitudes formatted without printf.
+        int exponent = (int)(nextRandom(&state) % 50) - 25;
+        EXPECT_FLOAT_FORMATTED_LIKE_PRINTF((double)nextRandom(&state) * pow(10.0, exponent - 16));
+
+        // Random doubles of all magnitudes.
+        uint64_t bits = nextRandom(&state) << 11 ^ nextRandom(&state);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        EXPECT_FLOAT_FORMATTED_LIKE_PRINTF(value);
+    }
+}
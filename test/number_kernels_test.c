@@ -0,0 +1,222 @@
+#include "cut.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "number_kernels.h"
+#include "random.h"
+
+
+#define MAX_COUNT 100
+#define ROUNDS    2000
+
+
+// Small numbers with the extremes among them, so that there are equal
+// items and overflows. Divisors aren't zero.
+static void fillRandomInts(uint64_t* state, int32_t* items, size_t count, bool is_divisor) {
+    for (size_t i = 0; i < count; ++i) {
+        switch (nextRandom(state) % 8) {
+            case 0:  items[i] = INT32_MIN; break;
+            case 1:  items[i] = INT32_MAX; break;
+            case 2:  items[i] = -1;        break;
+            default: items[i] = (int32_t)(nextRandom(state) % 21) - 10; break;
+        }
+        if (is_divisor && items[i] == 0) {
+            items[i] = 3;
+        }
+    }
+}
+
+// Fractions with NaNs and infinities among them.
+static void fillRandomFloats(uint64_t* state, double* items, size_t count, bool is_divisor) {
+    for (size_t i = 0; i < count; ++i) {
+        switch (nextRandom(state) % 10) {
+            case 0:  items[i] = NAN;       break;
+            case 1:  items[i] = -INFINITY; break;
+            default: items[i] = (double)((int64_t)(nextRandom(state) % 41) - 20) / 8; break;
+        }
+        if (is_divisor && fabs(items[i]) < 0.1) {
+            items[i] = 0.5;
+        }
+    }
+}
+
+
+// Runs the kernel call on copies of the destination, as items, with the
+// scalar level and with the tested one, and compares their bytes,
+// so that NaNs are equal. Masks of count bits are compared as count bytes,
+// their bytes past the mask are copied as they are.
+#define EXPECT_SAME_RESULT(type, destination, call)                     \
+    {                                                                   \
+        type expected[MAX_COUNT];                                       \
+        type result[MAX_COUNT];                                         \
+        memcpy(expected, destination, count * sizeof(type));            \
+        memcpy(result, destination, count * sizeof(type));              \
+        setNumberKernelsLevel(CPU_LEVEL_SCALAR);                        \
+        {                                                               \
+            type* items = expected;                                     \
+            call;                                                       \
+        }                                                               \
+        setNumberKernelsLevel(levels[level_i]);                         \
+        {                                                               \
+            type* items = result;                                       \
+            call;                                                       \
+        }                                                               \
+        matches &= memcmp(expected, result, count * sizeof(type)) == 0; \
+    }
+
+// Compares the bytes of a reduction with the scalar level and the tested one.
+#define EXPECT_SAME_VALUE(type, call)                                   \
+    {                                                                   \
+        setNumberKernelsLevel(CPU_LEVEL_SCALAR);                        \
+        type expected = call;                                           \
+        setNumberKernelsLevel(levels[level_i]);                         \
+        type result = call;                                             \
+        matches &= memcmp(&expected, &result, sizeof(type)) == 0;       \
+    }
+
+
+TEST(NumberKernelsMatchScalarKernels) {
+    CpuLevel levels[] = { CPU_LEVEL_SSE2, CPU_LEVEL_AVX2 };
+    CpuLevel best_level = numberKernelsLevel();
+
+    for (size_t level_i = 0; level_i < sizeof(levels) / sizeof(levels[0]); ++level_i) {
+        if (!setNumberKernelsLevel(levels[level_i])) {
+            continue;
+        }
+        const char* level_name = cpuLevelName(levels[level_i]);
+
+        uint64_t state = 1;
+        bool matches = true;
+        for (size_t round = 0; round < ROUNDS; ++round) {
+            size_t count = nextRandom(&state) % MAX_COUNT;
+            ItemsOperation operation = (ItemsOperation)(round % 3);
+
+            int32_t ints[3][MAX_COUNT];
+            double floats[3][MAX_COUNT];
+            for (size_t i = 0; i < 3; ++i) {
+                fillRandomInts(&state, ints[i], count, i == 1);
+                fillRandomFloats(&state, floats[i], count, i == 1);
+            }
+
+            EXPECT_SAME_RESULT(int32_t, ints[0], combineInts(items, ints[1], count, operation));
+            EXPECT_SAME_RESULT(double, floats[0], combineFloats(items, floats[1], count, operation));
+            EXPECT_SAME_RESULT(int32_t, ints[0], matches &= divideInts(items, ints[1], count));
+            EXPECT_SAME_RESULT(double, floats[0], matches &= divideFloats(items, floats[1], count, 0.1));
+            EXPECT_SAME_RESULT(int32_t, ints[0], scaleInts(items, count, ints[2][0]));
+            EXPECT_SAME_RESULT(double, floats[0], scaleFloats(items, count, -1.5));
+            EXPECT_SAME_RESULT(int32_t, ints[0], multiplyAddInts(items, ints[1], ints[2], count));
+            EXPECT_SAME_RESULT(double, floats[0], multiplyAddFloats(items, floats[1], floats[2], count));
+
+            // The masks are made of the compared items, so that they're random.
+            uint8_t bits[MAX_COUNT] = {0};
+            EXPECT_SAME_RESULT(uint8_t, bits, lessInts(items, ints[0], ints[1], count));
+            EXPECT_SAME_RESULT(uint8_t, bits, lessFloats(items, floats[0], floats[1], count));
+            lessInts(bits, ints[0], ints[1], count);
+            EXPECT_SAME_RESULT(int32_t, ints[0], selectInts(items, bits, ints[1], count));
+            EXPECT_SAME_RESULT(double, floats[0], selectFloats(items, bits, floats[1], count));
+
+            EXPECT_SAME_VALUE(int32_t, sumInts(ints[0], count));
+            EXPECT_SAME_VALUE(int64_t, sumIntsWide(ints[0], count));
+            EXPECT_SAME_VALUE(double, sumFloats(floats[0], count));
+            EXPECT_SAME_VALUE(int32_t, dotInts(ints[0], ints[1], count));
+            EXPECT_SAME_VALUE(double, dotFloats(floats[0], floats[1], count));
+            EXPECT_SAME_VALUE(size_t, findInt(ints[0], count, ints[2][0]));
+            EXPECT_SAME_VALUE(size_t, findFloat(floats[0], count, floats[2][0]));
+            if (count > 0) {
+                EXPECT_SAME_VALUE(int32_t, minInts(ints[0], count));
+                EXPECT_SAME_VALUE(int32_t, maxInts(ints[0], count));
+                EXPECT_SAME_VALUE(double, minFloats(floats[0], count));
+                EXPECT_SAME_VALUE(double, maxFloats(floats[0], count));
+            }
+        }
+        EXPECT_INTERNAL(matches, "%s kernels don't match the scalar ones", level_name);
+    }
+
+    setNumberKernelsLevel(best_level);
+}
+
+TEST(NumberKernelsWorkItemByItem) {
+    int32_t ints[] = { 7, -7, INT32_MIN, 9, 1, 2, 3, 4, 5, 6 };
+    int32_t divisors[] = { 2, 2, -1, -3, 1, 1, 1, 1, 1, 1 };
+    EXPECT(divideInts(ints, divisors, 10));
+    EXPECT(ints[0] == 3 && ints[1] == -3 && ints[2] == INT32_MIN && ints[3] == -3);
+
+    divisors[9] = 0;
+    EXPECT(!divideInts(ints, divisors, 10));
+
+    double floats[] = { 1.0, 2.0, 3.0 };
+    double divisors_floats[] = { 2.0, 1e-12, 1.0 };
+    EXPECT(!divideFloats(floats, divisors_floats, 3, 1e-10));
+
+    // The multiply-add of floats is rounded once.
+    double destination[] = { -1.0 };
+    double factors[] = { 1.0 + 0x1p-30 };
+    multiplyAddFloats(destination, factors, factors, 1);
+    EXPECT(destination[0] > 0x1p-29);
+
+    int32_t left[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    int32_t right[] = { 5, 5, 5, 5, 5, 5, 5, 5, 5, 5 };
+    uint8_t bits[2] = { 0xFF, 0xFF };
+    lessInts(bits, left, right, 10);
+    EXPECT(bits[0] == 0x0F && bits[1] == 0x00);
+
+    selectInts(right, bits, left, 10);
+    EXPECT(right[3] == 4 && right[4] == 5 && right[9] == 5);
+
+    double nans[] = { NAN, 1.0 };
+    double ones[] = { 1.0, NAN };
+    lessFloats(bits, nans, ones, 2);
+    EXPECT(bits[0] == 0);
+}
+
+TEST(NumberKernelsLevelIsSelected) {
+    CpuLevel level = numberKernelsLevel();
+    EXPECT(level == CPU_LEVEL_SCALAR || level == CPU_LEVEL_SSE2 || level == CPU_LEVEL_AVX2);
+    EXPECT(setNumberKernelsLevel(CPU_LEVEL_SCALAR));
+    EXPECT(numberKernelsLevel() == CPU_LEVEL_SCALAR);
+    EXPECT(setNumberKernelsLevel(level));
+}
+
+TEST(FloatsAreSummedPairwise) {
+    CpuLevel best_level = numberKernelsLevel();
+
+    // A naive sum of a million tenths is off by about 1e-6,
+    // the pairwise one by a few units of the last place.
+    size_t count = 1000000;
+    double* tenths = malloc(count * sizeof(double));
+    for (size_t i = 0; i < count; ++i) {
+        tenths[i] = 0.1;
+    }
+    double sums[3];
+    for (int level = CPU_LEVEL_SCALAR; level <= CPU_LEVEL_AVX2; ++level) {
+        sums[level] = setNumberKernelsLevel((CpuLevel)level) ? sumFloats(tenths, count) : sums[0];
+    }
+    EXPECT(fabs(sums[0] - 100000.0) < 1e-9);
+    EXPECT(memcmp(&sums[0], &sums[1], sizeof(double)) == 0);
+    EXPECT(memcmp(&sums[0], &sums[2], sizeof(double)) == 0);
+
+    free(tenths);
+    setNumberKernelsLevel(best_level);
+}
+
+TEST(NumberReductionsHandleExtremes) {
+    int32_t ints[] = { INT32_MAX, INT32_MAX, 5, INT32_MIN, -3, 5, 7, 8, 9 };
+    EXPECT(sumInts(ints, 2) == -2);
+    EXPECT(sumIntsWide(ints, 2) == 2 * (int64_t)INT32_MAX);
+    EXPECT(minInts(ints, 9) == INT32_MIN && maxInts(ints, 9) == INT32_MAX);
+    EXPECT(findInt(ints, 9, 5) == 2 && findInt(ints, 9, 4) == 9);
+    EXPECT(dotInts(ints + 4, ints + 5, 3) == -3 * 5 + 5 * 7 + 7 * 8);
+
+    double floats[] = { 2.0, NAN, -1.5, 4.0, NAN, 0.5 };
+    EXPECT(minFloats(floats, 6) < -1.0 && isnan(maxFloats(floats, 6)));
+    EXPECT(maxFloats(floats + 2, 2) > 3.0);
+    EXPECT(findFloat(floats, 6, NAN) == 1 && findFloat(floats, 6, 4.0) == 3);
+
+    double nans[] = { NAN, NAN, NAN, NAN, NAN };
+    EXPECT(isnan(minFloats(nans, 5)) && findFloat(nans, 5, 1.0) == 5);
+    EXPECT(fpclassify(sumFloats(nans, 0)) == FP_ZERO && fpclassify(dotFloats(floats, floats, 0)) == FP_ZERO);
+}
@@ -0,0 +1,113 @@
+#include "cut.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "input.h"
+#include "number_format.h"
+#include "output.h"
+
+
+// Everything written to the file so far.
+static size_t readFile(FILE* file, char* data, size_t capacity) {
+    rewind(file);
+    size_t size = fread(data, 1, capacity, file);
+    fseek(file, 0, SEEK_END);
+    return size;
+}
+
+#define EXPECT_FILE(file, expected)                                                 \
+    {                                                                               \
+        char data[256];                                                             \
+        size_t size = readFile(file, data, sizeof(data));                           \
+        EXPECT(size == strlen(expected) && memcmp(data, expected, size) == 0);      \
+    }
+
+
+TEST(OutputIsWrittenOnFlush) {
+    FILE* file = tmpfile();
+    Output output;
+    initOutput(&output, fileno(file));
+    setOutputBuffering(&output, OUTPUT_BUFFERING_FULL);
+
+    writeBool(&output, true);
+    endOutputLine(&output);
+    writeInt(&output, -2147483647 - 1);
+    endOutputLine(&output);
+    writeFloat(&output, 0.5);
+    endOutputLine(&output);
+    writeOutput(&output, (const uint8_t*)"lala", 4);
+    EXPECT_FILE(file, "");
+
+    flushOutput(&output);
+    EXPECT_FILE(file, "true\n-2147483648\n0.5\nlala");
+
+    setOutputBuffering(&output, OUTPUT_BUFFERING_LINE);
+    writeBool(&output, false);
+    EXPECT_FILE(file, "true\n-2147483648\n0.5\nlala");
+    endOutputLine(&output);
+    EXPECT_FILE(file, "true\n-2147483648\n0.5\nlalafalse\n");
+
+    freeOutput(&output);
+    fclose(file);
+}
+
+TEST(OutputIsWrittenWhenFull) {
+    FILE* file = tmpfile();
+    Output output;
+    initOutput(&output, fileno(file));
+    setOutputBuffering(&output, OUTPUT_BUFFERING_FULL);
+
+    // Each line is at least 2 bytes long.
+    size_t lines_count = OUTPUT_BUFFER_SIZE / 2 + 1;
+    for (size_t i = 0; i < lines_count; ++i) {
+        writeInt(&output, (int32_t)(i % 1000));
+        endOutputLine(&output);
+    }
+    EXPECT(output.size < OUTPUT_BUFFER_SIZE);
+    EXPECT(lseek(fileno(file), 0, SEEK_END) > 0);
+
+    // Writes bigger than the buffer go right to the file.
+    size_t big_size = OUTPUT_BUFFER_SIZE * 2;
+    uint8_t* big = malloc(big_size);
+    memset(big, 'a', big_size);
+    writeOutput(&output, big, big_size);
+    EXPECT(output.size == 0);
+
+    freeOutput(&output);
+    size_t expected_size = big_size;
+    for (size_t i = 0; i < lines_count; ++i) {
+        expected_size += intStringLength((int32_t)(i % 1000)) + 1;
+    }
+    EXPECT(lseek(fileno(file), 0, SEEK_END) == (off_t)expected_size);
+
+    free(big);
+    fclose(file);
+}
+
+TEST(TiedOutputIsFlushedBeforeReading) {
+    FILE* in = tmpfile();
+    fputs("42", in);
+    fflush(in);
+    rewind(in);
+    FILE* out = tmpfile();
+
+    Input input;
+    Output output;
+    initInput(&input, fileno(in));
+    initOutput(&output, fileno(out));
+    setOutputBuffering(&output, OUTPUT_BUFFERING_FULL);
+    input.tied_output = &output;
+
+    writeOutput(&output, (const uint8_t*)"Enter a number: ", 16);
+    EXPECT_FILE(out, "");
+
+    int32_t value;
+    EXPECT(readInt(&input, &value) && value == 42);
+    EXPECT_FILE(out, "Enter a number: ");
+
+    freeInput(&input);
+    freeOutput(&output);
+    fclose(in);
+    fclose(out);
+}
@@ -175,15 +175,58 @@ TEST_PARSER_EXPRESSION(ComplexExpression,
     OP_DIVIDE_INT,    
     OP_PUSH_INT,       0x05, 0x00, 0x00, 0x00, // 5
     OP_GREATER_INT,
+    OP_JUMP_IF_TRUE,   0x2A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 42
+    OP_PUSH_FALSE,
+    OP_JUMP,           0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 72
     OP_PUSH_FLOAT,     BINARY_FLOAT_2,
     OP_PUSH_FLOAT,     BINARY_FLOAT_4,
     OP_PUSH_FLOAT,     BINARY_FLOAT_0_5,
     OP_MULTIPLY_FLOAT,
     OP_EQUALS_FLOAT,
     OP_NEGATE_BOOL,
-    OP_AND,
+    OP_JUMP_IF_TRUE,   0x5B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 91
+    OP_PUSH_FALSE,
+    OP_JUMP,           0x5C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 92
+    OP_PUSH_TRUE
+);
+
+TEST_PARSER_EXPRESSION(OrJumpsOverRightOperand,
+    "true or false",
+    OP_PUSH_TRUE,
+    OP_JUMP_IF_FALSE,  0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 20
+    OP_PUSH_TRUE,
+    OP_JUMP,           0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 21
+    OP_PUSH_FALSE
+);
+
+TEST_PARSER_EXPRESSION(AndJumpsOverRightOperand,
+    "false and true",
+    OP_PUSH_FALSE,
+    OP_JUMP_IF_TRUE,   0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 20
+    OP_PUSH_FALSE,
+    OP_JUMP,           0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 21
+    OP_PUSH_TRUE
+);
+
+TEST_PARSER_EXPRESSION(ConcatenateTwoStrings,
+    "'a' + 'b'",
+    OP_LOAD_CONSTANT, 0x00,
+    OP_LOAD_CONSTANT, 0x01,
+    OP_CONCATENATE
+);
+
+TEST_PARSER_EXPRESSION(ConcatenateChain,
+    "'a' + 1: string + 0.5: string + true: string",
+    OP_LOAD_CONSTANT,       0x00,
+    OP_PUSH_INT,            0x01, 0x00, 0x00, 0x00, // 1
+    OP_PUSH_FLOAT,          BINARY_FLOAT_0_5,
     OP_PUSH_TRUE,
-    OP_AND
+    OP_CAST_BOOL_TO_STRING,
+    OP_CONCATENATE_N,       0x04,
+    CONCATENATE_OPERAND_STRING,
+    CONCATENATE_OPERAND_INT,
+    CONCATENATE_OPERAND_FLOAT,
+    CONCATENATE_OPERAND_STRING
 );
 
 #define EXPECT_VARIABLE(scope, name, value_type, address)                    \
@@ -302,6 +345,15 @@ TEST(AssignVariable) {
 }
 
 
+TEST_PARSER_EXPRESSION(BuiltinCall,
+    "substring('lala', 1, 3)",
+    OP_LOAD_CONSTANT, 0x00,
+    OP_PUSH_INT, 0x01, 0x00, 0x00, 0x00,
+    OP_PUSH_INT, 0x03, 0x00, 0x00, 0x00,
+    OP_SUBSTRING,
+);
+
+
 #undef BINARY_FLOAT_4
 #undef BINARY_FLOAT_2
 #undef BINARY_FLOAT_0_5
@@ -0,0 +1,82 @@
+#include "program.h"
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "parser.h"
+#include "vm.h"
+
+
+// ┌──────────────────────────────┐
+// │ Static function declarations │
+// └──────────────────────────────┘
+
+// Runs in the child process, with stdout and stderr redirected.
+static void compileAndRun(const char* source, const HeapConfig* heap_config);
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+void runProgram(const char* source, const HeapConfig* heap_config, ProgramResult* result) {
+    FILE* file = tmpfile();
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(fileno(file), STDOUT_FILENO);
+        dup2(fileno(file), STDERR_FILENO);
+        compileAndRun(source, heap_config);
+        exit(0);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    result->exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+    rewind(file);
+    size_t size = fread(result->output, 1, PROGRAM_OUTPUT_CAPACITY - 1, file);
+    result->output[size] = '\0';
+    fclose(file);
+}
+
+void initStressHeapConfig(HeapConfig* config) {
+    initHeapConfig(config);
+    config->initial_threshold = 0;
+    config->growth_factor = 0;
+}
+
+
+// ┌─────────────────────────────────┐
+// │ Static function implementations │
+// └─────────────────────────────────┘
+
+static void compileAndRun(const char* source, const HeapConfig* heap_config) {
+    Stack bytecode;
+    Parser parser;
+    initStack(&bytecode);
+    initParser(&parser, &bytecode);
+
+    parseString(&parser, source);
+    if (parser.had_error) {
+        fflush(stderr);
+        exit(1);
+    }
+
+    VM vm;
+    initVM(&vm, bytecode.stack, (size_t)(bytecode.stack_top - bytecode.stack), &parser.constants);
+    if (heap_config) {
+        setHeapConfig(&vm.heap, heap_config);
+    }
+
+    interpret(&vm);
+
+    freeVM(&vm);
+    freeParser(&parser);
+    freeStack(&bytecode);
+}
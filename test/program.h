@@ -0,0 +1,46 @@
+#ifndef lala_program_h
+#define lala_program_h
+
+
+#include <stddef.h>
+
+#include "heap.h"
+
+
+// ┌────────┐
+// │ Macros │
+// └────────┘
+
+#define PROGRAM_OUTPUT_CAPACITY 4096
+
+
+// ┌───────┐
+// │ Types │
+// └───────┘
+
+typedef struct {
+    // 0 if the program compiled and ran to the end. Compile
+    // and runtime errors exit with 1.
+    int exit_status;
+    // What the program wrote to stdout and stderr, null terminated.
+    // Longer output is cut.
+    char output[PROGRAM_OUTPUT_CAPACITY];
+} ProgramResult;
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+/* Compiles the lala source and runs it in a child process, since errors
+ * exit the process. The heap is configured with heap_config, or with
+ * the defaults if it's NULL.
+ * */
+void runProgram(const char* source, const HeapConfig* heap_config, ProgramResult* result);
+
+// A heap config that makes gc run on every allocation, so that
+// the objects a program uses are moved as often as possible.
+void initStressHeapConfig(HeapConfig* config);
+
+
+#endif
@@ -0,0 +1,11 @@
+#include "random.h"
+
+
+// ┌──────────────────────────┐
+// │ Function implementations │
+// └──────────────────────────┘
+
+uint64_t nextRandom(uint64_t* state) {
+    *state = *state * 6364136223846793005u + 1442695040888963407u;
+    return *state >> 11;
+}
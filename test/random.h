@@ -0,0 +1,17 @@
+#ifndef lala_random_h
+#define lala_random_h
+
+
+#include <stdint.h>
+
+
+// ┌───────────────────────┐
+// │ Function declarations │
+// └───────────────────────┘
+
+// Deterministic pseudo random numbers, so that failures are reproducible.
+// The state is any seed, and is advanced by every call.
+uint64_t nextRandom(uint64_t* state);
+
+
+#endif
@@ -0,0 +1,331 @@
+#include "cut.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "program.h"
+#include "sort.h"
+
+
+#define ITEMS_COUNT 100000
+
+
+static int compareIntsForQsort(const void* a, const void* b) {
+    int32_t l = *(const int32_t*)a;
+    int32_t r = *(const int32_t*)b;
+    return (l > r) - (l < r);
+}
+
+static Object stringObject(const char* value) {
+    Object object;
+    memset(&object, 0, sizeof(object));
+    object.reference_rule = REFERENCE_RULE_PLAIN;
+    object.immortal = true;
+    object.size = strlen(value);
+    object.value = (uint8_t*)(uintptr_t)value;
+    return object;
+}
+
+
+TEST(IntsAreSortedLikeQsortSortsThem) {
+    int32_t* items = malloc(ITEMS_COUNT * sizeof(int32_t));
+    int32_t* expected = malloc(ITEMS_COUNT * sizeof(int32_t));
+    srand(1);
+    for (size_t i = 0; i < ITEMS_COUNT; ++i) {
+        // Negative numbers, the extremes and many duplicates. Only the small
+        // numbers are scaled, so that none overflows.
+        int32_t number = rand() % 1000 - 500;
+        if (i % 3 == 0) {
+            number *= 1 << 20;
+        }
+        items[i] = i % 7 == 0 ? INT32_MIN : i % 11 == 0 ? INT32_MAX : number;
+    }
+    memcpy(expected, items, ITEMS_COUNT * sizeof(int32_t));
+    qsort(expected, ITEMS_COUNT, sizeof(int32_t), compareIntsForQsort);
+
+    EXPECT(sortInts(items, ITEMS_COUNT));
+    EXPECT(memcmp(items, expected, ITEMS_COUNT * sizeof(int32_t)) == 0);
+
+    // Short arrays are sorted by insertion.
+    int32_t short_items[] = { 3, -1, 2 };
+    EXPECT(sortInts(short_items, 3));
+    EXPECT(short_items[0] == -1 && short_items[1] == 2 && short_items[2] == 3);
+
+    free(items);
+    free(expected);
+}
+
+TEST(NarrowIntsAreSortedLikeInts) {
+    int8_t* bytes = malloc(ITEMS_COUNT * sizeof(int8_t));
+    int16_t* shorts = malloc(ITEMS_COUNT * sizeof(int16_t));
+    srand(5);
+    for (size_t i = 0; i < ITEMS_COUNT; ++i) {
+        bytes[i] = (int8_t)(rand() % 256 - 128);
+        shorts[i] = (int16_t)(rand() % 65536 - 32768);
+    }
+
+    sortInt8s(bytes, ITEMS_COUNT);
+    EXPECT(sortInt16s(shorts, ITEMS_COUNT));
+
+    bool sorted = true;
+    for (size_t i = 1; i < ITEMS_COUNT; ++i) {
+        sorted &= bytes[i - 1] <= bytes[i];
+        sorted &= shorts[i - 1] <= shorts[i];
+    }
+    EXPECT(sorted);
+    EXPECT(bytes[0] == INT8_MIN && bytes[ITEMS_COUNT - 1] == INT8_MAX);
+
+    int16_t short_items[] = { 300, -2, INT16_MIN };
+    EXPECT(sortInt16s(short_items, 3));
+    EXPECT(short_items[0] == INT16_MIN && short_items[1] == -2 && short_items[2] == 300);
+
+    free(bytes);
+    free(shorts);
+}
+
+TEST(Float32sAreSortedWithNaNsLast) {
+    float items[] = { 2.5f, NAN, -1.0f, 3.25f, NAN, 0.0f, -7.5f };
+    sortFloat32s(items, sizeof(items) / sizeof(items[0]));
+
+    EXPECT(items[0] < -7.0f && items[4] > 3.0f);
+    EXPECT(items[1] < items[2] && items[2] < items[3] && items[3] < items[4]);
+    EXPECT(isnan(items[5]) && isnan(items[6]));
+}
+
+TEST(FloatsAreSortedWithNaNsLast) {
+    double* items = malloc(ITEMS_COUNT * sizeof(double));
+    srand(2);
+    for (size_t i = 0; i < ITEMS_COUNT; ++i) {
+        items[i] = i % 101 == 0 ? NAN : (double)(rand() % 2000 - 1000) / 8;
+    }
+
+    sortFloats(items, ITEMS_COUNT);
+
+    size_t nans_count = (ITEMS_COUNT + 100) / 101;
+    bool sorted = true;
+    for (size_t i = 1; i < ITEMS_COUNT - nans_count; ++i) {
+        sorted &= items[i - 1] <= items[i];
+    }
+    for (size_t i = ITEMS_COUNT - nans_count; i < ITEMS_COUNT; ++i) {
+        sorted &= isnan(items[i]) != 0;
+    }
+    EXPECT(sorted);
+
+    free(items);
+}
+
+TEST(SortedInputDoesntDegradeIntrosort) {
+    double* items = malloc(ITEMS_COUNT * sizeof(double));
+    for (size_t i = 0; i < ITEMS_COUNT; ++i) {
+        items[i] = (double)(ITEMS_COUNT - i);
+    }
+
+    sortFloats(items, ITEMS_COUNT);
+
+    bool sorted = true;
+    for (size_t i = 0; i < ITEMS_COUNT; ++i) {
+        sorted &= !(items[i] < (double)(i + 1) || items[i] > (double)(i + 1));
+    }
+    EXPECT(sorted);
+
+    free(items);
+}
+
+TEST(StringsAreSortedByBytesBeyondThePrefix) {
+    const char* values[] = {
+        "prefix-b", "prefix-a", "prefix-ab", "prefix", "", "b", "a",
+        "prefix-aa", "\xff", "prefix-b", "pre", "a",
+        "z", "y", "x", "w", "v", "u", "t", "s", "r",
+    };
+    const char* expected[] = {
+        "", "a", "a", "b", "pre", "prefix", "prefix-a", "prefix-aa",
+        "prefix-ab", "prefix-b", "prefix-b",
+        "r", "s", "t", "u", "v", "w", "x", "y", "z", "\xff",
+    };
+    size_t count = sizeof(values) / sizeof(values[0]);
+
+    Object objects[sizeof(values) / sizeof(values[0])];
+    Object* strings[sizeof(values) / sizeof(values[0])];
+    for (size_t i = 0; i < count; ++i) {
+        objects[i] = stringObject(values[i]);
+        strings[i] = &objects[i];
+    }
+
+    EXPECT(sortStrings(strings, count));
+
+    bool sorted = true;
+    for (size_t i = 0; i < count; ++i) {
+        sorted &= strcmp((const char*)strings[i]->value, expected[i]) == 0;
+    }
+    EXPECT(sorted);
+}
+
+// Items with equal keys are numbered in their original order, so that
+// the program prints true if the sort kept them in it.
+#define STABLE_SORT_PROGRAM(items_count)                                                \
+    "structure Item {\n"                                                                \
+    "    key: int\n"                                                                    \
+    "    order: int\n"                                                                  \
+    "    name: string\n"                                                                \
+    "}\n"                                                                               \
+    "\n"                                                                                \
+    "function by-key(var a: Item, var b: Item): bool {\n"                               \
+    "    var copy: string = a.name + '!'\n"                                             \
+    "    return a.key < b.key\n"                                                        \
+    "}\n"                                                                               \
+    "\n"                                                                                \
+    "var items: [Item] = []\n"                                                          \
+    "var i: int = 0\n"                                                                  \
+    "while i < " #items_count " {\n"                                                    \
+    "    push(items, Item(i * 37 % 10, i, 'item ' + i: string))\n"                      \
+    "    i = i + 1\n"                                                                   \
+    "}\n"                                                                               \
+    "sort(items, by-key)\n"                                                             \
+    "\n"                                                                                \
+    "var ok: bool = items[0].key == 0 and items[" #items_count " - 1].key == 9\n"       \
+    "i = 1\n"                                                                           \
+    "while i < " #items_count " {\n"                                                    \
+    "    if items[i - 1].key > items[i].key\n"                                          \
+    "        ok = false\n"                                                              \
+    "    if items[i - 1].key == items[i].key and items[i - 1].order > items[i].order\n" \
+    "        ok = false\n"                                                              \
+    "    if items[i].name != 'item ' + items[i].order: string\n"                        \
+    "        ok = false\n"                                                              \
+    "    i = i + 1\n"                                                                   \
+    "}\n"                                                                               \
+    "print ok\n"
+
+TEST(SortByKeepsEqualItemsInOrder) {
+    ProgramResult result;
+    runProgram(STABLE_SORT_PROGRAM(1000), NULL, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "true\n") == 0);
+}
+
+// The function allocates, so gc moves the items, the array and
+// the merge buffer between the calls.
+TEST(SortByItemsSurviveGC) {
+    HeapConfig config;
+    initStressHeapConfig(&config);
+
+    ProgramResult result;
+    runProgram(STABLE_SORT_PROGRAM(200), &config, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "true\n") == 0);
+}
+
+TEST(SortBySortsBools) {
+    const char* source =
+        "function false-first(var a: bool, var b: bool): bool\n"
+        "    return a == false and b\n"
+        "\n"
+        "var items: [bool] = [true, false, true, false, false]\n"
+        "sort(items, false-first)\n"
+        "print items[0]: string + ' ' + items[2]: string + ' ' + items[3]: string + ' ' + items[4]: string\n";
+
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "false false true true\n") == 0);
+}
+
+TEST(SortByRejectsFunctionsThatDontReturnBool) {
+    const char* source =
+        "function difference(var a: int, var b: int): int\n"
+        "    return a - b\n"
+        "\n"
+        "var items: [int] = [3, 1, 2]\n"
+        "sort(items, difference)\n";
+
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    EXPECT(result.exit_status == 1);
+    EXPECT(strstr(result.output, "The function passed to sort must take two int items and return bool.") != NULL);
+}
+
+TEST(SortByStopsIfTheFunctionChangesTheArray) {
+    const char* source =
+        "var items: [int] = [3, 1, 2]\n"
+        "\n"
+        "function grow(var a: int, var b: int): bool {\n"
+        "    push(items, 0)\n"
+        "    return a < b\n"
+        "}\n"
+        "\n"
+        "sort(items, grow)\n"
+        "print 'unreachable'\n";
+
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    EXPECT(result.exit_status == 1);
+    EXPECT(strstr(result.output, "The array was changed while it was being sorted.") != NULL);
+    EXPECT(strstr(result.output, "unreachable") == NULL);
+}
+
+// Bools are packed, so the function is only asked how false and true
+// compare, and the bits are rearranged after that.
+#define BITS_SORT_PROGRAM(less_body)                    \
+    "var items: [bool] = []\n"                          \
+    "\n"                                                \
+    "function less(var a: bool, var b: bool): bool {\n" \
+    "    var copy: string = a: string + b: string\n"    \
+    "    " less_body "\n"                               \
+    "}\n"                                               \
+    "\n"                                                \
+    "var i: int = 0\n"                                  \
+    "while i < 20 {\n"                                  \
+    "    push(items, i % 3 == 0)\n"                     \
+    "    i = i + 1\n"                                   \
+    "}\n"                                               \
+    "sort(items, less)\n"                               \
+    "\n"                                                \
+    "var bits: string = ''\n"                           \
+    "i = 0\n"                                           \
+    "while i < length(items) {\n"                       \
+    "    if items[i]\n"                                 \
+    "        bits = bits + '1'\n"                       \
+    "    else\n"                                        \
+    "        bits = bits + '0'\n"                       \
+    "    i = i + 1\n"                                   \
+    "}\n"                                               \
+    "print bits\n"
+
+TEST(SortBySortsBitArrays) {
+    HeapConfig config;
+    initStressHeapConfig(&config);
+
+    ProgramResult result;
+    runProgram(BITS_SORT_PROGRAM("return a and !b"), &config, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "11111110000000000000\n") == 0);
+
+    runProgram(BITS_SORT_PROGRAM("return !a and b"), &config, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "00000000000001111111\n") == 0);
+
+    // Nothing is less, so every item is equal and stays where it is.
+    runProgram(BITS_SORT_PROGRAM("return false"), &config, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "10010010010010010010\n") == 0);
+
+    runProgram(BITS_SORT_PROGRAM("push(items, true)\n    return a"), NULL, &result);
+    EXPECT(result.exit_status == 1);
+    EXPECT(strstr(result.output, "The array was changed while it was being sorted.") != NULL);
+}
+
+TEST(SortByRejectsNarrowItems) {
+    const char* source =
+        "function less(var a: int, var b: int): bool\n"
+        "    return a < b\n"
+        "\n"
+        "var bytes: [int8] = to-int8([2, 1])\n"
+        "sort(bytes, less)\n";
+
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    EXPECT(result.exit_status == 1);
+    EXPECT(strstr(result.output, "Can't sort [int8] with a function.") != NULL);
+}
@@ -0,0 +1,123 @@
+#include "cut.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "random.h"
+#include "string_kernels.h"
+
+
+#define MAX_SIZE 300
+
+
+// Bytes from a small alphabet, so that there are many partial matches.
+// A null byte and a byte above 127 are included.
+static void fillRandomBytes(uint64_t* state, uint8_t* bytes, size_t size) {
+    static const uint8_t alphabet[] = { 'a', 'b', '\0', 0xFF };
+    for (size_t i = 0; i < size; ++i) {
+        bool is_rare = nextRandom(state) % 8 == 0;
+        bytes[i] = alphabet[is_rare ? 2 + nextRandom(state) % 2 : nextRandom(state) % 2];
+    }
+}
+
+static int naiveCompare(const uint8_t* left, const uint8_t* right, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        if (left[i] != right[i]) {
+            return left[i] < right[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static size_t naiveFind(const uint8_t* haystack, size_t size, const uint8_t* needle, size_t needle_size) {
+    for (size_t i = 0; i + needle_size <= size; ++i) {
+        if (naiveCompare(haystack + i, needle, needle_size) == 0) {
+            return i;
+        }
+    }
+    return STRING_NOT_FOUND;
+}
+
+static size_t naiveCount(const uint8_t* haystack, size_t size, const uint8_t* needle, size_t needle_size) {
+    if (needle_size == 0) {
+        return size + 1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i + needle_size <= size;) {
+        if (naiveCompare(haystack + i, needle, needle_size) == 0) {
+            ++count;
+            i += needle_size;
+        } else {
+            ++i;
+        }
+    }
+    return count;
+}
+
+
+TEST(StringKernelsMatchNaiveImplementations) {
+    CpuLevel levels[] = { CPU_LEVEL_SCALAR, CPU_LEVEL_SSE2, CPU_LEVEL_AVX2 };
+    CpuLevel best_level = stringKernelsLevel();
+
+    for (size_t level_i = 0; level_i < sizeof(levels) / sizeof(levels[0]); ++level_i) {
+        if (!setStringKernelsLevel(levels[level_i])) {
+            continue;
+        }
+        const char* level_name = cpuLevelName(levels[level_i]);
+
+        uint64_t state = 1;
+        for (size_t i = 0; i < 20000; ++i) {
+            uint8_t haystack[MAX_SIZE];
+            uint8_t needle[MAX_SIZE];
+            size_t size = nextRandom(&state) % MAX_SIZE;
+            size_t needle_size = nextRandom(&state) % (i % 2 == 0 ? 5 : MAX_SIZE);
+            fillRandomBytes(&state, haystack, size);
+            fillRandomBytes(&state, needle, needle_size);
+
+            // A copy of the haystack with a random byte changed.
+            uint8_t other[MAX_SIZE];
+            memcpy(other, haystack, size);
+            if (size > 0 && i % 4 != 0) {
+                other[nextRandom(&state) % size] ^= (uint8_t)(nextRandom(&state) % 256);
+            }
+
+            int compared = compareBytes(haystack, other, size);
+            EXPECT_INTERNAL(
+                compared == naiveCompare(haystack, other, size),
+                "%s compare of %zu bytes returned %d", level_name, size, compared
+            );
+
+            size_t found = findSubstring(haystack, size, needle, needle_size);
+            EXPECT_INTERNAL(
+                found == naiveFind(haystack, size, needle, needle_size),
+                "%s find of %zu bytes in %zu returned %zu", level_name, needle_size, size, found
+            );
+
+            size_t found_byte = findByte(haystack, size, needle_size > 0 ? needle[0] : 0xFF);
+            EXPECT_INTERNAL(
+                found_byte == naiveFind(haystack, size, needle_size > 0 ? needle : (const uint8_t*)"\xFF", 1),
+                "%s find byte in %zu returned %zu", level_name, size, found_byte
+            );
+
+            size_t count = countSubstring(haystack, size, needle, needle_size);
+            EXPECT_INTERNAL(
+                count == naiveCount(haystack, size, needle, needle_size),
+                "%s count of %zu bytes in %zu returned %zu", level_name, needle_size, size, count
+            );
+        }
+    }
+
+    // Counters of the count kernels are summed up before they overflow.
+    static uint8_t zeros[100000];
+    EXPECT(countSubstring(zeros, sizeof(zeros), (const uint8_t*)"", 1) == sizeof(zeros));
+
+    setStringKernelsLevel(best_level);
+}
+
+TEST(StringKernelsLevelIsSelected) {
+    CpuLevel level = stringKernelsLevel();
+    EXPECT(level == CPU_LEVEL_SCALAR || level == CPU_LEVEL_SSE2 || level == CPU_LEVEL_AVX2);
+    EXPECT(setStringKernelsLevel(CPU_LEVEL_SCALAR));
+    EXPECT(stringKernelsLevel() == CPU_LEVEL_SCALAR);
+    EXPECT(setStringKernelsLevel(level));
+}
@@ -1,5 +1,6 @@
 #include "cut.h"
 
+#include "program.h"
 #include "vm.h"
 
 
@@ -11,7 +12,8 @@
     {                                                             \
         uint8_t expected[] = expected_stack;                      \
         size_t n = (size_t)(vm.stack.stack_top - vm.stack.stack); \
-        for (size_t i = 0; i < n; ++i) {                          \
+        EXPECT_EQUALS(n, sizeof(expected));                       \
+        for (size_t i = 0; i < n && i < sizeof(expected); ++i) {  \
             EXPECT_EQUALS_F(                                      \
                 vm.stack.stack[i],                                \
                 expected[i],                                      \
@@ -75,6 +77,17 @@ TEST_VM(NegateBool,
     ARRAY({ 0x01, 0x00 })
 );
 
+// Both operands are popped, whichever decides the result.
+TEST_VM(Or,
+    ARRAY({ OP_PUSH_FALSE, OP_PUSH_TRUE, OP_OR, OP_PUSH_FALSE, OP_PUSH_FALSE, OP_OR }),
+    ARRAY({ 0x01, 0x00 })
+);
+
+TEST_VM(And,
+    ARRAY({ OP_PUSH_TRUE, OP_PUSH_FALSE, OP_AND, OP_PUSH_TRUE, OP_PUSH_TRUE, OP_AND }),
+    ARRAY({ 0x00, 0x01 })
+);
+
 TEST_VM(NegateInt,
     ARRAY({ OP_PUSH_INT, 0x05, 0x00, 0x00, 0x00, OP_NEGATE_INT }),
     ARRAY({ 0xFB, 0xFF, 0xFF, 0xFF })
@@ -279,6 +292,231 @@ TEST_VM(Temp,
     })
 );
 
+TEST(LoadConstantDoesntAllocate) {
+    uint8_t source[] = {
+        OP_LOAD_CONSTANT, 0x00,
+        OP_LOAD_CONSTANT, 0x00,
+        '\0'
+    };
+
+    VM vm;
+    Constants constants;
+    constants.count = 0;
+    addConstant(&constants, 4, (const uint8_t*)"lala");
+    initVM(&vm, source, sizeof(source) - 1, &constants);
+
+    interpret(&vm);
+
+    Object* first  = (Object*)getAddressFromStack(&vm.stack, 0);
+    Object* second = (Object*)getAddressFromStack(&vm.stack, sizeof(size_t));
+    EXPECT(first == second);
+    EXPECT(first->immortal);
+    EXPECT(first->size == 4 && memcmp(first->value, "lala", 4) == 0);
+    EXPECT(vm.heap.size == 0);
+
+    freeVM(&vm);
+}
+
+TEST(SubstringIsAViewAndCopyIsPlain) {
+    uint8_t source[] = {
+        OP_LOAD_CONSTANT, 0x00,
+        OP_PUSH_INT, 0x01, 0x00, 0x00, 0x00,
+        OP_PUSH_INT, 0x27, 0x00, 0x00, 0x00,
+        OP_SUBSTRING,
+
+        OP_LOAD_CONSTANT, 0x00,
+        OP_PUSH_INT, 0x01, 0x00, 0x00, 0x00,
+        OP_PUSH_INT, 0x03, 0x00, 0x00, 0x00,
+        OP_SUBSTRING,
+
+        OP_LOAD_CONSTANT, 0x00,
+        OP_PUSH_INT, 0x02, 0x00, 0x00, 0x00,
+        OP_PUSH_INT, 0x28, 0x00, 0x00, 0x00,
+        OP_SUBSTRING,
+        OP_COPY_STRING,
+        '\0'
+    };
+    const char* value = "0123456789abcdefghijklmnopqrstuvwxyzABCD";
+
+    VM vm;
+    Constants constants;
+    constants.count = 0;
+    addConstant(&constants, 40, (const uint8_t*)value);
+    initVM(&vm, source, sizeof(source) - 1, &constants);
+
+    interpret(&vm);
+
+    Object* view       = (Object*)getAddressFromStack(&vm.stack, 0);
+    Object* short_copy = (Object*)getAddressFromStack(&vm.stack, sizeof(size_t));
+    Object* copy       = (Object*)getAddressFromStack(&vm.stack, 2 * sizeof(size_t));
+
+    EXPECT(view->reference_rule == REFERENCE_RULE_VIEW);
+    EXPECT(view->base == &vm.constant_objects[0]);
+    EXPECT(view->size == 38 && view->value == vm.constant_objects[0].value + 1);
+
+    EXPECT(short_copy->reference_rule == REFERENCE_RULE_PLAIN);
+    EXPECT(short_copy->size == 2 && memcmp(short_copy->value, "12", 2) == 0);
+
+    EXPECT(copy->reference_rule == REFERENCE_RULE_PLAIN);
+    EXPECT(copy->size == 38 && memcmp(copy->value, value + 2, 38) == 0);
+
+    freeVM(&vm);
+}
+
+TEST(RightOperandIsEvaluatedOnlyIfNeeded) {
+    const char* source =
+        "function loud(var value: bool): bool {\n"
+        "    print 'evaluated ' + value: string\n"
+        "    return value\n"
+        "}\n"
+        "\n"
+        "print true or loud(true)\n"
+        "print false and loud(false)\n"
+        "print false or loud(true)\n"
+        "print true and loud(false)\n"
+        "print false or false and loud(true) or true\n";
+
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(
+        result.output,
+        "true\n"
+        "false\n"
+        "evaluated true\n"
+        "true\n"
+        "evaluated false\n"
+        "false\n"
+        "true\n"
+    ) == 0);
+}
+
+// Runs a program that's expected to stop with a runtime error.
+static bool failsWithError(const char* source, const char* message) {
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    return (
+        result.exit_status == 1 &&
+        strstr(result.output, "Runtime error") != NULL &&
+        strstr(result.output, message) != NULL
+    );
+}
+
+TEST(NarrowItemsAreRangeCheckedOnStore) {
+    const char* source =
+        "var bytes: [int8] = to-int8([0, 0])\n"
+        "bytes[0] = 127\n"
+        "bytes[1] = -128\n"
+        "push(bytes, 127)\n"
+        "var shorts: [int16] = to-int16([0, 0])\n"
+        "shorts[0] = 32767\n"
+        "shorts[1] = -32768\n"
+        "push(shorts, -32768)\n"
+        "print bytes[0]: string + ' ' + bytes[1]: string + ' ' + bytes[2]: string\n"
+        "print shorts[0]: string + ' ' + shorts[1]: string + ' ' + shorts[2]: string\n";
+
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "127 -128 127\n32767 -32768 -32768\n") == 0);
+
+    EXPECT(failsWithError(
+        "var bytes: [int8] = to-int8([0])\n"
+        "bytes[0] = 128\n",
+        "Int 128 doesn't fit into int8."
+    ));
+    EXPECT(failsWithError(
+        "var bytes: [int8] = to-int8([0])\n"
+        "push(bytes, -129)\n",
+        "Int -129 doesn't fit into int8."
+    ));
+    EXPECT(failsWithError(
+        "var shorts: [int16] = to-int16([0])\n"
+        "shorts[0] = 32768\n",
+        "Int 32768 doesn't fit into int16."
+    ));
+    EXPECT(failsWithError(
+        "var shorts: [int16] = to-int16([0])\n"
+        "push(shorts, -32769)\n",
+        "Int -32769 doesn't fit into int16."
+    ));
+    EXPECT(failsWithError(
+        "var floats: [float32] = to-float32([0.0])\n"
+        "floats[0] = 1000000000000000000000000000000000000000.0\n",
+        "Float 1e+39 doesn't fit into float32."
+    ));
+}
+
+TEST(Float32ItemsAreRoundedOnStore) {
+    const char* source =
+        "var floats: [float32] = to-float32([16777217.0, 0.1])\n"
+        "push(floats, 340282346638528859811704183484516925440.0)\n"
+        "floats[1] = 0.1\n"
+        "print floats[0] == 16777216.0\n"
+        "print floats[1] == 0.1\n"
+        "print floats[1] - 0.1 < 0.00000001 and 0.1 - floats[1] < 0.00000001\n"
+        "print floats[2] == 340282346638528859811704183484516925440.0\n";
+
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "true\nfalse\ntrue\ntrue\n") == 0);
+}
+
+TEST(NarrowItemsAreWidenedOnLoad) {
+    const char* source =
+        "var bytes: [int8] = to-int8([127, -128])\n"
+        "var shorts: [int16] = to-int16([32767, -32768])\n"
+        "var floats: [float32] = to-float32([0.5])\n"
+        "print bytes[0] + 1\n"
+        "print bytes[1] - 1\n"
+        "print shorts[0] + 1\n"
+        "print shorts[1] * 2\n"
+        "print floats[0] * 340282346638528859811704183484516925440.0 * 4.0 > 340282346638528859811704183484516925440.0\n"
+        "var ints: [int] = to-int(bytes)\n"
+        "var wide-shorts: [int] = to-int(shorts)\n"
+        "var wide-floats: [float] = to-float(floats)\n"
+        "print ints[1]: string + ' ' + wide-shorts[1]: string + ' ' + length(wide-floats): string\n";
+
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "128\n-129\n32768\n-65536\ntrue\n-128 -32768 1\n") == 0);
+}
+
+TEST(NarrowConversionsCheckEveryItem) {
+    const char* source =
+        "var bytes: [int8] = to-int8([-128, 0, 127])\n"
+        "var shorts: [int16] = to-int16([-32768, 0, 32767])\n"
+        "var floats: [float32] = to-float32([-340282346638528859811704183484516925440.0, 0.0])\n"
+        "print length(bytes) + length(shorts) + length(floats)\n";
+
+    ProgramResult result;
+    runProgram(source, NULL, &result);
+    EXPECT(result.exit_status == 0);
+    EXPECT(strcmp(result.output, "8\n") == 0);
+
+    EXPECT(failsWithError(
+        "var bytes: [int8] = to-int8([1, 2, 200])\n",
+        "Int 200 doesn't fit into int8."
+    ));
+    EXPECT(failsWithError(
+        "var bytes: [int8] = to-int8([-129])\n",
+        "Int -129 doesn't fit into int8."
+    ));
+    EXPECT(failsWithError(
+        "var shorts: [int16] = to-int16([0, -32769])\n",
+        "Int -32769 doesn't fit into int16."
+    ));
+    EXPECT(failsWithError(
+        "var shorts: [int16] = to-int16([32768])\n",
+        "Int 32768 doesn't fit into int16."
+    ));
+    EXPECT(failsWithError(
+        "var floats: [float32] = to-float32([0.5, -1000000000000000000000000000000000000000.0])\n",
+        "Float -1e+39 doesn't fit into float32."
+    ));
+}
 
 #undef TEST_VM
 #undef EXPECT_STACK_STATE